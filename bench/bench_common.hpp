@@ -0,0 +1,162 @@
+#pragma once
+/// @file bench_common.hpp
+/// @brief Allocator adapters and helpers shared by the multi-threaded
+///        benchmark suites.
+///
+/// Every adapter exposes the same minimal interface so a workload can be
+/// written once and instantiated per allocator:
+/// @code
+///   Block b = adapter.alloc(size);   // b.ptr == nullptr on OOM
+///   adapter.free(b);                 // may be called from any thread
+/// @endcode
+
+#include "allocator/arena.hpp"
+#include "allocator/free_list.hpp"
+#include "interface/visualization_arena.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace mmap_viz::bench {
+
+/// @brief A live allocation as seen by a workload.
+struct Block {
+  void *ptr = nullptr;
+  std::size_t size = 0; ///< Size to hand back to free().
+};
+
+// ─── Adapters ───────────────────────────────────────────────────────────
+
+/// @brief System malloc/free baseline.
+struct MallocAdapter {
+  static constexpr const char *kName = "malloc";
+
+  void setup(std::size_t /*arena_size*/) {}
+  void teardown() {}
+
+  auto alloc(std::size_t size) -> Block { return {std::malloc(size), size}; }
+  void free(Block b) { std::free(b.ptr); }
+};
+
+/// @brief A single FreeListAllocator behind one global mutex.
+///
+/// FreeListAllocator is not internally synchronized, so this is the
+/// "no sharding" reference point for the sharded VisualizationArena.
+struct FreeListAdapter {
+  static constexpr const char *kName = "FreeListAllocator";
+
+  void setup(std::size_t arena_size) {
+    arena.emplace(Arena::create(arena_size).value());
+    allocator =
+        std::make_unique<FreeListAllocator>(arena->base(), arena->capacity());
+  }
+  void teardown() {
+    allocator.reset();
+    arena.reset();
+  }
+
+  auto alloc(std::size_t size) -> Block {
+    std::lock_guard lock(mutex);
+    auto r = allocator->allocate(size, 16);
+    if (!r.has_value()) {
+      return {};
+    }
+    return {r->ptr, r->actual_size};
+  }
+  void free(Block b) {
+    std::lock_guard lock(mutex);
+    (void)allocator->deallocate(static_cast<std::byte *>(b.ptr), b.size);
+  }
+
+  std::optional<Arena> arena;
+  std::unique_ptr<FreeListAllocator> allocator;
+  std::mutex mutex;
+};
+
+/// @brief The full instrumented pipeline at a fixed event sampling rate.
+template <std::size_t Sampling> struct VisualizationArenaAdapter {
+  static constexpr const char *kName = "VisualizationArena";
+  static constexpr std::size_t kSampling = Sampling;
+
+  void setup(std::size_t arena_size) {
+    arena.emplace(VisualizationArena::create({.arena_size = arena_size,
+                                              .enable_server = false,
+                                              .sampling = Sampling})
+                      .value());
+  }
+  void teardown() { arena.reset(); }
+
+  auto alloc(std::size_t size) -> Block {
+    return {arena->alloc_raw(size, 16, "bench"), size};
+  }
+  void free(Block b) { arena->dealloc_raw(b.ptr, b.size); }
+
+  std::optional<VisualizationArena> arena;
+};
+
+// ─── Helpers ────────────────────────────────────────────────────────────
+
+/// @brief Bounded single-producer/single-consumer queue of blocks.
+///
+/// Used to hand allocations from the thread that allocated them to the
+/// thread that frees them. Indices live on separate cache lines so the
+/// queue itself does not introduce false sharing.
+template <std::size_t N> class SpscQueue {
+  static_assert((N & (N - 1)) == 0, "capacity must be a power of 2");
+
+public:
+  auto try_push(Block b) -> bool {
+    auto head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == N) {
+      return false;
+    }
+    slots_[head & (N - 1)] = b;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  auto try_pop(Block &out) -> bool {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    out = slots_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  alignas(64) std::atomic<std::size_t> head_{0};
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  alignas(64) Block slots_[N];
+};
+
+/// @brief Cheap per-thread xorshift generator (std::mt19937 would dominate
+/// the cost of a fast-path allocation).
+class FastRng {
+public:
+  explicit FastRng(std::uint64_t seed) noexcept
+      : state_{seed * 0x9E3779B97F4A7C15ull + 1} {}
+
+  auto next() noexcept -> std::uint64_t {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 7;
+    state_ ^= state_ << 17;
+    return state_;
+  }
+
+  /// @brief Uniform value in [lo, hi].
+  auto between(std::size_t lo, std::size_t hi) noexcept -> std::size_t {
+    return lo + static_cast<std::size_t>(next() % (hi - lo + 1));
+  }
+
+private:
+  std::uint64_t state_;
+};
+
+} // namespace mmap_viz::bench
@@ -1,6 +1,14 @@
+#include "bench_common.hpp"
+
+#include "interface/shard_lock.hpp"
 #include "interface/visualization_arena.hpp"
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <bit>
 #include <benchmark/benchmark.h>
+#include <cstring>
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -29,4 +37,367 @@ static void BM_Contention_Allocation(benchmark::State &state) {
 BENCHMARK(BM_Contention_Allocation)
     ->ThreadRange(1, std::thread::hardware_concurrency());
 
+// ─── Cross-thread (remote) frees ────────────────────────────────────────
+//
+// N producer threads allocate and M consumer threads free, so every free
+// goes through dealloc_raw's cross-shard path and contends with the owning
+// producer's allocations. Blocks travel through one SPSC queue per
+// (producer, consumer) pair. Each iteration a producer sends one block to
+// every consumer and a consumer drains one block from every producer, so
+// all queues carry exactly `iterations` blocks and the run always drains.
+
+constexpr std::size_t kRemoteQueue = 64;
+constexpr std::size_t kRemoteBlock = 64;
+
+struct RemoteFreeShared {
+  std::vector<std::unique_ptr<bench::SpscQueue<kRemoteQueue>>> queues;
+  ShardLockStats before;
+};
+
+static auto remote_free_arena() -> VisualizationArena & {
+  static auto va =
+      VisualizationArena::create({.arena_size = 256 * 1024 * 1024, // 256MB
+                                  .enable_server = false,
+                                  .sampling = 1})
+          .value();
+  return va;
+}
+
+/// @param state.range(0) Percentage of threads that are producers.
+static void BM_Contention_RemoteFree(benchmark::State &state) {
+  static RemoteFreeShared shared;
+  auto &va = remote_free_arena();
+
+  const auto threads = static_cast<std::size_t>(state.threads());
+  const auto producers = std::clamp<std::size_t>(
+      threads * static_cast<std::size_t>(state.range(0)) / 100, 1,
+      threads - 1);
+  const auto consumers = threads - producers;
+  const auto tid = static_cast<std::size_t>(state.thread_index());
+
+  if (tid == 0) {
+    shared.queues.clear();
+    for (std::size_t i = 0; i < producers * consumers; ++i) {
+      shared.queues.push_back(
+          std::make_unique<bench::SpscQueue<kRemoteQueue>>());
+    }
+    shared.before = va.shard_lock_stats();
+  }
+
+  const bool producer = tid < producers;
+  std::size_t oom = 0;
+  for (auto _ : state) {
+    if (producer) {
+      for (std::size_t c = 0; c < consumers; ++c) {
+        // A null block (OOM) is still sent so the queues stay balanced;
+        // dealloc_raw ignores it.
+        bench::Block b{va.alloc_raw(kRemoteBlock, 16, "remote"), kRemoteBlock};
+        oom += b.ptr == nullptr ? 1 : 0;
+        auto &q = *shared.queues[tid * consumers + c];
+        while (!q.try_push(b)) {
+          std::this_thread::yield();
+        }
+      }
+    } else {
+      const auto c = tid - producers;
+      for (std::size_t p = 0; p < producers; ++p) {
+        auto &q = *shared.queues[p * consumers + c];
+        bench::Block b;
+        while (!q.try_pop(b)) {
+          std::this_thread::yield();
+        }
+        va.dealloc_raw(b.ptr, b.size);
+      }
+    }
+  }
+
+  if (producer) {
+    state.SetItemsProcessed(state.iterations() *
+                            static_cast<std::int64_t>(consumers));
+    state.counters["oom"] = static_cast<double>(oom);
+  }
+
+  if (tid == 0) {
+    // Every thread has passed the end barrier, so all frees are done.
+    const auto after = va.shard_lock_stats();
+    const auto acquisitions = after.acquisitions - shared.before.acquisitions;
+    const auto contended = after.contended - shared.before.contended;
+    state.counters["producers"] = static_cast<double>(producers);
+    state.counters["consumers"] = static_cast<double>(consumers);
+    state.counters["lock_contended"] = static_cast<double>(contended);
+    state.counters["lock_contended_pct"] =
+        acquisitions == 0 ? 0.0
+                          : 100.0 * static_cast<double>(contended) /
+                                static_cast<double>(acquisitions);
+    shared.queues.clear();
+  }
+}
+
+BENCHMARK(BM_Contention_RemoteFree)
+    ->ArgName("producer_pct")
+    ->Arg(25)
+    ->Arg(50)
+    ->Arg(75)
+    ->ThreadRange(2, 64)
+    ->UseRealTime();
+
+// ─── Small objects ──────────────────────────────────────────────────────
+//
+// Each thread churns a ring of small blocks (16-64 B requests, so 80-128 B
+// blocks with the alloc_raw header) on its own shard, and every 8th
+// iteration frees a block allocated by the next thread instead, so
+// foreign-thread frees are part of the mix. Arg 1 serves these from the
+// lock-free small-block cache, arg 0 takes the shard lock for every call.
+
+constexpr std::size_t kSmallRing = 32;
+
+struct SmallObjectShared {
+  std::vector<std::unique_ptr<bench::SpscQueue<kRemoteQueue>>> handoff;
+};
+
+static auto small_object_arena(bool cache) -> VisualizationArena & {
+  static auto with_cache =
+      VisualizationArena::create({.arena_size = 256 * 1024 * 1024,
+                                  .enable_server = false,
+                                  .small_block_cache = true})
+          .value();
+  static auto without_cache =
+      VisualizationArena::create({.arena_size = 256 * 1024 * 1024,
+                                  .enable_server = false,
+                                  .small_block_cache = false})
+          .value();
+  return cache ? with_cache : without_cache;
+}
+
+/// @param state.range(0) 1 = lock-free small-block cache, 0 = locked.
+static void BM_Contention_SmallObjects(benchmark::State &state) {
+  static SmallObjectShared shared;
+  auto &va = small_object_arena(state.range(0) != 0);
+  const auto threads = static_cast<std::size_t>(state.threads());
+  const auto tid = static_cast<std::size_t>(state.thread_index());
+
+  if (tid == 0) {
+    shared.handoff.clear();
+    for (std::size_t i = 0; i < threads; ++i) {
+      shared.handoff.push_back(
+          std::make_unique<bench::SpscQueue<kRemoteQueue>>());
+    }
+    state.counters["lock_acquisitions"] =
+        -static_cast<double>(va.shard_lock_stats().acquisitions);
+  }
+
+  bench::FastRng rng(tid + 1);
+  std::array<bench::Block, kSmallRing> ring{};
+  std::size_t next = 0;
+  for (auto _ : state) {
+    // Looked up in the loop: thread 0 builds the queues before the start
+    // barrier, which the other threads only pass at the first iteration.
+    auto &outbox = *shared.handoff[(tid + 1) % threads];
+    auto &inbox = *shared.handoff[tid];
+    auto &slot = ring[next++ % kSmallRing];
+    if (slot.ptr != nullptr) {
+      // Hand every 8th block to the next thread instead of freeing it.
+      if (threads > 1 && next % 8 == 0 && outbox.try_push(slot)) {
+        slot = {};
+      } else {
+        va.dealloc_raw(slot.ptr, slot.size);
+      }
+    }
+    bench::Block foreign;
+    if (threads > 1 && inbox.try_pop(foreign)) {
+      va.dealloc_raw(foreign.ptr, foreign.size);
+    }
+    const auto size = rng.between(16, 64);
+    slot = {va.alloc_raw(size, 16, "small"), size};
+    if (slot.ptr == nullptr) {
+      state.SkipWithError("OOM");
+      break;
+    }
+  }
+
+  for (auto &b : ring) {
+    va.dealloc_raw(b.ptr, b.size);
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (tid == 0) {
+    // Blocks still in flight between threads are leaked to the next run;
+    // the arena is sized for it.
+    state.counters["lock_acquisitions"] +=
+        static_cast<double>(va.shard_lock_stats().acquisitions);
+  }
+}
+
+BENCHMARK(BM_Contention_SmallObjects)
+    ->ArgName("lock_free")
+    ->Arg(0)
+    ->Arg(1)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// ─── Shard lock kinds ───────────────────────────────────────────────────
+//
+// Every thread hammers one FreeListAllocator behind one ShardLock, the
+// worst case of many threads homed on (or freeing into) the same shard.
+// Each iteration frees a thread's oldest block and allocates a new one of
+// random size under the lock (a real shard critical section: a few hundred
+// ns of tree work), then touches the new block outside it. Thread counts
+// run to 4x the hardware threads to cover oversubscription, where a
+// preempted holder makes pure spinning expensive.
+
+constexpr std::size_t kLockArena = 64 * 1024 * 1024;
+constexpr std::size_t kLockRing = 16; // Live blocks per thread.
+
+struct SharedShardLock {
+  std::unique_ptr<ShardLock> lock;
+  std::unique_ptr<FreeListAllocator> allocator;
+};
+
+template <ShardLockKind Kind>
+static void BM_Contention_ShardLock(benchmark::State &state) {
+  static auto arena = Arena::create(kLockArena).value();
+  static SharedShardLock shared;
+
+  if (state.thread_index() == 0) {
+    shared.lock = std::make_unique<ShardLock>(Kind);
+    shared.allocator =
+        std::make_unique<FreeListAllocator>(arena.base(), arena.capacity());
+  }
+
+  bench::FastRng rng(static_cast<std::uint64_t>(state.thread_index()) + 1);
+  std::array<bench::Block, kLockRing> ring{};
+  std::size_t next = 0;
+  for (auto _ : state) {
+    auto &slot = ring[next++ % kLockRing];
+    const auto size = rng.between(16, 512);
+    shared.lock->lock_profiled(false);
+    if (slot.ptr != nullptr) {
+      (void)shared.allocator->deallocate(static_cast<std::byte *>(slot.ptr),
+                                         slot.size);
+    }
+    auto r = shared.allocator->allocate(size, 16);
+    shared.lock->unlock();
+    slot = r.has_value() ? bench::Block{r->ptr, r->actual_size}
+                         : bench::Block{};
+    if (slot.ptr != nullptr) {
+      std::memset(slot.ptr, 0xab, std::min<std::size_t>(size, 64));
+    }
+  }
+  // Blocks still in `ring` are dropped with the allocator on the next run.
+
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    // Every thread has passed the end barrier.
+    const auto p = shared.lock->profile();
+    const auto hw = std::max(1u, std::thread::hardware_concurrency());
+    state.counters["oversubscribed"] =
+        static_cast<unsigned>(state.threads()) > hw ? 1 : 0;
+    state.counters["lock_contended_pct"] =
+        p.acquisitions == 0 ? 0.0
+                            : 100.0 * static_cast<double>(p.contended) /
+                                  static_cast<double>(p.acquisitions);
+    state.counters["wait_p99_ns"] =
+        static_cast<double>(p.wait_ns.percentile(0.99));
+    state.counters["hold_p50_ns"] =
+        static_cast<double>(p.hold_ns.percentile(0.50));
+    if constexpr (Kind == ShardLockKind::kAdaptive) {
+      state.counters["spin_budget_ns"] =
+          static_cast<double>(shared.lock->spin_budget_ns());
+    }
+  }
+}
+
+static const int kMaxLockThreads = static_cast<int>(
+    4 * std::max(1u, std::thread::hardware_concurrency()));
+
+BENCHMARK_TEMPLATE(BM_Contention_ShardLock, ShardLockKind::kMutex)
+    ->Name("BM_Contention_ShardLock/std_mutex")
+    ->ThreadRange(1, kMaxLockThreads)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Contention_ShardLock, ShardLockKind::kSpinFutex)
+    ->Name("BM_Contention_ShardLock/spin_futex")
+    ->ThreadRange(1, kMaxLockThreads)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Contention_ShardLock, ShardLockKind::kAdaptive)
+    ->Name("BM_Contention_ShardLock/adaptive")
+    ->ThreadRange(1, kMaxLockThreads)
+    ->UseRealTime();
+
+// ─── Range partitions ───────────────────────────────────────────────────
+//
+// 32 threads churn a SubArena of 1-4 shards, each split into 1-8 locked
+// address ranges: with one range per shard, 8-32 threads share each lock.
+// Same critical section as above (free the oldest block, allocate one of
+// 16-512 B). edge_allocations counts blocks that had to straddle a range
+// edge; it should stay 0 at this fill level.
+
+constexpr int kRangeThreads = 32;
+constexpr std::size_t kMaxRangeShards = 4;
+constexpr std::size_t kMaxRanges = 8;
+
+/// @brief The sub-arena for @p shards x @p ranges. All are carved on first
+///        use: every benchmark run homes 32 new threads in the parent, and
+///        a sub-arena can only be carved above every home.
+static auto range_sub_arena(std::size_t shards, std::size_t ranges)
+    -> SubArena & {
+  static auto va =
+      VisualizationArena::create({.arena_size = 256 * 1024 * 1024, // 256MB
+                                  .enable_server = false})
+          .value();
+  static auto subs = [] {
+    std::vector<std::unique_ptr<SubArena>> out;
+    for (std::size_t s = 1; s <= kMaxRangeShards; ++s) {
+      for (std::size_t r = 1; r <= kMaxRanges; r *= 2) {
+        out.push_back(va.create_sub_arena({.name = "ranges",
+                                           .capacity = 8 * 1024 * 1024,
+                                           .shard_count = s,
+                                           .ranges_per_shard = r})
+                          .value());
+      }
+    }
+    return out;
+  }();
+  return *subs[((shards - 1) * 4) + static_cast<std::size_t>(
+                                        std::countr_zero(ranges))];
+}
+
+/// @param state.range(0) Shards.
+/// @param state.range(1) Ranges per shard.
+static void BM_Contention_Ranges(benchmark::State &state) {
+  auto &sub = range_sub_arena(static_cast<std::size_t>(state.range(0)),
+                              static_cast<std::size_t>(state.range(1)));
+  const auto edges_before = sub.stats().edge_allocations;
+
+  bench::FastRng rng(static_cast<std::uint64_t>(state.thread_index()) + 1);
+  std::array<bench::Block, kLockRing> ring{};
+  std::size_t next = 0;
+  for (auto _ : state) {
+    auto &slot = ring[next++ % kLockRing];
+    sub.dealloc_raw(slot.ptr, slot.size);
+    const auto size = rng.between(16, 512);
+    slot = {sub.alloc_raw(size, 16, "range"), size};
+    if (slot.ptr == nullptr) {
+      state.SkipWithError("OOM");
+      break;
+    }
+  }
+  for (auto &b : ring) {
+    sub.dealloc_raw(b.ptr, b.size);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    const auto stats = sub.stats();
+    state.counters["locks"] =
+        static_cast<double>(stats.shard_count * stats.ranges_per_shard);
+    state.counters["edge_allocations"] =
+        static_cast<double>(stats.edge_allocations - edges_before);
+  }
+}
+
+BENCHMARK(BM_Contention_Ranges)
+    ->ArgNames({"shards", "ranges"})
+    ->ArgsProduct({{1, 2, 3, 4}, {1, 2, 4, 8}})
+    ->Threads(kRangeThreads)
+    ->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -0,0 +1,166 @@
+/// @file bench_free_index.cpp
+/// @brief Out-of-line B+-tree free index vs the intrusive RB tree.
+///
+/// Both allocators get the same fragmented region: N free 144 B holes
+/// (tree-sized for FreeListAllocator, so none sit in its small lists),
+/// each followed by a live 16 B block so none coalesce.
+///
+///   BM_FirstFit  Some holes are 1 KB instead, at random positions; each
+///                round allocates a 1 KB block K times (first fit lands on
+///                the leftmost remaining big hole, anywhere in the region)
+///                and frees them again, restoring the layout.
+///   BM_Churn     Steady-state random churn: free a random live block,
+///                allocate 16–144 B (no larger than a hole).
+///
+/// Run with N = 10^3..10^7. The intrusive tree touches a node inside the
+/// region per level; the B+-tree reads 64-byte index nodes only.
+
+#include "allocator/arena.hpp"
+#include "allocator/btree_allocator.hpp"
+#include "allocator/free_list.hpp"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+using namespace mmap_viz;
+
+namespace {
+
+constexpr std::size_t kHole = 144;
+constexpr std::size_t kBigHole = 1024;
+constexpr std::size_t kLive = 16;
+
+/// @brief A fragmented region and the allocator over it.
+template <typename Alloc> struct Fragmented {
+  Arena arena;
+  std::unique_ptr<Alloc> alloc;
+  std::vector<AllocationResult> live; ///< The 16 B separators.
+};
+
+/// @brief Lay out @p holes free holes, @p big_count of them 1 KB.
+template <typename Alloc>
+auto make_fragmented(benchmark::State &state, std::size_t holes,
+                     std::size_t big_count)
+    -> std::optional<Fragmented<Alloc>> {
+  auto arena = Arena::create(holes * (kHole + kLive) +
+                             big_count * (kBigHole - kHole) + (1 << 20));
+  if (!arena) {
+    state.SkipWithError("Failed to create arena (too large?)");
+    return std::nullopt;
+  }
+  auto alloc = std::make_unique<Alloc>(arena->base(), arena->capacity());
+  std::optional<Fragmented<Alloc>> f{
+      Fragmented<Alloc>{std::move(*arena), std::move(alloc), {}}};
+  f->live.reserve(holes);
+
+  // Spread big holes uniformly at random among the others.
+  std::mt19937_64 rng(1);
+  std::vector<bool> big(holes, false);
+  for (std::size_t i = 0; i < big_count; ++i) {
+    big[rng() % holes] = true;
+  }
+
+  std::vector<AllocationResult> to_free;
+  to_free.reserve(holes);
+  for (std::size_t i = 0; i < holes; ++i) {
+    auto hole = f->alloc->allocate(big[i] ? kBigHole : kHole);
+    auto sep = f->alloc->allocate(kLive);
+    if (!hole || !sep) {
+      state.SkipWithError("Setup OOM");
+      return std::nullopt;
+    }
+    to_free.push_back(*hole);
+    f->live.push_back(*sep);
+  }
+  for (const auto &r : to_free) {
+    (void)f->alloc->deallocate(r.ptr, r.actual_size);
+  }
+  return f;
+}
+
+template <typename Alloc>
+void report(benchmark::State &state, const Alloc &alloc) {
+  state.counters["free_blocks"] = static_cast<double>(alloc.free_block_count());
+  if constexpr (std::is_same_v<Alloc, BTreeAllocator>) {
+    state.counters["depth"] = static_cast<double>(alloc.index().depth());
+    state.counters["index_MB"] =
+        static_cast<double>(alloc.index().metadata_bytes()) / (1 << 20);
+  }
+}
+
+} // namespace
+
+// ─── First fit over scattered candidates ────────────────────────────────
+
+template <typename Alloc> static void BM_FirstFit(benchmark::State &state) {
+  const auto holes = static_cast<std::size_t>(state.range(0));
+  const std::size_t k = std::min<std::size_t>(1024, holes / 4);
+  auto f = make_fragmented<Alloc>(state, holes, k);
+  if (!f) {
+    return;
+  }
+  std::vector<AllocationResult> taken;
+  taken.reserve(k);
+
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < k; ++i) {
+      auto r = f->alloc->allocate(kBigHole);
+      benchmark::DoNotOptimize(r);
+      taken.push_back(*r);
+    }
+    for (const auto &r : taken) {
+      (void)f->alloc->deallocate(r.ptr, r.actual_size);
+    }
+    taken.clear();
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * k *
+                                                    2));
+  report(state, *f->alloc);
+}
+
+BENCHMARK_TEMPLATE(BM_FirstFit, FreeListAllocator)
+    ->RangeMultiplier(10)
+    ->Range(1000, 10000000)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_FirstFit, BTreeAllocator)
+    ->RangeMultiplier(10)
+    ->Range(1000, 10000000)
+    ->Unit(benchmark::kMicrosecond);
+
+// ─── Random churn ───────────────────────────────────────────────────────
+
+template <typename Alloc> static void BM_Churn(benchmark::State &state) {
+  const auto holes = static_cast<std::size_t>(state.range(0));
+  auto f = make_fragmented<Alloc>(state, holes, 0);
+  if (!f) {
+    return;
+  }
+  std::mt19937_64 rng(2);
+  auto &live = f->live;
+
+  for (auto _ : state) {
+    auto victim = rng() % live.size();
+    (void)f->alloc->deallocate(live[victim].ptr, live[victim].actual_size);
+    auto r = f->alloc->allocate(16 * (1 + rng() % 9));
+    if (!r) {
+      state.SkipWithError("Churn OOM");
+      break;
+    }
+    live[victim] = *r;
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 2));
+  report(state, *f->alloc);
+}
+
+BENCHMARK_TEMPLATE(BM_Churn, FreeListAllocator)
+    ->RangeMultiplier(10)
+    ->Range(1000, 10000000);
+BENCHMARK_TEMPLATE(BM_Churn, BTreeAllocator)
+    ->RangeMultiplier(10)
+    ->Range(1000, 10000000);
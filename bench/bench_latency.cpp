@@ -0,0 +1,286 @@
+/// @file bench_latency.cpp
+/// @brief Per-operation tail latency of the allocator hot paths.
+///
+/// Runs the bench_allocator.cpp workloads, but timestamps every
+/// allocate/deallocate (FreeListAllocator) and alloc_raw/dealloc_raw
+/// (VisualizationArena) individually and reports p50 through p99.999 and
+/// max per operation type as benchmark counters (nanoseconds).
+///
+/// Multi-threaded runs give each thread its own FreeListAllocator (it is
+/// not internally synchronized) and share one VisualizationArena. Per-thread
+/// histograms are merged before reporting, so percentiles cover every
+/// sample from every thread.
+
+#include "latency_histogram.hpp"
+
+#include "allocator/arena.hpp"
+#include "allocator/free_list.hpp"
+#include "interface/visualization_arena.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mmap_viz;
+using namespace mmap_viz::bench;
+
+namespace {
+
+const int kMaxThreads =
+    static_cast<int>(std::max(4u, std::thread::hardware_concurrency()));
+
+// ─── Reporting ──────────────────────────────────────────────────────────
+
+struct OpHistograms {
+  LatencyHistogram alloc;
+  LatencyHistogram dealloc;
+};
+
+/// @brief Cross-thread merge point for one benchmark run.
+struct MergedHistograms {
+  std::mutex mutex;
+  OpHistograms merged;
+  int pending = 0;
+};
+
+void report(benchmark::State &state, const std::string &prefix,
+            const LatencyHistogram &h) {
+  constexpr std::array<std::pair<const char *, double>, 6> kQuantiles{{
+      {"p50", 0.50},
+      {"p90", 0.90},
+      {"p99", 0.99},
+      {"p99.9", 0.999},
+      {"p99.99", 0.9999},
+      {"p99.999", 0.99999},
+  }};
+  const double tpn = CycleClock::ticks_per_ns();
+  for (const auto &[name, q] : kQuantiles) {
+    state.counters[prefix + "_" + name] =
+        static_cast<double>(h.percentile(q)) / tpn;
+  }
+  state.counters[prefix + "_max"] = static_cast<double>(h.max()) / tpn;
+}
+
+/// @brief Thread 0 resets the merge point before the start barrier.
+void begin_run(benchmark::State &state, MergedHistograms &shared) {
+  if (state.thread_index() == 0) {
+    shared.merged.alloc.reset();
+    shared.merged.dealloc.reset();
+    shared.pending = state.threads();
+  }
+}
+
+/// @brief Merge this thread's samples; the last thread publishes counters.
+///
+/// Counters are summed across threads, so only one thread may set them.
+void end_run(benchmark::State &state, MergedHistograms &shared,
+             const OpHistograms &local, const char *alloc_name,
+             const char *dealloc_name) {
+  std::lock_guard lock(shared.mutex);
+  shared.merged.alloc.merge(local.alloc);
+  shared.merged.dealloc.merge(local.dealloc);
+  if (--shared.pending == 0) {
+    report(state, alloc_name, shared.merged.alloc);
+    report(state, dealloc_name, shared.merged.dealloc);
+  }
+}
+
+// ─── Backends ───────────────────────────────────────────────────────────
+
+/// @brief A private FreeListAllocator per thread.
+class FreeListBackend {
+public:
+  static constexpr const char *kAllocName = "allocate";
+  static constexpr const char *kDeallocName = "deallocate";
+
+  explicit FreeListBackend(std::size_t arena_size)
+      : arena_{Arena::create(arena_size).value()},
+        alloc_{arena_.base(), arena_.capacity()} {}
+
+  auto alloc(std::size_t size) -> void * {
+    auto r = alloc_.allocate(size, 16);
+    return r.has_value() ? r->ptr : nullptr;
+  }
+  void free(void *ptr, std::size_t size) {
+    (void)alloc_.deallocate(static_cast<std::byte *>(ptr), size);
+  }
+
+private:
+  Arena arena_;
+  FreeListAllocator alloc_;
+};
+
+/// @brief One VisualizationArena shared by every thread of the run.
+class ArenaBackend {
+public:
+  static constexpr const char *kAllocName = "alloc_raw";
+  static constexpr const char *kDeallocName = "dealloc_raw";
+
+  explicit ArenaBackend(VisualizationArena &arena) : arena_{arena} {}
+
+  auto alloc(std::size_t size) -> void * {
+    return arena_.alloc_raw(size, 16, "bench");
+  }
+  void free(void *ptr, std::size_t size) { arena_.dealloc_raw(ptr, size); }
+
+private:
+  VisualizationArena &arena_;
+};
+
+// ─── Workloads (mirroring bench_allocator.cpp) ──────────────────────────
+
+template <typename Backend>
+auto timed_alloc(Backend &b, OpHistograms &h, std::size_t size) -> void * {
+  const auto t0 = CycleClock::start();
+  void *p = b.alloc(size);
+  const auto t1 = CycleClock::stop();
+  h.alloc.record(t1 - t0);
+  return p;
+}
+
+template <typename Backend>
+void timed_free(Backend &b, OpHistograms &h, void *ptr, std::size_t size) {
+  const auto t0 = CycleClock::start();
+  b.free(ptr, size);
+  const auto t1 = CycleClock::stop();
+  h.dealloc.record(t1 - t0);
+}
+
+/// @brief BM_AllocateDealloc64B: a 64B allocate immediately freed.
+template <typename Backend>
+void alloc_dealloc_64(benchmark::State &state, Backend &b, OpHistograms &h) {
+  for (auto _ : state) {
+    void *p = timed_alloc(b, h, 64);
+    if (p == nullptr) {
+      state.SkipWithError("OOM");
+      break;
+    }
+    timed_free(b, h, p, 64);
+  }
+}
+
+/// @brief BM_AllocateVarySizes: cycling 32B..4KB requests. Blocks are kept
+/// in a FIFO window and the oldest is freed, so the run never exhausts the
+/// arena and frees are measured too.
+template <typename Backend>
+void vary_sizes(benchmark::State &state, Backend &b, OpHistograms &h) {
+  constexpr std::size_t kSizes[] = {32, 64, 128, 256, 512, 1024, 2048, 4096};
+  constexpr std::size_t kWindow = 256;
+  std::array<std::pair<void *, std::size_t>, kWindow> live{};
+  std::size_t idx = 0;
+
+  for (auto _ : state) {
+    auto &slot = live[idx % kWindow];
+    if (slot.first != nullptr) {
+      timed_free(b, h, slot.first, slot.second);
+    }
+    const std::size_t size = kSizes[idx % 8];
+    slot = {timed_alloc(b, h, size), size};
+    if (slot.first == nullptr) {
+      state.SkipWithError("OOM");
+      break;
+    }
+    ++idx;
+  }
+
+  for (auto &[p, size] : live) {
+    if (p != nullptr) {
+      b.free(p, size);
+    }
+  }
+}
+
+/// @brief BM_FragmentedAllocDealloc: 128B alloc/free pairs over 100 x 256B
+/// blocks with every other one freed.
+template <typename Backend>
+void fragmented(benchmark::State &state, Backend &b, OpHistograms &h) {
+  std::vector<void *> blocks;
+  for (int i = 0; i < 100; ++i) {
+    if (void *p = b.alloc(256)) {
+      blocks.push_back(p);
+    }
+  }
+  for (std::size_t i = 0; i < blocks.size(); i += 2) {
+    b.free(blocks[i], 256);
+    blocks[i] = nullptr;
+  }
+
+  for (auto _ : state) {
+    void *p = timed_alloc(b, h, 128);
+    if (p == nullptr) {
+      state.SkipWithError("OOM");
+      break;
+    }
+    timed_free(b, h, p, 128);
+  }
+
+  for (void *p : blocks) {
+    if (p != nullptr) {
+      b.free(p, 256);
+    }
+  }
+}
+
+template <typename Backend>
+using Workload = void (*)(benchmark::State &, Backend &, OpHistograms &);
+
+// ─── Benchmarks ─────────────────────────────────────────────────────────
+
+constexpr std::size_t kFreeListArena = 4 * 1024 * 1024;
+constexpr std::size_t kVisualizationArena = 256 * 1024 * 1024;
+
+template <Workload<FreeListBackend> Fn>
+void BM_FreeListLatency(benchmark::State &state) {
+  static MergedHistograms shared;
+  begin_run(state, shared);
+
+  FreeListBackend backend{kFreeListArena};
+  OpHistograms local;
+  Fn(state, backend, local);
+
+  end_run(state, shared, local, FreeListBackend::kAllocName,
+          FreeListBackend::kDeallocName);
+}
+
+template <Workload<ArenaBackend> Fn>
+void BM_ArenaLatency(benchmark::State &state) {
+  // One arena for the whole process: every thread may touch it before the
+  // start barrier (fragmented() sets up outside the timed loop), and every
+  // workload frees what it allocates.
+  static auto arena =
+      VisualizationArena::create({.arena_size = kVisualizationArena,
+                                  .enable_server = false,
+                                  .sampling = 1})
+          .value();
+  static MergedHistograms shared;
+  begin_run(state, shared);
+
+  ArenaBackend backend{arena};
+  OpHistograms local;
+  Fn(state, backend, local);
+
+  end_run(state, shared, local, ArenaBackend::kAllocName,
+          ArenaBackend::kDeallocName);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_FreeListLatency, alloc_dealloc_64<FreeListBackend>)
+    ->ThreadRange(1, kMaxThreads);
+BENCHMARK_TEMPLATE(BM_FreeListLatency, vary_sizes<FreeListBackend>)
+    ->ThreadRange(1, kMaxThreads);
+BENCHMARK_TEMPLATE(BM_FreeListLatency, fragmented<FreeListBackend>)
+    ->ThreadRange(1, kMaxThreads);
+
+BENCHMARK_TEMPLATE(BM_ArenaLatency, alloc_dealloc_64<ArenaBackend>)
+    ->ThreadRange(1, kMaxThreads);
+BENCHMARK_TEMPLATE(BM_ArenaLatency, vary_sizes<ArenaBackend>)
+    ->ThreadRange(1, kMaxThreads);
+BENCHMARK_TEMPLATE(BM_ArenaLatency, fragmented<ArenaBackend>)
+    ->ThreadRange(1, kMaxThreads);
+
+BENCHMARK_MAIN();
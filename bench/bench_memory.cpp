@@ -0,0 +1,415 @@
+/// @file bench_memory.cpp
+/// @brief Space-efficiency benchmark: peak footprint, per-block metadata
+///        overhead and fragmentation over time, emitted as JSON.
+///
+/// Throughput benchmarks say nothing about how much memory we waste. This
+/// tool replays deterministic workloads (uniform sizes, powers of two, the
+/// server_sim request mix, and grow/shrink waves) against the headerless
+/// FreeListAllocator and the headered VisualizationArena, and reports:
+///   - peak arena bytes (allocator accounting) vs. peak requested bytes,
+///   - metadata overhead per block (header, footer, alignment padding,
+///     size-class rounding),
+///   - a time series of live bytes, free block count, largest free block and
+///     external fragmentation for plotting.
+///
+/// Usage: memory_mapper_bench_memory [output.json]   (default: stdout)
+
+#include "bench_common.hpp"
+
+#include "allocator/arena.hpp"
+#include "allocator/free_list.hpp"
+#include "interface/visualization_arena.hpp"
+#include "tracker/block_metadata.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace mmap_viz;
+
+namespace {
+
+/// Capacity available to a single-threaded workload. VisualizationArena
+/// splits its arena into 256 shards and a single thread only ever uses its
+/// home shard, so it is sized so that one shard matches this.
+constexpr std::size_t kWorkingSet = 16ull * 1024 * 1024;
+constexpr std::size_t kShards = 256;
+constexpr std::size_t kSampleEvery = 1000;
+
+/// Seeded identically per run so every allocator sees the same op sequence.
+using Rng = bench::FastRng;
+
+// ─── Backends ───────────────────────────────────────────────────────────
+
+/// @brief What a backend reports for one allocation.
+struct Placement {
+  void *ptr = nullptr;
+  std::byte *block_start = nullptr; ///< Start of the allocator block.
+  std::size_t block_size = 0;       ///< Bytes consumed in the allocator.
+  std::size_t header = 0;
+  std::size_t footer = 0;
+  std::size_t padding = 0;
+};
+
+/// @brief Raw FreeListAllocator: no per-block metadata at all.
+class FreeListBackend {
+public:
+  static constexpr const char *kName = "free_list";
+
+  FreeListBackend()
+      : arena_{Arena::create(kWorkingSet).value()},
+        alloc_{arena_.base(), arena_.capacity()} {}
+
+  auto alloc(std::size_t size) -> Placement {
+    auto r = alloc_.allocate(size, 16);
+    if (!r.has_value()) {
+      return {};
+    }
+    return {.ptr = r->ptr, .block_start = r->ptr, .block_size = r->actual_size};
+  }
+
+  void free(const Placement &p, std::size_t /*size*/) {
+    (void)alloc_.deallocate(p.block_start, p.block_size);
+  }
+
+  [[nodiscard]] auto free_list() const -> const FreeListAllocator * {
+    return &alloc_;
+  }
+
+private:
+  Arena arena_;
+  FreeListAllocator alloc_;
+};
+
+/// @brief VisualizationArena: AllocationHeader + uint32 footer per block.
+class ArenaBackend {
+public:
+  static constexpr const char *kName = "visualization_arena";
+
+  ArenaBackend()
+      : arena_{VisualizationArena::create({.arena_size = kWorkingSet * kShards,
+                                           .enable_server = false,
+                                           .sampling = 1})
+                   .value()} {}
+
+  auto alloc(std::size_t size) -> Placement {
+    // The façade does not expose the block size, so derive it from the
+    // allocator accounting (single-threaded, so nothing else moves it).
+    const auto before = arena_.bytes_allocated();
+    void *p = arena_.alloc_raw(size, kAlign, "bench");
+    if (p == nullptr) {
+      return {};
+    }
+    const auto consumed = arena_.bytes_allocated() - before;
+
+    constexpr std::size_t kHeader = sizeof(AllocationHeader);
+    constexpr std::size_t kFooter = sizeof(std::uint32_t);
+    constexpr std::size_t kPadding =
+        (kAlign - (kHeader + kFooter) % kAlign) % kAlign;
+    constexpr std::size_t kOffset = kHeader + kFooter + kPadding;
+
+    return {.ptr = p,
+            .block_start = static_cast<std::byte *>(p) - kOffset,
+            .block_size = consumed,
+            .header = kHeader,
+            .footer = kFooter,
+            .padding = kPadding};
+  }
+
+  void free(const Placement &p, std::size_t size) {
+    arena_.dealloc_raw(p.ptr, size);
+  }
+
+  /// Fragmentation is only meaningful for the home shard, which the façade
+  /// does not expose.
+  [[nodiscard]] auto free_list() const -> const FreeListAllocator * {
+    return nullptr;
+  }
+
+private:
+  static constexpr std::size_t kAlign = 16;
+  VisualizationArena arena_;
+};
+
+// ─── Measurement driver ─────────────────────────────────────────────────
+
+/// @brief Tracks live blocks and accumulates every reported metric.
+template <typename Backend> class Driver {
+public:
+  explicit Driver(Backend &backend) : backend_{backend} {}
+
+  /// @return false on OOM (the run is reported as truncated).
+  auto alloc(std::size_t size) -> bool {
+    auto p = backend_.alloc(size);
+    if (p.ptr == nullptr) {
+      oom_ = true;
+      return false;
+    }
+    live_.push_back({p, size});
+    requested_ += size;
+    allocated_ += p.block_size;
+
+    ++total_blocks_;
+    header_ += p.header;
+    footer_ += p.footer;
+    padding_ += p.padding;
+    rounding_ += p.block_size - size - p.header - p.footer - p.padding;
+
+    lowest_ = std::min(lowest_, p.block_start);
+    highest_ = std::max(highest_, p.block_start + p.block_size);
+    peak_requested_ = std::max(peak_requested_, requested_);
+    peak_allocated_ = std::max(peak_allocated_, allocated_);
+    tick();
+    return true;
+  }
+
+  /// @brief Free the live block at @p index (swap-remove).
+  void free_at(std::size_t index) {
+    auto [p, size] = live_[index];
+    live_[index] = live_.back();
+    live_.pop_back();
+    backend_.free(p, size);
+    requested_ -= size;
+    allocated_ -= p.block_size;
+    tick();
+  }
+
+  void free_random(Rng &rng) { free_at(rng.next() % live_.size()); }
+
+  void free_all() {
+    while (!live_.empty()) {
+      free_at(live_.size() - 1);
+    }
+  }
+
+  [[nodiscard]] auto live() const -> std::size_t { return live_.size(); }
+  [[nodiscard]] auto oom() const -> bool { return oom_; }
+
+  [[nodiscard]] auto result(const char *workload) const -> nlohmann::json {
+    const auto blocks =
+        static_cast<double>(std::max<std::size_t>(1, total_blocks_));
+    const auto metadata = header_ + footer_ + padding_ + rounding_;
+    return {
+        {"workload", workload},
+        {"allocator", Backend::kName},
+        {"ops", ops_},
+        {"truncated_by_oom", oom_},
+        {"peak_requested_bytes", peak_requested_},
+        {"peak_allocated_bytes", peak_allocated_},
+        {"peak_span_bytes",
+         highest_ > lowest_ ? static_cast<std::size_t>(highest_ - lowest_) : 0},
+        {"space_efficiency",
+         peak_allocated_ == 0 ? 0.0
+                              : static_cast<double>(peak_requested_) /
+                                    static_cast<double>(peak_allocated_)},
+        {"overhead_per_block",
+         {{"blocks", total_blocks_},
+          {"header", static_cast<double>(header_) / blocks},
+          {"footer", static_cast<double>(footer_) / blocks},
+          {"padding", static_cast<double>(padding_) / blocks},
+          {"rounding", static_cast<double>(rounding_) / blocks},
+          {"total", static_cast<double>(metadata) / blocks}}},
+        {"series", series_},
+    };
+  }
+
+private:
+  void tick() {
+    if (++ops_ % kSampleEvery != 0) {
+      return;
+    }
+    nlohmann::json s = {
+        {"op", ops_},
+        {"live_blocks", live_.size()},
+        {"requested_bytes", requested_},
+        {"allocated_bytes", allocated_},
+    };
+    // External fragmentation: share of free memory not usable for the
+    // largest possible request.
+    if (const FreeListAllocator *a = backend_.free_list()) {
+      const auto free = a->bytes_free();
+      const auto largest = a->largest_free_block();
+      s["free_blocks"] = a->free_block_count();
+      s["largest_free_block"] = largest;
+      s["fragmentation"] =
+          free == 0 ? 0.0
+                    : 1.0 - static_cast<double>(largest) /
+                                static_cast<double>(free);
+    }
+    series_.push_back(std::move(s));
+  }
+
+  struct Live {
+    Placement placement;
+    std::size_t size;
+  };
+
+  Backend &backend_;
+  std::vector<Live> live_;
+
+  std::size_t ops_ = 0;
+  bool oom_ = false;
+
+  std::size_t requested_ = 0;
+  std::size_t allocated_ = 0;
+  std::size_t peak_requested_ = 0;
+  std::size_t peak_allocated_ = 0;
+  std::byte *lowest_ = reinterpret_cast<std::byte *>(UINTPTR_MAX);
+  std::byte *highest_ = nullptr;
+
+  std::size_t total_blocks_ = 0;
+  std::size_t header_ = 0;
+  std::size_t footer_ = 0;
+  std::size_t padding_ = 0;
+  std::size_t rounding_ = 0;
+
+  nlohmann::json series_ = nlohmann::json::array();
+};
+
+// ─── Workloads ──────────────────────────────────────────────────────────
+
+constexpr std::size_t kSteadyOps = 200'000;
+constexpr std::size_t kSteadyLive = 2048;
+
+/// @brief Random alloc/free around a steady live-block target.
+template <typename D, typename SizeFn>
+void steady_state(D &d, Rng &rng, SizeFn size_fn) {
+  for (std::size_t i = 0; i < kSteadyOps && !d.oom(); ++i) {
+    if (d.live() < kSteadyLive / 2 ||
+        (d.live() < kSteadyLive && (rng.next() & 1) != 0)) {
+      d.alloc(size_fn(rng));
+    } else {
+      d.free_random(rng);
+    }
+  }
+}
+
+template <typename D> void uniform(D &d, Rng &rng) {
+  steady_state(d, rng, [](Rng &r) { return r.between(16, 4096); });
+}
+
+template <typename D> void power_of_two(D &d, Rng &rng) {
+  steady_state(d, rng,
+               [](Rng &r) { return std::size_t{1} << r.between(4, 12); });
+}
+
+/// @brief The server_sim request mix: request buffer, response buffer,
+/// request freed; STREAM responses stay alive (bounded FIFO here so the
+/// run reaches a steady state), everything else is freed immediately.
+template <typename D> void server_mix(D &d, Rng &rng) {
+  constexpr std::size_t kRequests = 50'000;
+  constexpr std::size_t kMaxStreams = 128;
+
+  for (std::size_t i = 0; i < kRequests && !d.oom(); ++i) {
+    // GET=50%, POST=20%, PUT=15%, DELETE=10%, STREAM=5%.
+    const auto roll = rng.between(0, 19);
+    std::size_t payload = 0;
+    std::size_t response = 0;
+    const bool stream = roll == 19;
+    if (roll < 10) {
+      payload = rng.between(0, 64);
+      response = rng.between(64, 512);
+    } else if (roll < 17) {
+      payload = rng.between(32, 8192);
+      response = rng.between(32, 256);
+    } else if (roll < 19) {
+      payload = rng.between(0, 32);
+      response = rng.between(16, 64);
+    } else {
+      payload = rng.between(32, 4096);
+      response = rng.between(4096, 65536);
+    }
+
+    if (payload > 0 && !d.alloc(payload)) {
+      break;
+    }
+    if (!d.alloc(response)) {
+      break;
+    }
+    // The response is the newest block; the request (if any) sits before it.
+    if (payload > 0) {
+      d.free_at(d.live() - 2);
+    }
+    if (stream) {
+      // Only stream buffers outlive their request, so a random live block
+      // is always a stream buffer.
+      if (d.live() > kMaxStreams) {
+        d.free_random(rng);
+      }
+    } else {
+      d.free_at(d.live() - 1);
+    }
+  }
+}
+
+/// @brief Grow to a peak, free 90% in random order, repeat.
+template <typename D> void waves(D &d, Rng &rng) {
+  constexpr int kWaves = 4;
+  constexpr std::size_t kPeak = 4096;
+  for (int w = 0; w < kWaves && !d.oom(); ++w) {
+    while (d.live() < kPeak && d.alloc(rng.between(16, 2048))) {
+    }
+    while (d.live() > kPeak / 10) {
+      d.free_random(rng);
+    }
+  }
+}
+
+template <typename Backend, typename Fn>
+auto run(const char *name, Fn workload) -> nlohmann::json {
+  Backend backend;
+  Driver<Backend> d{backend};
+  Rng rng{42};
+  workload(d, rng);
+  auto result = d.result(name);
+  d.free_all();
+  return result;
+}
+
+template <typename Backend> void run_all(nlohmann::json &out) {
+  using D = Driver<Backend>;
+  out.push_back(run<Backend>("uniform", uniform<D>));
+  out.push_back(run<Backend>("power_of_two", power_of_two<D>));
+  out.push_back(run<Backend>("server_sim", server_mix<D>));
+  out.push_back(run<Backend>("waves", waves<D>));
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  nlohmann::json results = nlohmann::json::array();
+  run_all<FreeListBackend>(results);
+  run_all<ArenaBackend>(results);
+
+  const nlohmann::json report = {
+      {"benchmark", "memory_overhead"},
+      {"working_set_bytes", kWorkingSet},
+      {"sample_every_ops", kSampleEvery},
+      {"results", results},
+  };
+
+  // Human-readable summary on stderr, JSON for plotting on stdout/file.
+  for (const auto &r : results) {
+    std::cerr << r["workload"].get<std::string>() << " / "
+              << r["allocator"].get<std::string>()
+              << ": peak requested=" << r["peak_requested_bytes"]
+              << " peak allocated=" << r["peak_allocated_bytes"]
+              << " efficiency=" << r["space_efficiency"]
+              << " overhead/block=" << r["overhead_per_block"]["total"]
+              << "\n";
+  }
+
+  if (argc > 1) {
+    std::ofstream file(argv[1]);
+    file << report.dump(2) << "\n";
+  } else {
+    std::cout << report.dump(2) << "\n";
+  }
+  return 0;
+}
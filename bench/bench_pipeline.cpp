@@ -0,0 +1,343 @@
+/// @file bench_pipeline.cpp
+/// @brief End-to-end latency from alloc_raw() to WebSocket client receipt.
+///
+/// Measures how stale the dashboard is: every allocation carries its
+/// steady_clock timestamp in the tag ("t:<ns>"), travels through the
+/// thread-local ring → batcher → JSON → broadcast → socket, and in-process
+/// Beast clients compute receive-time minus stamp. Because the producer
+/// mirrors the tracker's sampling counter, it knows exactly how many
+/// events every client should have seen, which gives the drop rate.
+///
+/// Sweeps event rate × client count × sampling level and prints one row
+/// per configuration.
+
+#include "latency_histogram.hpp"
+
+#include "interface/visualization_arena.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace mmap_viz;
+
+namespace {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace ws = beast::websocket;
+using tcp = net::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+// ─── CLI ────────────────────────────────────────────────────────────────
+
+struct PipelineArgs {
+  std::vector<std::size_t> rates = {10'000, 100'000, 1'000'000, 10'000'000};
+  std::vector<std::size_t> clients = {1, 8, 32};
+  std::vector<std::size_t> sampling = {1, 16, 256};
+  std::size_t duration_ms = 1000;
+  unsigned short port = 9100;
+};
+
+void print_usage(const char *prog) {
+  std::cout
+      << "Usage: " << prog << " [options]\n\n"
+      << "Options:\n"
+      << "  --rates <a,b,..>     Target events/sec (default: "
+         "10000,100000,1000000,10000000)\n"
+      << "  --clients <a,b,..>   WebSocket client counts (default: 1,8,32)\n"
+      << "  --sampling <a,b,..>  Event sampling levels (default: 1,16,256)\n"
+      << "  --duration-ms <N>    Producer run time per configuration "
+         "(default: 1000)\n"
+      << "  --port <N>           Server port (default: 9100)\n"
+      << "  --help               Show this help\n";
+}
+
+auto parse_list(const std::string &s) -> std::vector<std::size_t> {
+  std::vector<std::size_t> out;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) {
+      out.push_back(std::stoull(item));
+    }
+  }
+  return out;
+}
+
+auto parse_args(int argc, char *argv[]) -> PipelineArgs {
+  PipelineArgs args;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      print_usage(argv[0]);
+      std::exit(0);
+    } else if (arg == "--rates" && i + 1 < argc) {
+      args.rates = parse_list(argv[++i]);
+    } else if (arg == "--clients" && i + 1 < argc) {
+      args.clients = parse_list(argv[++i]);
+    } else if (arg == "--sampling" && i + 1 < argc) {
+      args.sampling = parse_list(argv[++i]);
+    } else if (arg == "--duration-ms" && i + 1 < argc) {
+      args.duration_ms = std::stoull(argv[++i]);
+    } else if (arg == "--port" && i + 1 < argc) {
+      args.port = static_cast<unsigned short>(std::stoul(argv[++i]));
+    }
+  }
+  return args;
+}
+
+auto now_ns() -> std::uint64_t {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now().time_since_epoch())
+          .count());
+}
+
+// ─── Client ─────────────────────────────────────────────────────────────
+
+/// @brief WebSocket client that timestamps stamped events on receipt.
+///
+/// Frames are scanned for `"tag":"t:` rather than parsed, so the client
+/// stays far cheaper than the server and does not distort the result.
+class LatencyClient {
+public:
+  explicit LatencyClient(net::io_context &ioc) : ws_{ioc} {}
+
+  auto connect(unsigned short port) -> bool {
+    beast::error_code ec;
+    beast::get_lowest_layer(ws_).connect(
+        tcp::endpoint{net::ip::make_address("127.0.0.1"), port}, ec);
+    if (!ec) {
+      ws_.handshake("127.0.0.1", "/ws", ec);
+    }
+    return !ec;
+  }
+
+  void start() { do_read(); }
+
+  void close() {
+    beast::error_code ec;
+    beast::get_lowest_layer(ws_).socket().close(ec);
+  }
+
+  [[nodiscard]] auto received() const -> std::uint64_t { return received_; }
+  [[nodiscard]] auto histogram() const -> const bench::LatencyHistogram & {
+    return latency_ns_;
+  }
+
+private:
+  void do_read() {
+    ws_.async_read(buffer_, [this](beast::error_code ec, std::size_t) {
+      if (ec) {
+        return;
+      }
+      on_frame();
+      buffer_.consume(buffer_.size());
+      do_read();
+    });
+  }
+
+  void on_frame() {
+    const auto t = now_ns();
+    auto data = buffer_.cdata();
+    std::string_view frame{static_cast<const char *>(data.data()),
+                           data.size()};
+    // Event batches are arrays; the initial snapshot is an object whose
+    // blocks also carry tags, so skip it.
+    if (frame.empty() || frame.front() != '[') {
+      return;
+    }
+
+    constexpr std::string_view kStamp = R"("tag":"t:)";
+    for (auto pos = frame.find(kStamp); pos != std::string_view::npos;
+         pos = frame.find(kStamp, pos)) {
+      pos += kStamp.size();
+      std::uint64_t stamp = 0;
+      auto [end, err] =
+          std::from_chars(frame.data() + pos, frame.data() + frame.size(),
+                          stamp);
+      if (err == std::errc{}) {
+        ++received_;
+        latency_ns_.record(t > stamp ? t - stamp : 0);
+      }
+    }
+  }
+
+  ws::stream<beast::tcp_stream> ws_;
+  beast::flat_buffer buffer_;
+  std::uint64_t received_ = 0;
+  bench::LatencyHistogram latency_ns_;
+};
+
+// ─── One configuration ──────────────────────────────────────────────────
+
+struct RunResult {
+  double achieved_rate = 0;
+  std::uint64_t expected = 0; ///< Stamped events each client should see.
+  std::uint64_t received_min = 0;
+  double received_avg = 0;
+  std::size_t connected = 0;
+  bench::LatencyHistogram latency_ns;
+};
+
+constexpr std::size_t kBlockSize = 64;
+constexpr std::size_t kClientThreads = 4;
+
+auto run_config(const PipelineArgs &args, std::size_t rate,
+                std::size_t num_clients, std::size_t sampling) -> RunResult {
+  RunResult result;
+
+  auto va = VisualizationArena::create({.arena_size = 1024 * 1024 * 1024,
+                                        .enable_server = true,
+                                        .port = args.port,
+                                        .sampling = sampling});
+  if (!va.has_value()) {
+    std::cerr << "arena creation failed: " << va.error().message() << "\n";
+    return result;
+  }
+
+  // Clients are spread over a few io threads; each client is only touched
+  // by its own io_context, so per-client state needs no locking.
+  std::vector<std::unique_ptr<net::io_context>> iocs;
+  for (std::size_t i = 0; i < std::min(kClientThreads, num_clients); ++i) {
+    iocs.push_back(std::make_unique<net::io_context>(1));
+  }
+  std::vector<std::unique_ptr<LatencyClient>> clients;
+  for (std::size_t i = 0; i < num_clients; ++i) {
+    auto c = std::make_unique<LatencyClient>(*iocs[i % iocs.size()]);
+    // The server thread may still be starting up.
+    bool ok = false;
+    for (int attempt = 0; attempt < 50 && !ok; ++attempt) {
+      ok = c->connect(args.port);
+      if (!ok) {
+        c = std::make_unique<LatencyClient>(*iocs[i % iocs.size()]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+    }
+    if (ok) {
+      c->start();
+      clients.push_back(std::move(c));
+    }
+  }
+  result.connected = clients.size();
+
+  std::vector<std::thread> io_threads;
+  for (auto &ioc : iocs) {
+    io_threads.emplace_back([&ioc] { ioc->run(); });
+  }
+
+  // Producer: every 1ms tick allocate rate/1000 stamped blocks, then free
+  // them. Allocations are grouped so that the sampled subset (every
+  // `sampling`-th tracker event) includes stamped allocate events.
+  const std::size_t per_tick = std::max<std::size_t>(1, rate / 1000);
+  const auto start = Clock::now();
+  const auto deadline = start + std::chrono::milliseconds(args.duration_ms);
+  auto next_tick = start;
+  std::uint64_t events = 0; // Mirrors LocalTracker's event counter.
+  std::uint64_t allocs = 0;
+  std::vector<void *> live;
+  live.reserve(per_tick);
+  char tag[32];
+
+  while (Clock::now() < deadline) {
+    for (std::size_t i = 0; i < per_tick; ++i) {
+      std::snprintf(tag, sizeof(tag), "t:%llu",
+                    static_cast<unsigned long long>(now_ns()));
+      void *p = va->alloc_raw(kBlockSize, 16, tag);
+      if (p == nullptr) {
+        continue;
+      }
+      live.push_back(p);
+      ++allocs;
+      if (++events % sampling == 0) {
+        ++result.expected;
+      }
+    }
+    for (void *p : live) {
+      va->dealloc_raw(p, kBlockSize);
+      ++events;
+    }
+    live.clear();
+
+    next_tick += std::chrono::milliseconds(1);
+    while (Clock::now() < next_tick) {
+      std::this_thread::yield();
+    }
+  }
+  const auto elapsed =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  result.achieved_rate = static_cast<double>(allocs) / elapsed;
+
+  // Let the batcher flush (16ms cadence) and the sockets drain.
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+  for (auto &ioc : iocs) {
+    ioc->stop();
+  }
+  for (auto &t : io_threads) {
+    t.join();
+  }
+
+  result.received_min = clients.empty() ? 0 : UINT64_MAX;
+  std::uint64_t received_total = 0;
+  for (auto &c : clients) {
+    result.received_min = std::min(result.received_min, c->received());
+    received_total += c->received();
+    result.latency_ns.merge(c->histogram());
+    c->close();
+  }
+  result.received_avg =
+      clients.empty() ? 0.0
+                      : static_cast<double>(received_total) /
+                            static_cast<double>(clients.size());
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  auto args = parse_args(argc, argv);
+
+  std::printf("%10s %8s %8s %12s %10s %10s %7s %9s %9s %9s %9s %9s\n",
+              "rate", "clients", "sampling", "achieved/s", "expected",
+              "recv/cli", "drop%", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms",
+              "max ms");
+
+  for (auto sampling : args.sampling) {
+    for (auto clients : args.clients) {
+      for (auto rate : args.rates) {
+        auto r = run_config(args, rate, clients, sampling);
+        const auto &h = r.latency_ns;
+        const double drop =
+            r.expected == 0 ? 0.0
+                            : 100.0 * (1.0 - r.received_avg /
+                                                 static_cast<double>(
+                                                     r.expected));
+        auto ms = [](std::uint64_t ns) {
+          return static_cast<double>(ns) / 1e6;
+        };
+        std::printf(
+            "%10zu %4zu/%-3zu %8zu %12.0f %10llu %10.0f %7.2f %9.3f %9.3f "
+            "%9.3f %9.3f %9.3f\n",
+            rate, r.connected, clients, sampling, r.achieved_rate,
+            static_cast<unsigned long long>(r.expected), r.received_avg,
+            drop, ms(h.percentile(0.50)), ms(h.percentile(0.90)),
+            ms(h.percentile(0.99)), ms(h.percentile(0.999)), ms(h.max()));
+        std::fflush(stdout);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,233 @@
+/// @file bench_pmr.cpp
+/// @brief std::pmr container workloads on TrackedResource and friends.
+///
+/// Most code reaches the arena through `std::pmr` containers backed by
+/// VisualizationArena::resource() (a TrackedResource), so that is the
+/// path whose cost matters in practice. Every container workload runs on:
+///   - `NewDelete`:  std::pmr::new_delete_resource() (baseline),
+///   - `Tracked`:    TrackedResource directly,
+///   - `UnsyncPool`: std::pmr::unsynchronized_pool_resource over Tracked,
+///   - `SyncPool`:   std::pmr::synchronized_pool_resource over Tracked,
+///   - `TrackedUnsyncPool` / `TrackedSyncPool`: TrackedPoolResource, which
+///     carves nodes from arena chunks and reports chunk occupancy.
+///
+/// The BM_Overhead_* group isolates the two costs TrackedResource adds on
+/// top of alloc_raw(): the virtual memory_resource dispatch, and building
+/// and clearing the per-allocation tag string.
+
+#include "allocator/tracked_pool_resource.hpp"
+#include "allocator/tracked_resource.hpp"
+#include "interface/visualization_arena.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace mmap_viz;
+
+namespace {
+
+/// One process-wide arena. A single thread only uses its home shard
+/// (1/256 of the arena), so 4GB leaves each benchmark 16MB; pages are
+/// only touched as they are used.
+auto tracked_arena() -> VisualizationArena & {
+  static auto va =
+      VisualizationArena::create({.arena_size = 4096ull * 1024 * 1024,
+                                  .enable_server = false,
+                                  .sampling = 1})
+          .value();
+  return va;
+}
+
+// ─── Resources ──────────────────────────────────────────────────────────
+
+struct NewDelete {
+  auto get() -> std::pmr::memory_resource * {
+    return std::pmr::new_delete_resource();
+  }
+};
+
+struct Tracked {
+  auto get() -> std::pmr::memory_resource * {
+    return tracked_arena().resource();
+  }
+};
+
+/// Pools are rebuilt per benchmark run so their chunks are returned to the
+/// arena between runs.
+struct UnsyncPool {
+  std::pmr::unsynchronized_pool_resource pool{tracked_arena().resource()};
+  auto get() -> std::pmr::memory_resource * { return &pool; }
+};
+
+struct SyncPool {
+  std::pmr::synchronized_pool_resource pool{tracked_arena().resource()};
+  auto get() -> std::pmr::memory_resource * { return &pool; }
+};
+
+struct TrackedUnsyncPool {
+  UnsynchronizedTrackedPoolResource pool{tracked_arena()};
+  auto get() -> std::pmr::memory_resource * { return &pool; }
+};
+
+struct TrackedSyncPool {
+  SynchronizedTrackedPoolResource pool{tracked_arena()};
+  auto get() -> std::pmr::memory_resource * { return &pool; }
+};
+
+// ─── Container workloads ────────────────────────────────────────────────
+
+/// @brief push_back N ints into an unreserved vector (geometric regrowth).
+template <typename Resource> void BM_PmrVectorGrowth(benchmark::State &state) {
+  Resource res;
+  const auto n = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    std::pmr::vector<int> v{res.get()};
+    for (int i = 0; i < n; ++i) {
+      v.push_back(i);
+    }
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+/// @brief Steady-state insert/erase churn on a map of N live entries.
+template <typename Resource>
+void BM_PmrUnorderedMapChurn(benchmark::State &state) {
+  Resource res;
+  const auto n = static_cast<std::uint64_t>(state.range(0));
+  std::pmr::unordered_map<std::uint64_t, std::uint64_t> m{res.get()};
+  for (std::uint64_t i = 0; i < n; ++i) {
+    m.emplace(i, i);
+  }
+  std::uint64_t next = n;
+  for (auto _ : state) {
+    m.erase(next - n);
+    m.emplace(next, next);
+    ++next;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// @brief Build a string of N bytes from 16-byte appends.
+template <typename Resource> void BM_PmrStringBuild(benchmark::State &state) {
+  Resource res;
+  const auto n = static_cast<std::size_t>(state.range(0));
+  const std::string chunk(16, 'x');
+  for (auto _ : state) {
+    std::pmr::string s{res.get()};
+    while (s.size() < n) {
+      s.append(chunk);
+    }
+    benchmark::DoNotOptimize(s.data());
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(n));
+}
+
+/// @brief Node churn on an ordered map of N live entries.
+template <typename Resource> void BM_PmrMapNodeChurn(benchmark::State &state) {
+  Resource res;
+  const auto n = static_cast<std::uint64_t>(state.range(0));
+  std::pmr::map<std::uint64_t, std::uint64_t> m{res.get()};
+  for (std::uint64_t i = 0; i < n; ++i) {
+    m.emplace(i, i);
+  }
+  std::uint64_t next = n;
+  for (auto _ : state) {
+    m.erase(m.begin());
+    m.emplace_hint(m.end(), next, next);
+    ++next;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// ─── Overhead breakdown ─────────────────────────────────────────────────
+
+constexpr std::size_t kOverheadSize = 64;
+
+/// @brief alloc_raw/dealloc_raw called directly: the floor for Tracked.
+void BM_Overhead_DirectAllocRaw(benchmark::State &state) {
+  auto &va = tracked_arena();
+  for (auto _ : state) {
+    void *p = va.alloc_raw(kOverheadSize, alignof(std::max_align_t), "");
+    benchmark::DoNotOptimize(p);
+    va.dealloc_raw(p, kOverheadSize);
+  }
+}
+
+/// @brief Same call through memory_resource::allocate (virtual dispatch,
+///        empty tag).
+void BM_Overhead_VirtualDispatch(benchmark::State &state) {
+  auto *res = tracked_arena().resource();
+  for (auto _ : state) {
+    void *p = res->allocate(kOverheadSize);
+    benchmark::DoNotOptimize(p);
+    res->deallocate(p, kOverheadSize);
+  }
+}
+
+/// @brief Virtual dispatch plus set_next_tag() before every allocation.
+///        Arg 0 uses a tag that fits the SSO buffer, arg 1 one that does not
+///        (heap-allocated std::string per allocation).
+void BM_Overhead_Tagged(benchmark::State &state) {
+  auto *res = static_cast<TrackedResource *>(tracked_arena().resource());
+  const char *tag = state.range(0) == 0 ? "http:GET"
+                                        : "http:GET /api/v1/users/profile";
+  for (auto _ : state) {
+    res->set_next_tag(tag);
+    void *p = res->allocate(kOverheadSize);
+    benchmark::DoNotOptimize(p);
+    res->deallocate(p, kOverheadSize);
+  }
+}
+
+/// @brief Pure dispatch cost: a virtual call into new_delete_resource vs.
+///        calling operator new directly.
+void BM_Overhead_NewDeleteDirect(benchmark::State &state) {
+  for (auto _ : state) {
+    void *p = ::operator new(kOverheadSize);
+    benchmark::DoNotOptimize(p);
+    ::operator delete(p, kOverheadSize);
+  }
+}
+
+void BM_Overhead_NewDeleteVirtual(benchmark::State &state) {
+  auto *res = std::pmr::new_delete_resource();
+  for (auto _ : state) {
+    void *p = res->allocate(kOverheadSize);
+    benchmark::DoNotOptimize(p);
+    res->deallocate(p, kOverheadSize);
+  }
+}
+
+} // namespace
+
+#define MMAP_VIZ_PMR_BENCH(Workload, lo, hi)                                   \
+  BENCHMARK_TEMPLATE(Workload, NewDelete)->RangeMultiplier(8)->Range(lo, hi);  \
+  BENCHMARK_TEMPLATE(Workload, Tracked)->RangeMultiplier(8)->Range(lo, hi);    \
+  BENCHMARK_TEMPLATE(Workload, UnsyncPool)->RangeMultiplier(8)->Range(lo, hi); \
+  BENCHMARK_TEMPLATE(Workload, SyncPool)->RangeMultiplier(8)->Range(lo, hi);   \
+  BENCHMARK_TEMPLATE(Workload, TrackedUnsyncPool)                              \
+      ->RangeMultiplier(8)                                                     \
+      ->Range(lo, hi);                                                         \
+  BENCHMARK_TEMPLATE(Workload, TrackedSyncPool)                                \
+      ->RangeMultiplier(8)                                                     \
+      ->Range(lo, hi)
+
+MMAP_VIZ_PMR_BENCH(BM_PmrVectorGrowth, 64, 64 << 10);
+MMAP_VIZ_PMR_BENCH(BM_PmrUnorderedMapChurn, 64, 16 << 10);
+MMAP_VIZ_PMR_BENCH(BM_PmrStringBuild, 64, 64 << 10);
+MMAP_VIZ_PMR_BENCH(BM_PmrMapNodeChurn, 64, 16 << 10);
+
+BENCHMARK(BM_Overhead_DirectAllocRaw);
+BENCHMARK(BM_Overhead_VirtualDispatch);
+BENCHMARK(BM_Overhead_Tagged)->Arg(0)->Arg(1);
+BENCHMARK(BM_Overhead_NewDeleteDirect);
+BENCHMARK(BM_Overhead_NewDeleteVirtual);
+
+BENCHMARK_MAIN();
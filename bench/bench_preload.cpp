@@ -0,0 +1,139 @@
+/// @file bench_preload.cpp
+/// @brief malloc/free workloads to compare the LD_PRELOAD interposer with
+///        glibc.
+///
+/// The binary only calls the C allocation functions, so the same build
+/// measures either allocator depending on how it is started (from the
+/// build directory):
+/// @code
+///   ./memory_mapper_bench_preload                                # glibc
+///   LD_PRELOAD=./libmmap_viz_preload.so ./memory_mapper_bench_preload  # arena
+/// @endcode
+/// The "allocator" context line in the header records which one ran, and
+/// the interposer's glibc fallback counts are printed at the end so a run
+/// that overflowed its shard is easy to spot.
+
+#include "preload/malloc_interposer.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// @brief One malloc/free pair per iteration.
+void BM_MallocFree(benchmark::State &state) {
+  const auto size = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    void *p = std::malloc(size);
+    benchmark::DoNotOptimize(p);
+    std::free(p);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// @brief Allocate N 64-byte blocks, then free them all (LIFO), so the
+///        allocator holds many live blocks at once.
+void BM_MallocBatch(benchmark::State &state) {
+  const auto n = static_cast<std::size_t>(state.range(0));
+  std::vector<void *> ptrs(n);
+  for (auto _ : state) {
+    for (auto &p : ptrs) {
+      p = std::malloc(64);
+      benchmark::DoNotOptimize(p);
+    }
+    for (auto it = ptrs.rbegin(); it != ptrs.rend(); ++it) {
+      std::free(*it);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(n));
+}
+
+/// @brief Grow a buffer from 16 B to N bytes by doubling realloc().
+void BM_ReallocGrow(benchmark::State &state) {
+  const auto n = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    void *p = nullptr;
+    for (std::size_t size = 16; size <= n; size *= 2) {
+      p = std::realloc(p, size);
+      benchmark::DoNotOptimize(p);
+    }
+    std::free(p);
+  }
+}
+
+/// @brief calloc/free pair; the arena zero-fills every block anyway.
+void BM_Calloc(benchmark::State &state) {
+  const auto size = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    void *p = std::calloc(1, size);
+    benchmark::DoNotOptimize(p);
+    std::free(p);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(size));
+}
+
+/// @brief posix_memalign at cache-line and page alignment.
+void BM_PosixMemalign(benchmark::State &state) {
+  const auto alignment = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    void *p = nullptr;
+    benchmark::DoNotOptimize(posix_memalign(&p, alignment, 256));
+    std::free(p);
+  }
+}
+
+/// @brief malloc/free of 64 B from several threads at once.
+void BM_MallocFreeThreaded(benchmark::State &state) {
+  for (auto _ : state) {
+    void *p = std::malloc(64);
+    benchmark::DoNotOptimize(p);
+    std::free(p);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_MallocFree)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_MallocBatch)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(BM_ReallocGrow)->Arg(4096)->Arg(1 << 20);
+BENCHMARK(BM_Calloc)->Arg(64)->Arg(4096);
+BENCHMARK(BM_PosixMemalign)->Arg(64)->Arg(4096);
+BENCHMARK(BM_MallocFreeThreaded)
+    ->ThreadRange(1, static_cast<int>(
+                         std::max(1u, std::thread::hardware_concurrency())));
+
+int main(int argc, char **argv) {
+  using StatsFn = void (*)(MmapVizPreloadStats *);
+  auto stats_fn = reinterpret_cast<StatsFn>(
+      ::dlsym(RTLD_DEFAULT, "mmap_viz_preload_stats"));
+  benchmark::AddCustomContext("allocator", stats_fn != nullptr
+                                               ? "mmap_viz (LD_PRELOAD)"
+                                               : "glibc");
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+  if (stats_fn != nullptr) {
+    MmapVizPreloadStats stats{};
+    stats_fn(&stats);
+    std::printf("interposer: %llu glibc passthrough, %llu shard overflow "
+                "allocations\n",
+                static_cast<unsigned long long>(stats.passthrough_allocs),
+                static_cast<unsigned long long>(stats.overflow_allocs));
+  }
+  return 0;
+}
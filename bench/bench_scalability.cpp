@@ -4,7 +4,9 @@
 #include "allocator/arena.hpp"
 #include "allocator/free_list.hpp"
 
+#include <algorithm>
 #include <benchmark/benchmark.h>
+#include <cstdint>
 #include <random>
 #include <vector>
 
@@ -82,4 +84,70 @@ static void BM_Scalability(benchmark::State &state) {
 // Range: 100 to 100,000 free blocks
 BENCHMARK(BM_Scalability)->RangeMultiplier(10)->Range(100, 10000);
 
+// Deallocate cost under heavy fragmentation. Tree-sized blocks (> 128 B,
+// so not the small lists) alternate kept / freed, leaving N free holes;
+// the timed part frees the kept blocks in random order, so each free
+// finds free neighbours on both sides and coalesces three blocks into one.
+static void BM_DeallocFragmented(benchmark::State &state) {
+  const auto num_blocks = static_cast<std::size_t>(state.range(0));
+  constexpr std::size_t kBlock = 192;
+
+  auto result = Arena::create((2 * num_blocks + 1) * kBlock + 4096);
+  if (!result.has_value()) {
+    state.SkipWithError("Failed to create arena (too large?)");
+    return;
+  }
+  Arena arena = std::move(*result);
+
+  std::mt19937_64 rng(42);
+  std::vector<std::byte *> keep;
+  std::vector<std::byte *> holes;
+  keep.reserve(num_blocks);
+  holes.reserve(num_blocks + 1);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      // A fresh allocator per round; the previous one's bitmap is freed.
+      FreeListAllocator alloc{arena.base(), arena.capacity()};
+      keep.clear();
+      holes.clear();
+      for (std::size_t i = 0; i < num_blocks; ++i) {
+        auto hole = alloc.allocate(kBlock, 16);
+        auto kept = alloc.allocate(kBlock, 16);
+        if (!hole || !kept) {
+          state.SkipWithError("Setup OOM");
+          return;
+        }
+        holes.push_back(hole->ptr);
+        keep.push_back(kept->ptr);
+      }
+      for (auto *ptr : holes) {
+        (void)alloc.deallocate(ptr, kBlock);
+      }
+      std::shuffle(keep.begin(), keep.end(), rng);
+      state.ResumeTiming();
+
+      for (auto *ptr : keep) {
+        benchmark::DoNotOptimize(alloc.deallocate(ptr, kBlock));
+      }
+
+      state.PauseTiming();
+      if (alloc.free_block_count() != 1) {
+        state.SkipWithError("Free blocks did not coalesce");
+      }
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(num_blocks));
+  state.counters["free_blocks"] = static_cast<double>(num_blocks);
+}
+
+// 1,000 to 1,000,000 free blocks; items/s is frees per second.
+BENCHMARK(BM_DeallocFragmented)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
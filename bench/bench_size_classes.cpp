@@ -0,0 +1,119 @@
+/// @file bench_size_classes.cpp
+/// @brief Internal fragmentation and throughput per size-class scheme.
+///
+/// Random steady-state churn (free a random live block, allocate a new
+/// one) over FreeListAllocator with each scheme:
+///
+///   Linear     8 classes, 16..128 B (FreeListAllocator)
+///   Geometric  20 classes, 4 per doubling up to 1 KB
+///   Profiled   20 classes fitted to tools/server_mix_sizes.txt
+///
+/// Two request mixes: the server mix that histogram records, and sizes
+/// uniform over 1 B..1 KB. internal_frag_pct is the share of handed-out
+/// bytes that were not requested; list_pct the share of allocations small
+/// enough for a list (the rest search the tree).
+
+#include "allocator/arena.hpp"
+#include "allocator/free_list.hpp"
+#include "allocator/profiled_size_classes.hpp"
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace mmap_viz;
+
+namespace {
+
+constexpr std::size_t kLive = 8192;
+constexpr std::size_t kArenaSize = 64 * 1024 * 1024;
+
+/// @brief The request mix of tools/server_mix_sizes.txt.
+auto server_mix(std::mt19937_64 &rng) -> std::size_t {
+  auto between = [&](std::size_t lo, std::size_t hi) {
+    return lo + rng() % (hi - lo + 1);
+  };
+  const auto roll = rng() % 20;
+  if (roll < 8) {
+    return 8 * between(1, 8); // Headers, small strings.
+  }
+  if (roll < 13) {
+    return 8 * between(8, 64); // Response bodies.
+  }
+  if (roll < 17) {
+    return 8 * between(22, 27); // Session records.
+  }
+  if (roll < 19) {
+    return 8 * between(64, 128); // Larger payloads.
+  }
+  return 24; // List nodes.
+}
+
+auto uniform(std::mt19937_64 &rng) -> std::size_t { return 1 + rng() % 1024; }
+
+template <typename Alloc, auto Sizes>
+void BM_Churn(benchmark::State &state) {
+  auto arena = Arena::create(kArenaSize);
+  if (!arena) {
+    state.SkipWithError("Failed to create arena");
+    return;
+  }
+  Alloc alloc{arena->base(), arena->capacity()};
+  std::mt19937_64 rng(42);
+
+  struct Live {
+    AllocationResult block;
+    std::size_t requested;
+  };
+  std::vector<Live> live;
+  live.reserve(kLive);
+  for (std::size_t i = 0; i < kLive; ++i) {
+    auto size = Sizes(rng);
+    live.push_back({*alloc.allocate(size), size});
+  }
+
+  std::uint64_t requested = 0;
+  std::uint64_t handed_out = 0;
+  std::uint64_t listed = 0;
+  for (auto _ : state) {
+    auto &victim = live[rng() % kLive];
+    (void)alloc.deallocate(victim.block.ptr, victim.block.actual_size);
+    const auto size = Sizes(rng);
+    auto r = alloc.allocate(size);
+    if (!r) {
+      state.SkipWithError("Churn OOM");
+      break;
+    }
+    victim = {*r, size};
+    requested += size;
+    handed_out += r->actual_size;
+    listed += Alloc::block_size(size) <= Alloc::kMaxSmallSize;
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 2));
+  if (handed_out > 0) {
+    state.counters["internal_frag_pct"] =
+        100.0 * static_cast<double>(handed_out - requested) /
+        static_cast<double>(handed_out);
+    state.counters["list_pct"] = 100.0 * static_cast<double>(listed) /
+                                 static_cast<double>(state.iterations());
+  }
+  state.counters["free_blocks"] =
+      static_cast<double>(alloc.free_block_count());
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Churn, FreeListAllocator, server_mix)
+    ->Name("Linear/server_mix");
+BENCHMARK_TEMPLATE(BM_Churn, GeometricFreeListAllocator, server_mix)
+    ->Name("Geometric/server_mix");
+BENCHMARK_TEMPLATE(BM_Churn, ProfiledFreeListAllocator, server_mix)
+    ->Name("Profiled/server_mix");
+BENCHMARK_TEMPLATE(BM_Churn, FreeListAllocator, uniform)
+    ->Name("Linear/uniform");
+BENCHMARK_TEMPLATE(BM_Churn, GeometricFreeListAllocator, uniform)
+    ->Name("Geometric/uniform");
+BENCHMARK_TEMPLATE(BM_Churn, ProfiledFreeListAllocator, uniform)
+    ->Name("Profiled/uniform");
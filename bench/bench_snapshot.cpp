@@ -0,0 +1,260 @@
+/// @file bench_snapshot.cpp
+/// @brief Snapshot generation cost across arena sizes and live-block counts.
+///
+/// Every new dashboard client receives a full snapshot, and for large
+/// arenas that snapshot is tens of megabytes (see performance_report.md).
+/// This tool populates a VisualizationArena with a given number of live
+/// blocks spread over all shards and measures, per output format:
+///   - build time,
+///   - peak resident memory growth while building (VmHWM, reset through
+///     /proc/self/clear_refs before each build),
+///   - output size.
+///
+/// Formats: `json` is the production path, VisualizationArena::
+/// snapshot_json() (heap walk, DOM build, dump). `cbor` and `msgpack`
+/// re-encode the same snapshot DOM with nlohmann's binary writers, and
+/// their time and memory cover only that encoding. They give a baseline
+/// for a cheaper wire format.
+///
+/// Usage: memory_mapper_bench_snapshot [--arena-mb a,b,..] [--blocks a,b,..]
+
+#include "interface/visualization_arena.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace mmap_viz;
+
+namespace {
+
+constexpr std::size_t kShards = 256;
+constexpr std::size_t kMiB = 1024 * 1024;
+/// alloc_raw header + footer, rounded to the 16-byte alignment it uses.
+constexpr std::size_t kBlockOverhead = 64;
+
+// ─── CLI ────────────────────────────────────────────────────────────────
+
+struct SnapshotArgs {
+  std::vector<std::size_t> arena_mb = {16, 256, 1024, 4096};
+  std::vector<std::size_t> blocks = {1'000, 10'000, 100'000, 1'000'000,
+                                     10'000'000};
+};
+
+auto parse_list(const std::string &s) -> std::vector<std::size_t> {
+  std::vector<std::size_t> out;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) {
+      out.push_back(std::stoull(item));
+    }
+  }
+  return out;
+}
+
+auto parse_args(int argc, char *argv[]) -> SnapshotArgs {
+  SnapshotArgs args;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      std::cout << "Usage: " << argv[0]
+                << " [--arena-mb a,b,..] [--blocks a,b,..]\n"
+                << "  defaults: --arena-mb 16,256,1024,4096 "
+                   "--blocks 1000,10000,100000,1000000,10000000\n";
+      std::exit(0);
+    } else if (arg == "--arena-mb" && i + 1 < argc) {
+      args.arena_mb = parse_list(argv[++i]);
+    } else if (arg == "--blocks" && i + 1 < argc) {
+      args.blocks = parse_list(argv[++i]);
+    }
+  }
+  return args;
+}
+
+// ─── Resident memory ────────────────────────────────────────────────────
+
+/// @brief Read a "Vm*:  N kB" line from /proc/self/status, in bytes.
+auto read_status_kb(const std::string &key) -> std::size_t {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.starts_with(key)) {
+      return std::stoull(line.substr(key.size())) * 1024;
+    }
+  }
+  return 0;
+}
+
+/// @brief Reset VmHWM to the current RSS so the next peak is ours.
+auto reset_peak_rss() -> bool {
+  std::ofstream clear("/proc/self/clear_refs");
+  clear << "5";
+  return static_cast<bool>(clear.flush());
+}
+
+/// @brief Return freed heap pages to the kernel, so a build that reuses
+///        them still shows up as RSS growth.
+auto trim_heap() -> bool {
+#if defined(__GLIBC__)
+  ::malloc_trim(0);
+#endif
+  return true;
+}
+
+/// @brief Measures peak RSS growth over a scope.
+class PeakRss {
+public:
+  PeakRss()
+      : valid_{trim_heap() && reset_peak_rss()},
+        base_{read_status_kb("VmRSS:")} {}
+
+  /// @return Peak growth in bytes, or -1 if the kernel refused the reset.
+  [[nodiscard]] auto growth() const -> double {
+    if (!valid_) {
+      return -1.0;
+    }
+    const auto peak = read_status_kb("VmHWM:");
+    return peak > base_ ? static_cast<double>(peak - base_) : 0.0;
+  }
+
+private:
+  bool valid_;
+  std::size_t base_;
+};
+
+// ─── Population ─────────────────────────────────────────────────────────
+
+/// @brief Payload size so @p blocks fill about half of the arena, or 0 if
+///        the blocks cannot fit.
+auto payload_for(std::size_t arena_bytes, std::size_t blocks) -> std::size_t {
+  const std::size_t per_shard = (blocks + kShards - 1) / kShards;
+  const std::size_t budget = arena_bytes / kShards / per_shard;
+  if (budget < 2 * (kBlockOverhead + 16)) {
+    return 0;
+  }
+  return std::clamp<std::size_t>((budget / 2 - kBlockOverhead) & ~15ull, 16,
+                                 4096);
+}
+
+/// @brief Allocate @p blocks live blocks spread evenly over every shard.
+///
+/// A thread is bound to one shard for life, so one short-lived thread per
+/// shard does the filling. Blocks are never freed; the arena is dropped
+/// whole.
+auto populate(VisualizationArena &va, std::size_t blocks, std::size_t payload)
+    -> std::size_t {
+  static constexpr const char *kTags[] = {"GET /api/users", "POST /api/orders",
+                                          "SESSION", "STREAM buffer",
+                                          "cache entry"};
+  std::size_t live = 0;
+  for (std::size_t s = 0; s < kShards; ++s) {
+    const std::size_t quota = blocks / kShards + (s < blocks % kShards);
+    std::size_t filled = 0;
+    std::thread([&] {
+      for (std::size_t i = 0; i < quota; ++i) {
+        if (va.alloc_raw(payload, 16, kTags[i % 5]) == nullptr) {
+          break;
+        }
+        ++filled;
+      }
+    }).join();
+    live += filled;
+  }
+  return live;
+}
+
+// ─── Report ─────────────────────────────────────────────────────────────
+
+void print_row(std::size_t arena_mb, std::size_t live, std::size_t payload,
+               const char *format, double ms, double peak, std::size_t size) {
+  std::printf("%9zu %10zu %8zu %8s %10.2f %10.1f %10.2f %9.1f\n", arena_mb,
+              live, payload, format, ms,
+              peak < 0 ? -1.0 : peak / static_cast<double>(kMiB),
+              static_cast<double>(size) / static_cast<double>(kMiB),
+              live == 0 ? 0.0
+                        : static_cast<double>(size) /
+                              static_cast<double>(live));
+}
+
+template <typename Fn> auto timed_ms(Fn &&fn) -> double {
+  const auto t0 = std::chrono::steady_clock::now();
+  fn();
+  const auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+void run_config(std::size_t arena_mb, std::size_t blocks) {
+  const std::size_t arena_bytes = arena_mb * kMiB;
+  const std::size_t payload = payload_for(arena_bytes, blocks);
+  if (payload == 0) {
+    std::printf("%9zu %10zu %8s   (does not fit, skipped)\n", arena_mb,
+                blocks, "-");
+    return;
+  }
+
+  auto va = VisualizationArena::create({.arena_size = arena_bytes,
+                                        .enable_server = false,
+                                        .sampling = 1'000'000});
+  if (!va.has_value()) {
+    std::printf("%9zu %10zu %8s   (arena creation failed: %s)\n", arena_mb,
+                blocks, "-", va.error().message().c_str());
+    return;
+  }
+  const std::size_t live = populate(*va, blocks, payload);
+
+  std::string json;
+  {
+    PeakRss rss;
+    const double ms = timed_ms([&] { json = va->snapshot_json(); });
+    print_row(arena_mb, live, payload, "json", ms, rss.growth(), json.size());
+  }
+
+  auto dom = nlohmann::json::parse(json);
+  json.clear();
+  json.shrink_to_fit();
+
+  std::vector<std::uint8_t> bin;
+  {
+    PeakRss rss;
+    const double ms = timed_ms([&] { bin = nlohmann::json::to_cbor(dom); });
+    print_row(arena_mb, live, payload, "cbor", ms, rss.growth(), bin.size());
+  }
+  bin = {};
+  {
+    PeakRss rss;
+    const double ms = timed_ms([&] { bin = nlohmann::json::to_msgpack(dom); });
+    print_row(arena_mb, live, payload, "msgpack", ms, rss.growth(),
+              bin.size());
+  }
+  std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  auto args = parse_args(argc, argv);
+
+  std::printf("%9s %10s %8s %8s %10s %10s %10s %9s\n", "arena MB", "blocks",
+              "payload", "format", "build ms", "peak MB", "output MB",
+              "B/block");
+  for (auto arena_mb : args.arena_mb) {
+    for (auto blocks : args.blocks) {
+      run_config(arena_mb, blocks);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,100 @@
+/// @file bench_startup.cpp
+/// @brief Arena and sub-arena creation plus first-allocation latency.
+///
+///   BM_CreateArena     VisualizationArena::create() and the first
+///                      alloc_raw() on a fresh thread context, for arenas of
+///                      1 MB to 64 GB (256 shards each).
+///   BM_CreateSubArena  create_sub_arena() and the first alloc_raw() for
+///                      sub-arenas of 4 to 4096 locked ranges over 256 MB.
+///
+/// Only creation and the first allocation are timed; destruction is not.
+/// page_faults counts minor faults over the timed part (pages the arena
+/// actually touched), per iteration. Shards and ranges are built on first
+/// use, so both should stay flat as size and count grow.
+
+#include "interface/visualization_arena.hpp"
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <sys/resource.h>
+
+using namespace mmap_viz;
+
+namespace {
+
+auto minor_faults() -> std::int64_t {
+  rusage usage{};
+  ::getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt;
+}
+
+} // namespace
+
+/// @param state.range(0) Arena size in bytes.
+static void BM_CreateArena(benchmark::State &state) {
+  const auto size = static_cast<std::size_t>(state.range(0));
+  std::int64_t faults = 0;
+  for (auto _ : state) {
+    const auto faults_before = minor_faults();
+    const auto start = std::chrono::steady_clock::now();
+    auto va = VisualizationArena::create(
+        {.arena_size = size, .enable_server = false});
+    if (!va) {
+      state.SkipWithError("Failed to create arena");
+      break;
+    }
+    void *p = va->alloc_raw(64, 8, "first");
+    const auto stop = std::chrono::steady_clock::now();
+    faults += minor_faults() - faults_before;
+    benchmark::DoNotOptimize(p);
+    state.SetIterationTime(
+        std::chrono::duration<double>(stop - start).count());
+  }
+  state.counters["page_faults"] = benchmark::Counter(
+      static_cast<double>(faults), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_CreateArena)
+    ->ArgName("bytes")
+    ->RangeMultiplier(8)
+    ->Range(std::int64_t{1} << 20, std::int64_t{64} << 30)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+
+/// @param state.range(0) Shards; each is split into 8 ranges from 8 up.
+static void BM_CreateSubArena(benchmark::State &state) {
+  static auto va = VisualizationArena::create({.arena_size = 1024 << 20,
+                                               .enable_server = false})
+                       .value();
+  const auto shards = static_cast<std::size_t>(state.range(0));
+  const std::size_t ranges = shards >= 8 ? 8 : 1;
+  std::int64_t faults = 0;
+  for (auto _ : state) {
+    const auto faults_before = minor_faults();
+    const auto start = std::chrono::steady_clock::now();
+    auto sub = va.create_sub_arena({.capacity = 256 << 20,
+                                    .shard_count = shards,
+                                    .ranges_per_shard = ranges});
+    if (!sub) {
+      state.SkipWithError("Failed to carve sub-arena");
+      break;
+    }
+    void *p = (*sub)->alloc_raw(64, 8, "first");
+    const auto stop = std::chrono::steady_clock::now();
+    faults += minor_faults() - faults_before;
+    benchmark::DoNotOptimize(p);
+    state.SetIterationTime(
+        std::chrono::duration<double>(stop - start).count());
+  }
+  state.counters["ranges"] = static_cast<double>(shards * ranges);
+  state.counters["page_faults"] = benchmark::Counter(
+      static_cast<double>(faults), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_CreateSubArena)
+    ->ArgName("shards")
+    ->RangeMultiplier(8)
+    ->Range(4, 512)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,161 @@
+/// @file bench_stl.cpp
+/// @brief STL-heavy workloads to compare the global operator new/delete
+///        replacement with the default allocator.
+///
+/// The source is built twice:
+///   - `memory_mapper_bench_stl`:       default operator new (glibc malloc),
+///   - `memory_mapper_bench_stl_arena`: linked with mmap_viz_new_delete.
+/// Every container below allocates through plain operator new and frees
+/// through sized delete, so the arena build exercises the sized-delete
+/// fast path throughout. The "allocator" context line records which build
+/// ran; the arena build also prints its fallback counts at the end.
+
+#include <benchmark/benchmark.h>
+
+#ifdef MMAP_VIZ_BENCH_NEW_DELETE
+#include "preload/process_arena.hpp"
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+auto key_for(std::int64_t i) -> std::string {
+  // Long enough to defeat the small-string buffer.
+  return "session-key-" + std::to_string(i) + "-padding";
+}
+
+/// @brief Build a std::map<string, int> of N entries, then erase it.
+void BM_MapBuildTeardown(benchmark::State &state) {
+  const auto n = state.range(0);
+  for (auto _ : state) {
+    std::map<std::string, int> m;
+    for (std::int64_t i = 0; i < n; ++i) {
+      m.emplace(key_for(i), static_cast<int>(i));
+    }
+    benchmark::DoNotOptimize(m.size());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+/// @brief Steady-state churn on a std::unordered_map of N entries: every
+///        iteration erases the oldest key and inserts a new one.
+void BM_UnorderedMapChurn(benchmark::State &state) {
+  const auto n = state.range(0);
+  std::unordered_map<std::string, std::vector<int>> m;
+  for (std::int64_t i = 0; i < n; ++i) {
+    m.emplace(key_for(i), std::vector<int>(8));
+  }
+  std::int64_t next = n;
+  for (auto _ : state) {
+    m.erase(key_for(next - n));
+    m.emplace(key_for(next), std::vector<int>(8));
+    ++next;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// @brief Grow a std::vector<std::string> to N elements by push_back.
+void BM_VectorOfStrings(benchmark::State &state) {
+  const auto n = state.range(0);
+  for (auto _ : state) {
+    std::vector<std::string> v;
+    for (std::int64_t i = 0; i < n; ++i) {
+      v.push_back(key_for(i));
+    }
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+/// @brief Build and destroy a std::list<int> of N nodes (one tiny
+///        allocation per element).
+void BM_ListNodes(benchmark::State &state) {
+  const auto n = state.range(0);
+  for (auto _ : state) {
+    std::list<int> l;
+    for (std::int64_t i = 0; i < n; ++i) {
+      l.push_back(static_cast<int>(i));
+    }
+    benchmark::DoNotOptimize(l.back());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+/// @brief make_shared / release of a small object graph.
+void BM_SharedPtrGraph(benchmark::State &state) {
+  struct Node {
+    std::shared_ptr<Node> next;
+    std::string name;
+  };
+  const auto n = state.range(0);
+  for (auto _ : state) {
+    std::shared_ptr<Node> head;
+    for (std::int64_t i = 0; i < n; ++i) {
+      head = std::make_shared<Node>(Node{head, key_for(i)});
+    }
+    // Unlink iteratively so destruction does not recurse N deep.
+    while (head) {
+      head = std::move(head->next);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+/// @brief The map workload from several threads at once.
+void BM_MapThreaded(benchmark::State &state) {
+  for (auto _ : state) {
+    std::map<int, std::string> m;
+    for (int i = 0; i < 256; ++i) {
+      m.emplace(i, key_for(i));
+    }
+    benchmark::DoNotOptimize(m.size());
+  }
+  state.SetItemsProcessed(state.iterations() * 256);
+}
+
+} // namespace
+
+// Sizes stay within one thread's shard (16MB with the default 4GB arena);
+// beyond that the arena build would measure its malloc fallback.
+BENCHMARK(BM_MapBuildTeardown)->RangeMultiplier(10)->Range(100, 10000);
+BENCHMARK(BM_UnorderedMapChurn)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_VectorOfStrings)->RangeMultiplier(10)->Range(100, 10000);
+BENCHMARK(BM_ListNodes)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_SharedPtrGraph)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_MapThreaded)
+    ->ThreadRange(1, static_cast<int>(
+                         std::max(1u, std::thread::hardware_concurrency())));
+
+int main(int argc, char **argv) {
+#ifdef MMAP_VIZ_BENCH_NEW_DELETE
+  benchmark::AddCustomContext("allocator", "mmap_viz (operator new)");
+#else
+  benchmark::AddCustomContext("allocator", "default operator new");
+#endif
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+#ifdef MMAP_VIZ_BENCH_NEW_DELETE
+  auto &counters = mmap_viz::process_arena::counters();
+  std::printf("new/delete: %llu malloc passthrough, %llu shard overflow "
+              "allocations\n",
+              static_cast<unsigned long long>(counters.passthrough.load()),
+              static_cast<unsigned long long>(counters.overflow.load()));
+#endif
+  return 0;
+}
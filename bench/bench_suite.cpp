@@ -0,0 +1,296 @@
+/// @file bench_suite.cpp
+/// @brief Classic multi-threaded allocator workloads (Larson, threadtest,
+///        xmalloc, cache-scratch) run against every allocator we ship.
+///
+/// This is the regression yardstick: each workload is instantiated for
+/// malloc, a globally locked FreeListAllocator, and VisualizationArena at
+/// several event sampling rates, across a range of thread counts.
+
+#include "bench_common.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace mmap_viz;
+using namespace mmap_viz::bench;
+
+namespace {
+
+constexpr std::size_t kArenaSize = 1024ull * 1024 * 1024; // 1GB
+
+const int kMaxThreads =
+    static_cast<int>(std::max(4u, std::thread::hardware_concurrency()));
+
+// ─── Larson ─────────────────────────────────────────────────────────────
+//
+// Server simulation: every thread owns a set of live blocks and repeatedly
+// replaces a random one (free + alloc of a random size). After each round
+// the set is handed to another thread, so most frees hit memory that was
+// allocated elsewhere.
+
+constexpr std::size_t kLarsonSlots = 1000;
+constexpr std::size_t kLarsonRound = 1000;
+constexpr std::size_t kLarsonMinSize = 16;
+constexpr std::size_t kLarsonMaxSize = 1024;
+
+template <typename Adapter> struct LarsonShared {
+  Adapter adapter;
+  std::vector<std::vector<Block>> sets;
+  std::mutex mutex;
+  std::deque<std::size_t> idle; ///< Sets waiting for a new owner.
+};
+
+template <typename Adapter> void BM_Larson(benchmark::State &state) {
+  static LarsonShared<Adapter> shared;
+  const auto threads = static_cast<std::size_t>(state.threads());
+
+  if (state.thread_index() == 0) {
+    shared.adapter.setup(kArenaSize);
+    FastRng rng{42};
+    // One spare set so an exchange never hands a thread its own set back.
+    shared.sets.assign(threads + 1, {});
+    shared.idle.clear();
+    for (std::size_t s = 0; s < shared.sets.size(); ++s) {
+      for (std::size_t i = 0; i < kLarsonSlots; ++i) {
+        shared.sets[s].push_back(
+            shared.adapter.alloc(rng.between(kLarsonMinSize, kLarsonMaxSize)));
+      }
+      if (s >= threads) {
+        shared.idle.push_back(s);
+      }
+    }
+  }
+
+  FastRng rng{static_cast<std::uint64_t>(state.thread_index()) + 1};
+  std::size_t current = static_cast<std::size_t>(state.thread_index());
+  std::size_t ops_in_round = 0;
+
+  for (auto _ : state) {
+    auto &set = shared.sets[current];
+    auto &slot = set[rng.next() % set.size()];
+    if (slot.ptr != nullptr) {
+      shared.adapter.free(slot);
+    }
+    // The block escapes into the shared set, so it cannot be optimized away.
+    // Do not pass `slot` to DoNotOptimize: with GCC the non-const overload's
+    // "+r,m" constraint may operate on a register copy and drop the store.
+    slot = shared.adapter.alloc(rng.between(kLarsonMinSize, kLarsonMaxSize));
+
+    if (++ops_in_round == kLarsonRound) {
+      ops_in_round = 0;
+      std::lock_guard lock(shared.mutex);
+      shared.idle.push_back(current);
+      current = shared.idle.front();
+      shared.idle.pop_front();
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    for (auto &set : shared.sets) {
+      for (auto &b : set) {
+        if (b.ptr != nullptr) {
+          shared.adapter.free(b);
+        }
+      }
+    }
+    shared.sets.clear();
+    shared.adapter.teardown();
+  }
+}
+
+// ─── threadtest ─────────────────────────────────────────────────────────
+//
+// Each thread allocates a batch of fixed-size objects and frees the whole
+// batch, with no sharing between threads. Measures the pure per-thread
+// fast path and how well it scales.
+
+constexpr std::size_t kThreadtestBatch = 100;
+constexpr std::size_t kThreadtestSize = 64;
+
+template <typename Adapter> struct ThreadtestShared {
+  Adapter adapter;
+};
+
+template <typename Adapter> void BM_Threadtest(benchmark::State &state) {
+  static ThreadtestShared<Adapter> shared;
+  if (state.thread_index() == 0) {
+    shared.adapter.setup(kArenaSize);
+  }
+
+  std::vector<Block> batch(kThreadtestBatch);
+
+  for (auto _ : state) {
+    for (auto &b : batch) {
+      b = shared.adapter.alloc(kThreadtestSize);
+    }
+    for (auto &b : batch) {
+      if (b.ptr != nullptr) {
+        shared.adapter.free(b);
+      }
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(kThreadtestBatch));
+
+  if (state.thread_index() == 0) {
+    shared.adapter.teardown();
+  }
+}
+
+// ─── xmalloc ────────────────────────────────────────────────────────────
+//
+// Producer/consumer: even threads allocate and push blocks through an SPSC
+// queue to their odd partner, which frees them. Every free is remote.
+// With a single thread the workload degenerates to alloc-then-free.
+
+constexpr std::size_t kXmallocQueue = 1024;
+constexpr std::size_t kXmallocMinSize = 16;
+constexpr std::size_t kXmallocMaxSize = 512;
+
+template <typename Adapter> struct XmallocShared {
+  Adapter adapter;
+  std::vector<std::unique_ptr<SpscQueue<kXmallocQueue>>> queues;
+};
+
+template <typename Adapter> void BM_Xmalloc(benchmark::State &state) {
+  static XmallocShared<Adapter> shared;
+  const auto threads = static_cast<std::size_t>(state.threads());
+  const auto tid = static_cast<std::size_t>(state.thread_index());
+
+  if (tid == 0) {
+    shared.adapter.setup(kArenaSize);
+    shared.queues.clear();
+    for (std::size_t i = 0; i < (threads + 1) / 2; ++i) {
+      shared.queues.push_back(std::make_unique<SpscQueue<kXmallocQueue>>());
+    }
+  }
+
+  FastRng rng{tid + 1};
+  const bool paired = (tid ^ 1) < threads;
+  const bool producer = (tid % 2) == 0;
+
+  for (auto _ : state) {
+    if (!paired) {
+      const auto b =
+          shared.adapter.alloc(rng.between(kXmallocMinSize, kXmallocMaxSize));
+      benchmark::DoNotOptimize(b.ptr);
+      if (b.ptr != nullptr) {
+        shared.adapter.free(b);
+      }
+    } else if (producer) {
+      const auto b =
+          shared.adapter.alloc(rng.between(kXmallocMinSize, kXmallocMaxSize));
+      // Both partners run the same iteration count, so this always drains.
+      while (!shared.queues[tid / 2]->try_push(b)) {
+        std::this_thread::yield();
+      }
+    } else {
+      Block b;
+      while (!shared.queues[tid / 2]->try_pop(b)) {
+        std::this_thread::yield();
+      }
+      if (b.ptr != nullptr) {
+        shared.adapter.free(b);
+      }
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+
+  if (tid == 0) {
+    shared.queues.clear();
+    shared.adapter.teardown();
+  }
+}
+
+// ─── cache-scratch ──────────────────────────────────────────────────────
+//
+// Passive false sharing: thread 0 allocates one small object per thread
+// back to back, so they share cache lines. Each thread frees its object
+// and then repeatedly allocates, writes and frees same-sized objects. An
+// allocator that hands the freed slot back to the same thread keeps the
+// threads writing to a shared line.
+
+constexpr std::size_t kScratchSize = 8;
+constexpr int kScratchWrites = 100;
+
+template <typename Adapter> struct ScratchShared {
+  Adapter adapter;
+  std::vector<Block> seeds;
+};
+
+template <typename Adapter> void BM_CacheScratch(benchmark::State &state) {
+  static ScratchShared<Adapter> shared;
+  const auto tid = static_cast<std::size_t>(state.thread_index());
+
+  if (tid == 0) {
+    shared.adapter.setup(kArenaSize);
+    shared.seeds.clear();
+    for (int i = 0; i < state.threads(); ++i) {
+      shared.seeds.push_back(shared.adapter.alloc(kScratchSize));
+    }
+  }
+
+  bool seeded = false;
+  for (auto _ : state) {
+    if (!seeded) {
+      // Seeds are only guaranteed to exist once the start barrier is passed.
+      if (shared.seeds[tid].ptr != nullptr) {
+        shared.adapter.free(shared.seeds[tid]);
+      }
+      seeded = true;
+    }
+    auto b = shared.adapter.alloc(kScratchSize);
+    if (b.ptr != nullptr) {
+      auto *p = static_cast<volatile char *>(b.ptr);
+      for (int w = 0; w < kScratchWrites; ++w) {
+        p[w % kScratchSize] = static_cast<char>(p[w % kScratchSize] + 1);
+      }
+      shared.adapter.free(b);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+
+  if (tid == 0) {
+    shared.seeds.clear();
+    shared.adapter.teardown();
+  }
+}
+
+} // namespace
+
+// ─── Registration ───────────────────────────────────────────────────────
+
+#define MMAP_VIZ_SUITE(workload)                                               \
+  BENCHMARK_TEMPLATE(workload, MallocAdapter)                                  \
+      ->ThreadRange(1, kMaxThreads)                                            \
+      ->UseRealTime();                                                         \
+  BENCHMARK_TEMPLATE(workload, FreeListAdapter)                                \
+      ->ThreadRange(1, kMaxThreads)                                            \
+      ->UseRealTime();                                                         \
+  BENCHMARK_TEMPLATE(workload, VisualizationArenaAdapter<1>)                   \
+      ->ThreadRange(1, kMaxThreads)                                            \
+      ->UseRealTime();                                                         \
+  BENCHMARK_TEMPLATE(workload, VisualizationArenaAdapter<64>)                  \
+      ->ThreadRange(1, kMaxThreads)                                            \
+      ->UseRealTime();                                                         \
+  BENCHMARK_TEMPLATE(workload, VisualizationArenaAdapter<4096>)                \
+      ->ThreadRange(1, kMaxThreads)                                            \
+      ->UseRealTime()
+
+MMAP_VIZ_SUITE(BM_Larson);
+MMAP_VIZ_SUITE(BM_Threadtest);
+MMAP_VIZ_SUITE(BM_Xmalloc);
+MMAP_VIZ_SUITE(BM_CacheScratch);
+
+BENCHMARK_MAIN();
@@ -25,8 +25,10 @@ auto Arena::create(std::size_t capacity)
   const auto ps = page_size();
   const auto aligned_capacity = ((capacity + ps - 1) / ps) * ps;
 
+  // Reserve only: pages are backed as they are first touched, so an arena
+  // far larger than its working set (or than RAM) is cheap to create.
   void *ptr = ::mmap(nullptr, aligned_capacity, PROT_READ | PROT_WRITE,
-                     MAP_ANONYMOUS | MAP_PRIVATE,
+                     MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE,
                      -1, // No file descriptor.
                      0   // No offset.
   );
@@ -0,0 +1,132 @@
+/// @file btree_allocator.cpp
+/// @brief Implementation of BTreeAllocator.
+
+#include "allocator/btree_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace mmap_viz {
+
+namespace {
+
+constexpr std::size_t kGranule = BTreeFreeIndex::kGranule;
+constexpr std::size_t kMaxGranules = (std::size_t{1} << 32) - 1;
+
+} // namespace
+
+BTreeAllocator::BTreeAllocator(std::byte *base, std::size_t size) noexcept
+    : base_{base}, size_{size & ~(kGranule - 1)} {
+  if (reinterpret_cast<std::uintptr_t>(base) % kGranule != 0 ||
+      size_ / kGranule > kMaxGranules) {
+    std::fprintf(stderr,
+                 "FATAL: BTreeAllocator needs a 16-byte aligned region of at "
+                 "most 64 GB (got %p, %zu B)\n",
+                 static_cast<void *>(base), size);
+    std::abort();
+  }
+  if (size_ > 0) {
+    index_.insert({0, static_cast<std::uint32_t>(size_ / kGranule)});
+  }
+}
+
+auto BTreeAllocator::allocate(std::size_t size, std::size_t alignment)
+    -> std::expected<AllocationResult, AllocError> {
+  if (!std::has_single_bit(alignment)) {
+    return std::unexpected(AllocError::InvalidAlignment);
+  }
+  const std::size_t block = FreeListAllocator::block_size(size);
+  if (block > size_) {
+    return std::unexpected(AllocError::OutOfMemory);
+  }
+  const auto need = static_cast<std::uint32_t>(block / kGranule);
+  const std::size_t align = std::max(alignment, kGranule);
+
+  auto padding = [&](const BTreeFreeIndex::Extent &e) -> std::size_t {
+    auto addr = reinterpret_cast<std::uintptr_t>(base_) + e.offset * kGranule;
+    return ((align - (addr % align)) % align) / kGranule;
+  };
+
+  auto fit = index_.first_fit(need);
+  if (fit && fit->size < padding(*fit) + need) {
+    // The first fit is too short once aligned; any extent this long
+    // holds an aligned block.
+    auto slack = static_cast<std::uint32_t>(align / kGranule - 1);
+    fit = need + std::uint64_t{slack} <= kMaxGranules
+              ? index_.first_fit(need + slack)
+              : std::nullopt;
+  }
+  if (!fit) {
+    return std::unexpected(AllocError::OutOfMemory);
+  }
+
+  const auto pad = static_cast<std::uint32_t>(padding(*fit));
+  const auto rest = fit->size - pad - need;
+  if (pad == 0) {
+    if (rest == 0) {
+      index_.erase(fit->offset);
+    } else {
+      index_.rekey(fit->offset, {fit->offset + need, rest});
+    }
+  } else {
+    index_.rekey(fit->offset, {fit->offset, pad});
+    if (rest != 0) {
+      index_.insert({fit->offset + pad + need, rest});
+    }
+  }
+
+  const std::size_t offset = (fit->offset + pad) * kGranule;
+  allocated_ += block;
+  return AllocationResult{
+      .ptr = base_ + offset,
+      .offset = offset,
+      .actual_size = block,
+  };
+}
+
+auto BTreeAllocator::deallocate(std::byte *ptr, std::size_t size)
+    -> std::expected<void, AllocError> {
+  if (ptr == nullptr) {
+    return {};
+  }
+  if (!contains(ptr)) {
+    return std::unexpected(AllocError::BadPointer);
+  }
+  const auto byte_offset = static_cast<std::size_t>(ptr - base_);
+  const std::size_t block = FreeListAllocator::block_size(size);
+  if (byte_offset % kGranule != 0) {
+    return std::unexpected(AllocError::InvalidAlignment);
+  }
+  if (block > size_ - byte_offset) {
+    return std::unexpected(AllocError::BadPointer);
+  }
+  const auto off = static_cast<std::uint32_t>(byte_offset / kGranule);
+  const auto len = static_cast<std::uint32_t>(block / kGranule);
+
+  auto prev = index_.floor(off);
+  if (prev && std::uint64_t{prev->offset} + prev->size > off) {
+    return std::unexpected(AllocError::DoubleFree);
+  }
+  auto next = index_.find(off + len);
+
+  if (prev && prev->offset + prev->size == off) {
+    // Grows in place; an adjacent successor is folded in too.
+    std::uint32_t grown = prev->size + len;
+    if (next) {
+      grown += next->size;
+      index_.erase(next->offset);
+    }
+    index_.rekey(prev->offset, {prev->offset, grown});
+  } else if (next) {
+    index_.rekey(next->offset, {off, len + next->size});
+  } else {
+    index_.insert({off, len});
+  }
+  allocated_ -= block;
+  return {};
+}
+
+} // namespace mmap_viz
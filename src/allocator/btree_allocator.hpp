@@ -0,0 +1,76 @@
+#pragma once
+/// @file btree_allocator.hpp
+/// @brief First-fit allocator whose free index lives outside the region.
+
+#include "allocator/btree_free_index.hpp"
+#include "allocator/free_list.hpp"
+
+#include <cstddef>
+#include <expected>
+
+namespace mmap_viz {
+
+/// @brief First-fit allocator over a BTreeFreeIndex.
+///
+/// The same contract as FreeListAllocator, but free extents are tracked in
+/// the out-of-line B+-tree rather than in the free blocks themselves: a
+/// search reads a few 64-byte index nodes instead of walking tree nodes
+/// scattered over the region, and free memory is never written, so pages
+/// that are free stay untouched (and can stay decommitted). Neighbours
+/// coalesce on deallocate; there is no minimum block size beyond one
+/// 16-byte granule, so no remainder is absorbed or parked in small lists.
+///
+/// The region must be 16-byte aligned and at most 64 GB; a trailing part
+/// shorter than 16 bytes is not used.
+class BTreeAllocator {
+public:
+  BTreeAllocator(std::byte *base, std::size_t size) noexcept;
+
+  BTreeAllocator(const BTreeAllocator &) = delete;
+  BTreeAllocator &operator=(const BTreeAllocator &) = delete;
+
+  /// @brief As FreeListAllocator::allocate().
+  [[nodiscard]] auto allocate(std::size_t size,
+                              std::size_t alignment = alignof(std::max_align_t))
+      -> std::expected<AllocationResult, AllocError>;
+
+  /// @brief As FreeListAllocator::deallocate(); @p size may be the request
+  ///        or the actual size. Freeing a block that overlaps a free
+  ///        extent fails with DoubleFree.
+  auto deallocate(std::byte *ptr, std::size_t size)
+      -> std::expected<void, AllocError>;
+
+  [[nodiscard]] auto bytes_allocated() const noexcept -> std::size_t {
+    return allocated_;
+  }
+  [[nodiscard]] auto bytes_free() const noexcept -> std::size_t {
+    return size_ - allocated_;
+  }
+  [[nodiscard]] auto largest_free_block() const noexcept -> std::size_t {
+    return std::size_t{index_.max_size()} * BTreeFreeIndex::kGranule;
+  }
+  [[nodiscard]] auto free_block_count() const noexcept -> std::size_t {
+    return index_.size();
+  }
+  [[nodiscard]] auto capacity() const noexcept -> std::size_t {
+    return size_;
+  }
+  [[nodiscard]] auto base() const noexcept -> std::byte * { return base_; }
+  [[nodiscard]] bool contains(const void *ptr) const noexcept {
+    const auto *p = static_cast<const std::byte *>(ptr);
+    return p >= base_ && p < base_ + size_;
+  }
+
+  /// @brief The free index, for depth and metadata footprint.
+  [[nodiscard]] auto index() const noexcept -> const BTreeFreeIndex & {
+    return index_;
+  }
+
+private:
+  std::byte *base_;
+  std::size_t size_; ///< Whole granules only.
+  std::size_t allocated_ = 0;
+  BTreeFreeIndex index_;
+};
+
+} // namespace mmap_viz
@@ -0,0 +1,569 @@
+/// @file btree_free_index.cpp
+/// @brief Implementation of BTreeFreeIndex.
+
+#include "allocator/btree_free_index.hpp"
+#include "allocator/arena.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+
+namespace mmap_viz {
+
+BTreeFreeIndex::BTreeFreeIndex() noexcept {
+  capacity_ = Arena::page_size() / sizeof(Node);
+  void *p = ::mmap(nullptr, capacity_ * sizeof(Node), PROT_READ | PROT_WRITE,
+                   MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+  if (p == MAP_FAILED) {
+    std::fprintf(stderr, "FATAL: cannot map B+-tree free index\n");
+    std::abort();
+  }
+  nodes_ = static_cast<Node *>(p);
+}
+
+BTreeFreeIndex::~BTreeFreeIndex() {
+  ::munmap(nodes_, capacity_ * sizeof(Node));
+}
+
+// ─── Node storage ────────────────────────────────────────────────────────
+
+void BTreeFreeIndex::reserve(std::size_t n) noexcept {
+  if (used_ + n <= capacity_) {
+    return;
+  }
+  std::size_t grown = std::max(capacity_ * 2, used_ + n);
+  void *p = ::mremap(nodes_, capacity_ * sizeof(Node), grown * sizeof(Node),
+                     MREMAP_MAYMOVE);
+  if (p == MAP_FAILED) {
+    std::fprintf(stderr, "FATAL: cannot grow B+-tree free index to %zu B\n",
+                 grown * sizeof(Node));
+    std::abort();
+  }
+  nodes_ = static_cast<Node *>(p);
+  capacity_ = grown;
+}
+
+auto BTreeFreeIndex::alloc_node() noexcept -> std::uint32_t {
+  std::uint32_t i;
+  if (free_head_ != 0) {
+    i = free_head_;
+    free_head_ = node(i).leaf.next;
+  } else {
+    reserve(1);
+    i = used_++;
+  }
+  std::memset(&node(i), 0, sizeof(Node));
+  ++live_nodes_;
+  return i;
+}
+
+void BTreeFreeIndex::free_node(std::uint32_t i) noexcept {
+  node(i).leaf.next = free_head_;
+  free_head_ = i;
+  --live_nodes_;
+}
+
+// ─── Lookup ──────────────────────────────────────────────────────────────
+
+auto BTreeFreeIndex::child_slot(const Inner &in, std::uint32_t key) noexcept
+    -> std::uint32_t {
+  std::uint32_t s = 0;
+  while (s + 1 < in.count && key >= in.keys[s]) {
+    ++s;
+  }
+  return s;
+}
+
+auto BTreeFreeIndex::leaf_slot(const Leaf &leaf, std::uint32_t key) noexcept
+    -> std::uint32_t {
+  std::uint32_t s = 0;
+  while (s < leaf.count && leaf.keys[s] < key) {
+    ++s;
+  }
+  return s;
+}
+
+auto BTreeFreeIndex::node_max(std::uint32_t i) const noexcept
+    -> std::uint32_t {
+  const auto &n = node(i);
+  std::uint32_t m = 0;
+  if (n.leaf.is_leaf != 0) {
+    for (std::uint32_t s = 0; s < n.leaf.count; ++s) {
+      m = std::max(m, n.leaf.sizes[s]);
+    }
+  } else {
+    for (std::uint32_t s = 0; s < n.inner.count; ++s) {
+      m = std::max(m, n.inner.max[s]);
+    }
+  }
+  return m;
+}
+
+void BTreeFreeIndex::descend(std::uint32_t key, Path &path) const noexcept {
+  path.depth = 0;
+  std::uint32_t i = root_;
+  for (;;) {
+    const auto &n = node(i);
+    path.node[path.depth] = i;
+    if (n.leaf.is_leaf != 0) {
+      path.slot[path.depth++] = leaf_slot(n.leaf, key);
+      return;
+    }
+    auto s = child_slot(n.inner, key);
+    path.slot[path.depth++] = s;
+    i = n.inner.children[s];
+  }
+}
+
+auto BTreeFreeIndex::first_fit(std::uint32_t size) const noexcept
+    -> std::optional<Extent> {
+  if (root_ == 0) {
+    return std::nullopt;
+  }
+  std::uint32_t i = root_;
+  for (;;) {
+    const auto &n = node(i);
+    if (n.leaf.is_leaf != 0) {
+      for (std::uint32_t s = 0; s < n.leaf.count; ++s) {
+        if (n.leaf.sizes[s] >= size) {
+          return Extent{n.leaf.keys[s], n.leaf.sizes[s]};
+        }
+      }
+      return std::nullopt;
+    }
+    std::uint32_t s = 0;
+    while (s < n.inner.count && n.inner.max[s] < size) {
+      ++s;
+    }
+    if (s == n.inner.count) {
+      return std::nullopt;
+    }
+    i = n.inner.children[s];
+  }
+}
+
+auto BTreeFreeIndex::find(std::uint32_t offset) const noexcept
+    -> std::optional<Extent> {
+  if (root_ == 0) {
+    return std::nullopt;
+  }
+  Path path;
+  descend(offset, path);
+  const auto &leaf = node(path.node[path.depth - 1]).leaf;
+  auto s = path.slot[path.depth - 1];
+  if (s < leaf.count && leaf.keys[s] == offset) {
+    return Extent{offset, leaf.sizes[s]};
+  }
+  return std::nullopt;
+}
+
+auto BTreeFreeIndex::floor(std::uint32_t offset) const noexcept
+    -> std::optional<Extent> {
+  if (root_ == 0) {
+    return std::nullopt;
+  }
+  Path path;
+  descend(offset, path);
+  const auto *leaf = &node(path.node[path.depth - 1]).leaf;
+  auto s = path.slot[path.depth - 1];
+  if (s < leaf->count && leaf->keys[s] == offset) {
+    return Extent{offset, leaf->sizes[s]};
+  }
+  if (s == 0) {
+    // Everything below offset lives in the leaves to the left, and empty
+    // leaves are unlinked at once.
+    if (leaf->prev == 0) {
+      return std::nullopt;
+    }
+    leaf = &node(leaf->prev).leaf;
+    s = leaf->count;
+  }
+  return Extent{leaf->keys[s - 1], leaf->sizes[s - 1]};
+}
+
+auto BTreeFreeIndex::max_size() const noexcept -> std::uint32_t {
+  return root_ == 0 ? 0 : node_max(root_);
+}
+
+// ─── Update ──────────────────────────────────────────────────────────────
+
+void BTreeFreeIndex::update_max(const Path &path, std::size_t level) noexcept {
+  for (std::size_t l = level; l > 0; --l) {
+    auto m = node_max(path.node[l]);
+    auto &parent = node(path.node[l - 1]).inner;
+    auto &slot = parent.max[path.slot[l - 1]];
+    if (slot == m) {
+      return;
+    }
+    slot = m;
+  }
+}
+
+void BTreeFreeIndex::insert(Extent e) noexcept {
+  // A split chain takes at most one node per level, plus a new root.
+  reserve(depth_ + 1);
+  ++count_;
+  if (root_ == 0) {
+    root_ = alloc_node();
+    auto &leaf = node(root_).leaf;
+    leaf.is_leaf = 1;
+    leaf.count = 1;
+    leaf.keys[0] = e.offset;
+    leaf.sizes[0] = e.size;
+    depth_ = 1;
+    return;
+  }
+
+  Path path;
+  descend(e.offset, path);
+  const auto level = path.depth - 1;
+  const auto left = path.node[level];
+  const auto s = path.slot[level];
+  auto *leaf = &node(left).leaf;
+
+  if (leaf->count < kLeafCapacity) {
+    for (auto k = leaf->count; k > s; --k) {
+      leaf->keys[k] = leaf->keys[k - 1];
+      leaf->sizes[k] = leaf->sizes[k - 1];
+    }
+    leaf->keys[s] = e.offset;
+    leaf->sizes[s] = e.size;
+    ++leaf->count;
+    update_max(path, level);
+    return;
+  }
+
+  // Split: the lower half stays, the upper half moves to a new leaf. An
+  // append at the end keeps the leaf full instead, so extents freed in
+  // address order pack leaves rather than leaving them two-thirds empty.
+  std::uint32_t keys[kLeafCapacity + 1];
+  std::uint32_t sizes[kLeafCapacity + 1];
+  for (std::uint32_t k = 0, j = 0; k <= kLeafCapacity; ++k) {
+    if (k == s) {
+      keys[k] = e.offset;
+      sizes[k] = e.size;
+    } else {
+      keys[k] = leaf->keys[j];
+      sizes[k] = leaf->sizes[j];
+      ++j;
+    }
+  }
+  const std::uint32_t keep =
+      s == kLeafCapacity ? kLeafCapacity : (kLeafCapacity + 2) / 2;
+  const auto right = alloc_node();
+  leaf = &node(left).leaf;
+  auto &rleaf = node(right).leaf;
+  rleaf.is_leaf = 1;
+  leaf->count = static_cast<std::uint16_t>(keep);
+  rleaf.count = static_cast<std::uint16_t>(kLeafCapacity + 1 - keep);
+  for (std::uint32_t k = 0; k <= kLeafCapacity; ++k) {
+    if (k < keep) {
+      leaf->keys[k] = keys[k];
+      leaf->sizes[k] = sizes[k];
+    } else {
+      rleaf.keys[k - keep] = keys[k];
+      rleaf.sizes[k - keep] = sizes[k];
+    }
+  }
+  rleaf.prev = left;
+  rleaf.next = leaf->next;
+  if (leaf->next != 0) {
+    node(leaf->next).leaf.prev = right;
+  }
+  leaf->next = right;
+
+  if (level == 0) {
+    root_ = alloc_node();
+    auto &root = node(root_).inner;
+    root.count = 2;
+    root.keys[0] = rleaf.keys[0];
+    root.children[0] = left;
+    root.children[1] = right;
+    root.max[0] = node_max(left);
+    root.max[1] = node_max(right);
+    ++depth_;
+    return;
+  }
+  insert_child(path, level - 1, node(right).leaf.keys[0], right);
+}
+
+void BTreeFreeIndex::insert_child(const Path &path, std::size_t level,
+                                  std::uint32_t key,
+                                  std::uint32_t right) noexcept {
+  const auto self = path.node[level];
+  const auto s = path.slot[level];
+  auto *in = &node(self).inner;
+  in->max[s] = node_max(in->children[s]);
+
+  if (in->count < kInnerCapacity) {
+    for (auto k = in->count; k > s + 1; --k) {
+      in->children[k] = in->children[k - 1];
+      in->max[k] = in->max[k - 1];
+      in->keys[k - 1] = in->keys[k - 2];
+    }
+    in->children[s + 1] = right;
+    in->max[s + 1] = node_max(right);
+    in->keys[s] = key;
+    ++in->count;
+    update_max(path, level);
+    return;
+  }
+
+  // Split: 3 children stay, 3 move, and the middle key goes up; as for
+  // leaves, an append at the end keeps the node full.
+  std::uint32_t children[kInnerCapacity + 1];
+  std::uint32_t max[kInnerCapacity + 1];
+  std::uint32_t keys[kInnerCapacity];
+  for (std::uint32_t k = 0, j = 0; k <= kInnerCapacity; ++k) {
+    if (k == s + 1) {
+      children[k] = right;
+      max[k] = node_max(right);
+    } else {
+      children[k] = in->children[j];
+      max[k] = in->max[j];
+      ++j;
+    }
+  }
+  for (std::uint32_t k = 0, j = 0; k < kInnerCapacity; ++k) {
+    keys[k] = k == s ? key : in->keys[j++];
+  }
+  const std::uint32_t keep =
+      s + 1 == kInnerCapacity ? kInnerCapacity : (kInnerCapacity + 1) / 2;
+  const auto sibling = alloc_node();
+  in = &node(self).inner;
+  auto &sib = node(sibling).inner;
+  in->count = static_cast<std::uint16_t>(keep);
+  sib.count = static_cast<std::uint16_t>(kInnerCapacity + 1 - keep);
+  for (std::uint32_t k = 0; k <= kInnerCapacity; ++k) {
+    if (k < keep) {
+      in->children[k] = children[k];
+      in->max[k] = max[k];
+    } else {
+      sib.children[k - keep] = children[k];
+      sib.max[k - keep] = max[k];
+    }
+  }
+  for (std::uint32_t k = 0; k + 1 < keep; ++k) {
+    in->keys[k] = keys[k];
+  }
+  for (std::uint32_t k = keep; k < kInnerCapacity; ++k) {
+    sib.keys[k - keep] = keys[k];
+  }
+  const auto up = keys[keep - 1];
+
+  if (level == 0) {
+    root_ = alloc_node();
+    auto &root = node(root_).inner;
+    root.count = 2;
+    root.keys[0] = up;
+    root.children[0] = self;
+    root.children[1] = sibling;
+    root.max[0] = node_max(self);
+    root.max[1] = node_max(sibling);
+    ++depth_;
+    return;
+  }
+  insert_child(path, level - 1, up, sibling);
+}
+
+auto BTreeFreeIndex::erase(std::uint32_t offset) noexcept -> bool {
+  if (root_ == 0) {
+    return false;
+  }
+  Path path;
+  descend(offset, path);
+  const auto level = path.depth - 1;
+  const auto self = path.node[level];
+  const auto s = path.slot[level];
+  auto &leaf = node(self).leaf;
+  if (s >= leaf.count || leaf.keys[s] != offset) {
+    return false;
+  }
+  for (std::uint32_t k = s; k + 1 < leaf.count; ++k) {
+    leaf.keys[k] = leaf.keys[k + 1];
+    leaf.sizes[k] = leaf.sizes[k + 1];
+  }
+  --leaf.count;
+  --count_;
+
+  if (level == 0) {
+    if (leaf.count == 0) {
+      free_node(self);
+      root_ = 0;
+      depth_ = 0;
+    }
+    return true;
+  }
+
+  auto unlink = [this](std::uint32_t i) {
+    auto &l = node(i).leaf;
+    if (l.prev != 0) {
+      node(l.prev).leaf.next = l.next;
+    }
+    if (l.next != 0) {
+      node(l.next).leaf.prev = l.prev;
+    }
+  };
+
+  const auto &parent = node(path.node[level - 1]).inner;
+  const auto ps = path.slot[level - 1];
+  if (leaf.count == 0) {
+    unlink(self);
+    free_node(self);
+    remove_child(path, level - 1, ps);
+    return true;
+  }
+
+  // Fold an under-half leaf into a sibling under the same parent.
+  if (leaf.count < kLeafCapacity / 2) {
+    std::uint32_t ls = ps > 0 ? ps - 1 : ps;
+    if (ls + 1 < parent.count) {
+      const auto li = parent.children[ls];
+      const auto ri = parent.children[ls + 1];
+      auto &l = node(li).leaf;
+      const auto &r = node(ri).leaf;
+      if (l.count + r.count <= kLeafCapacity) {
+        for (std::uint32_t k = 0; k < r.count; ++k) {
+          l.keys[l.count + k] = r.keys[k];
+          l.sizes[l.count + k] = r.sizes[k];
+        }
+        l.count = static_cast<std::uint16_t>(l.count + r.count);
+        unlink(ri);
+        free_node(ri);
+        node(path.node[level - 1]).inner.max[ls] = node_max(li);
+        remove_child(path, level - 1, ls + 1);
+        return true;
+      }
+    }
+  }
+  update_max(path, level);
+  return true;
+}
+
+void BTreeFreeIndex::remove_child(const Path &path, std::size_t level,
+                                  std::uint32_t slot) noexcept {
+  const auto self = path.node[level];
+  auto &in = node(self).inner;
+  for (std::uint32_t k = slot; k + 1 < in.count; ++k) {
+    in.children[k] = in.children[k + 1];
+    in.max[k] = in.max[k + 1];
+  }
+  // Child k + 1 starts at keys[k]: dropping child 0 drops keys[0], any
+  // other child the key in front of it.
+  for (std::uint32_t k = slot == 0 ? 0 : slot - 1; k + 2 < in.count; ++k) {
+    in.keys[k] = in.keys[k + 1];
+  }
+  --in.count;
+
+  if (in.count == 0) {
+    // Only a non-root node can empty: the root keeps two children.
+    free_node(self);
+    remove_child(path, level - 1, path.slot[level - 1]);
+    return;
+  }
+  if (level == 0 && in.count == 1) {
+    // Lower nodes may be down to one child too.
+    do {
+      const auto only = node(root_).inner.children[0];
+      free_node(root_);
+      root_ = only;
+      --depth_;
+    } while (node(root_).leaf.is_leaf == 0 && node(root_).inner.count == 1);
+    return;
+  }
+  update_max(path, level);
+}
+
+void BTreeFreeIndex::rekey(std::uint32_t offset, Extent e) noexcept {
+  Path path;
+  descend(offset, path);
+  const auto level = path.depth - 1;
+  auto &leaf = node(path.node[level]).leaf;
+  const auto s = path.slot[level];
+  if (s >= leaf.count || leaf.keys[s] != offset) {
+    return;
+  }
+  // In place if the new key routes down the same path; with no key in
+  // between, its position within the leaf holds too.
+  bool same_path = true;
+  for (std::size_t l = 0; l < level && same_path; ++l) {
+    same_path = child_slot(node(path.node[l]).inner, e.offset) == path.slot[l];
+  }
+  if (!same_path) {
+    erase(offset);
+    insert(e);
+    return;
+  }
+  leaf.keys[s] = e.offset;
+  leaf.sizes[s] = e.size;
+  update_max(path, level);
+}
+
+// ─── Verification ───────────────────────────────────────────────────────
+
+auto BTreeFreeIndex::verify_node(std::uint32_t i, std::size_t level,
+                                 std::uint64_t lo, std::uint64_t hi,
+                                 std::uint32_t &prev_leaf,
+                                 std::size_t &extents) const noexcept -> bool {
+  const auto &n = node(i);
+  if (n.leaf.is_leaf != 0) {
+    const auto &leaf = n.leaf;
+    if (level + 1 != depth_ || leaf.count == 0 ||
+        leaf.count > kLeafCapacity || leaf.prev != prev_leaf) {
+      return false;
+    }
+    if (prev_leaf != 0) {
+      const auto &p = node(prev_leaf).leaf;
+      if (p.next != i || std::uint64_t{p.keys[p.count - 1]} +
+                                 p.sizes[p.count - 1] >
+                             leaf.keys[0]) {
+        return false;
+      }
+    }
+    for (std::uint32_t s = 0; s < leaf.count; ++s) {
+      if (leaf.keys[s] < lo || leaf.keys[s] >= hi || leaf.sizes[s] == 0) {
+        return false;
+      }
+      if (s > 0 && std::uint64_t{leaf.keys[s - 1]} + leaf.sizes[s - 1] >
+                       leaf.keys[s]) {
+        return false;
+      }
+    }
+    prev_leaf = i;
+    extents += leaf.count;
+    return true;
+  }
+
+  const auto &in = n.inner;
+  if (in.count == 0 || in.count > kInnerCapacity ||
+      (level == 0 && in.count < 2)) {
+    return false;
+  }
+  for (std::uint32_t s = 0; s < in.count; ++s) {
+    std::uint64_t clo = s == 0 ? lo : in.keys[s - 1];
+    std::uint64_t chi = s + 1 == in.count ? hi : in.keys[s];
+    if (clo > chi || in.max[s] != node_max(in.children[s]) ||
+        !verify_node(in.children[s], level + 1, clo, chi, prev_leaf,
+                     extents)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto BTreeFreeIndex::verify() const noexcept -> bool {
+  if (root_ == 0) {
+    return count_ == 0 && depth_ == 0;
+  }
+  std::uint32_t prev_leaf = 0;
+  std::size_t extents = 0;
+  if (!verify_node(root_, 0, 0, std::uint64_t{1} << 32, prev_leaf,
+                   extents)) {
+    return false;
+  }
+  return node(prev_leaf).leaf.next == 0 && extents == count_;
+}
+
+} // namespace mmap_viz
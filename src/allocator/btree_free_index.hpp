@@ -0,0 +1,168 @@
+#pragma once
+/// @file btree_free_index.hpp
+/// @brief Out-of-line B+-tree of free extents, keyed by offset.
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace mmap_viz {
+
+/// @brief Free extents of one region, indexed outside the region itself.
+///
+/// A B+-tree of 64-byte nodes in its own mmap'd metadata area. Offsets and
+/// sizes are in 16-byte granules, 32 bits each, so regions up to 64 GB
+/// fit. Leaves hold 6 (offset, size) entries and link to their neighbours;
+/// inner nodes hold up to 5 children, each with the largest extent below
+/// it. A first-fit search reads one node, i.e. one cache line, per level
+/// and never touches the free memory it describes.
+///
+/// Erasing frees empty nodes and merges a leaf into a sibling when both
+/// fit in one, but does not otherwise rebalance: nodes may run under half
+/// full. The metadata area starts at one page and doubles on demand
+/// (mremap), so node indices, not pointers, link the tree.
+class BTreeFreeIndex {
+public:
+  /// @brief A free extent, in granules.
+  struct Extent {
+    std::uint32_t offset;
+    std::uint32_t size;
+  };
+
+  static constexpr std::size_t kGranule = 16;
+  static constexpr std::size_t kLeafCapacity = 6;
+  static constexpr std::size_t kInnerCapacity = 5; ///< Children.
+  /// Deep enough for 2^32 extents even at two children per inner node.
+  static constexpr std::size_t kMaxDepth = 34;
+
+  BTreeFreeIndex() noexcept;
+  ~BTreeFreeIndex();
+
+  BTreeFreeIndex(const BTreeFreeIndex &) = delete;
+  BTreeFreeIndex &operator=(const BTreeFreeIndex &) = delete;
+
+  /// @brief Add an extent. Its range must not overlap any other.
+  void insert(Extent e) noexcept;
+
+  /// @brief Remove the extent starting at @p offset.
+  /// @return false if there is none.
+  auto erase(std::uint32_t offset) noexcept -> bool;
+
+  /// @brief Replace the extent at @p offset by @p e, e.g. to shrink or grow
+  ///        it. No other extent may start between the two offsets.
+  void rekey(std::uint32_t offset, Extent e) noexcept;
+
+  /// @brief Lowest-offset extent of at least @p size granules.
+  [[nodiscard]] auto first_fit(std::uint32_t size) const noexcept
+      -> std::optional<Extent>;
+
+  /// @brief The extent starting exactly at @p offset.
+  [[nodiscard]] auto find(std::uint32_t offset) const noexcept
+      -> std::optional<Extent>;
+
+  /// @brief The highest-offset extent starting at or below @p offset.
+  [[nodiscard]] auto floor(std::uint32_t offset) const noexcept
+      -> std::optional<Extent>;
+
+  /// @brief Size of the largest extent, or 0.
+  [[nodiscard]] auto max_size() const noexcept -> std::uint32_t;
+
+  /// @brief Number of extents.
+  [[nodiscard]] auto size() const noexcept -> std::size_t { return count_; }
+
+  /// @brief Levels from the root to the leaves (1 for a lone leaf).
+  [[nodiscard]] auto depth() const noexcept -> std::size_t { return depth_; }
+
+  /// @brief Nodes in use, and metadata bytes they occupy.
+  [[nodiscard]] auto node_count() const noexcept -> std::size_t {
+    return live_nodes_;
+  }
+  [[nodiscard]] auto metadata_bytes() const noexcept -> std::size_t {
+    return live_nodes_ * sizeof(Node);
+  }
+
+  /// @brief Check ordering, separators, maxima and leaf links. O(n).
+  /// @return false at the first violation.
+  [[nodiscard]] auto verify() const noexcept -> bool;
+
+private:
+  struct Leaf {
+    std::uint16_t count;
+    std::uint16_t is_leaf; ///< 1.
+    std::uint32_t prev;    ///< Neighbour leaves, 0 at the ends.
+    std::uint32_t next;
+    std::uint32_t pad;
+    std::uint32_t keys[kLeafCapacity];
+    std::uint32_t sizes[kLeafCapacity];
+  };
+
+  /// Child i holds the keys in [keys[i - 1], keys[i]).
+  struct Inner {
+    std::uint16_t count;   ///< Children.
+    std::uint16_t is_leaf; ///< 0.
+    std::uint32_t keys[kInnerCapacity - 1];
+    std::uint32_t children[kInnerCapacity];
+    std::uint32_t max[kInnerCapacity]; ///< Largest extent in each child.
+  };
+
+  union alignas(64) Node {
+    Leaf leaf;
+    Inner inner;
+  };
+  static_assert(sizeof(Node) == 64);
+
+  /// @brief Root-to-leaf descent: node and the child slot taken in it.
+  struct Path {
+    std::uint32_t node[kMaxDepth];
+    std::uint32_t slot[kMaxDepth];
+    std::size_t depth = 0; ///< Entries used; the last one is the leaf.
+  };
+
+  [[nodiscard]] auto node(std::uint32_t i) const noexcept -> Node & {
+    return nodes_[i];
+  }
+  [[nodiscard]] auto alloc_node() noexcept -> std::uint32_t;
+  void free_node(std::uint32_t i) noexcept;
+  /// @brief Grow the area so @p n more nodes can be taken without moving.
+  void reserve(std::size_t n) noexcept;
+
+  /// @brief Descend towards @p key, filling @p path.
+  void descend(std::uint32_t key, Path &path) const noexcept;
+  [[nodiscard]] static auto child_slot(const Inner &in,
+                                       std::uint32_t key) noexcept
+      -> std::uint32_t;
+  [[nodiscard]] static auto leaf_slot(const Leaf &leaf,
+                                      std::uint32_t key) noexcept
+      -> std::uint32_t;
+  [[nodiscard]] auto node_max(std::uint32_t i) const noexcept
+      -> std::uint32_t;
+
+  /// @brief Refresh the max slots above path level @p level, stopping
+  ///        once a level is unchanged.
+  void update_max(const Path &path, std::size_t level) noexcept;
+
+  /// @brief Insert child @p right, keyed @p key, after the slot the path
+  ///        took at @p level; splits upwards as needed.
+  void insert_child(const Path &path, std::size_t level, std::uint32_t key,
+                    std::uint32_t right) noexcept;
+  /// @brief Remove child @p slot of the inner node at path @p level,
+  ///        freeing emptied nodes and collapsing a single-child root.
+  void remove_child(const Path &path, std::size_t level,
+                    std::uint32_t slot) noexcept;
+
+  auto verify_node(std::uint32_t i, std::size_t level, std::uint64_t lo,
+                   std::uint64_t hi, std::uint32_t &prev_leaf,
+                   std::size_t &extents) const noexcept -> bool;
+
+  Node *nodes_ = nullptr;       ///< Slot 0 is unused: index 0 = none.
+  std::size_t capacity_ = 0;    ///< Slots mapped.
+  std::uint32_t used_ = 1;      ///< Slots ever handed out.
+  std::uint32_t free_head_ = 0; ///< Recycled slots, linked via leaf.next.
+  std::size_t live_nodes_ = 0;
+
+  std::uint32_t root_ = 0;
+  std::size_t depth_ = 0;
+  std::size_t count_ = 0;
+};
+
+} // namespace mmap_viz
@@ -3,6 +3,8 @@
 /// Address-Ordered Red-Black Tree.
 
 #include "allocator/free_list.hpp"
+#include "allocator/profiled_size_classes.hpp"
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
@@ -87,21 +89,27 @@ thread_local AllocLog g_log;
     (n)->right = (r);                                                          \
   } while (0)
 
-FreeListAllocator::FreeListAllocator(std::byte *base, std::size_t size) noexcept
-    : base_{base}, size_{size} {
+template <typename SizeClasses>
+BasicFreeListAllocator<SizeClasses>::BasicFreeListAllocator(
+    std::byte *base, std::size_t size) noexcept
+    : base_{base}, size_{size},
+      tag_origin_{reinterpret_cast<std::uintptr_t>(base) &
+                  ~std::uintptr_t{kSmallBlockQuantum - 1}} {
   static_assert(sizeof(FreeBlock) <= 48, "FreeBlock too large");
+
+  // One bit per 16-byte granule: shard_size / 128 bytes, e.g. 32 B for a
+  // 4 KiB shard. calloc zeroes it, so every boundary starts clear; only
+  // a bitmap past glibc's mmap threshold (128 KiB, a 16 MiB shard) is
+  // mapped fresh and backed page by page as it is touched.
+  std::size_t granules = granule(base_ + size_) + 1;
+  tags_ = static_cast<std::uint64_t *>(
+      std::calloc((granules + 63) / 64, sizeof(std::uint64_t)));
+  if (tags_ == nullptr) {
+    std::fprintf(stderr, "FATAL: cannot allocate boundary bitmap (%zu B)\n",
+                 ((granules + 63) / 64) * sizeof(std::uint64_t));
+    std::abort();
+  }
   // Initialize sentinel node for leaves.
-  // We allocate it from the arena? No, that's messy.
-  // We can just use a static instance or a member instance?
-  // Member instance is safer for lifetime.
-  // But FreeBlock is huge now.
-  // Let's allocate it on the heap for now, or use a special location.
-  // Ah, we can't allocate from the allocator itself.
-  // We can treat nil_ as a special pointer value, but that complicates logic.
-  // Better to have a real object.
-  // Let's just `new` it on the C++ heap. It's one node per allocator.
-
-  nil_ = new FreeBlock();
   nil_->size = 0;
   nil_->parent = nil_;
   nil_->left = nil_;
@@ -132,39 +140,31 @@ FreeListAllocator::FreeListAllocator(std::byte *base, std::size_t size) noexcept
   }
 }
 
-// Check Allocator destructor? We aren't deleting nil_.
-// It's a leak of sizeof(FreeBlock) per Allocator instance.
-// But this is "Memory Mapping Visualization", likely long lived.
-// Ideally usage requires a destructor, but the class didn't have one
-// deklarated. We should add one if we want to be clean, but for now we follow
-// the existing style or just leak the sentinel. Actually, I can just make nil_
-// a member variable? `FreeBlock nil_node_;` `nil_ = &nil_node_;` But FreeBlock
-// is incomplete in header? No, it's defined in private. We can't change the
-// header again easily in this step. Let's just leak it for now, or use a
-// `std::unique_ptr` wrapper if we could. For the purpose of this task, leaking
-// one node on allocator destruction (which likely happens at program exit) is
-// acceptable for the prototype optimization.
+template <typename SizeClasses>
+BasicFreeListAllocator<SizeClasses>::~BasicFreeListAllocator() {
+  std::free(tags_);
+}
 
-auto FreeListAllocator::allocate(std::size_t size, std::size_t alignment)
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::allocate(std::size_t size,
+                                                   std::size_t alignment)
     -> std::expected<AllocationResult, AllocError> {
-  if (size == 0)
-    size = 1;
-
   // Enforce 16-byte alignment for internal structural integrity.
   // All FreeBlock headers MUST be 16-byte aligned.
   std::size_t internal_align = std::max(alignment, std::size_t(16));
-  std::size_t internal_size = (size + 15) & ~std::size_t(15);
+  std::size_t internal_size = block_size(size);
 
   // 1. Check small block segregated lists first
-  if (internal_size <= kMaxSmallBlockSize &&
-      internal_size >= kSmallBlockQuantum) {
-    std::size_t idx = (internal_size / kSmallBlockQuantum) - 1;
-    if (idx < kNumSmallClasses && free_lists_[idx]) {
+  if (internal_size <= SizeClasses::kMaxSize) {
+    std::size_t idx = SizeClasses::class_of(internal_size);
+    if (free_lists_[idx]) {
       auto *node = free_lists_[idx];
       free_lists_[idx] = node->next;
 
       allocated_ += internal_size;
       free_blocks_--;
+      count(&FreeListStats::small_list_hits);
+      count(&FreeListStats::allocations);
 
       return AllocationResult{
           .ptr = reinterpret_cast<std::byte *>(node),
@@ -173,6 +173,7 @@ auto FreeListAllocator::allocate(std::size_t size, std::size_t alignment)
           .actual_size = internal_size,
       };
     }
+    count(&FreeListStats::small_list_misses);
   }
 
   // 2. Search Red-Black Tree for first-fit
@@ -197,14 +198,16 @@ auto FreeListAllocator::allocate(std::size_t size, std::size_t alignment)
 
       // Handle Pre-Padding
       if (pre_padding >= kSmallBlockQuantum) {
+        count(&FreeListStats::splits);
         auto *gap_block = reinterpret_cast<FreeBlock *>(block_start);
         gap_block->size = pre_padding;
 
-        if (pre_padding <= kMaxSmallBlockSize) {
-          std::size_t idx = (pre_padding / kSmallBlockQuantum) - 1;
-          auto *node = reinterpret_cast<FreeNode *>(gap_block);
-          node->next = free_lists_[idx];
-          free_lists_[idx] = node;
+        // Gaps too short for the tree, or of a class size, go to a list.
+        if (pre_padding < kMinBlockSize ||
+            (pre_padding <= SizeClasses::kMaxSize &&
+             SizeClasses::size_of(SizeClasses::class_of(pre_padding)) ==
+                 pre_padding)) {
+          push_small(block_start, pre_padding);
         } else {
           ASSERT_NOT_NULL(nil_);
           gap_block->parent = nil_;
@@ -222,6 +225,7 @@ auto FreeListAllocator::allocate(std::size_t size, std::size_t alignment)
 
       bool absorbed = false;
       if (remainder_size >= kMinBlockSize) {
+        count(&FreeListStats::splits);
         auto *new_free = new (header_ptr + internal_size)
             FreeBlock{.size = remainder_size,
                       .parent = nil_,
@@ -231,26 +235,26 @@ auto FreeListAllocator::allocate(std::size_t size, std::size_t alignment)
                       .color = Color::Red};
         insert_node(new_free);
       } else if (remainder_size >= kSmallBlockQuantum) {
-        if (remainder_size <= kMaxSmallBlockSize) {
-          std::size_t idx = (remainder_size / kSmallBlockQuantum) - 1;
-          auto *node = reinterpret_cast<FreeNode *>(header_ptr + internal_size);
-          node->next = free_lists_[idx];
-          free_lists_[idx] = node;
-        } else {
-          absorbed = true;
-        }
+        push_small(header_ptr + internal_size, remainder_size);
+        count(&FreeListStats::splits);
       } else {
         absorbed = true;
       }
 
       if (absorbed) {
+        if (remainder_size > 0) {
+          count(&FreeListStats::absorbed_remainders);
+        }
         internal_size += remainder_size;
         free_blocks_--;
       }
 
       allocated_ += internal_size;
+      count(&FreeListStats::allocations);
 
-      verify_tree(root_);
+      if constexpr (kVerifyTree) {
+        verify_tree(root_);
+      }
       return AllocationResult{
           .ptr = header_ptr,
           .offset = static_cast<std::size_t>(header_ptr - base_),
@@ -259,15 +263,19 @@ auto FreeListAllocator::allocate(std::size_t size, std::size_t alignment)
     }
 
     curr = successor(curr);
+    count(&FreeListStats::successor_steps);
     while (curr != nil_ && curr->size < min_size) {
       curr = successor(curr);
+      count(&FreeListStats::successor_steps);
     }
   }
 
   return std::unexpected(AllocError::OutOfMemory);
 }
 
-auto FreeListAllocator::deallocate(std::byte *ptr, std::size_t size)
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::deallocate(std::byte *ptr,
+                                                     std::size_t size)
     -> std::expected<void, AllocError> {
   if (ptr == nullptr)
     return {};
@@ -295,118 +303,233 @@ auto FreeListAllocator::deallocate(std::byte *ptr, std::size_t size)
   std::size_t actual_size = size;
   // No header to find. 'ptr' is the start of the block.
 
-  if (actual_size <= kMaxSmallBlockSize) {
-    std::size_t idx = (actual_size / kSmallBlockQuantum) - 1;
-    if (idx >= kNumSmallClasses)
-      idx = kNumSmallClasses - 1;
-
-    auto *block = reinterpret_cast<FreeNode *>(ptr);
-
-    block->next = free_lists_[idx];
-    free_lists_[idx] = block;
-
+  // A block of a class size (give or take a partial granule) goes back to
+  // its list; so does anything too short for the tree, which 16, 32 and 48
+  // always being classes guarantees has one.
+  if (actual_size <= SizeClasses::kMaxSize &&
+      (actual_size < kMinBlockSize ||
+       actual_size - SizeClasses::size_of(SizeClasses::class_floor(
+                         actual_size)) <
+           kSmallBlockQuantum)) {
+    push_small(ptr, actual_size);
     allocated_ -= actual_size;
     free_blocks_++;
+    count(&FreeListStats::deallocations);
     return {};
   }
 
-  // Ensure block is large enough for RB metadata
-  if (actual_size < kMinBlockSize) {
-    std::size_t idx = kNumSmallClasses - 1;
-    auto *block = reinterpret_cast<FreeNode *>(ptr);
-    block->next = free_lists_[idx];
-    free_lists_[idx] = block;
-    allocated_ -= actual_size;
+  allocated_ -= actual_size;
+  count(&FreeListStats::deallocations);
+
+  // 1. Free neighbours, straight from the boundary bitmap.
+  auto *next = ptr + actual_size;
+  FreeBlock *succ = nil_;
+  if (next < end && tagged(granule(next))) {
+    succ = reinterpret_cast<FreeBlock *>(next);
+  }
+  FreeBlock *prev = nil_;
+  if (ptr > base && tagged(granule(ptr - 1))) {
+    std::size_t prev_size;
+    std::memcpy(&prev_size, ptr - sizeof(prev_size), sizeof(prev_size));
+    if (prev_size > static_cast<std::size_t>(ptr - base) || prev_size == 0) {
+      std::fprintf(stderr, "FATAL: coalescing with garbage prev_size %zu\n",
+                   prev_size);
+      std::fflush(stderr);
+      g_log.dump();
+      std::abort();
+    }
+    prev = reinterpret_cast<FreeBlock *>(ptr - prev_size);
+  }
+
+  std::size_t succ_size = 0;
+  if (succ != nil_) {
+    succ_size = succ->size;
+    if (succ_size > static_cast<std::size_t>(end - next) || succ_size == 0) {
+      std::fprintf(stderr, "FATAL: coalescing with garbage succ_size %zu\n",
+                   succ_size);
+      std::fflush(stderr);
+      g_log.dump();
+      std::abort();
+    }
+  }
+
+  // 2. Merge, touching the tree at most once per neighbour.
+  if (prev != nil_) {
+    // The predecessor keeps its address, hence its place in the tree: grow
+    // it in place. A successor too is absorbed and leaves the tree.
+    unmark_free(prev);
+    if (succ != nil_) {
+      delete_node(succ);
+      free_blocks_--;
+      count(&FreeListStats::coalesces);
+    }
+    prev->size += actual_size + succ_size;
+    mark_free(prev);
+    grow_max_upwards(prev);
+    count(&FreeListStats::coalesces);
+  } else if (succ != nil_) {
+    // Nothing lies between the freed block and its successor, so the freed
+    // block takes over the successor's node as is.
+    auto *freed = reinterpret_cast<FreeBlock *>(ptr);
+    unmark_free(succ);
+    replace_node(succ, freed);
+    freed->size = actual_size + succ_size;
+    mark_free(freed);
+    grow_max_upwards(freed);
+    count(&FreeListStats::coalesces);
+  } else {
+    auto *freed = new (ptr) FreeBlock{.size = actual_size,
+                                      .parent = nil_,
+                                      .left = nil_,
+                                      .right = nil_,
+                                      .subtree_max = actual_size,
+                                      .color = Color::Red};
+    insert_node(freed);
     free_blocks_++;
-    return {};
   }
 
-  auto *block_addr = ptr;
+  if constexpr (kVerifyTree) {
+    verify_tree(root_);
+  }
+  return {};
+}
 
-  // 1. Find potential neighbors in address-ordered tree
-  // We insert a temporary node to find predecessor/successor
-  auto *freed = new (block_addr) FreeBlock{.size = actual_size,
-                                           .parent = nil_,
-                                           .left = nil_,
-                                           .right = nil_,
-                                           .subtree_max = actual_size,
-                                           .color = Color::Red};
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::push_small(
+    std::byte *p, std::size_t size) noexcept {
+  auto &list = free_lists_[SizeClasses::class_floor(size)];
+  auto *node = reinterpret_cast<FreeNode *>(p);
+  node->next = list;
+  list = node;
+}
 
-  insert_node(freed);
-  free_blocks_++;
-  allocated_ -= actual_size;
+// ─── Region edges ────────────────────────────────────────────────────────
 
-  // 2. Coalesce with Successor
-  auto *succ = successor(freed);
-  if (succ != nil_) {
-    auto *freed_end = reinterpret_cast<std::byte *>(freed) + freed->size;
-    if (freed_end == reinterpret_cast<std::byte *>(succ)) {
-      std::size_t succ_size = succ->size;
-      if (succ_size > size_ || succ_size == 0) {
-        std::fprintf(stderr, "FATAL: coalescing with garbage succ_size %zu\n",
-                     succ_size);
-        std::fflush(stderr);
-        g_log.dump();
-        std::abort();
-      }
-      delete_node(succ);
-      freed->size += succ_size;
-      update_max_upwards(freed);
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::free_tail() const noexcept
+    -> std::size_t {
+  // Tree blocks span at least 4 granules, so a set last bit is an end.
+  if (size_ < kMinBlockSize || !tagged(granule(base_ + size_ - 1))) {
+    return 0;
+  }
+  std::size_t tail;
+  std::memcpy(&tail, base_ + size_ - sizeof(tail), sizeof(tail));
+  return tail;
+}
+
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::free_head() const noexcept
+    -> std::size_t {
+  if (size_ < kMinBlockSize || !tagged(granule(base_))) {
+    return 0;
+  }
+  return reinterpret_cast<const FreeBlock *>(base_)->size;
+}
+
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::take_tail(std::size_t n) noexcept {
+  const std::size_t tail = free_tail();
+  auto *b = reinterpret_cast<FreeBlock *>(base_ + size_ - tail);
+  const std::size_t rest = tail - n;
+  if (rest >= kMinBlockSize) {
+    // Keeps its address, so its place in the tree.
+    unmark_free(b);
+    b->size = rest;
+    mark_free(b);
+    update_max_upwards(b);
+  } else {
+    delete_node(b);
+    if (rest >= kSmallBlockQuantum) {
+      push_small(reinterpret_cast<std::byte *>(b), rest);
+    } else {
       free_blocks_--;
     }
   }
+  allocated_ += n;
+  count(&FreeListStats::allocations);
+  if constexpr (kVerifyTree) {
+    verify_tree(root_);
+  }
+}
 
-  // 3. Coalesce with Predecessor
-  auto *prev = predecessor(freed);
-  if (prev != nil_) {
-    auto *prev_end = reinterpret_cast<std::byte *>(prev) + prev->size;
-    if (prev_end == reinterpret_cast<std::byte *>(freed)) {
-      std::size_t freed_size = freed->size;
-      if (freed_size > size_ || freed_size == 0) {
-        std::fprintf(stderr, "FATAL: coalescing with garbage freed_size %zu\n",
-                     freed_size);
-        std::fflush(stderr);
-        g_log.dump();
-        std::abort();
-      }
-      delete_node(freed);
-      prev->size += freed_size;
-      update_max_upwards(prev);
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::take_head(std::size_t n) noexcept {
+  const std::size_t head = free_head();
+  auto *b = reinterpret_cast<FreeBlock *>(base_);
+  const std::size_t rest = head - n;
+  if (rest >= kMinBlockSize && n >= sizeof(FreeBlock)) {
+    // Nothing lies between the two, so the remainder takes over the node
+    // (if its header does not overlap the old one).
+    auto *moved = reinterpret_cast<FreeBlock *>(base_ + n);
+    unmark_free(b);
+    replace_node(b, moved);
+    moved->size = rest;
+    mark_free(moved);
+    update_max_upwards(moved);
+  } else {
+    delete_node(b);
+    if (rest >= kMinBlockSize) {
+      insert_node(new (base_ + n) FreeBlock{.size = rest,
+                                            .parent = nil_,
+                                            .left = nil_,
+                                            .right = nil_,
+                                            .subtree_max = rest,
+                                            .color = Color::Red});
+    } else if (rest >= kSmallBlockQuantum) {
+      push_small(base_ + n, rest);
+    } else {
       free_blocks_--;
     }
   }
-
-  verify_tree(root_);
-  return {};
+  allocated_ += n;
+  count(&FreeListStats::allocations);
+  if constexpr (kVerifyTree) {
+    verify_tree(root_);
+  }
 }
 
-auto FreeListAllocator::bytes_allocated() const noexcept -> std::size_t {
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::bytes_allocated() const noexcept
+    -> std::size_t {
   return allocated_;
 }
 
-auto FreeListAllocator::bytes_free() const noexcept -> std::size_t {
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::bytes_free() const noexcept
+    -> std::size_t {
   return size_ - allocated_;
 }
 
-auto FreeListAllocator::largest_free_block() const noexcept -> std::size_t {
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::largest_free_block() const noexcept
+    -> std::size_t {
   if (root_ == nil_)
     return 0;
   return root_->subtree_max;
 }
 
-auto FreeListAllocator::free_block_count() const noexcept -> std::size_t {
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::free_block_count() const noexcept
+    -> std::size_t {
   return free_blocks_;
 }
 
-auto FreeListAllocator::capacity() const noexcept -> std::size_t {
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::capacity() const noexcept
+    -> std::size_t {
   return size_;
 }
 
-auto FreeListAllocator::base() const noexcept -> std::byte * { return base_; }
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::base() const noexcept
+    -> std::byte * {
+  return base_;
+}
 
 // --- RB Tree Implementation ---
 
-void FreeListAllocator::left_rotate(FreeBlock *x) {
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::left_rotate(FreeBlock *x) {
   FreeBlock *y = x->right;
   ASSERT_NOT_NULL(y);
   SET_RIGHT(x, y->left);
@@ -425,6 +548,7 @@ void FreeListAllocator::left_rotate(FreeBlock *x) {
   SET_PARENT(x, y);
 
   g_log.add("left_rotate", x, x->parent, x->left, x->right, x->size);
+  count(&FreeListStats::rotations);
 
   // Update max. Note: y's max becomes what x's was, then we re-derive.
   y->subtree_max = x->subtree_max;
@@ -432,7 +556,8 @@ void FreeListAllocator::left_rotate(FreeBlock *x) {
   update_max(y);
 }
 
-void FreeListAllocator::right_rotate(FreeBlock *x) {
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::right_rotate(FreeBlock *x) {
   FreeBlock *y = x->left;
   ASSERT_NOT_NULL(y);
   SET_LEFT(x, y->right);
@@ -451,6 +576,7 @@ void FreeListAllocator::right_rotate(FreeBlock *x) {
   SET_PARENT(x, y);
 
   g_log.add("right_rotate", x, x->parent, x->left, x->right, x->size);
+  count(&FreeListStats::rotations);
 
   // Update max. Note: y's max becomes what x's was, then we re-derive.
   y->subtree_max = x->subtree_max;
@@ -458,11 +584,12 @@ void FreeListAllocator::right_rotate(FreeBlock *x) {
   update_max(y);
 }
 
-void FreeListAllocator::insert_node(FreeBlock *z) {
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::insert_node(FreeBlock *z) {
   if (z == nullptr || z == nil_)
     return;
 
-  if (z->size > 1024 * 1024 * 1024 || z->size == 0) {
+  if (z->size > size_ || z->size == 0) {
     std::fprintf(stderr, "FATAL: insert_node with garbage size %zu at %p\n",
                  z->size, (void *)z);
     std::fflush(stderr);
@@ -481,10 +608,12 @@ void FreeListAllocator::insert_node(FreeBlock *z) {
 
   FreeBlock *y = nil_;
   FreeBlock *x = root_;
+  std::uint64_t depth = 0;
 
   // Key is Address
   while (x != nil_) {
     ASSERT_NOT_NULL(x);
+    ++depth;
     y = x;
     if (z < x) {
       x = x->left;
@@ -512,13 +641,20 @@ void FreeListAllocator::insert_node(FreeBlock *z) {
   z->subtree_max = z->size;
 
   g_log.add("insert_node", z, z->parent, z->left, z->right, z->size);
+  count(&FreeListStats::inserts);
+  count(&FreeListStats::insert_depth_total, depth);
+  if constexpr (kStatsEnabled) {
+    stats_.insert_depth_max = std::max(stats_.insert_depth_max, depth);
+  }
 
   update_max_upwards(z);
+  mark_free(z);
 
   rb_insert_fixup(z);
 }
 
-void FreeListAllocator::rb_insert_fixup(FreeBlock *z) {
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::rb_insert_fixup(FreeBlock *z) {
   while (z != nullptr && z->parent != nullptr &&
          z->parent->color == Color::Red) {
     ASSERT_NOT_NULL(z->parent->parent);
@@ -559,7 +695,9 @@ void FreeListAllocator::rb_insert_fixup(FreeBlock *z) {
   root_->color = Color::Black;
 }
 
-void FreeListAllocator::rb_transplant(FreeBlock *u, FreeBlock *v) {
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::rb_transplant(FreeBlock *u,
+                                                        FreeBlock *v) {
   if (u->parent == nil_) {
     root_ = v;
   } else if (u == u->parent->left) {
@@ -572,7 +710,8 @@ void FreeListAllocator::rb_transplant(FreeBlock *u, FreeBlock *v) {
   }
 }
 
-void FreeListAllocator::delete_node(FreeBlock *z) {
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::delete_node(FreeBlock *z) {
   if (z->parent == nil_) {
     // Parent is nil (root), this is fine.
   }
@@ -587,6 +726,8 @@ void FreeListAllocator::delete_node(FreeBlock *z) {
 
   FreeBlock *x_parent = nil_;
 
+  unmark_free(z);
+
   if (z->left == nil_) {
     x = z->right;
     x_parent = z->parent;
@@ -638,7 +779,9 @@ void FreeListAllocator::delete_node(FreeBlock *z) {
   }
 }
 
-void FreeListAllocator::rb_delete_fixup(FreeBlock *x, FreeBlock *x_parent) {
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::rb_delete_fixup(FreeBlock *x,
+                                                          FreeBlock *x_parent) {
   while (x != root_ &&
          (x == nil_ || (x != nullptr && x->color == Color::Black))) {
     ASSERT_NOT_NULL(x_parent);
@@ -700,21 +843,47 @@ void FreeListAllocator::rb_delete_fixup(FreeBlock *x, FreeBlock *x_parent) {
     x->color = Color::Black;
 }
 
-auto FreeListAllocator::minimum(FreeBlock *x) const -> FreeBlock * {
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::replace_node(FreeBlock *u,
+                                                       FreeBlock *v) {
+  v->parent = u->parent;
+  v->left = u->left;
+  v->right = u->right;
+  v->color = u->color;
+  v->subtree_max = u->subtree_max;
+  if (u->parent == nil_) {
+    root_ = v;
+  } else if (u == u->parent->left) {
+    SET_LEFT(u->parent, v);
+  } else {
+    SET_RIGHT(u->parent, v);
+  }
+  SET_PARENT(v->left, v);
+  SET_PARENT(v->right, v);
+  g_log.add("replace_node", v, v->parent, v->left, v->right, v->size);
+}
+
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::minimum(FreeBlock *x) const
+    -> FreeBlock * {
   while (x->left != nil_) {
     x = x->left;
   }
   return x;
 }
 
-auto FreeListAllocator::maximum(FreeBlock *x) const -> FreeBlock * {
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::maximum(FreeBlock *x) const
+    -> FreeBlock * {
   while (x->right != nil_) {
     x = x->right;
   }
   return x;
 }
 
-auto FreeListAllocator::predecessor(FreeBlock *x) const -> FreeBlock * {
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::predecessor(FreeBlock *x) const
+    -> FreeBlock * {
   if (x->left != nil_) {
     return maximum(x->left);
   }
@@ -726,7 +895,9 @@ auto FreeListAllocator::predecessor(FreeBlock *x) const -> FreeBlock * {
   return y;
 }
 
-auto FreeListAllocator::successor(FreeBlock *x) const -> FreeBlock * {
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::successor(FreeBlock *x) const
+    -> FreeBlock * {
   if (x->right != nil_) {
     return minimum(x->right);
   }
@@ -738,7 +909,8 @@ auto FreeListAllocator::successor(FreeBlock *x) const -> FreeBlock * {
   return y;
 }
 
-void FreeListAllocator::update_max_upwards(FreeBlock *x) {
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::update_max_upwards(FreeBlock *x) {
   while (x != nil_ && x != nullptr) {
     std::size_t old_max = x->subtree_max;
     update_max(x);
@@ -751,7 +923,18 @@ void FreeListAllocator::update_max_upwards(FreeBlock *x) {
   }
 }
 
-void FreeListAllocator::update_max(FreeBlock *x) {
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::grow_max_upwards(FreeBlock *x) {
+  update_max(x);
+  // A larger max only propagates until an ancestor already covers it.
+  std::size_t m = x->subtree_max;
+  for (x = x->parent; x != nil_ && x->subtree_max < m; x = x->parent) {
+    x->subtree_max = m;
+  }
+}
+
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::update_max(FreeBlock *x) {
   if (x == nil_ || x == nullptr)
     return;
   x->subtree_max = x->size;
@@ -763,9 +946,33 @@ void FreeListAllocator::update_max(FreeBlock *x) {
   }
 }
 
-auto FreeListAllocator::find_first_fit(std::size_t size) const -> FreeBlock * {
+// --- Boundary bitmap ---
+
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::mark_free(FreeBlock *b) noexcept {
+  auto *start = reinterpret_cast<std::byte *>(b);
+  std::size_t first = granule(start);
+  std::size_t last = granule(start + b->size - 1);
+  tags_[first / 64] |= std::uint64_t{1} << (first % 64);
+  tags_[last / 64] |= std::uint64_t{1} << (last % 64);
+  std::memcpy(start + b->size - sizeof(b->size), &b->size, sizeof(b->size));
+}
+
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::unmark_free(FreeBlock *b) noexcept {
+  auto *start = reinterpret_cast<std::byte *>(b);
+  std::size_t first = granule(start);
+  std::size_t last = granule(start + b->size - 1);
+  tags_[first / 64] &= ~(std::uint64_t{1} << (first % 64));
+  tags_[last / 64] &= ~(std::uint64_t{1} << (last % 64));
+}
+
+template <typename SizeClasses>
+auto BasicFreeListAllocator<SizeClasses>::find_first_fit(std::size_t size) const
+    -> FreeBlock * {
   FreeBlock *x = root_;
   FreeBlock *result = nil_;
+  count(&FreeListStats::fit_searches);
 
   // We want the node with the SMALLEST address (Leftmost) that satisfies
   // node.size >= size? No, we want the node with SMALLEST address (Leftmost)
@@ -775,6 +982,7 @@ auto FreeListAllocator::find_first_fit(std::size_t size) const -> FreeBlock * {
   // candidate.
 
   while (x != nil_) {
+    count(&FreeListStats::fit_nodes_visited);
     if (x->left != nil_ && x->left->subtree_max >= size) {
       // There is a candidate on the left.
       // We MUST go left to find the first (address-ordered) contact.
@@ -801,7 +1009,8 @@ auto FreeListAllocator::find_first_fit(std::size_t size) const -> FreeBlock * {
   return nil_;
 }
 
-void FreeListAllocator::verify_tree(FreeBlock *x) const {
+template <typename SizeClasses>
+void BasicFreeListAllocator<SizeClasses>::verify_tree(FreeBlock *x) const {
   if (x == nil_ || x == nullptr)
     return;
 
@@ -823,6 +1032,17 @@ void FreeListAllocator::verify_tree(FreeBlock *x) const {
     }
     verify_tree(x->left);
   }
+  auto *start = reinterpret_cast<const std::byte *>(x);
+  std::size_t footer;
+  std::memcpy(&footer, start + x->size - sizeof(footer), sizeof(footer));
+  if (!tagged(granule(start)) || !tagged(granule(start + x->size - 1)) ||
+      footer != x->size) {
+    std::fprintf(stderr,
+                 "RB-Tree Error: boundary tags of %p (size %zu) are stale\n",
+                 (void *)x, x->size);
+    g_log.dump();
+    std::abort();
+  }
   if (x->right != nil_) {
     if (x->right->parent != x) {
       std::fprintf(stderr,
@@ -851,4 +1071,8 @@ void FreeListAllocator::verify_tree(FreeBlock *x) const {
   }
 }
 
+template class BasicFreeListAllocator<LinearSizeClasses<>>;
+template class BasicFreeListAllocator<GeometricSizeClasses<>>;
+template class BasicFreeListAllocator<ProfiledSizeClasses>;
+
 } // namespace mmap_viz
@@ -2,7 +2,10 @@
 /// @file free_list.hpp
 /// @brief First-fit free-list allocator operating over an Arena.
 
+#include "allocator/size_classes.hpp"
+
 #include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <string>
 
@@ -40,23 +43,106 @@ struct AllocationResult {
   std::size_t actual_size; ///< Size including alignment padding.
 };
 
+/// @brief Hot-path counters of one FreeListAllocator.
+///
+/// Maintained only when built with MMAP_VIZ_ALLOC_STATS (the CMake option
+/// of the same name); otherwise the counting compiles away and every field
+/// stays 0. Counters are monotonic since construction.
+struct FreeListStats {
+  std::uint64_t allocations = 0;   ///< Successful allocate() calls.
+  std::uint64_t deallocations = 0; ///< Successful deallocate() calls.
+
+  std::uint64_t small_list_hits = 0;   ///< Served by a segregated list.
+  std::uint64_t small_list_misses = 0; ///< Small request, list empty.
+
+  std::uint64_t fit_searches = 0;      ///< find_first_fit() calls.
+  std::uint64_t fit_nodes_visited = 0; ///< Nodes visited by those calls.
+  std::uint64_t successor_steps = 0;   ///< Steps past misaligned fits.
+
+  std::uint64_t inserts = 0;            ///< Tree insertions.
+  std::uint64_t insert_depth_total = 0; ///< Sum of insertion depths.
+  std::uint64_t insert_depth_max = 0;   ///< Deepest insertion seen.
+  std::uint64_t rotations = 0;          ///< Left and right rotations.
+
+  std::uint64_t splits = 0;    ///< Remainders/alignment gaps split off.
+  std::uint64_t coalesces = 0; ///< Merges with a free neighbour.
+  std::uint64_t absorbed_remainders = 0; ///< Remainders left in the block.
+
+  /// @brief Fraction of small requests served by a segregated list.
+  [[nodiscard]] auto small_list_hit_rate() const noexcept -> double {
+    auto total = small_list_hits + small_list_misses;
+    return total == 0 ? 0.0 : static_cast<double>(small_list_hits) / total;
+  }
+
+  /// @brief Average nodes visited per find_first_fit() call.
+  [[nodiscard]] auto mean_fit_visits() const noexcept -> double {
+    return fit_searches == 0
+               ? 0.0
+               : static_cast<double>(fit_nodes_visited) / fit_searches;
+  }
+
+  /// @brief Average tree depth at which new free blocks were inserted.
+  [[nodiscard]] auto mean_insert_depth() const noexcept -> double {
+    return inserts == 0 ? 0.0
+                        : static_cast<double>(insert_depth_total) / inserts;
+  }
+
+  /// @brief Rotations per allocate/deallocate.
+  [[nodiscard]] auto rotations_per_op() const noexcept -> double {
+    auto ops = allocations + deallocations;
+    return ops == 0 ? 0.0 : static_cast<double>(rotations) / ops;
+  }
+
+  /// @brief Accumulate another allocator's counters (max for depth).
+  auto operator+=(const FreeListStats &o) noexcept -> FreeListStats & {
+    allocations += o.allocations;
+    deallocations += o.deallocations;
+    small_list_hits += o.small_list_hits;
+    small_list_misses += o.small_list_misses;
+    fit_searches += o.fit_searches;
+    fit_nodes_visited += o.fit_nodes_visited;
+    successor_steps += o.successor_steps;
+    inserts += o.inserts;
+    insert_depth_total += o.insert_depth_total;
+    insert_depth_max = insert_depth_max > o.insert_depth_max
+                           ? insert_depth_max
+                           : o.insert_depth_max;
+    rotations += o.rotations;
+    splits += o.splits;
+    coalesces += o.coalesces;
+    absorbed_remainders += o.absorbed_remainders;
+    return *this;
+  }
+};
+
 /// @brief First-fit free-list allocator backed by an Arena.
 ///
 /// Maintains an intrusive linked list of free blocks stored within
 /// the free regions themselves (zero metadata overhead for free blocks).
 /// Supports coalescing on deallocate and splitting on allocate.
-class FreeListAllocator {
+///
+/// Tree blocks are also marked in a side bitmap of 16-byte granules, set at
+/// each block's first and last granule, and carry their size in their last
+/// word. deallocate() finds free neighbours from the bitmap in O(1) and
+/// merges them in place, without tree lookups or a re-insert.
+///
+/// @tparam SizeClasses The SizeClassScheme of the segregated lists. The
+///         definitions live in free_list.cpp and are instantiated there for
+///         the schemes aliased below; another scheme needs its own explicit
+///         instantiation added there.
+template <typename SizeClasses> class BasicFreeListAllocator {
 public:
   /// @brief Construct a free-list allocator over the given memory range.
   /// @param base Start of the memory region.
   /// @param size Size of the memory region in bytes.
-  FreeListAllocator(std::byte *base, std::size_t size) noexcept;
+  BasicFreeListAllocator(std::byte *base, std::size_t size) noexcept;
+  ~BasicFreeListAllocator();
 
   // Non-copyable, non-movable (references an arena).
-  FreeListAllocator(const FreeListAllocator &) = delete;
-  FreeListAllocator &operator=(const FreeListAllocator &) = delete;
-  FreeListAllocator(FreeListAllocator &&) = delete;
-  FreeListAllocator &operator=(FreeListAllocator &&) = delete;
+  BasicFreeListAllocator(const BasicFreeListAllocator &) = delete;
+  BasicFreeListAllocator &operator=(const BasicFreeListAllocator &) = delete;
+  BasicFreeListAllocator(BasicFreeListAllocator &&) = delete;
+  BasicFreeListAllocator &operator=(BasicFreeListAllocator &&) = delete;
 
   /// @brief Allocate a block of at least @p size bytes with given @p alignment.
   /// @param size     Requested size in bytes (must be > 0).
@@ -66,6 +152,27 @@ public:
                               std::size_t alignment = alignof(std::max_align_t))
       -> std::expected<AllocationResult, AllocError>;
 
+  /// @brief Largest request served from a size-class list.
+  static constexpr std::size_t kMaxSmallSize = SizeClasses::kMaxSize;
+
+  /// @brief Block size allocate() hands out for a request of @p size bytes,
+  ///        i.e. the AllocationResult::actual_size it will report: the
+  ///        size class up to SizeClasses::kMaxSize, whole granules above.
+  ///
+  /// Exact whenever the managed region is 16-byte aligned and a multiple of
+  /// 16 bytes long (as every VisualizationArena shard is): all free blocks
+  /// are then too, so a remainder is either split off or empty. Lets a
+  /// caller that remembers the request size free without storing the block
+  /// size.
+  [[nodiscard]] static constexpr auto block_size(std::size_t size) noexcept
+      -> std::size_t {
+    const std::size_t b = ((size == 0 ? 1 : size) + kSmallBlockQuantum - 1) &
+                          ~(kSmallBlockQuantum - 1);
+    return b <= SizeClasses::kMaxSize
+               ? SizeClasses::size_of(SizeClasses::class_of(b))
+               : b;
+  }
+
   /// @brief Deallocate a previously allocated block.
   /// @param ptr  Pointer returned by allocate().
   /// @param size Size passed to allocate().
@@ -85,12 +192,45 @@ public:
   /// @brief Number of free blocks in the list (fragmentation indicator).
   [[nodiscard]] auto free_block_count() const noexcept -> std::size_t;
 
+  /// @brief Size of the free tree block ending at the end of the region, or
+  ///        0 if the last granule is in use or on a list. O(1), from the
+  ///        boundary bitmap.
+  [[nodiscard]] auto free_tail() const noexcept -> std::size_t;
+
+  /// @brief As free_tail(), for a free block starting at base().
+  [[nodiscard]] auto free_head() const noexcept -> std::size_t;
+
+  /// @brief Allocate the last @p n bytes of the region, which must lie in
+  ///        free_tail(); @p n is a multiple of 16. Freed by deallocate()
+  ///        like any block.
+  void take_tail(std::size_t n) noexcept;
+
+  /// @brief As take_tail(), for the first @p n bytes of free_head().
+  void take_head(std::size_t n) noexcept;
+
   /// @brief Total capacity of the backing arena.
   [[nodiscard]] auto capacity() const noexcept -> std::size_t;
 
   /// @brief Base address of the arena.
   [[nodiscard]] auto base() const noexcept -> std::byte *;
 
+  /// @brief Whether this build maintains FreeListStats.
+#ifdef MMAP_VIZ_ALLOC_STATS
+  static constexpr bool kStatsEnabled = true;
+#else
+  static constexpr bool kStatsEnabled = false;
+#endif
+
+  /// @brief Whether every allocate/deallocate re-checks the whole tree.
+#ifdef MMAP_VIZ_VERIFY_TREE
+  static constexpr bool kVerifyTree = true;
+#else
+  static constexpr bool kVerifyTree = false;
+#endif
+
+  /// @brief Hot-path counters; all zero unless kStatsEnabled.
+  [[nodiscard]] auto stats() const noexcept -> FreeListStats { return stats_; }
+
   /// @brief Check if this allocator owns the given pointer.
   [[nodiscard]] bool contains(const void *ptr) const noexcept {
     const auto *p = reinterpret_cast<const std::byte *>(ptr);
@@ -110,8 +250,9 @@ private:
     Color color;             ///< RB Color.
   };
 
-  /// @brief Minimum size required to store a FreeBlock header.
-  static constexpr std::size_t kMinBlockSize = sizeof(FreeBlock);
+  /// @brief Minimum tree block: a FreeBlock header plus a size footer.
+  static constexpr std::size_t kMinBlockSize = 64;
+  static_assert(sizeof(FreeBlock) + sizeof(std::size_t) <= kMinBlockSize);
 
   // --- RB Tree Helpers ---
   void insert_node(FreeBlock *z);
@@ -122,9 +263,15 @@ private:
   void left_rotate(FreeBlock *x);
   void right_rotate(FreeBlock *x);
 
+  /// @brief Put @p v in @p u's place in the tree, links and colour alike.
+  ///        Valid only when no other node's key lies between the two.
+  void replace_node(FreeBlock *u, FreeBlock *v);
+
   /// @brief Updates subtree_max for x and its ancestors.
   void update_max(FreeBlock *x);
   void update_max_upwards(FreeBlock *x);
+  /// @brief update_max_upwards() after x->size grew; stops early.
+  void grow_max_upwards(FreeBlock *x);
 
   /// @brief Finds the first block in address order that fits the size.
   [[nodiscard]] auto find_first_fit(std::size_t size) const -> FreeBlock *;
@@ -137,24 +284,65 @@ private:
   std::byte *base_;
   std::size_t size_;
   FreeBlock *root_ = nullptr; ///< Root of the address-ordered RB tree.
-  FreeBlock *nil_;            ///< Sentinel node for leaves.
+  FreeBlock sentinel_{};      ///< Leaf sentinel, in the allocator itself.
+  FreeBlock *nil_ = &sentinel_;
 
   // Segregated Free Lists for small allocations (O(1))
-  static constexpr std::size_t kSmallBlockQuantum = 16;
-  static constexpr std::size_t kNumSmallClasses = 8;
-  static constexpr std::size_t kMaxSmallBlockSize =
-      kSmallBlockQuantum * kNumSmallClasses;
+  static constexpr std::size_t kSmallBlockQuantum = size_classes::kGranule;
 
   struct FreeNode {
     FreeNode *next;
   };
 
-  FreeNode *free_lists_[kNumSmallClasses];
+  FreeNode *free_lists_[SizeClasses::kCount];
+
+  /// @brief Push a free block of @p size bytes on its class's list.
+  void push_small(std::byte *p, std::size_t size) noexcept;
+
+  // --- Boundary bitmap ---
+  // One bit per 16-byte granule, set at the first and last granule of each
+  // tree block. Tree blocks span at least 4 granules, so a set bit just
+  // before a block is always a free predecessor's end and one just after
+  // it a free successor's start. Small-list blocks are never marked.
+  std::uint64_t *tags_ = nullptr;
+  std::uintptr_t tag_origin_; ///< base_ rounded down to a granule.
+
+  [[nodiscard]] auto granule(const void *p) const noexcept -> std::size_t {
+    return (reinterpret_cast<std::uintptr_t>(p) - tag_origin_) /
+           kSmallBlockQuantum;
+  }
+  [[nodiscard]] auto tagged(std::size_t g) const noexcept -> bool {
+    return ((tags_[g / 64] >> (g % 64)) & 1) != 0;
+  }
+  /// @brief Set both boundary bits and the size footer of @p b.
+  void mark_free(FreeBlock *b) noexcept;
+  /// @brief Clear both boundary bits of @p b.
+  void unmark_free(FreeBlock *b) noexcept;
 
   void verify_tree(FreeBlock *x) const;
 
   std::size_t allocated_ = 0;
   std::size_t free_blocks_ = 0;
+
+  /// Mutable so const searches (find_first_fit) can count too.
+  mutable FreeListStats stats_;
+
+  /// @brief stats_.*field += n, or nothing without MMAP_VIZ_ALLOC_STATS.
+  void count(std::uint64_t FreeListStats::*field,
+             std::uint64_t n = 1) const noexcept {
+    if constexpr (kStatsEnabled) {
+      stats_.*field += n;
+    }
+  }
 };
 
+/// @brief The original scheme: 8 lists 16 bytes apart, up to 128 B.
+using FreeListAllocator = BasicFreeListAllocator<LinearSizeClasses<>>;
+/// @brief jemalloc-style lists, 4 per doubling up to 1 KB.
+using GeometricFreeListAllocator =
+    BasicFreeListAllocator<GeometricSizeClasses<>>;
+
+extern template class BasicFreeListAllocator<LinearSizeClasses<>>;
+extern template class BasicFreeListAllocator<GeometricSizeClasses<>>;
+
 } // namespace mmap_viz
@@ -0,0 +1,22 @@
+#pragma once
+/// @file profiled_size_classes.hpp
+/// @brief Size classes fitted by tools/size_class_gen.
+///
+/// Fitted to tools/server_mix_sizes.txt: 20 classes up to 1024 B, with
+/// 5.67% of the bytes those requests take lost to rounding.
+/// Generated, do not edit; see tools/size_class_gen.cpp.
+
+#include "allocator/free_list.hpp"
+
+namespace mmap_viz {
+
+using ProfiledSizeClasses =
+    TableSizeClasses<16, 32, 48, 64, 112, 176, 192, 208, 224, 272, 320, 368,
+                     416, 464, 512, 608, 704, 800, 912, 1024>;
+
+/// @brief FreeListAllocator with the fitted lists.
+using ProfiledFreeListAllocator = BasicFreeListAllocator<ProfiledSizeClasses>;
+
+extern template class BasicFreeListAllocator<ProfiledSizeClasses>;
+
+} // namespace mmap_viz
@@ -0,0 +1,156 @@
+#pragma once
+/// @file size_classes.hpp
+/// @brief Compile-time size-class schemes for FreeListAllocator's lists.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace mmap_viz {
+
+namespace size_classes {
+
+/// @brief Granule every class size is a multiple of.
+inline constexpr std::size_t kGranule = 16;
+
+/// @brief Whether @p sizes is a usable scheme: ascending multiples of the
+///        granule, starting 16, 32, 48.
+///
+/// Fragments shorter than a 64-byte tree block can only go to a list, so
+/// every such size must be a class of its own.
+template <std::size_t N>
+constexpr auto valid(const std::array<std::size_t, N> &sizes) -> bool {
+  if (N < 3 || N > 255 || sizes[0] != 16 || sizes[1] != 32 ||
+      sizes[2] != 48) {
+    return false;
+  }
+  for (std::size_t i = 0; i < N; ++i) {
+    if (sizes[i] % kGranule != 0 || (i > 0 && sizes[i] <= sizes[i - 1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// @brief 16, 32, ... 16 * Count.
+template <std::size_t Count> constexpr auto linear() {
+  std::array<std::size_t, Count> sizes{};
+  for (std::size_t i = 0; i < Count; ++i) {
+    sizes[i] = kGranule * (i + 1);
+  }
+  return sizes;
+}
+
+/// @brief Number of geometric classes up to @p max_size.
+constexpr auto geometric_count(std::size_t max_size, std::size_t per_doubling)
+    -> std::size_t {
+  std::size_t n = 0;
+  std::size_t size = kGranule;
+  std::size_t step = kGranule;
+  while (size <= max_size) {
+    ++n;
+    if (size >= kGranule * per_doubling && (size & (size - 1)) == 0) {
+      step = size / per_doubling;
+    }
+    size += step;
+  }
+  return n;
+}
+
+/// @brief jemalloc-style classes: multiples of 16 up to 16 * PerDoubling,
+///        then PerDoubling evenly spaced classes per doubling, up to
+///        MaxSize (16..128, 160, 192, 224, 256, 320, ... for 4).
+template <std::size_t MaxSize, std::size_t PerDoubling>
+constexpr auto geometric() {
+  std::array<std::size_t, geometric_count(MaxSize, PerDoubling)> sizes{};
+  std::size_t size = kGranule;
+  std::size_t step = kGranule;
+  for (auto &s : sizes) {
+    s = size;
+    if (size >= kGranule * PerDoubling && (size & (size - 1)) == 0) {
+      step = size / PerDoubling;
+    }
+    size += step;
+  }
+  return sizes;
+}
+
+} // namespace size_classes
+
+/// @brief A size-class scheme for FreeListAllocator's segregated lists.
+///
+/// Requests up to kMaxSize are rounded up to a class and served from that
+/// class's list, which never coalesces; larger ones go to the tree. Both
+/// directions of the size-to-class mapping are single table loads.
+///
+/// @tparam Sizes Ascending class sizes; see size_classes::valid().
+template <auto Sizes> struct SizeClassScheme {
+  static_assert(size_classes::valid(Sizes),
+                "size classes must ascend in multiples of 16 from 16, 32, 48");
+
+  static constexpr std::size_t kCount = Sizes.size();
+  static constexpr std::size_t kMaxSize = Sizes[kCount - 1];
+
+  /// @brief Bytes in class @p cls.
+  [[nodiscard]] static constexpr auto size_of(std::size_t cls) noexcept
+      -> std::size_t {
+    return Sizes[cls];
+  }
+
+  /// @brief Smallest class holding @p size; 1 <= size <= kMaxSize.
+  [[nodiscard]] static constexpr auto class_of(std::size_t size) noexcept
+      -> std::size_t {
+    return kCeil[(size + size_classes::kGranule - 1) / size_classes::kGranule];
+  }
+
+  /// @brief Largest class no bigger than @p size; 16 <= size <= kMaxSize.
+  [[nodiscard]] static constexpr auto class_floor(std::size_t size) noexcept
+      -> std::size_t {
+    return kFloor[size / size_classes::kGranule];
+  }
+
+private:
+  using Lookup = std::array<std::uint8_t,
+                            kMaxSize / size_classes::kGranule + 1>;
+
+  // Indexed by size in granules, rounded up (kCeil) or down (kFloor).
+  static constexpr Lookup kCeil = [] {
+    Lookup t{};
+    std::size_t cls = 0;
+    for (std::size_t g = 0; g < t.size(); ++g) {
+      while (Sizes[cls] < g * size_classes::kGranule) {
+        ++cls;
+      }
+      t[g] = static_cast<std::uint8_t>(cls);
+    }
+    return t;
+  }();
+  static constexpr Lookup kFloor = [] {
+    Lookup t{};
+    std::size_t cls = 0;
+    for (std::size_t g = 1; g < t.size(); ++g) {
+      while (cls + 1 < kCount &&
+             Sizes[cls + 1] <= g * size_classes::kGranule) {
+        ++cls;
+      }
+      t[g] = static_cast<std::uint8_t>(cls);
+    }
+    return t;
+  }();
+};
+
+/// @brief Count classes 16 bytes apart (the original 16..128 by default).
+template <std::size_t Count = 8>
+using LinearSizeClasses = SizeClassScheme<size_classes::linear<Count>()>;
+
+/// @brief jemalloc-style geometric classes up to @p MaxSize.
+template <std::size_t MaxSize = 1024, std::size_t PerDoubling = 4>
+using GeometricSizeClasses =
+    SizeClassScheme<size_classes::geometric<MaxSize, PerDoubling>()>;
+
+/// @brief An explicit table, e.g. from tools/size_class_gen.
+template <std::size_t... Sizes>
+using TableSizeClasses =
+    SizeClassScheme<std::array<std::size_t, sizeof...(Sizes)>{Sizes...}>;
+
+} // namespace mmap_viz
@@ -0,0 +1,155 @@
+#pragma once
+/// @file small_block_cache.hpp
+/// @brief Lock-free per-size-class stacks of small free blocks.
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+namespace mmap_viz {
+
+/// @brief Free small blocks of one memory region, kept outside its
+///        FreeListAllocator so they can be reused without its lock.
+///
+/// One Treiber stack per 16-byte size class up to kMaxBlockSize. A stack
+/// head packs a 32-bit block index (offset / 16 from the region base, plus
+/// one; 0 = empty) with a 32-bit tag bumped by every push and pop, so a
+/// pop that raced with a pop-push of the same block fails its CAS instead
+/// of installing a stale next link (ABA). Regions up to 64 GB fit.
+///
+/// A cached block keeps its size in its first word, like a tree FreeBlock,
+/// so heap walks can step over it. The next links live in a side array of
+/// 32-bit indices, one per 16-byte granule, never in block memory: a pop
+/// that loses the race for a block reads only the link, never bytes the
+/// winner is already rewriting as a header. The array is calloc'd zeroed
+/// and only its entries for cached blocks are ever written. If it cannot
+/// be allocated, the cache is disabled. Blocks are never coalesced while
+/// cached; the owner returns them to the allocator with drain().
+class SmallBlockCache {
+public:
+  static constexpr std::size_t kQuantum = 16;
+  static constexpr std::size_t kNumClasses = 8;
+  static constexpr std::size_t kMaxBlockSize = kQuantum * kNumClasses;
+  /// Largest region whose block indices fit the 32-bit head field.
+  static constexpr std::size_t kMaxRegion =
+      ((std::size_t{1} << 32) - 1) * kQuantum;
+
+  /// @param enabled false makes accepts() always false (cache unused).
+  SmallBlockCache(std::byte *base, std::size_t size,
+                  bool enabled = true) noexcept
+      : base_{base}, enabled_{enabled && size <= kMaxRegion} {
+    if (enabled_) {
+      links_ = static_cast<std::uint32_t *>(
+          std::calloc(size / kQuantum, sizeof(std::uint32_t)));
+      enabled_ = links_ != nullptr;
+    }
+  }
+
+  ~SmallBlockCache() { std::free(links_); }
+
+  SmallBlockCache(const SmallBlockCache &) = delete;
+  SmallBlockCache &operator=(const SmallBlockCache &) = delete;
+
+  /// @brief Whether blocks of @p block_size bytes can be cached here.
+  [[nodiscard]] auto accepts(std::size_t block_size) const noexcept -> bool {
+    return enabled_ && block_size >= kQuantum && block_size <= kMaxBlockSize &&
+           block_size % kQuantum == 0;
+  }
+
+  /// @brief Take a cached block of exactly @p block_size bytes, or nullptr.
+  /// @pre accepts(block_size)
+  [[nodiscard]] auto pop(std::size_t block_size) noexcept -> std::byte * {
+    auto &stack = stacks_[class_of(block_size)];
+    auto head = stack.head.load(std::memory_order_acquire);
+    for (;;) {
+      auto index = static_cast<std::uint32_t>(head);
+      if (index == 0) {
+        return nullptr;
+      }
+      auto next = link(index).load(std::memory_order_relaxed);
+      if (stack.head.compare_exchange_weak(head, pack(next, tag_of(head) + 1),
+                                           std::memory_order_acquire,
+                                           std::memory_order_acquire)) {
+        stack.bytes.fetch_sub(block_size, std::memory_order_relaxed);
+        return block_at(index);
+      }
+    }
+  }
+
+  /// @brief Cache a free block of @p block_size bytes.
+  /// @pre accepts(block_size), @p block is 16-aligned inside the region.
+  void push(std::byte *block, std::size_t block_size) noexcept {
+    auto &stack = stacks_[class_of(block_size)];
+    *reinterpret_cast<std::size_t *>(block) = block_size;
+    auto index = index_of(block);
+    // Counted before it is visible, so a racing pop never underflows.
+    stack.bytes.fetch_add(block_size, std::memory_order_relaxed);
+    auto head = stack.head.load(std::memory_order_relaxed);
+    do {
+      link(index).store(static_cast<std::uint32_t>(head),
+                        std::memory_order_relaxed);
+    } while (!stack.head.compare_exchange_weak(head,
+                                               pack(index, tag_of(head) + 1),
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed));
+  }
+
+  /// @brief Bytes currently cached, over all classes.
+  [[nodiscard]] auto cached_bytes() const noexcept -> std::size_t {
+    std::size_t sum = 0;
+    for (const auto &stack : stacks_) {
+      sum += stack.bytes.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  /// @brief Pop every cached block, calling @p fn(block, block_size).
+  template <typename Fn> void drain(Fn &&fn) {
+    for (std::size_t c = 0; c < kNumClasses; ++c) {
+      auto block_size = (c + 1) * kQuantum;
+      while (auto *block = pop(block_size)) {
+        fn(block, block_size);
+      }
+    }
+  }
+
+private:
+  /// @brief Stack head and byte count, one cache line per class.
+  struct alignas(64) Stack {
+    std::atomic<std::uint64_t> head{0};
+    std::atomic<std::size_t> bytes{0};
+  };
+
+  static constexpr auto class_of(std::size_t block_size) noexcept
+      -> std::size_t {
+    return block_size / kQuantum - 1;
+  }
+  static constexpr auto pack(std::uint32_t index, std::uint32_t tag) noexcept
+      -> std::uint64_t {
+    return (std::uint64_t{tag} << 32) | index;
+  }
+  static constexpr auto tag_of(std::uint64_t head) noexcept -> std::uint32_t {
+    return static_cast<std::uint32_t>(head >> 32);
+  }
+  /// @brief Next link of the block at @p index (1-based).
+  auto link(std::uint32_t index) const noexcept
+      -> std::atomic_ref<std::uint32_t> {
+    return std::atomic_ref<std::uint32_t>(links_[index - 1]);
+  }
+
+  auto index_of(const std::byte *block) const noexcept -> std::uint32_t {
+    return static_cast<std::uint32_t>((block - base_) / kQuantum + 1);
+  }
+  auto block_at(std::uint32_t index) const noexcept -> std::byte * {
+    return base_ + std::size_t{index - 1} * kQuantum;
+  }
+
+  std::array<Stack, kNumClasses> stacks_{};
+  std::byte *base_;
+  std::uint32_t *links_ = nullptr; ///< Next index per granule; calloc'd.
+  bool enabled_;
+};
+
+} // namespace mmap_viz
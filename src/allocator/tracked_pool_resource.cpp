@@ -0,0 +1,221 @@
+/// @file tracked_pool_resource.cpp
+/// @brief Implementation of TrackedPoolResource.
+
+#include "allocator/tracked_pool_resource.hpp"
+#include "interface/visualization_arena.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <new>
+
+namespace mmap_viz {
+
+template <typename Lock>
+BasicTrackedPoolResource<Lock>::BasicTrackedPoolResource(
+    VisualizationArena &arena, TrackedPoolOptions options)
+    : arena_{&arena}, options_{std::move(options)} {
+  const std::size_t max_node =
+      std::bit_floor(std::max(options_.max_node_size, kMinNodeSize));
+  for (std::size_t size = kMinNodeSize; size <= max_node; size *= 2) {
+    if (options_.chunk_size / size < 2) {
+      break; // A chunk must hold at least two nodes to be worth it.
+    }
+    classes_.push_back(SizeClass{
+        .node_size = size,
+        .chunk_tag = options_.tag + ":" + std::to_string(size),
+    });
+  }
+}
+
+template <typename Lock>
+BasicTrackedPoolResource<Lock>::~BasicTrackedPoolResource() {
+  release();
+}
+
+template <typename Lock> void BasicTrackedPoolResource<Lock>::release() {
+  std::lock_guard guard(lock_);
+  for (auto &[addr, chunk] : chunks_) {
+    arena_->dealloc_raw(chunk->base, options_.chunk_size);
+  }
+  chunks_.clear();
+  for (auto &cls : classes_) {
+    cls.available.clear();
+  }
+}
+
+template <typename Lock>
+auto BasicTrackedPoolResource<Lock>::chunks() const
+    -> std::vector<PoolChunkInfo> {
+  std::lock_guard guard(lock_);
+  std::vector<PoolChunkInfo> out;
+  out.reserve(chunks_.size());
+  for (const auto &[addr, chunk] : chunks_) {
+    out.push_back({
+        .base = chunk->base,
+        .node_size = classes_[chunk->class_idx].node_size,
+        .capacity = chunk->capacity,
+        .used = chunk->used,
+    });
+  }
+  return out;
+}
+
+// ─── Allocation ──────────────────────────────────────────────────────────
+
+template <typename Lock>
+void *BasicTrackedPoolResource<Lock>::do_allocate(std::size_t bytes,
+                                                  std::size_t alignment) {
+  const auto idx = class_for(bytes, alignment);
+  if (idx == classes_.size()) {
+    void *ptr = arena_->alloc_raw(bytes, alignment, options_.tag);
+    if (!ptr) {
+      throw std::bad_alloc{};
+    }
+    return ptr;
+  }
+
+  std::lock_guard guard(lock_);
+  auto &cls = classes_[idx];
+  Chunk *chunk = cls.available.empty() ? new_chunk(idx) : cls.available.back();
+
+  void *node = nullptr;
+  if (chunk->free_head != nullptr) {
+    node = chunk->free_head;
+    chunk->free_head = *static_cast<void **>(node);
+  } else {
+    node = chunk->base + chunk->bump * cls.node_size;
+    ++chunk->bump;
+  }
+  ++chunk->used;
+
+  if (chunk->used == chunk->capacity) {
+    cls.available.pop_back();
+    chunk->available = false;
+  }
+  report(*chunk);
+  if (sample_node()) {
+    arena_->record_suballoc(node, bytes, alignment, options_.tag);
+  }
+  return node;
+}
+
+template <typename Lock>
+void BasicTrackedPoolResource<Lock>::do_deallocate(void *ptr,
+                                                   std::size_t bytes,
+                                                   std::size_t alignment) {
+  if (ptr == nullptr) {
+    return;
+  }
+  const auto idx = class_for(bytes, alignment);
+  if (idx == classes_.size()) {
+    arena_->dealloc_raw(ptr, bytes);
+    return;
+  }
+
+  std::lock_guard guard(lock_);
+  const auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+  auto it = chunks_.upper_bound(addr);
+  if (it == chunks_.begin()) {
+    return; // Not ours.
+  }
+  Chunk *chunk = std::prev(it)->second.get();
+  if (addr >= reinterpret_cast<std::uintptr_t>(chunk->base) +
+                  options_.chunk_size) {
+    return; // Not ours.
+  }
+
+  if (sample_node()) {
+    arena_->record_subfree(ptr, bytes);
+  }
+
+  *static_cast<void **>(ptr) = chunk->free_head;
+  chunk->free_head = ptr;
+  --chunk->used;
+
+  auto &cls = classes_[chunk->class_idx];
+  if (!chunk->available) {
+    cls.available.push_back(chunk);
+    chunk->available = true;
+  }
+  if (chunk->used == 0 && cls.available.size() > 1) {
+    std::erase(cls.available, chunk);
+    release_chunk(chunk);
+    return;
+  }
+  report(*chunk);
+}
+
+template <typename Lock>
+bool BasicTrackedPoolResource<Lock>::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept {
+  return this == &other;
+}
+
+// ─── Helpers ─────────────────────────────────────────────────────────────
+
+template <typename Lock>
+auto BasicTrackedPoolResource<Lock>::class_for(
+    std::size_t bytes, std::size_t alignment) const noexcept -> std::size_t {
+  const std::size_t need = std::max({bytes, alignment, kMinNodeSize});
+  if (classes_.empty() || need > classes_.back().node_size) {
+    return classes_.size();
+  }
+  // Classes are consecutive powers of two starting at kMinNodeSize.
+  return static_cast<std::size_t>(std::countr_zero(std::bit_ceil(need)) -
+                                  std::countr_zero(kMinNodeSize));
+}
+
+template <typename Lock>
+auto BasicTrackedPoolResource<Lock>::new_chunk(std::size_t class_idx)
+    -> Chunk * {
+  auto &cls = classes_[class_idx];
+  // Aligning the chunk to the node size aligns every node to it too.
+  auto *base = static_cast<std::byte *>(
+      arena_->alloc_raw(options_.chunk_size, cls.node_size, cls.chunk_tag));
+  if (!base) {
+    throw std::bad_alloc{};
+  }
+
+  auto chunk = std::make_unique<Chunk>();
+  chunk->base = base;
+  chunk->class_idx = class_idx;
+  chunk->capacity = options_.chunk_size / cls.node_size;
+  chunk->available = true;
+
+  Chunk *raw = chunk.get();
+  chunks_.emplace(reinterpret_cast<std::uintptr_t>(base), std::move(chunk));
+  cls.available.push_back(raw);
+  return raw;
+}
+
+template <typename Lock>
+void BasicTrackedPoolResource<Lock>::release_chunk(Chunk *chunk) {
+  arena_->dealloc_raw(chunk->base, options_.chunk_size);
+  chunks_.erase(reinterpret_cast<std::uintptr_t>(chunk->base));
+}
+
+template <typename Lock>
+void BasicTrackedPoolResource<Lock>::report(Chunk &chunk) {
+  // Report on distance from the last report rather than on crossing a
+  // fixed boundary, so churn around one boundary stays quiet.
+  const std::size_t delta = chunk.used > chunk.reported_used
+                                ? chunk.used - chunk.reported_used
+                                : chunk.reported_used - chunk.used;
+  if (delta < std::max<std::size_t>(1, chunk.capacity / kOccupancySteps)) {
+    return;
+  }
+  chunk.reported_used = chunk.used;
+  arena_->record_occupancy(chunk.base,
+                           chunk.used * classes_[chunk.class_idx].node_size);
+}
+
+template <typename Lock>
+auto BasicTrackedPoolResource<Lock>::sample_node() noexcept -> bool {
+  return options_.node_sampling != 0 &&
+         ++node_events_ % options_.node_sampling == 0;
+}
+
+template class BasicTrackedPoolResource<detail::NullLock>;
+template class BasicTrackedPoolResource<std::mutex>;
+
+} // namespace mmap_viz
@@ -0,0 +1,144 @@
+#pragma once
+/// @file tracked_pool_resource.hpp
+/// @brief Size-class pool front end for VisualizationArena.
+///
+/// pmr node containers make many tiny allocations, and through
+/// TrackedResource each one pays the full alloc_raw() path (shard lock,
+/// header, event). TrackedPoolResource takes large per-size-class chunks
+/// from the arena and hands out nodes from them without touching the arena
+/// or emitting per-node events. The chunks themselves are ordinary tracked
+/// blocks, and their fill level is reported to the visualization.
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mmap_viz {
+
+class VisualizationArena;
+
+/// @brief Tuning for TrackedPoolResource.
+struct TrackedPoolOptions {
+  std::size_t chunk_size = 64 * 1024; ///< Bytes per chunk from the arena.
+  std::size_t max_node_size = 512;    ///< Larger requests bypass the pool.
+  std::size_t node_sampling = 0; ///< Emit every Nth node event (0 = none).
+  std::string tag = "pool";      ///< Tag for nodes; chunks get "<tag>:<size>".
+};
+
+/// @brief Usage of one pool chunk.
+struct PoolChunkInfo {
+  const void *base = nullptr;
+  std::size_t node_size = 0;
+  std::size_t capacity = 0; ///< Nodes the chunk can hold.
+  std::size_t used = 0;     ///< Nodes currently handed out.
+};
+
+namespace detail {
+/// @brief Lock used by the unsynchronized pool.
+struct NullLock {
+  void lock() noexcept {}
+  void unlock() noexcept {}
+};
+} // namespace detail
+
+/// @brief Pool memory resource over a VisualizationArena.
+///
+/// Requests up to `max_node_size` are rounded up to a power-of-two size
+/// class (16 B minimum) and served from that class's chunks; larger or
+/// over-aligned requests go straight to alloc_raw(). A chunk that becomes
+/// empty is returned to the arena unless it is the last one with space in
+/// its class.
+///
+/// Occupancy is reported through VisualizationArena::record_occupancy()
+/// whenever a chunk's fill level has moved by a sixteenth of its capacity
+/// since the last report.
+///
+/// The arena must outlive the pool and must not be moved while it exists.
+/// Destroying the pool returns every chunk, like std::pmr pool resources.
+///
+/// @tparam Lock std::mutex for the synchronized variant, detail::NullLock
+///              for the unsynchronized one.
+template <typename Lock>
+class BasicTrackedPoolResource final : public std::pmr::memory_resource {
+public:
+  explicit BasicTrackedPoolResource(VisualizationArena &arena,
+                                    TrackedPoolOptions options = {});
+  ~BasicTrackedPoolResource() override;
+
+  BasicTrackedPoolResource(const BasicTrackedPoolResource &) = delete;
+  BasicTrackedPoolResource &
+  operator=(const BasicTrackedPoolResource &) = delete;
+
+  /// @brief Return every chunk to the arena. Outstanding nodes dangle.
+  void release();
+
+  /// @brief Snapshot of every live chunk, ordered by address.
+  [[nodiscard]] auto chunks() const -> std::vector<PoolChunkInfo>;
+
+  [[nodiscard]] auto options() const noexcept -> const TrackedPoolOptions & {
+    return options_;
+  }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+  void do_deallocate(void *ptr, std::size_t bytes,
+                     std::size_t alignment) override;
+
+  bool
+  do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+private:
+  struct Chunk {
+    std::byte *base = nullptr;
+    std::size_t class_idx = 0;
+    std::size_t capacity = 0;
+    std::size_t used = 0;
+    std::size_t bump = 0; ///< Nodes never handed out start here.
+    void *free_head = nullptr;
+    std::size_t reported_used = 0;
+    bool available = false; ///< Listed in its class's `available`.
+  };
+
+  struct SizeClass {
+    std::size_t node_size = 0;
+    std::string chunk_tag;
+    std::vector<Chunk *> available; ///< Chunks with at least one free node.
+  };
+
+  static constexpr std::size_t kMinNodeSize = 16;
+  static constexpr std::size_t kOccupancySteps = 16;
+
+  /// @return Index into classes_, or classes_.size() to bypass the pool.
+  [[nodiscard]] auto class_for(std::size_t bytes,
+                               std::size_t alignment) const noexcept
+      -> std::size_t;
+  auto new_chunk(std::size_t class_idx) -> Chunk *;
+  void release_chunk(Chunk *chunk);
+  void report(Chunk &chunk);
+  [[nodiscard]] auto sample_node() noexcept -> bool;
+
+  VisualizationArena *arena_;
+  TrackedPoolOptions options_;
+  std::vector<SizeClass> classes_;
+  std::map<std::uintptr_t, std::unique_ptr<Chunk>> chunks_; ///< By base.
+  std::size_t node_events_ = 0;
+  mutable Lock lock_;
+};
+
+extern template class BasicTrackedPoolResource<detail::NullLock>;
+extern template class BasicTrackedPoolResource<std::mutex>;
+
+/// @brief Pool for single-threaded use (cf. unsynchronized_pool_resource).
+using UnsynchronizedTrackedPoolResource =
+    BasicTrackedPoolResource<detail::NullLock>;
+
+/// @brief Pool safe to share across threads (cf. synchronized_pool_resource).
+using SynchronizedTrackedPoolResource = BasicTrackedPoolResource<std::mutex>;
+
+} // namespace mmap_viz
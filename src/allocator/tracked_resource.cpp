@@ -7,8 +7,9 @@
 
 namespace mmap_viz {
 
-TrackedResource::TrackedResource(VisualizationArena &arena) noexcept
-    : arena_{&arena} {}
+TrackedResource::TrackedResource(VisualizationArena &arena,
+                                 std::pmr::memory_resource *upstream) noexcept
+    : arena_{&arena}, upstream_{upstream} {}
 
 TrackedResource::~TrackedResource() = default;
 
@@ -23,7 +24,15 @@ void TrackedResource::set_arena(VisualizationArena *arena) noexcept {
 void *TrackedResource::do_allocate(std::size_t bytes, std::size_t alignment) {
   if (!arena_)
     throw std::bad_alloc{};
-  void *ptr = arena_->alloc_raw(bytes, alignment, next_tag_);
+  auto result = arena_->try_alloc_raw(bytes, alignment, next_tag_);
+  void *ptr = result.value_or(nullptr);
+  if (!ptr && upstream_ && result.error() != AllocFailure::kQuotaExceeded) {
+    // Arena exhausted, or over a quota that defers to the overflow
+    // policy: degrade to the upstream resource. May throw, in which case
+    // nothing was recorded.
+    ptr = upstream_->allocate(bytes, alignment);
+    arena_->record_overflow_alloc(ptr, bytes, alignment, next_tag_);
+  }
   next_tag_.clear(); // Reset tag
   if (!ptr) {
     throw std::bad_alloc{};
@@ -32,9 +41,15 @@ void *TrackedResource::do_allocate(std::size_t bytes, std::size_t alignment) {
 }
 
 void TrackedResource::do_deallocate(void *ptr, std::size_t bytes,
-                                    std::size_t /*alignment*/) {
-  if (arena_)
+                                    std::size_t alignment) {
+  if (!arena_ || ptr == nullptr)
+    return;
+  if (arena_->owns(ptr)) {
     arena_->dealloc_raw(ptr, bytes);
+  } else if (upstream_) {
+    arena_->record_overflow_free(ptr, bytes);
+    upstream_->deallocate(ptr, bytes, alignment);
+  }
 }
 
 bool TrackedResource::do_is_equal(
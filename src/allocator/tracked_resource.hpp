@@ -11,11 +11,23 @@ class VisualizationArena;
 
 /// @brief PMR memory resource that tracks every alloc/dealloc through the
 /// Arena.
+///
+/// When the arena cannot satisfy a request, the allocation falls through to
+/// an upstream resource and is reported as an "overflow" allocation instead
+/// of throwing; so does one refused by a QuotaAction::kOverflow tag quota,
+/// while a QuotaAction::kFail quota throws std::bad_alloc. Frees are routed
+/// back by checking whether the pointer lies inside the arena's address
+/// range.
 class TrackedResource final : public std::pmr::memory_resource {
 public:
   /// @brief Construct a tracked resource.
-  /// @param arena The backing visualization arena.
-  explicit TrackedResource(VisualizationArena &arena) noexcept;
+  /// @param arena    The backing visualization arena.
+  /// @param upstream Overflow resource used when the arena is exhausted, or
+  ///                 nullptr to throw std::bad_alloc instead.
+  explicit TrackedResource(
+      VisualizationArena &arena,
+      std::pmr::memory_resource *upstream =
+          std::pmr::new_delete_resource()) noexcept;
   ~TrackedResource() override;
 
   /// @brief Set a tag that will be applied to the next allocation.
@@ -25,6 +37,11 @@ public:
   /// @brief Update the backing arena pointer (used after move).
   void set_arena(VisualizationArena *arena) noexcept;
 
+  /// @brief Overflow resource, or nullptr if overflow is disabled.
+  [[nodiscard]] auto upstream() const noexcept -> std::pmr::memory_resource * {
+    return upstream_;
+  }
+
 protected:
   void *do_allocate(std::size_t bytes, std::size_t alignment) override;
 
@@ -36,6 +53,7 @@ protected:
 
 private:
   VisualizationArena *arena_;
+  std::pmr::memory_resource *upstream_;
   std::string next_tag_;
 };
 
@@ -0,0 +1,115 @@
+#pragma once
+/// @file lazy_shards.hpp
+/// @brief Fixed array of shards, each built on first use.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace mmap_viz {
+
+/// @brief @p count slots for T, in one contiguous array of cache-line
+///        aligned slots, each constructed by the first get() that needs it.
+///
+/// An arena of many shards pays for only the shards its threads touch:
+/// creating the array writes no shard memory and allocates nothing per
+/// shard. Each slot carries an atomic state (empty, building, ready); the
+/// get() that moves it from empty to building constructs the T, and any
+/// other get() for that slot waits until it is ready. If construction
+/// throws, the slot goes back to empty and the waiters race to build it
+/// again, so one failed build does not wedge the slot. find() never builds
+/// and returns nullptr for a slot no get() has reached, so readers treat
+/// such a shard as untouched.
+///
+/// A built T stays until clear() or destruction, so references to it stay
+/// valid as long as the array.
+template <typename T> class LazyShards {
+public:
+  /// Default-initialised: only the states are written up front.
+  explicit LazyShards(std::size_t count)
+      : slots_{new Slot[count]}, count_{count} {}
+
+  ~LazyShards() { clear(); }
+
+  LazyShards(const LazyShards &) = delete;
+  LazyShards &operator=(const LazyShards &) = delete;
+
+  /// @brief The T in slot @p i, built with `make()` if no get() has yet.
+  /// @param make Returns the T by value (constructed in place).
+  /// @throws Whatever `make()` or T's construction throws; the slot is
+  ///         left empty for the next get().
+  template <typename Make> auto get(std::size_t i, Make &&make) -> T & {
+    auto &slot = slots_[i];
+    auto state = slot.state.load(std::memory_order_acquire);
+    while (state != kReady) [[unlikely]] {
+      if (state == kBuilding) {
+        slot.state.wait(kBuilding, std::memory_order_acquire);
+        state = slot.state.load(std::memory_order_acquire);
+      } else if (slot.state.compare_exchange_weak(
+                     state, kBuilding, std::memory_order_acquire)) {
+        build(slot, make);
+        break;
+      }
+    }
+    return *slot.object();
+  }
+
+  /// @brief The T in slot @p i, or nullptr if it was never built.
+  [[nodiscard]] auto find(std::size_t i) const noexcept -> T * {
+    const auto &slot = slots_[i];
+    return slot.state.load(std::memory_order_acquire) == kReady
+               ? slot.object()
+               : nullptr;
+  }
+
+  [[nodiscard]] auto size() const noexcept -> std::size_t { return count_; }
+  [[nodiscard]] auto empty() const noexcept -> bool { return count_ == 0; }
+
+  /// @brief Destroy every built T and drop all slots; size() becomes 0.
+  ///        No other call may run concurrently.
+  void clear() noexcept {
+    for (std::size_t i = 0; i < count_; ++i) {
+      if (auto *object = find(i)) {
+        object->~T();
+      }
+    }
+    slots_.reset();
+    count_ = 0;
+  }
+
+private:
+  static constexpr std::uint8_t kEmpty = 0;
+  static constexpr std::uint8_t kBuilding = 1;
+  static constexpr std::uint8_t kReady = 2;
+
+  struct alignas(alignof(T) > 64 ? alignof(T) : 64) Slot {
+    alignas(T) std::byte storage[sizeof(T)];
+    std::atomic<std::uint8_t> state{kEmpty};
+
+    [[nodiscard]] auto object() const noexcept -> T * {
+      return std::launder(
+          reinterpret_cast<T *>(const_cast<std::byte *>(storage)));
+    }
+  };
+
+  /// @brief Construct the T of @p slot, which this thread moved to
+  ///        building, and wake its waiters either way.
+  template <typename Make> static void build(Slot &slot, Make &make) {
+    try {
+      ::new (slot.storage) T(make());
+    } catch (...) {
+      slot.state.store(kEmpty, std::memory_order_release);
+      slot.state.notify_all();
+      throw;
+    }
+    slot.state.store(kReady, std::memory_order_release);
+    slot.state.notify_all();
+  }
+
+  std::unique_ptr<Slot[]> slots_;
+  std::size_t count_;
+};
+
+} // namespace mmap_viz
@@ -0,0 +1,271 @@
+/// @file memory_pressure.cpp
+/// @brief Implementation of Watermarks and PressureMonitor.
+
+#include "interface/memory_pressure.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mmap_viz {
+
+namespace {
+
+/// @brief @p fraction of @p capacity in bytes, clamped to [0, capacity + 1]
+///        so a watermark above 1 is never reached.
+auto fraction_of(double fraction, std::size_t capacity) noexcept
+    -> std::size_t {
+  if (fraction <= 0) {
+    return 0;
+  }
+  if (fraction > 1) {
+    return capacity + 1;
+  }
+  return static_cast<std::size_t>(
+      std::ceil(fraction * static_cast<double>(capacity)));
+}
+
+} // namespace
+
+// ─── Watermarks ─────────────────────────────────────────────────────────
+
+auto Watermarks::next_level(PressureLevel current, std::size_t used,
+                            std::size_t capacity) const noexcept
+    -> PressureLevel {
+  const auto low_at = fraction_of(low, capacity);
+  const auto critical_at = fraction_of(critical, capacity);
+  const auto low_exit = fraction_of(low - hysteresis, capacity);
+  const auto critical_exit = fraction_of(critical - hysteresis, capacity);
+
+  if (used >= critical_at) {
+    return PressureLevel::kCritical;
+  }
+  if (current == PressureLevel::kCritical && used >= critical_exit) {
+    return PressureLevel::kCritical;
+  }
+  if (used >= low_at) {
+    return PressureLevel::kLow;
+  }
+  if (current != PressureLevel::kNormal && used >= low_exit) {
+    return PressureLevel::kLow;
+  }
+  return PressureLevel::kNormal;
+}
+
+auto Watermarks::bounds(PressureLevel level,
+                        std::size_t capacity) const noexcept -> Bounds {
+  switch (level) {
+  case PressureLevel::kNormal:
+    return {0, fraction_of(low, capacity)};
+  case PressureLevel::kLow:
+    return {fraction_of(low - hysteresis, capacity),
+            fraction_of(critical, capacity)};
+  case PressureLevel::kCritical:
+    return {fraction_of(critical - hysteresis, capacity), SIZE_MAX};
+  }
+  return {};
+}
+
+// ─── PressureMonitor ────────────────────────────────────────────────────
+
+PressureMonitor::PressureMonitor(std::size_t arena_capacity,
+                                 std::size_t shard_count,
+                                 std::size_t shard_capacity,
+                                 std::function<void()> on_thread_start)
+    : arena_capacity_{arena_capacity}, shard_capacity_{shard_capacity},
+      quantum_{static_cast<std::ptrdiff_t>(
+          std::max<std::size_t>(shard_capacity / 64, 1))},
+      on_thread_start_{std::move(on_thread_start)},
+      shards_{std::make_unique<ShardState[]>(shard_count)},
+      shard_count_{shard_count} {}
+
+PressureMonitor::~PressureMonitor() { stop(); }
+
+void PressureMonitor::stop() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+    queue_.clear();
+  }
+  queue_cv_.notify_all();
+  if (thread_.joinable() && thread_.get_id() != std::this_thread::get_id()) {
+    thread_.join();
+  }
+}
+
+auto PressureMonitor::watch_arena(Watermarks marks, PressureCallback callback)
+    -> std::size_t {
+  std::lock_guard lock(mutex_);
+  auto id = next_id_++;
+  watches_.push_back(Watch{
+      .id = id,
+      .per_shard = false,
+      .marks = marks,
+      .callback = std::make_shared<PressureCallback>(std::move(callback)),
+  });
+  start_thread_locked();
+  // Usage may already be past a watermark; report that now.
+  evaluate_arena_locked(arena_used_.load(std::memory_order_relaxed));
+  return id;
+}
+
+auto PressureMonitor::watch_shards(Watermarks marks,
+                                   PressureCallback callback) -> std::size_t {
+  std::lock_guard lock(mutex_);
+  auto id = next_id_++;
+  watches_.push_back(Watch{
+      .id = id,
+      .per_shard = true,
+      .marks = marks,
+      .callback = std::make_shared<PressureCallback>(std::move(callback)),
+      .shard_levels =
+          std::vector<PressureLevel>(shard_count_, PressureLevel::kNormal),
+  });
+  start_thread_locked();
+  // Shard usage is only known under the shard locks: have each shard's
+  // next report evaluate the new watch.
+  for (std::size_t i = 0; i < shard_count_; ++i) {
+    shards_[i].up.store(0, std::memory_order_relaxed);
+  }
+  return id;
+}
+
+void PressureMonitor::unwatch(std::size_t id) {
+  bool from_callback = false;
+  {
+    std::lock_guard lock(mutex_);
+    std::erase_if(watches_, [id](const Watch &w) { return w.id == id; });
+    std::erase_if(queue_,
+                  [id](const Pending &p) { return p.watch_id == id; });
+    refresh_bounds_locked();
+    from_callback = thread_.get_id() == std::this_thread::get_id();
+  }
+  // Wait out a delivery already in progress, unless this is it.
+  if (!from_callback) {
+    std::lock_guard wait(delivery_mutex_);
+  }
+}
+
+void PressureMonitor::evaluate_shard(std::size_t shard, std::size_t bytes) {
+  std::lock_guard lock(mutex_);
+  Watermarks::Bounds b;
+  for (auto &w : watches_) {
+    if (!w.per_shard) {
+      continue;
+    }
+    auto &level = w.shard_levels[shard];
+    auto next = w.marks.next_level(level, bytes, shard_capacity_);
+    if (next != level && !stopping_) {
+      queue_.push_back(Pending{
+          .watch_id = w.id,
+          .callback = w.callback,
+          .event = {.shard = shard,
+                    .level = next,
+                    .previous = level,
+                    .bytes_in_use = bytes,
+                    .capacity = shard_capacity_},
+      });
+      events_raised_.fetch_add(1, std::memory_order_relaxed);
+      queue_cv_.notify_one();
+    }
+    level = next;
+    auto wb = w.marks.bounds(level, shard_capacity_);
+    b.down = std::max(b.down, wb.down);
+    b.up = std::min(b.up, wb.up);
+  }
+  shards_[shard].down.store(b.down, std::memory_order_relaxed);
+  shards_[shard].up.store(b.up, std::memory_order_relaxed);
+}
+
+void PressureMonitor::evaluate_arena() {
+  std::lock_guard lock(mutex_);
+  // Re-read: other shards may have folded in since the caller's sum.
+  evaluate_arena_locked(arena_used_.load(std::memory_order_relaxed));
+}
+
+void PressureMonitor::evaluate_arena_locked(std::size_t bytes) {
+  Watermarks::Bounds b;
+  for (auto &w : watches_) {
+    if (w.per_shard) {
+      continue;
+    }
+    auto next = w.marks.next_level(w.arena_level, bytes, arena_capacity_);
+    if (next != w.arena_level && !stopping_) {
+      queue_.push_back(Pending{
+          .watch_id = w.id,
+          .callback = w.callback,
+          .event = {.shard = PressureEvent::kArena,
+                    .level = next,
+                    .previous = w.arena_level,
+                    .bytes_in_use = bytes,
+                    .capacity = arena_capacity_},
+      });
+      events_raised_.fetch_add(1, std::memory_order_relaxed);
+      queue_cv_.notify_one();
+    }
+    w.arena_level = next;
+    auto wb = w.marks.bounds(next, arena_capacity_);
+    b.down = std::max(b.down, wb.down);
+    b.up = std::min(b.up, wb.up);
+  }
+  arena_down_.store(b.down, std::memory_order_relaxed);
+  arena_up_.store(b.up, std::memory_order_relaxed);
+}
+
+void PressureMonitor::refresh_bounds_locked() {
+  Watermarks::Bounds arena;
+  std::vector<Watermarks::Bounds> shard(shard_count_);
+  for (const auto &w : watches_) {
+    if (w.per_shard) {
+      for (std::size_t i = 0; i < shard_count_; ++i) {
+        auto wb = w.marks.bounds(w.shard_levels[i], shard_capacity_);
+        shard[i].down = std::max(shard[i].down, wb.down);
+        shard[i].up = std::min(shard[i].up, wb.up);
+      }
+    } else {
+      auto wb = w.marks.bounds(w.arena_level, arena_capacity_);
+      arena.down = std::max(arena.down, wb.down);
+      arena.up = std::min(arena.up, wb.up);
+    }
+  }
+  for (std::size_t i = 0; i < shard_count_; ++i) {
+    shards_[i].down.store(shard[i].down, std::memory_order_relaxed);
+    shards_[i].up.store(shard[i].up, std::memory_order_relaxed);
+  }
+  arena_down_.store(arena.down, std::memory_order_relaxed);
+  arena_up_.store(arena.up, std::memory_order_relaxed);
+}
+
+void PressureMonitor::start_thread_locked() {
+  if (thread_.joinable() || stopping_) {
+    return;
+  }
+  thread_ = std::thread([this] {
+    if (on_thread_start_)
+      on_thread_start_();
+    run();
+  });
+}
+
+void PressureMonitor::run() {
+  std::unique_lock lock(mutex_);
+  for (;;) {
+    queue_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+    if (stopping_) {
+      return;
+    }
+    auto pending = std::move(queue_.front());
+    queue_.pop_front();
+
+    // Deliver outside the monitor mutex: the callback may free memory,
+    // which reports usage and can raise further events. Taking
+    // delivery_mutex_ first means an unwatch() that removed this watch
+    // after the pop still waits for the call to finish.
+    std::unique_lock delivering(delivery_mutex_);
+    lock.unlock();
+    (*pending.callback)(pending.event);
+    delivering.unlock();
+    lock.lock();
+  }
+}
+
+} // namespace mmap_viz
@@ -0,0 +1,219 @@
+#pragma once
+/// @file memory_pressure.hpp
+/// @brief Low/critical memory watermarks with asynchronous callbacks.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mmap_viz {
+
+/// @brief How close a region is to full.
+enum class PressureLevel : std::uint8_t {
+  kNormal,   ///< Below the low watermark.
+  kLow,      ///< At or above the low watermark: shed optional memory.
+  kCritical, ///< At or above the critical watermark: shed everything.
+};
+
+/// @brief Human-readable pressure level.
+[[nodiscard]] constexpr auto to_string(PressureLevel level) -> const char * {
+  switch (level) {
+  case PressureLevel::kNormal:
+    return "normal";
+  case PressureLevel::kLow:
+    return "low";
+  case PressureLevel::kCritical:
+    return "critical";
+  }
+  return "unknown";
+}
+
+/// @brief Watermarks as fractions of a region's capacity in use.
+///
+/// A level is entered when usage reaches its watermark and left only once
+/// usage falls @p hysteresis below it, so a region hovering at a
+/// watermark does not flap between levels.
+struct Watermarks {
+  double low = 0.80;
+  double critical = 0.95;
+  double hysteresis = 0.05;
+
+  /// @brief The level after usage moved to @p used of @p capacity bytes.
+  [[nodiscard]] auto next_level(PressureLevel current, std::size_t used,
+                                std::size_t capacity) const noexcept
+      -> PressureLevel;
+
+  /// @brief Usage range [down, up) in which @p level holds; outside it
+  ///        next_level() may change it.
+  struct Bounds {
+    std::size_t down = 0;
+    std::size_t up = SIZE_MAX;
+  };
+  [[nodiscard]] auto bounds(PressureLevel level,
+                            std::size_t capacity) const noexcept -> Bounds;
+};
+
+/// @brief A level change, delivered to a PressureCallback.
+struct PressureEvent {
+  /// `shard` of arena-wide events.
+  static constexpr std::size_t kArena = SIZE_MAX;
+
+  std::size_t shard = kArena;                 ///< Shard index, or kArena.
+  PressureLevel level = PressureLevel::kNormal;    ///< New level.
+  PressureLevel previous = PressureLevel::kNormal; ///< Level before it.
+  std::size_t bytes_in_use = 0; ///< Usage that triggered the change.
+  std::size_t capacity = 0;     ///< Capacity of the arena or shard.
+};
+
+using PressureCallback = std::function<void(const PressureEvent &)>;
+
+/// @brief Frees memory for an allocation of @p bytes that failed; returns
+///        whether anything was freed, i.e. whether a retry may succeed.
+using ReclaimHandler = std::function<bool(std::size_t bytes)>;
+
+/// @brief Watches running usage counters against registered watermarks
+///        and calls back on a reclaim thread when a level changes.
+///
+/// The allocation paths report a shard's usage under its lock through
+/// on_shard_usage(). That is two compares against the bounds of the
+/// shard's current levels, plus folding the shard into an arena-wide
+/// counter once its usage has drifted a quantum (1/64 of a shard) from
+/// what was last folded in, so the arena counter is shared but rarely
+/// written. Regions the monitor keeps no shard state for (the ranges of a
+/// sub-arena) fold into the same counter through on_region_usage(). Only
+/// a bound crossing takes the monitor mutex to work out the new levels
+/// and queue events. Callbacks run in order on one
+/// reclaim thread, started with the first watch, and may allocate and
+/// free from the arena.
+class PressureMonitor {
+public:
+  /// @param on_thread_start Run first on the reclaim thread.
+  PressureMonitor(std::size_t arena_capacity, std::size_t shard_count,
+                  std::size_t shard_capacity,
+                  std::function<void()> on_thread_start = {});
+  ~PressureMonitor();
+
+  PressureMonitor(const PressureMonitor &) = delete;
+  PressureMonitor &operator=(const PressureMonitor &) = delete;
+
+  /// @brief Call @p callback on arena-wide level changes.
+  /// @return Id for unwatch().
+  auto watch_arena(Watermarks marks, PressureCallback callback)
+      -> std::size_t;
+
+  /// @brief Call @p callback on level changes of each shard separately.
+  /// @return Id for unwatch().
+  auto watch_shards(Watermarks marks, PressureCallback callback)
+      -> std::size_t;
+
+  /// @brief Remove a watch. Once this returns its callback is not running
+  ///        and will not run again (unless called from that callback).
+  void unwatch(std::size_t id);
+
+  /// @brief Report that shard @p shard now has @p bytes in use. The
+  ///        caller holds the shard's lock.
+  void on_shard_usage(std::size_t shard, std::size_t bytes) noexcept {
+    auto &s = shards_[shard];
+    if (bytes >= s.up.load(std::memory_order_relaxed) ||
+        bytes < s.down.load(std::memory_order_relaxed)) {
+      evaluate_shard(shard, bytes);
+    }
+    on_region_usage(s.reported, bytes);
+  }
+
+  /// @brief Report that a region counted in the arena but not one of its
+  ///        shards now has @p bytes in use. Arena watches only.
+  /// @param reported The region's usage as last folded in, updated here.
+  ///        The caller serializes the calls for one region.
+  void on_region_usage(std::size_t &reported, std::size_t bytes) noexcept {
+    auto delta = static_cast<std::ptrdiff_t>(bytes - reported);
+    // Always fold an emptied region, so the arena counter drains to 0.
+    if (delta >= quantum_ || -delta >= quantum_ ||
+        (bytes == 0 && delta != 0)) {
+      reported = bytes;
+      auto total = arena_used_.fetch_add(static_cast<std::size_t>(delta),
+                                         std::memory_order_relaxed) +
+                   static_cast<std::size_t>(delta);
+      if (total >= arena_up_.load(std::memory_order_relaxed) ||
+          total < arena_down_.load(std::memory_order_relaxed)) {
+        evaluate_arena();
+      }
+    }
+  }
+
+  /// @brief Arena usage as last folded in from the shards and regions
+  ///        (within one quantum per shard or region).
+  [[nodiscard]] auto arena_bytes_in_use() const noexcept -> std::size_t {
+    return arena_used_.load(std::memory_order_relaxed);
+  }
+
+  /// @brief Level changes queued so far, over all watches.
+  [[nodiscard]] auto events_raised() const noexcept -> std::uint64_t {
+    return events_raised_.load(std::memory_order_relaxed);
+  }
+
+  /// @brief Stop the reclaim thread, dropping undelivered events. Later
+  ///        level changes are not delivered.
+  void stop();
+
+private:
+  struct Watch {
+    std::size_t id;
+    bool per_shard;
+    Watermarks marks;
+    std::shared_ptr<PressureCallback> callback;
+    PressureLevel arena_level = PressureLevel::kNormal;
+    std::vector<PressureLevel> shard_levels; ///< Per-shard watches only.
+  };
+  struct Pending {
+    std::size_t watch_id;
+    std::shared_ptr<PressureCallback> callback;
+    PressureEvent event;
+  };
+  /// @brief Per-shard bounds and fold-in state, one cache line each.
+  struct alignas(64) ShardState {
+    std::atomic<std::size_t> down{0};
+    std::atomic<std::size_t> up{SIZE_MAX};
+    std::size_t reported = 0; ///< Under the shard lock.
+  };
+
+  void evaluate_shard(std::size_t shard, std::size_t bytes);
+  void evaluate_arena();
+  void evaluate_arena_locked(std::size_t bytes);
+  /// @brief Recompute every bound from the current levels (mutex held).
+  void refresh_bounds_locked();
+  void start_thread_locked();
+  void run();
+
+  const std::size_t arena_capacity_;
+  const std::size_t shard_capacity_;
+  const std::ptrdiff_t quantum_;
+  std::function<void()> on_thread_start_;
+
+  std::unique_ptr<ShardState[]> shards_;
+  std::size_t shard_count_;
+  alignas(64) std::atomic<std::size_t> arena_used_{0};
+  std::atomic<std::size_t> arena_down_{0};
+  std::atomic<std::size_t> arena_up_{SIZE_MAX};
+  std::atomic<std::uint64_t> events_raised_{0};
+
+  std::mutex mutex_; ///< Guards everything below.
+  std::vector<Watch> watches_;
+  std::size_t next_id_ = 1;
+  std::deque<Pending> queue_;
+  std::condition_variable queue_cv_;
+  bool stopping_ = false;
+  std::thread thread_;
+
+  /// Held while a callback runs, so unwatch() can wait it out.
+  std::mutex delivery_mutex_;
+};
+
+} // namespace mmap_viz
@@ -0,0 +1,149 @@
+/// @file observer_meter.cpp
+/// @brief Implementation of ObserverMeter.
+
+#include "interface/observer_meter.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace mmap_viz {
+
+namespace {
+
+auto clock_ns(clockid_t clock) noexcept -> std::uint64_t {
+  timespec ts{};
+  if (clock_gettime(clock, &ts) != 0) {
+    return 0;
+  }
+  return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000ull +
+         static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+auto steady_ns() noexcept -> std::uint64_t {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+auto pct(double part, double whole) noexcept -> double {
+  return whole > 0 ? 100.0 * part / whole : 0.0;
+}
+
+} // namespace
+
+// ─── ObserverClocks ─────────────────────────────────────────────────────
+
+auto ObserverClocks::read(clockid_t server_clock) noexcept -> ObserverClocks {
+  return ObserverClocks{
+      .wall_ns = steady_ns(),
+      .cycles = ObserverMeter::cycles(),
+      .process_cpu_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID),
+      .batcher_cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID),
+      .server_cpu_ns =
+          server_clock == static_cast<clockid_t>(-1) ? 0
+                                                      : clock_ns(server_clock),
+  };
+}
+
+// ─── ObserverMeter ──────────────────────────────────────────────────────
+
+ObserverMeter::ObserverMeter(std::size_t base_sampling,
+                             double target_pct) noexcept
+    : sampling_{std::max<std::size_t>(base_sampling, 1)},
+      base_sampling_{std::max<std::size_t>(base_sampling, 1)},
+      target_pct_{std::max(target_pct, 0.0)} {
+  latest_.sampling = base_sampling_;
+  latest_.target_pct = target_pct_;
+}
+
+auto ObserverMeter::cycles() noexcept -> std::uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+  // No fences: a probe is a statistical sample, not a precise timing.
+  return __rdtsc();
+#else
+  return steady_ns();
+#endif
+}
+
+auto ObserverMeter::next_sampling(std::size_t current, std::size_t base,
+                                  double overhead_pct,
+                                  double target_pct) noexcept
+    -> std::size_t {
+  if (target_pct <= 0) {
+    return base;
+  }
+  // Event costs scale with 1 / rate, so steps are factors of two; the gap
+  // between target / 2 and target keeps the rate from flapping.
+  if (overhead_pct > target_pct) {
+    return std::min(current * 2, std::max(kMaxSampling, base));
+  }
+  if (overhead_pct < target_pct / 2 && current > base) {
+    return std::max(current / 2, base);
+  }
+  return current;
+}
+
+auto ObserverMeter::update(const ObserverClocks &now) -> ObserverOverhead {
+  const auto cycles_total = tracking_cycles_.load(std::memory_order_relaxed);
+  const auto samples_total = tracking_samples_.load(std::memory_order_relaxed);
+  if (!started_ || now.wall_ns <= prev_.wall_ns) {
+    started_ = true;
+    prev_ = now;
+    prev_tracking_cycles_ = cycles_total;
+    prev_tracking_samples_ = samples_total;
+    return latest();
+  }
+
+  const double wall = static_cast<double>(now.wall_ns - prev_.wall_ns);
+  // An idle process would bill the observer's timer wakeups as most of its
+  // CPU; the budget is never taken as less than one core for the window.
+  const double process = std::max(
+      static_cast<double>(now.process_cpu_ns - prev_.process_cpu_ns), wall);
+  const double batcher =
+      static_cast<double>(now.batcher_cpu_ns - prev_.batcher_cpu_ns);
+  const double server =
+      static_cast<double>(now.server_cpu_ns - prev_.server_cpu_ns);
+
+  // The window doubles as the cycle counter's calibration.
+  const double cycles_per_ns =
+      std::max(static_cast<double>(now.cycles - prev_.cycles) / wall, 1e-9);
+  const auto timed_cycles =
+      static_cast<double>(cycles_total - prev_tracking_cycles_);
+  const auto timed_calls =
+      static_cast<double>(samples_total - prev_tracking_samples_);
+  const double tracking = timed_cycles * kCostSampleEvery / cycles_per_ns;
+
+  ObserverOverhead o;
+  o.batcher_pct = pct(batcher, process);
+  o.server_pct = pct(server, process);
+  o.tracking_pct = pct(tracking, process);
+  o.overhead_pct = o.batcher_pct + o.server_pct + o.tracking_pct;
+  o.tracking_ns_per_op =
+      timed_calls > 0 ? timed_cycles / timed_calls / cycles_per_ns : 0.0;
+  o.target_pct = target_pct_;
+  o.window_ns = now.wall_ns - prev_.wall_ns;
+  o.sampling = next_sampling(sampling_.load(std::memory_order_relaxed),
+                             base_sampling_, o.overhead_pct, target_pct_);
+  sampling_.store(o.sampling, std::memory_order_relaxed);
+
+  prev_ = now;
+  prev_tracking_cycles_ = cycles_total;
+  prev_tracking_samples_ = samples_total;
+  {
+    std::lock_guard lock(latest_mutex_);
+    latest_ = o;
+  }
+  return o;
+}
+
+auto ObserverMeter::latest() const -> ObserverOverhead {
+  std::lock_guard lock(latest_mutex_);
+  return latest_;
+}
+
+} // namespace mmap_viz
@@ -0,0 +1,138 @@
+#pragma once
+/// @file observer_meter.hpp
+/// @brief Measures what the visualization itself costs and steers the
+///        event sampling rate to keep that cost under a target.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+namespace mmap_viz {
+
+/// @brief One measurement window of the instrumentation's own cost.
+///
+/// Percentages are shares of the process CPU time spent in the window,
+/// counted as at least one core's worth (the window's wall time).
+struct ObserverOverhead {
+  double overhead_pct = 0;       ///< batcher + server + tracking.
+  double batcher_pct = 0;        ///< Event batcher thread.
+  double server_pct = 0;         ///< WebSocket / HTTP server thread.
+  double tracking_pct = 0;       ///< Tracking code on the alloc path.
+  double tracking_ns_per_op = 0; ///< Mean cost of one tracked call.
+  std::size_t sampling = 1;      ///< Sampling rate in force after it.
+  double target_pct = 0;         ///< Configured target (0 = no control).
+  std::uint64_t window_ns = 0;   ///< Wall-clock length of the window.
+};
+
+/// @brief Cumulative clock readings a window is the difference of.
+struct ObserverClocks {
+  std::uint64_t wall_ns = 0;        ///< steady_clock.
+  std::uint64_t cycles = 0;         ///< ObserverMeter::cycles().
+  std::uint64_t process_cpu_ns = 0; ///< CLOCK_PROCESS_CPUTIME_ID.
+  std::uint64_t batcher_cpu_ns = 0; ///< Caller's CLOCK_THREAD_CPUTIME_ID.
+  std::uint64_t server_cpu_ns = 0;  ///< CPU clock of the server thread.
+
+  /// @brief Read every clock. Runs on the batcher thread.
+  /// @param server_clock CPU clock of the server thread (from
+  ///        pthread_getcpuclockid), or -1 if there is none.
+  [[nodiscard]] static auto read(clockid_t server_clock) noexcept
+      -> ObserverClocks;
+};
+
+/// @brief Overhead meter and sampling controller, one per arena.
+///
+/// The alloc path feeds it through Probe, which times the tracking code
+/// on 1 in kCostSampleEvery calls per thread with the cycle counter and
+/// scales the result back up. The batcher closes a window about once a
+/// second with update(): thread CPU clocks give the observer threads'
+/// share, the probes give the tracking share, and the controller doubles
+/// the sampling rate while overhead is above the target and halves it
+/// (never below the configured rate) once overhead is under half of it.
+/// The batcher and server wake on a timer whatever the rate, so a target
+/// below their idle cost parks the rate at kMaxSampling.
+class ObserverMeter {
+public:
+  static constexpr std::uint32_t kCostSampleEvery = 64;
+  static constexpr std::size_t kMaxSampling = 4096;
+  /// Probes longer than this (~100 us) caught a preemption, not tracking
+  /// work, and are dropped: off-CPU time is nobody's overhead.
+  static constexpr std::uint64_t kMaxProbeCycles = std::uint64_t{1} << 18;
+
+  /// @param base_sampling Configured sampling rate; the controller's floor.
+  /// @param target_pct    Overhead target; 0 keeps the rate fixed.
+  ObserverMeter(std::size_t base_sampling, double target_pct) noexcept;
+
+  ObserverMeter(const ObserverMeter &) = delete;
+  ObserverMeter &operator=(const ObserverMeter &) = delete;
+
+  /// @brief Cheap monotonic tick count: the TSC where there is one,
+  ///        steady_clock nanoseconds elsewhere.
+  [[nodiscard]] static auto cycles() noexcept -> std::uint64_t;
+
+  /// @brief Times its scope when the per-thread @p tick counter says so.
+  class Probe {
+  public:
+    Probe(ObserverMeter &meter, std::uint32_t &tick) noexcept
+        : meter_{meter},
+          start_{++tick % kCostSampleEvery == 0 ? cycles() : 0} {}
+    ~Probe() {
+      if (start_ != 0)
+        meter_.add_tracking_cost(cycles() - start_);
+    }
+    Probe(const Probe &) = delete;
+    Probe &operator=(const Probe &) = delete;
+
+  private:
+    ObserverMeter &meter_;
+    std::uint64_t start_;
+  };
+
+  /// @brief Account one timed tracking call of @p cycles ticks.
+  void add_tracking_cost(std::uint64_t cycles) noexcept {
+    if (cycles > kMaxProbeCycles)
+      return;
+    tracking_cycles_.fetch_add(cycles, std::memory_order_relaxed);
+    tracking_samples_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// @brief The live sampling rate, for LocalTracker to follow.
+  [[nodiscard]] auto sampling() const noexcept
+      -> const std::atomic<std::size_t> & {
+    return sampling_;
+  }
+
+  /// @brief Close the window that ended at @p now and run the controller.
+  ///        The first call only starts a window. Single caller (batcher).
+  auto update(const ObserverClocks &now) -> ObserverOverhead;
+
+  /// @brief The last closed window; before the first, only sampling and
+  ///        target_pct are set.
+  [[nodiscard]] auto latest() const -> ObserverOverhead;
+
+  /// @brief The controller step: the rate for the next window.
+  [[nodiscard]] static auto next_sampling(std::size_t current,
+                                          std::size_t base,
+                                          double overhead_pct,
+                                          double target_pct) noexcept
+      -> std::size_t;
+
+private:
+  std::atomic<std::size_t> sampling_;
+  std::atomic<std::uint64_t> tracking_cycles_{0};
+  std::atomic<std::uint64_t> tracking_samples_{0};
+  const std::size_t base_sampling_;
+  const double target_pct_;
+
+  // Batcher-only window state.
+  ObserverClocks prev_{};
+  std::uint64_t prev_tracking_cycles_ = 0;
+  std::uint64_t prev_tracking_samples_ = 0;
+  bool started_ = false;
+
+  mutable std::mutex latest_mutex_;
+  ObserverOverhead latest_{};
+};
+
+} // namespace mmap_viz
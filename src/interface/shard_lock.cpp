@@ -0,0 +1,205 @@
+/// @file shard_lock.cpp
+/// @brief Implementation of ShardLock and its histograms.
+
+#include "interface/shard_lock.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace mmap_viz {
+
+namespace {
+
+auto now_ns() noexcept -> std::uint64_t {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+/// @brief Single-writer increment: no RMW needed, readers see either value.
+inline auto bump(std::atomic<std::uint64_t> &counter,
+                 std::uint64_t n = 1) noexcept -> std::uint64_t {
+  auto value = counter.load(std::memory_order_relaxed) + n;
+  counter.store(value, std::memory_order_relaxed);
+  return value;
+}
+
+} // namespace
+
+// ─── LockHistogram ──────────────────────────────────────────────────────
+
+auto LockHistogram::percentile(double q) const noexcept -> std::uint64_t {
+  if (count == 0) {
+    return 0;
+  }
+  auto rank = static_cast<std::uint64_t>(
+      std::max(1.0, q * static_cast<double>(count) + 0.5));
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return i == 0 ? 0 : std::min(bucket_limit_ns(i) - 1, max_ns);
+    }
+  }
+  return max_ns;
+}
+
+auto LockHistogram::operator+=(const LockHistogram &o) noexcept
+    -> LockHistogram & {
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    buckets[i] += o.buckets[i];
+  }
+  count += o.count;
+  sum_ns += o.sum_ns;
+  max_ns = std::max(max_ns, o.max_ns);
+  return *this;
+}
+
+// ─── ShardLock ──────────────────────────────────────────────────────────
+
+void ShardLock::Recorder::record(std::uint64_t ns) noexcept {
+  bump(buckets[LockHistogram::bucket_of(ns)]);
+  bump(count);
+  bump(sum_ns, ns);
+  if (ns > max_ns.load(std::memory_order_relaxed)) {
+    max_ns.store(ns, std::memory_order_relaxed);
+  }
+}
+
+auto ShardLock::Recorder::load() const noexcept -> LockHistogram {
+  LockHistogram h;
+  for (std::size_t i = 0; i < LockHistogram::kBuckets; ++i) {
+    h.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+  }
+  h.count = count.load(std::memory_order_relaxed);
+  h.sum_ns = sum_ns.load(std::memory_order_relaxed);
+  h.max_ns = max_ns.load(std::memory_order_relaxed);
+  return h;
+}
+
+void ShardLock::lock_slow() noexcept {
+  switch (kind_) {
+  case ShardLockKind::kSpinFutex:
+    lock_spin();
+    break;
+  case ShardLockKind::kAdaptive:
+    lock_adaptive();
+    break;
+  case ShardLockKind::kMutex:
+    // Contended path only, so counting the waiter costs the fast path
+    // nothing.
+    state_.fetch_add(1, std::memory_order_release);
+    mutex_.lock();
+    state_.fetch_sub(1, std::memory_order_relaxed);
+    break;
+  }
+}
+
+void ShardLock::lock_spin() noexcept {
+  for (std::uint32_t spin = 0; spin < kSpinLimit; ++spin) {
+    cpu_relax();
+    auto s = state_.load(std::memory_order_relaxed);
+    if (s == kUnlocked &&
+        state_.compare_exchange_weak(s, kLocked, std::memory_order_acquire,
+                                     std::memory_order_relaxed)) {
+      return;
+    }
+  }
+  sleep_until_acquired();
+}
+
+void ShardLock::lock_adaptive() noexcept {
+  const auto budget = spin_budget_ns_.load(std::memory_order_relaxed);
+  const auto start = now_ns();
+  std::uint32_t backoff = 1;
+  for (;;) {
+    // Test before test-and-set: only CAS once the lock looks free, so
+    // waiters spin on a shared cache line instead of bouncing it.
+    auto s = state_.load(std::memory_order_relaxed);
+    if (s == kUnlocked &&
+        state_.compare_exchange_weak(s, kLocked, std::memory_order_acquire,
+                                     std::memory_order_relaxed)) {
+      return;
+    }
+    for (std::uint32_t i = 0; i < backoff; ++i) {
+      cpu_relax();
+    }
+    backoff = std::min(backoff * 2, kMaxBackoff);
+    if (now_ns() - start >= budget) {
+      break;
+    }
+  }
+  // The whole budget was spun for nothing: the holder is slow or not
+  // running. Spin less next time.
+  spin_budget_ns_.store(std::max(kMinSpinNs, budget * 3 / 4),
+                        std::memory_order_relaxed);
+  sleep_until_acquired();
+}
+
+void ShardLock::sleep_until_acquired() noexcept {
+  // Announce a sleeper so unlock() knows to wake someone. Whoever gets the
+  // lock this way keeps kSleepers set, which may cost one spurious wake.
+  while (state_.exchange(kSleepers, std::memory_order_acquire) !=
+         kUnlocked) {
+    state_.wait(kSleepers, std::memory_order_relaxed);
+  }
+}
+
+void ShardLock::lock_profiled(bool remote) noexcept {
+  std::uint64_t waited = 0;
+  bool was_contended = false;
+  if (!try_lock()) {
+    was_contended = true;
+    auto start = now_ns();
+    lock_slow();
+    waited = std::max<std::uint64_t>(now_ns() - start, 1);
+  }
+
+  // From here on this thread holds the lock.
+  auto n = bump(acquisitions_);
+  if (was_contended) {
+    bump(contended_);
+  }
+  if (remote) {
+    bump(remote_);
+  }
+  wait_.record(waited);
+  hold_start_ns_ = n % kHoldSampleEvery == 0 ? now_ns() : 0;
+}
+
+void ShardLock::record_hold() noexcept {
+  auto held = now_ns() - hold_start_ns_;
+  hold_.record(held);
+  hold_start_ns_ = 0;
+
+  if (kind_ == ShardLockKind::kAdaptive) {
+    // Move a quarter of the way towards twice this hold time.
+    auto target = static_cast<std::int64_t>(
+        std::clamp(2 * held, kMinSpinNs, kMaxSpinNs));
+    auto budget = static_cast<std::int64_t>(spin_budget_ns());
+    spin_budget_ns_.store(
+        static_cast<std::uint64_t>(budget + (target - budget) / 4),
+        std::memory_order_relaxed);
+  }
+}
+
+auto ShardLock::profile() const noexcept -> ShardLockProfile {
+  return ShardLockProfile{
+      .acquisitions = acquisitions_.load(std::memory_order_relaxed),
+      .contended = contended_.load(std::memory_order_relaxed),
+      .remote = remote_.load(std::memory_order_relaxed),
+      .wait_ns = wait_.load(),
+      .hold_ns = hold_.load(),
+  };
+}
+
+} // namespace mmap_viz
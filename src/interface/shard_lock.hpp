@@ -0,0 +1,189 @@
+#pragma once
+/// @file shard_lock.hpp
+/// @brief Instrumented spin-then-futex mutex guarding one arena shard.
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace mmap_viz {
+
+/// @brief Log2 histogram of durations in nanoseconds.
+///
+/// Bucket 0 holds 0 ns (an uncontended acquisition); bucket i > 0 holds
+/// [2^(i-1), 2^i) ns. The last bucket also takes everything longer.
+struct LockHistogram {
+  static constexpr std::size_t kBuckets = 40; ///< Up to ~4.5 minutes.
+
+  std::array<std::uint64_t, kBuckets> buckets{};
+  std::uint64_t count = 0;
+  std::uint64_t sum_ns = 0;
+  std::uint64_t max_ns = 0;
+
+  [[nodiscard]] static constexpr auto bucket_of(std::uint64_t ns) noexcept
+      -> std::size_t {
+    auto i = static_cast<std::size_t>(std::bit_width(ns));
+    return i < kBuckets ? i : kBuckets - 1;
+  }
+
+  /// @brief Exclusive upper bound of bucket @p i, in nanoseconds.
+  [[nodiscard]] static constexpr auto bucket_limit_ns(std::size_t i) noexcept
+      -> std::uint64_t {
+    return std::uint64_t{1} << i;
+  }
+
+  /// @brief Upper bound of the bucket holding quantile @p q in [0, 1],
+  ///        capped at max_ns.
+  [[nodiscard]] auto percentile(double q) const noexcept -> std::uint64_t;
+
+  [[nodiscard]] auto mean_ns() const noexcept -> double {
+    return count == 0 ? 0.0 : static_cast<double>(sum_ns) / count;
+  }
+
+  auto operator+=(const LockHistogram &o) noexcept -> LockHistogram &;
+};
+
+/// @brief What a ShardLock recorded, copied out for reporting.
+struct ShardLockProfile {
+  std::uint64_t acquisitions = 0; ///< Profiled acquisitions.
+  std::uint64_t contended = 0;    ///< Those that found the lock held.
+  std::uint64_t remote = 0;       ///< Those by a thread homed elsewhere.
+  LockHistogram wait_ns;          ///< Time to acquire, every acquisition.
+  LockHistogram hold_ns;          ///< Time held, every kHoldSampleEvery-th.
+};
+
+/// @brief How a ShardLock waits when it finds the lock held.
+enum class ShardLockKind : std::uint8_t {
+  /// Fixed number of pause-spins, then a futex sleep.
+  kSpinFutex,
+  /// Test-and-test-and-set with exponential pause backoff for a spin budget
+  /// adapted online from hold times, then a futex sleep.
+  kAdaptive,
+  /// std::mutex, which parks waiters in the kernel (baseline).
+  kMutex,
+};
+
+/// @brief Mutex for one shard with built-in contention profiling; how it
+///        waits is chosen by ShardLockKind.
+///
+/// The adaptive kind keeps its spin budget near twice the mean sampled hold
+/// time, so a waiter spins through a typical critical section but not much
+/// longer, and shrinks it whenever spinning ends in a futex sleep anyway
+/// (holder preempted, e.g. under oversubscription).
+///
+/// lock()/try_lock()/unlock() make it a standard Lockable and are not
+/// profiled, so diagnostic walks do not skew the numbers. Allocation paths
+/// use lock_profiled(), which counts the acquisition, times any wait, and
+/// samples the hold time. Profile counters are only written by the lock
+/// holder; profile() reads them without taking the lock.
+class ShardLock {
+public:
+  /// Pause-spins before sleeping on the futex (kSpinFutex).
+  static constexpr std::uint32_t kSpinLimit = 100;
+  /// Hold time is measured on one in this many profiled acquisitions.
+  static constexpr std::uint64_t kHoldSampleEvery = 8;
+  /// Bounds and starting point of the kAdaptive spin budget.
+  static constexpr std::uint64_t kMinSpinNs = 250;
+  static constexpr std::uint64_t kMaxSpinNs = 50'000;
+  static constexpr std::uint64_t kInitialSpinNs = 2'000;
+  /// Longest kAdaptive backoff step, in pause instructions.
+  static constexpr std::uint32_t kMaxBackoff = 64;
+
+  explicit ShardLock(ShardLockKind kind = ShardLockKind::kSpinFutex) noexcept
+      : kind_{kind} {}
+  ShardLock(const ShardLock &) = delete;
+  ShardLock &operator=(const ShardLock &) = delete;
+
+  void lock() noexcept {
+    if (!try_lock()) {
+      lock_slow();
+    }
+  }
+
+  [[nodiscard]] auto try_lock() noexcept -> bool {
+    if (kind_ == ShardLockKind::kMutex) {
+      return mutex_.try_lock();
+    }
+    std::uint32_t expected = kUnlocked;
+    return state_.compare_exchange_strong(expected, kLocked,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed);
+  }
+
+  void unlock() noexcept {
+    if (hold_start_ns_ != 0) {
+      record_hold();
+    }
+    if (kind_ == ShardLockKind::kMutex) {
+      mutex_.unlock();
+    } else if (state_.exchange(kUnlocked, std::memory_order_release) ==
+               kSleepers) {
+      state_.notify_one();
+    }
+  }
+
+  [[nodiscard]] auto kind() const noexcept -> ShardLockKind { return kind_; }
+
+  /// @brief Whether some thread has given up spinning and is blocked on
+  ///        the lock (or, for kMutex, is inside its lock()). May stay true
+  ///        briefly after that thread got the lock; for tests and
+  ///        diagnostics only.
+  [[nodiscard]] auto has_waiters() const noexcept -> bool {
+    auto s = state_.load(std::memory_order_acquire);
+    return kind_ == ShardLockKind::kMutex ? s != 0 : s == kSleepers;
+  }
+
+  /// @brief Current kAdaptive spin budget in nanoseconds.
+  [[nodiscard]] auto spin_budget_ns() const noexcept -> std::uint64_t {
+    return spin_budget_ns_.load(std::memory_order_relaxed);
+  }
+
+  /// @brief lock() for an allocation path, recording the acquisition.
+  /// @param remote The caller's home shard is a different one, e.g. a
+  ///               cross-thread free.
+  void lock_profiled(bool remote) noexcept;
+
+  /// @brief Snapshot of everything recorded so far.
+  [[nodiscard]] auto profile() const noexcept -> ShardLockProfile;
+
+private:
+  static constexpr std::uint32_t kUnlocked = 0;
+  static constexpr std::uint32_t kLocked = 1;
+  static constexpr std::uint32_t kSleepers = 2; ///< Locked, maybe waiters.
+
+  /// @brief Single-writer histogram readable while it is being updated.
+  struct Recorder {
+    std::array<std::atomic<std::uint64_t>, LockHistogram::kBuckets> buckets{};
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> sum_ns{0};
+    std::atomic<std::uint64_t> max_ns{0};
+
+    void record(std::uint64_t ns) noexcept;
+    [[nodiscard]] auto load() const noexcept -> LockHistogram;
+  };
+
+  void lock_slow() noexcept;
+  void lock_spin() noexcept;
+  void lock_adaptive() noexcept;
+  void sleep_until_acquired() noexcept;
+  void record_hold() noexcept;
+
+  /// Lock word; for kMutex, the number of threads blocked in lock_slow().
+  std::atomic<std::uint32_t> state_{kUnlocked};
+  ShardLockKind kind_;
+  std::atomic<std::uint64_t> spin_budget_ns_{kInitialSpinNs};
+  std::mutex mutex_; ///< Used only by kMutex.
+
+  // Profile; written only while holding the lock.
+  std::atomic<std::uint64_t> acquisitions_{0};
+  std::atomic<std::uint64_t> contended_{0};
+  std::atomic<std::uint64_t> remote_{0};
+  Recorder wait_;
+  Recorder hold_;
+  std::uint64_t hold_start_ns_ = 0; ///< 0 = this hold is not sampled.
+};
+
+} // namespace mmap_viz
@@ -0,0 +1,291 @@
+/// @file sub_arena.cpp
+/// @brief Implementation of SubArena.
+
+#include "interface/sub_arena.hpp"
+#include "interface/memory_pressure.hpp"
+#include "interface/visualization_arena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <expected>
+#include <mutex>
+
+namespace mmap_viz {
+
+/// @brief This thread's round-robin slot, shared by every sub-arena.
+static auto thread_slot() noexcept -> std::size_t {
+  static std::atomic<std::size_t> next_slot{0};
+  thread_local std::size_t slot =
+      next_slot.fetch_add(1, std::memory_order_relaxed);
+  return slot;
+}
+
+SubArena::SubArena(VisualizationArena &parent, PressureMonitor &pressure,
+                   SubArenaConfig cfg, std::byte *base, std::size_t capacity)
+    : parent_{&parent}, pressure_{&pressure}, name_{std::move(cfg.name)},
+      base_{base},
+      capacity_{capacity}, shard_count_{cfg.shard_count},
+      ranges_per_shard_{cfg.ranges_per_shard},
+      range_size_{(capacity / (shard_count_ * ranges_per_shard_)) &
+                  ~std::size_t{15}},
+      lock_kind_{cfg.shard_lock}, ranges_(shard_count_ * ranges_per_shard_) {}
+
+SubArena::~SubArena() { release(); }
+
+void SubArena::release() {
+  if (ranges_.empty()) {
+    return;
+  }
+  // Every block goes at once; so does its share of the arena's usage.
+  for (std::size_t i = 0; i < ranges_.size(); ++i) {
+    if (auto *r = ranges_.find(i)) {
+      pressure_->on_region_usage(r->reported, 0);
+    }
+  }
+  parent_->release_sub_arena(*this);
+  ranges_.clear();
+  capacity_ = 0;
+}
+
+auto SubArena::range(std::size_t i) -> Range & {
+  return ranges_.get(i, [&] {
+    return Range(lock_kind_, base_ + (i * range_size_), range_capacity(i));
+  });
+}
+
+void SubArena::report_usage(Range &range) noexcept {
+  pressure_->on_region_usage(range.reported,
+                             range.allocator.bytes_allocated());
+}
+
+auto SubArena::range_of(const std::byte *ptr) const noexcept
+    -> std::size_t {
+  auto idx = static_cast<std::size_t>(ptr - base_) / range_size_;
+  return std::min(idx, ranges_.size() - 1);
+}
+
+// ─── Allocation ──────────────────────────────────────────────────────────
+
+auto SubArena::alloc_raw(std::size_t size, std::size_t alignment,
+                         std::string_view tag) -> void * {
+  if (ranges_.empty()) {
+    return nullptr;
+  }
+
+  std::size_t offset_to_user = user_offset(alignment);
+  std::size_t total_request = size + offset_to_user;
+  auto result = allocate(total_request, alignment);
+  if (!result.has_value()) {
+    return nullptr;
+  }
+
+  // Same layout as VisualizationArena::alloc_raw().
+  std::byte *raw_ptr = result->ptr;
+  std::byte *user_ptr = raw_ptr + offset_to_user;
+  auto *header = reinterpret_cast<AllocationHeader *>(raw_ptr);
+  header->magic = AllocationHeader::kMagicValue;
+  header->size = size;
+  header->actual_size = result->actual_size;
+  std::size_t len = std::min(tag.size(), sizeof(header->tag) - 1);
+  std::memcpy(header->tag, tag.data(), len);
+  header->tag[len] = '\0';
+  *reinterpret_cast<std::uint32_t *>(user_ptr - sizeof(std::uint32_t)) =
+      static_cast<std::uint32_t>(offset_to_user);
+  std::memset(user_ptr, 0, size);
+
+  BlockMetadata meta{
+      .offset = static_cast<std::size_t>(raw_ptr - parent_->base()),
+      .size = size,
+      .alignment = alignment,
+      .actual_size = result->actual_size,
+      .timestamp = std::chrono::system_clock::now(),
+  };
+  meta.set_tag(tag);
+  parent_->record_sub_arena_alloc(std::move(meta));
+  return user_ptr;
+}
+
+void SubArena::dealloc_raw(void *ptr, std::size_t /*size*/) {
+  if (ptr == nullptr || !owns(ptr)) {
+    return;
+  }
+
+  auto *user_ptr = static_cast<std::byte *>(ptr);
+  std::uint32_t offset_val =
+      *reinterpret_cast<std::uint32_t *>(user_ptr - sizeof(std::uint32_t));
+  std::byte *raw_ptr = user_ptr - offset_val;
+  auto *header = reinterpret_cast<AllocationHeader *>(raw_ptr);
+  if (header->magic != AllocationHeader::kMagicValue) {
+    return; // Double free
+  }
+  header->magic = 0;
+  const auto actual_size = header->actual_size;
+
+  const auto idx = range_of(raw_ptr);
+  auto &range = this->range(idx);
+  std::byte *edge = range.allocator.base() + range.allocator.capacity();
+  if (raw_ptr + actual_size <= edge) {
+    std::lock_guard lock(range.mutex);
+    (void)range.allocator.deallocate(raw_ptr, actual_size);
+    --range.active_blocks;
+    ++range.deallocations;
+    report_usage(range);
+  } else {
+    // Straddles the edge: each part goes back to its own range.
+    auto &next = this->range(idx + 1);
+    std::scoped_lock lock(range.mutex, next.mutex);
+    const auto lower = static_cast<std::size_t>(edge - raw_ptr);
+    (void)range.allocator.deallocate(raw_ptr, lower);
+    (void)next.allocator.deallocate(edge, actual_size - lower);
+    --range.active_blocks;
+    ++range.deallocations;
+    report_usage(range);
+    report_usage(next);
+  }
+  parent_->record_sub_arena_free(
+      static_cast<std::size_t>(raw_ptr - parent_->base()), actual_size);
+}
+
+auto SubArena::allocate(std::size_t total_request, std::size_t alignment)
+    -> std::expected<AllocationResult, AllocError> {
+  // Home range first: the shard picks the thread round-robin, and within
+  // it the next bits of the slot pick the range.
+  const auto n = ranges_.size();
+  const auto slot = thread_slot();
+  const auto shard = slot % shard_count_;
+  const auto first = shard * ranges_per_shard_;
+  const auto home = first + ((slot / shard_count_) % ranges_per_shard_);
+
+  auto try_range = [&](Range &range) {
+    auto result = range.allocator.allocate(total_request, alignment);
+    if (result.has_value()) {
+      ++range.active_blocks;
+      ++range.allocations;
+      report_usage(range);
+    }
+    return result;
+  };
+
+  // 1. The shard's ranges, skipping any another thread holds.
+  for (std::size_t k = 0; k < ranges_per_shard_; ++k) {
+    auto &range = this->range(first + ((home - first + k) % ranges_per_shard_));
+    if (range.mutex.try_lock()) {
+      std::lock_guard lock(range.mutex, std::adopt_lock);
+      if (auto result = try_range(range)) {
+        return result;
+      }
+    }
+  }
+
+  // 2. Every range, waiting for each: a tenant is bounded by its whole
+  //    capacity, not by one shard of it.
+  for (std::size_t k = 0; k < n; ++k) {
+    auto &range = this->range((home + k) % n);
+    std::lock_guard lock(range.mutex);
+    if (auto result = try_range(range)) {
+      return result;
+    }
+  }
+
+  // 3. No range has room on its own; try the free space around each edge.
+  const std::size_t block_size = FreeListAllocator::block_size(total_request);
+  for (std::size_t k = 0; k + 1 < n; ++k) {
+    if (auto result =
+            allocate_across_edge((home + k) % (n - 1), block_size, alignment)) {
+      return result;
+    }
+  }
+  return std::unexpected(AllocError::OutOfMemory);
+}
+
+auto SubArena::allocate_across_edge(std::size_t lower, std::size_t block_size,
+                                    std::size_t alignment)
+    -> std::expected<AllocationResult, AllocError> {
+  auto &low = range(lower);
+  auto &high = range(lower + 1);
+  std::scoped_lock lock(low.mutex, high.mutex);
+
+  // Lowest aligned start in the free end of `low` that leaves the rest to
+  // the free start of `high`.
+  const auto edge = reinterpret_cast<std::uintptr_t>(high.allocator.base());
+  const std::size_t tail = low.allocator.free_tail();
+  const std::size_t head = high.allocator.free_head();
+  const std::size_t align = std::max<std::size_t>(alignment, 16);
+  const std::uintptr_t start = (edge - tail + align - 1) & ~(align - 1);
+  if (tail == 0 || head == 0 || start >= edge ||
+      start + block_size <= edge || start + block_size > edge + head) {
+    return std::unexpected(AllocError::OutOfMemory);
+  }
+
+  const auto below = static_cast<std::size_t>(edge - start);
+  low.allocator.take_tail(below);
+  high.allocator.take_head(block_size - below);
+  ++low.active_blocks;
+  ++low.allocations;
+  ++low.edge_allocations;
+  report_usage(low);
+  report_usage(high);
+  auto *ptr = reinterpret_cast<std::byte *>(start);
+  return AllocationResult{
+      .ptr = ptr,
+      .offset = static_cast<std::size_t>(ptr - low.allocator.base()),
+      .actual_size = block_size,
+  };
+}
+
+// ─── Accessors ───────────────────────────────────────────────────────────
+
+auto SubArena::owns(const void *ptr) const noexcept -> bool {
+  const auto *p = static_cast<const std::byte *>(ptr);
+  return p >= base_ && p < base_ + capacity_;
+}
+
+auto SubArena::bytes_allocated() const noexcept -> std::size_t {
+  std::size_t sum = 0;
+  for (std::size_t i = 0; i < ranges_.size(); ++i) {
+    if (const auto *r = ranges_.find(i)) {
+      sum += r->allocator.bytes_allocated();
+    }
+  }
+  return sum;
+}
+
+auto SubArena::bytes_free() const noexcept -> std::size_t {
+  std::size_t sum = 0;
+  for (std::size_t i = 0; i < ranges_.size(); ++i) {
+    const auto *r = ranges_.find(i);
+    sum += r ? r->allocator.bytes_free() : range_capacity(i);
+  }
+  return sum;
+}
+
+auto SubArena::stats() const -> SubArenaStats {
+  SubArenaStats out{
+      .name = name_,
+      .offset = static_cast<std::size_t>(base_ - parent_->base()),
+      .capacity = capacity_,
+      .shard_count = shard_count_,
+      .ranges_per_shard = ranges_per_shard_,
+  };
+  for (std::size_t i = 0; i < ranges_.size(); ++i) {
+    const auto *r = ranges_.find(i);
+    if (r == nullptr) {
+      out.bytes_free += range_capacity(i);
+      ++out.free_blocks;
+      continue;
+    }
+    std::lock_guard lock(r->mutex);
+    out.bytes_allocated += r->allocator.bytes_allocated();
+    out.bytes_free += r->allocator.bytes_free();
+    out.free_blocks += r->allocator.free_block_count();
+    out.active_blocks += r->active_blocks;
+    out.allocations += r->allocations;
+    out.deallocations += r->deallocations;
+    out.edge_allocations += r->edge_allocations;
+  }
+  return out;
+}
+
+} // namespace mmap_viz
@@ -0,0 +1,204 @@
+#pragma once
+/// @file sub_arena.hpp
+/// @brief A tenant arena carved out of a VisualizationArena's address range.
+///
+/// A SubArena owns a contiguous run of its parent's address range with its
+/// own shards, locks, tags and counters. Its allocations stream to the
+/// parent's visualization and its usage is rolled up into the parent's
+/// totals. release() drops every block at once and hands the range back.
+
+#include "allocator/free_list.hpp"
+#include "interface/lazy_shards.hpp"
+#include "interface/shard_lock.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace mmap_viz {
+
+class PressureMonitor;
+class VisualizationArena;
+
+/// @brief Configuration for VisualizationArena::create_sub_arena().
+struct SubArenaConfig {
+  std::string name = "sub"; ///< Shown in the hierarchy view.
+  /// Bytes to delegate; rounded up to whole parent shards.
+  std::size_t capacity = 0;
+  std::size_t shard_count = 4; ///< Independently locked shards.
+  /// Address ranges each shard's free index is split into, each with its
+  /// own lock; the shard's threads spread over them. 1 = one per shard.
+  std::size_t ranges_per_shard = 1;
+  ShardLockKind shard_lock = ShardLockKind::kSpinFutex;
+};
+
+/// @brief Usage of one sub-arena, as rolled up into its parent.
+struct SubArenaStats {
+  std::string name;
+  std::size_t offset = 0;   ///< Start of the range in the parent.
+  std::size_t capacity = 0; ///< Bytes delegated by the parent.
+  std::size_t shard_count = 0;
+  std::size_t ranges_per_shard = 0;
+  std::size_t bytes_allocated = 0; ///< Block bytes handed out.
+  std::size_t bytes_free = 0;
+  std::size_t free_blocks = 0; ///< Free fragments over all ranges.
+  std::size_t active_blocks = 0;
+  std::uint64_t allocations = 0; ///< Monotonic.
+  std::uint64_t deallocations = 0;
+  std::uint64_t edge_allocations = 0; ///< Blocks straddling a range edge.
+};
+
+/// @brief Arena delegated from a VisualizationArena.
+///
+/// Threads are spread over the shards round-robin and fall back to the
+/// other shards when theirs is full. Blocks use the parent's header
+/// layout, so tags and sizes show up in its snapshots and timeline, and
+/// each range's usage feeds the parent's arena pressure watches.
+///
+/// Each shard's range is split into ranges_per_shard address ranges with
+/// a lock and free index each. A free locks only the range it falls in;
+/// an allocation tries the ranges of its shard from the thread's own,
+/// skipping busy ones, then waits on each range in turn.
+///
+/// Free blocks do not merge across a range edge: each range has its own
+/// free index over fixed bounds, so there is no single block to merge
+/// into. The cost is bounded: an edge splits a free run into at most a
+/// free end of one range and a free start of the next, and a request no
+/// single range can serve may take both together, holding both locks
+/// (always taken in address order). Freeing that block returns each part
+/// to its own range, where it merges with its neighbours as usual.
+/// `stats().free_blocks` counts the fragments. A range is built by the
+/// first allocation that reaches it, so carving a sub-arena of many shards
+/// costs no more than carving one.
+///
+/// The parent must outlive the sub-arena and must not be moved while it
+/// exists. Blocks must be freed through the sub-arena that made them.
+class SubArena {
+public:
+  ~SubArena();
+
+  SubArena(const SubArena &) = delete;
+  SubArena &operator=(const SubArena &) = delete;
+
+  // ─── Allocation ──────────────────────────────────────────────────────
+
+  /// @brief Allocate and construct a T within the sub-arena.
+  /// @return Pointer to the constructed T, or nullptr when full.
+  template <typename T, typename... Args>
+  auto alloc(std::string_view tag, Args &&...args) -> T * {
+    auto *raw = alloc_raw(sizeof(T), alignof(T), tag);
+    if (raw == nullptr) {
+      return nullptr;
+    }
+    return ::new (raw) T(std::forward<Args>(args)...);
+  }
+
+  /// @brief Destruct and deallocate a T from alloc<T>().
+  template <typename T> void dealloc(T *ptr) {
+    if (ptr == nullptr) {
+      return;
+    }
+    ptr->~T();
+    dealloc_raw(ptr, sizeof(T));
+  }
+
+  /// @brief Allocate raw bytes, as VisualizationArena::alloc_raw().
+  /// @return Pointer to zeroed memory, or nullptr when every shard is
+  ///         full or the sub-arena was released.
+  auto alloc_raw(std::size_t size, std::size_t alignment, std::string_view tag)
+      -> void *;
+
+  /// @brief Free a block from alloc_raw().
+  void dealloc_raw(void *ptr, std::size_t size);
+
+  /// @brief Drop every block and return the range to the parent. Later
+  ///        allocations fail. No other call may run concurrently.
+  ///        Called by the destructor.
+  void release();
+
+  // ─── Accessors ───────────────────────────────────────────────────────
+
+  [[nodiscard]] auto name() const noexcept -> const std::string & {
+    return name_;
+  }
+  [[nodiscard]] auto base() const noexcept -> std::byte * { return base_; }
+  /// @brief Delegated bytes; 0 once released.
+  [[nodiscard]] auto capacity() const noexcept -> std::size_t {
+    return capacity_;
+  }
+  [[nodiscard]] auto owns(const void *ptr) const noexcept -> bool;
+
+  /// @brief Block bytes handed out (unlocked read, like the parent's).
+  [[nodiscard]] auto bytes_allocated() const noexcept -> std::size_t;
+  [[nodiscard]] auto bytes_free() const noexcept -> std::size_t;
+
+  /// @brief Counters, taken under each range lock.
+  [[nodiscard]] auto stats() const -> SubArenaStats;
+
+private:
+  friend class VisualizationArena;
+
+  /// @brief One independently locked address range of a shard.
+  struct Range {
+    Range(ShardLockKind kind, std::byte *base, std::size_t size)
+        : mutex(kind), allocator(base, size) {}
+
+    alignas(64) mutable ShardLock mutex;
+    FreeListAllocator allocator;
+    // Under mutex. A block straddling an edge counts in the lower range.
+    std::size_t active_blocks = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t edge_allocations = 0;
+    std::size_t reported = 0; ///< Usage last folded into the monitor.
+  };
+
+  SubArena(VisualizationArena &parent, PressureMonitor &pressure,
+           SubArenaConfig cfg, std::byte *base, std::size_t capacity);
+
+  /// @brief Range @p i, built on first use.
+  auto range(std::size_t i) -> Range &;
+
+  /// @brief Bytes spanned by range @p i; the last takes the remainder.
+  [[nodiscard]] auto range_capacity(std::size_t i) const noexcept
+      -> std::size_t {
+    return i + 1 < ranges_.size() ? range_size_
+                                  : capacity_ - (i * range_size_);
+  }
+
+  /// @brief Report @p range's usage to the parent's pressure monitor. The
+  ///        caller holds the range lock.
+  void report_usage(Range &range) noexcept;
+
+  /// @brief Index of the range holding @p ptr.
+  auto range_of(const std::byte *ptr) const noexcept -> std::size_t;
+
+  /// @brief A block of @p total_request bytes from the first range, in
+  ///        this thread's order, that has room; else across an edge.
+  auto allocate(std::size_t total_request, std::size_t alignment)
+      -> std::expected<AllocationResult, AllocError>;
+
+  /// @brief Carve a block from the free end of range @p lower and the free
+  ///        start of the next. Takes both locks.
+  auto allocate_across_edge(std::size_t lower, std::size_t block_size,
+                            std::size_t alignment)
+      -> std::expected<AllocationResult, AllocError>;
+
+  VisualizationArena *parent_;
+  PressureMonitor *pressure_;
+  std::string name_;
+  std::byte *base_;
+  std::size_t capacity_;
+  std::size_t shard_count_ = 0;
+  std::size_t ranges_per_shard_ = 0;
+  std::size_t range_size_ = 0;
+  ShardLockKind lock_kind_;
+  /// Shard i owns the ranges_per_shard_ ranges from i * ranges_per_shard_.
+  LazyShards<Range> ranges_;
+};
+
+} // namespace mmap_viz
@@ -0,0 +1,139 @@
+/// @file tag_quota.cpp
+/// @brief Implementation of TagQuotas.
+
+#include "interface/tag_quota.hpp"
+
+#include <algorithm>
+#include <set>
+
+namespace mmap_viz {
+
+TagQuotas::TagQuotas(std::vector<TagQuota> quotas)
+    : quotas_{std::move(quotas)},
+      shared_{std::make_unique<Shared[]>(quotas_.size())},
+      stripes_{std::make_unique<Stripe[]>(quotas_.size() * kStripes)} {
+  chunks_.reserve(quotas_.size());
+  for (std::size_t i = 0; i < quotas_.size(); ++i) {
+    chunks_.push_back(quotas_[i].limit_bytes / (kStripes * 4));
+
+    auto len = quotas_[i].prefix.size();
+    auto it = std::find_if(by_length_.begin(), by_length_.end(),
+                           [len](const auto &e) { return e.first == len; });
+    if (it == by_length_.end()) {
+      by_length_.emplace_back(len, PrefixMap{});
+      it = std::prev(by_length_.end());
+    }
+    it->second.emplace(quotas_[i].prefix, i);
+  }
+  std::sort(by_length_.begin(), by_length_.end(),
+            [](const auto &a, const auto &b) { return a.first > b.first; });
+}
+
+auto TagQuotas::valid(const std::vector<TagQuota> &quotas) -> bool {
+  std::set<std::string_view> seen;
+  for (const auto &q : quotas) {
+    if (q.prefix.size() > kMaxPrefix || !seen.insert(q.prefix).second) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto TagQuotas::find(std::string_view tag) const noexcept -> std::size_t {
+  for (const auto &[len, prefixes] : by_length_) {
+    if (len > tag.size()) {
+      continue;
+    }
+    if (auto it = prefixes.find(tag.substr(0, len)); it != prefixes.end()) {
+      return it->second;
+    }
+  }
+  return kNone;
+}
+
+auto TagQuotas::reserve(std::size_t quota, std::size_t bytes) noexcept
+    -> bool {
+  auto &reserved = shared_[quota].reserved;
+  const auto limit = quotas_[quota].limit_bytes;
+  auto r = reserved.load(std::memory_order_relaxed);
+  while (bytes <= limit && r <= limit - bytes) {
+    if (reserved.compare_exchange_weak(r, r + bytes,
+                                       std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TagQuotas::pull_back(std::size_t quota) noexcept {
+  std::size_t idle = 0;
+  for (std::size_t s = 0; s < kStripes; ++s) {
+    idle += stripe(quota, s).tokens.exchange(0, std::memory_order_relaxed);
+  }
+  shared_[quota].reserved.fetch_sub(idle, std::memory_order_relaxed);
+}
+
+auto TagQuotas::try_charge(std::size_t quota, std::size_t s,
+                           std::size_t bytes) noexcept -> bool {
+  auto &tokens = stripe(quota, s).tokens;
+  auto t = tokens.load(std::memory_order_relaxed);
+  while (t >= bytes) {
+    if (tokens.compare_exchange_weak(t, t - bytes,
+                                     std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+
+  // Pool dry: reserve this request plus a chunk for the next ones, or
+  // just the request when the limit is close.
+  const auto chunk = chunks_[quota];
+  if (chunk != 0 && reserve(quota, bytes + chunk)) {
+    tokens.fetch_add(chunk, std::memory_order_relaxed);
+    return true;
+  }
+  if (reserve(quota, bytes)) {
+    return true;
+  }
+  // Idle tokens parked on other stripes still count as reserved.
+  pull_back(quota);
+  if (reserve(quota, bytes)) {
+    return true;
+  }
+  shared_[quota].hits.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void TagQuotas::credit(std::size_t quota, std::size_t s,
+                       std::size_t bytes) noexcept {
+  auto &tokens = stripe(quota, s).tokens;
+  const auto chunk = chunks_[quota];
+  auto t = tokens.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  // Keep one chunk for this stripe's next allocations; the rest goes back
+  // where other stripes can reserve it.
+  if (t > 2 * chunk &&
+      tokens.compare_exchange_strong(t, chunk, std::memory_order_relaxed)) {
+    shared_[quota].reserved.fetch_sub(t - chunk, std::memory_order_relaxed);
+  }
+}
+
+auto TagQuotas::stats() const -> std::vector<TagQuotaStats> {
+  std::vector<TagQuotaStats> out;
+  out.reserve(quotas_.size());
+  for (std::size_t i = 0; i < quotas_.size(); ++i) {
+    std::size_t idle = 0;
+    for (std::size_t s = 0; s < kStripes; ++s) {
+      idle += stripes_[i * kStripes + s].tokens.load(std::memory_order_relaxed);
+    }
+    auto reserved = shared_[i].reserved.load(std::memory_order_relaxed);
+    out.push_back(TagQuotaStats{
+        .prefix = quotas_[i].prefix,
+        .limit_bytes = quotas_[i].limit_bytes,
+        .bytes_in_use = reserved > idle ? reserved - idle : 0,
+        .hits = shared_[i].hits.load(std::memory_order_relaxed),
+        .action = quotas_[i].action,
+    });
+  }
+  return out;
+}
+
+} // namespace mmap_viz
@@ -0,0 +1,138 @@
+#pragma once
+/// @file tag_quota.hpp
+/// @brief Byte quotas per allocation tag prefix.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mmap_viz {
+
+/// @brief What an allocation that would exceed its quota does.
+enum class QuotaAction : std::uint8_t {
+  kFail,     ///< Fail, even through resource() with an overflow upstream.
+  kOverflow, ///< Fail in the arena, so resource() overflows upstream.
+};
+
+/// @brief Human-readable quota action.
+[[nodiscard]] constexpr auto to_string(QuotaAction action) -> const char * {
+  switch (action) {
+  case QuotaAction::kFail:
+    return "fail";
+  case QuotaAction::kOverflow:
+    return "overflow";
+  }
+  return "unknown";
+}
+
+/// @brief A byte budget for every allocation whose tag starts with
+///        @p prefix. Block sizes (header and padding included) count.
+struct TagQuota {
+  /// Tag prefix; the longest matching prefix wins. At most kMaxPrefix
+  /// characters, so it fits the tag stored in the block header.
+  std::string prefix;
+  std::size_t limit_bytes = 0;
+  QuotaAction action = QuotaAction::kFail;
+};
+
+/// @brief Usage of one quota.
+struct TagQuotaStats {
+  std::string prefix;
+  std::size_t limit_bytes = 0;
+  std::size_t bytes_in_use = 0; ///< Live bytes charged to the quota.
+  std::uint64_t hits = 0;       ///< Allocations refused so far.
+  QuotaAction action = QuotaAction::kFail;
+};
+
+/// @brief Enforces a fixed set of TagQuota.
+///
+/// Each quota has a shared reservation and kStripes per-stripe token
+/// pools, one cache line each. An allocation takes tokens from its
+/// stripe's pool with one compare-exchange; only when the pool runs dry
+/// does it reserve another chunk (1/64 of the limit per stripe) from the
+/// shared counter, so that line is written about once per chunk rather
+/// than on every call. Frees return tokens to the freeing thread's stripe
+/// and hand surplus back. A request the shared counter cannot cover
+/// first pulls back every stripe's idle tokens, so a quota only refuses
+/// when its live bytes really would exceed the limit.
+class TagQuotas {
+public:
+  static constexpr std::size_t kStripes = 16;
+  /// Longest prefix: the header keeps 31 tag characters.
+  static constexpr std::size_t kMaxPrefix = 31;
+  /// find() result for tags no quota covers.
+  static constexpr std::size_t kNone = SIZE_MAX;
+
+  /// @pre Every prefix is at most kMaxPrefix characters and unique.
+  explicit TagQuotas(std::vector<TagQuota> quotas);
+
+  TagQuotas(const TagQuotas &) = delete;
+  TagQuotas &operator=(const TagQuotas &) = delete;
+
+  /// @brief Whether @p quotas satisfy the constructor's precondition.
+  [[nodiscard]] static auto valid(const std::vector<TagQuota> &quotas)
+      -> bool;
+
+  [[nodiscard]] auto empty() const noexcept -> bool { return quotas_.empty(); }
+
+  /// @brief Index of the quota with the longest prefix of @p tag, or
+  ///        kNone. One hash lookup per distinct prefix length.
+  [[nodiscard]] auto find(std::string_view tag) const noexcept -> std::size_t;
+
+  [[nodiscard]] auto action(std::size_t quota) const noexcept
+      -> QuotaAction {
+    return quotas_[quota].action;
+  }
+
+  /// @brief Charge @p bytes to @p quota from @p stripe's pool.
+  /// @return false, counting a hit, if that would exceed the limit.
+  auto try_charge(std::size_t quota, std::size_t stripe,
+                  std::size_t bytes) noexcept -> bool;
+
+  /// @brief Return @p bytes charged earlier (from any stripe).
+  void credit(std::size_t quota, std::size_t stripe,
+              std::size_t bytes) noexcept;
+
+  [[nodiscard]] auto stats() const -> std::vector<TagQuotaStats>;
+
+private:
+  struct alignas(64) Shared {
+    std::atomic<std::size_t> reserved{0}; ///< Tokens handed to stripes.
+    std::atomic<std::uint64_t> hits{0};
+  };
+  struct alignas(64) Stripe {
+    std::atomic<std::size_t> tokens{0}; ///< Reserved but unused bytes.
+  };
+  struct PrefixHash {
+    using is_transparent = void;
+    auto operator()(std::string_view s) const noexcept -> std::size_t {
+      return std::hash<std::string_view>{}(s);
+    }
+  };
+  using PrefixMap =
+      std::unordered_map<std::string, std::size_t, PrefixHash, std::equal_to<>>;
+
+  /// @brief Add @p bytes to the shared reservation if it stays in limit.
+  auto reserve(std::size_t quota, std::size_t bytes) noexcept -> bool;
+  /// @brief Move every stripe's idle tokens back to the reservation.
+  void pull_back(std::size_t quota) noexcept;
+  auto stripe(std::size_t quota, std::size_t stripe) noexcept -> Stripe & {
+    return stripes_[quota * kStripes + stripe % kStripes];
+  }
+
+  std::vector<TagQuota> quotas_;
+  std::vector<std::size_t> chunks_; ///< Per-quota refill size.
+  std::unique_ptr<Shared[]> shared_;
+  std::unique_ptr<Stripe[]> stripes_;
+  /// (length, prefixes of that length), longest first.
+  std::vector<std::pair<std::size_t, PrefixMap>> by_length_;
+};
+
+} // namespace mmap_viz
@@ -2,12 +2,19 @@
 /// @brief Implementation of the VisualizationArena façade.
 
 #include "interface/visualization_arena.hpp"
+#include "interface/lazy_shards.hpp"
 #include "serialization/json_serializer.hpp"
+#include "serialization/metrics_serializer.hpp"
 #include "server/ws_server.hpp"
 
 #include <nlohmann/json.hpp>
 
+#include <pthread.h>
+
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <thread>
 #include <utility>
@@ -22,12 +29,19 @@ std::atomic<std::size_t> VisualizationArena::global_generation_{1};
 
 static constexpr std::size_t kMaxShards = 256;
 
+/// Reclaim-and-retry rounds alloc_raw() makes before giving up.
+static constexpr int kMaxReclaimRetries = 3;
+
 // ─── Impl Definition ─────────────────────────────────────────────────────
 
 struct VisualizationArena::Impl {
-  Impl(ArenaConfig cfg) : config(cfg) {}
+  Impl(ArenaConfig cfg)
+      : config(cfg), observer(cfg.sampling, cfg.overhead_target_pct),
+        quotas(cfg.tag_quotas), shards(kMaxShards) {}
 
   ArenaConfig config;
+  ObserverMeter observer;
+  TagQuotas quotas;
 
   // Global state
   std::unique_ptr<Arena> arena;
@@ -35,11 +49,157 @@ struct VisualizationArena::Impl {
 
   // Sharding
   struct Shard {
-    alignas(64) std::mutex mutex;
-    std::unique_ptr<FreeListAllocator> allocator;
+    /// Blocks carved per lock acquisition when the small cache runs dry.
+    static constexpr std::size_t kRefillBatch = 16;
+
+    Shard(ShardLockKind kind, std::byte *base, std::size_t size,
+          bool small_block_cache, PressureMonitor &monitor, std::size_t idx)
+        : mutex(kind),
+          allocator(base, size),
+          cache(base, size, small_block_cache), pressure(monitor),
+          index(idx) {}
+
+    alignas(64) ShardLock mutex;
+    FreeListAllocator allocator;
+    SmallBlockCache cache; ///< Lock-free small blocks, outside allocator.
+    PressureMonitor &pressure;
+    std::size_t index; ///< Slot in Impl::shards.
+    /// Range handed to a SubArena: allocator and cache are stale and no
+    /// thread is homed here. Set and cleared under the lock.
+    std::atomic<bool> delegated{false};
+
+    /// @brief Lock the shard for an allocation path, profiling the wait.
+    /// @param remote The calling thread is homed on another shard.
+    auto lock(bool remote = false) -> std::unique_lock<ShardLock> {
+      mutex.lock_profiled(remote);
+      return std::unique_lock(mutex, std::adopt_lock);
+    }
+
+    /// @brief Return every cached small block to the allocator so it can
+    ///        coalesce. The caller holds the lock.
+    void reclaim() {
+      cache.drain([this](std::byte *block, std::size_t block_size) {
+        (void)allocator.deallocate(block, block_size);
+      });
+    }
+
+    /// @brief Report usage to the pressure monitor. The caller holds the
+    ///        lock. Cached small blocks count as in use.
+    void report_usage() noexcept {
+      pressure.on_shard_usage(index, allocator.bytes_allocated());
+    }
+
+    /// @brief Allocate a block for @p total_request bytes, from the small
+    ///        cache when @p block_size fits it, else under the lock.
+    auto allocate(std::size_t total_request, std::size_t alignment,
+                  std::size_t block_size)
+        -> std::expected<AllocationResult, AllocError> {
+      if (alignment <= SmallBlockCache::kQuantum && cache.accepts(block_size)) {
+        // Small block: lock-free unless the cache needs a refill.
+        if (auto *block = cache.pop(block_size)) {
+          return AllocationResult{
+              .ptr = block,
+              .offset = static_cast<std::size_t>(block - allocator.base()),
+              .actual_size = block_size,
+          };
+        }
+        return refill(block_size);
+      }
+      auto guard = lock();
+      auto result = allocator.allocate(total_request, alignment);
+      if (!result.has_value()) {
+        reclaim();
+        result = allocator.allocate(total_request, alignment);
+      }
+      report_usage();
+      return result;
+    }
+
+    /// @brief Return a block: onto the small cache if it fits, else to the
+    ///        allocator under the lock.
+    /// @param remote The calling thread is homed on another shard.
+    void deallocate(std::byte *block, std::size_t block_size, bool remote) {
+      if (cache.accepts(block_size)) {
+        cache.push(block, block_size);
+        return;
+      }
+      auto guard = lock(remote);
+      (void)allocator.deallocate(block, block_size);
+      report_usage();
+    }
+
+    /// @brief Small-cache miss: under one lock acquisition, carve up to
+    ///        kRefillBatch blocks of @p block_size, keep the first and
+    ///        cache the rest.
+    auto refill(std::size_t block_size)
+        -> std::expected<AllocationResult, AllocError> {
+      auto guard = lock();
+      auto first = allocator.allocate(block_size, SmallBlockCache::kQuantum);
+      if (!first.has_value()) {
+        reclaim();
+        first = allocator.allocate(block_size, SmallBlockCache::kQuantum);
+        if (!first.has_value()) {
+          report_usage();
+          return first;
+        }
+      }
+      for (std::size_t i = 1; i < kRefillBatch; ++i) {
+        auto extra =
+            allocator.allocate(block_size, SmallBlockCache::kQuantum);
+        if (!extra.has_value())
+          break;
+        if (extra->actual_size != block_size) {
+          // Absorbed a remainder; it would not fit its class.
+          (void)allocator.deallocate(extra->ptr, extra->actual_size);
+          break;
+        }
+        cache.push(extra->ptr, block_size);
+      }
+      report_usage();
+      return first;
+    }
+
+    /// Cached blocks count as free, not as handed out.
+    [[nodiscard]] auto bytes_allocated() const -> std::size_t {
+      auto allocated = allocator.bytes_allocated();
+      auto cached = cache.cached_bytes();
+      return allocated > cached ? allocated - cached : 0;
+    }
+    [[nodiscard]] auto bytes_free() const -> std::size_t {
+      return allocator.bytes_free() + cache.cached_bytes();
+    }
   };
-  std::vector<std::unique_ptr<Shard>> shards;
+  /// Built on first use; an unbuilt shard is empty and wholly free.
+  LazyShards<Shard> shards;
   std::atomic<std::size_t> next_shard_idx{0};
+  /// Live threads homed on each shard. Shared with each ThreadContext, so a
+  /// thread that outlives the arena can still drop its count.
+  std::shared_ptr<std::atomic<std::size_t>[]> homes{
+      new std::atomic<std::size_t>[kMaxShards]()};
+
+  [[nodiscard]] auto shard_size() const noexcept -> std::size_t {
+    return arena->capacity() / kMaxShards;
+  }
+  /// @brief Shard @p i, built on first use.
+  auto shard(std::size_t i) -> Shard &;
+
+  // Sub-arenas, by offset. The mutex also serializes carving and release.
+  mutable std::mutex sub_arenas_mutex;
+  std::vector<SubArena *> sub_arenas;
+
+  /// @brief Bytes allocated and free over the parent's own shards plus
+  ///        every sub-arena.
+  auto usage() const -> std::pair<std::size_t, std::size_t>;
+
+  // Memory pressure: watermark callbacks, and the OOM reclaim hook.
+  std::unique_ptr<PressureMonitor> pressure;
+  std::mutex reclaim_mutex;
+  std::shared_ptr<ReclaimHandler> reclaim_handler;
+  std::atomic<std::uint64_t> reclaim_calls{0};
+
+  /// @brief Run the reclaim handler for a failed @p bytes allocation.
+  /// @return Whether it freed memory, so a retry may succeed.
+  auto try_reclaim(std::size_t bytes) -> bool;
 
   // Server & Aggregation
   struct Batcher {
@@ -56,12 +216,20 @@ struct VisualizationArena::Impl {
   // PMR Resource
   std::unique_ptr<TrackedResource> resource;
 
+  // Overflow upstream accounting (see record_overflow_alloc)
+  std::atomic<std::uint64_t> overflow_allocations{0};
+  std::atomic<std::uint64_t> overflow_deallocations{0};
+  std::atomic<std::size_t> overflow_bytes{0};
+  std::atomic<std::size_t> overflow_peak{0};
+
   // Control
   std::atomic<bool> running{true};
   std::size_t generation = 0;
 
   // Methods moved to Impl to simplify callbacks
   auto snapshot_json() const -> std::string;
+  auto shard_lock_profiles() const -> std::vector<ShardLockProfile>;
+  auto metrics_text() const -> std::string;
   auto event_log_json() const -> std::string;
 };
 
@@ -70,7 +238,16 @@ struct VisualizationArena::Impl {
 struct VisualizationArena::ThreadContext {
   std::size_t generation = 0;
   Impl::Shard *shard = nullptr;
+  std::size_t shard_idx = 0; ///< Slot of `shard` in Impl::shards.
   std::unique_ptr<LocalTracker> tracker;
+  std::uint32_t probe_tick = 0; ///< ObserverMeter::Probe sampling counter.
+  /// Impl::homes, counting this thread on `shard_idx` while it lives.
+  std::shared_ptr<std::atomic<std::size_t>[]> homes;
+
+  ~ThreadContext() {
+    if (homes)
+      homes[shard_idx].fetch_sub(1);
+  }
 };
 
 thread_local std::shared_ptr<VisualizationArena::ThreadContext>
@@ -78,81 +255,262 @@ thread_local std::shared_ptr<VisualizationArena::ThreadContext>
 
 // ─── Impl Methods ────────────────────────────────────────────────────────
 
+/// @brief Append the live blocks of @p alloc to @p blocks, with offsets
+///        from @p arena_base. The caller holds the allocator's lock.
+/// @param start Offset of the first header: past the part of a block that
+///        reaches in from the range below.
+/// @param overhang_limit How far a live block may run past the end, into
+///        the next range of a sub-arena; 0 for a parent shard.
+/// @return How far the last live block runs past the end, i.e. where the
+///         walk of the next range starts.
+static auto collect_live_blocks(const FreeListAllocator &alloc,
+                                const std::byte *arena_base,
+                                std::vector<BlockMetadata> &blocks,
+                                std::size_t start = 0,
+                                std::size_t overhang_limit = 0)
+    -> std::size_t {
+  // Walk heap
+  auto *base = alloc.base();
+  std::size_t cap = alloc.capacity();
+  std::size_t offset = start;
+  std::size_t overhang = 0;
+
+  while (offset + sizeof(AllocationHeader) <= cap) {
+    auto *ptr = base + offset;
+    auto *header = reinterpret_cast<AllocationHeader *>(ptr);
+    std::size_t block_size = 0;
+    bool is_allocated = false;
+
+    if (header->magic == AllocationHeader::kMagicValue) {
+      block_size = header->actual_size;
+      is_allocated = true;
+    } else {
+      struct GenericHeader {
+        std::size_t size;
+      };
+      auto *generic = reinterpret_cast<GenericHeader *>(ptr);
+      block_size = generic->size;
+    }
+
+    if (block_size == 0 || offset + block_size > cap + overhang_limit ||
+        (!is_allocated && offset + block_size > cap)) {
+      break;
+    }
+
+    if (is_allocated) {
+      BlockMetadata meta;
+      meta.offset = static_cast<std::size_t>(ptr - arena_base);
+      meta.actual_size = block_size;
+      meta.size = header->size;
+
+      char safe_tag[33] = {};
+      std::memcpy(safe_tag, header->tag, sizeof(header->tag));
+      safe_tag[32] = '\0';
+
+      // Sanitize tag for JSON
+      for (int i = 0; i < 32 && safe_tag[i] != '\0'; ++i) {
+        if (static_cast<unsigned char>(safe_tag[i]) < 32 ||
+            static_cast<unsigned char>(safe_tag[i]) > 126) {
+          safe_tag[i] = '?';
+        }
+      }
+
+      meta.set_tag(safe_tag);
+
+      blocks.push_back(meta);
+    }
+    offset += block_size;
+  }
+  if (offset > cap) {
+    overhang = offset - cap; // Straddles the edge into the next range.
+  }
+  return overhang;
+}
+
 auto VisualizationArena::Impl::snapshot_json() const -> std::string {
   std::vector<BlockMetadata> blocks;
   std::size_t total_allocated = 0;
   std::size_t total_free = 0;
   std::size_t free_blocks = 0;
 
-  for (const auto &shard : shards) {
-    if (!shard)
+  for (std::size_t i = 0; i < shards.size(); ++i) {
+    auto *shard = shards.find(i);
+    if (!shard) {
+      total_free += shard_size();
+      ++free_blocks;
       continue;
+    }
     std::lock_guard lock(shard->mutex);
-    auto *alloc = shard->allocator.get();
-
-    total_allocated += alloc->bytes_allocated();
-    total_free += alloc->bytes_free();
-    free_blocks += alloc->free_block_count();
-
-    // Walk heap
-    auto *base = alloc->base();
-    std::size_t cap = alloc->capacity();
-    std::size_t offset = 0;
-
-    while (offset + sizeof(AllocationHeader) <= cap) {
-      auto *ptr = base + offset;
-      auto *header = reinterpret_cast<AllocationHeader *>(ptr);
-      std::size_t block_size = 0;
-      bool is_allocated = false;
-
-      if (header->magic == AllocationHeader::kMagicValue) {
-        block_size = header->size;
-        is_allocated = true;
-      } else {
-        struct GenericHeader {
-          std::size_t size;
-        };
-        auto *generic = reinterpret_cast<GenericHeader *>(ptr);
-        block_size = generic->size;
-      }
+    if (shard->delegated.load(std::memory_order_relaxed))
+      continue;
 
-      if (block_size == 0 || block_size > cap || offset + block_size > cap) {
-        break;
-      }
+    total_allocated += shard->bytes_allocated();
+    total_free += shard->bytes_free();
+    free_blocks += shard->allocator.free_block_count();
+    collect_live_blocks(shard->allocator, arena->base(), blocks);
+  }
 
-      if (is_allocated) {
-        BlockMetadata meta;
-        meta.offset = static_cast<std::size_t>(ptr - arena->base());
-        meta.actual_size = block_size;
-        meta.size = block_size > sizeof(AllocationHeader)
-                        ? block_size - sizeof(AllocationHeader)
-                        : 0;
-
-        char safe_tag[33] = {};
-        std::memcpy(safe_tag, header->tag, sizeof(header->tag));
-        safe_tag[32] = '\0';
-
-        // Sanitize tag for JSON
-        for (int i = 0; i < 32 && safe_tag[i] != '\0'; ++i) {
-          if (static_cast<unsigned char>(safe_tag[i]) < 32 ||
-              static_cast<unsigned char>(safe_tag[i]) > 126) {
-            safe_tag[i] = '?';
-          }
+  // Sub-arena blocks sit in the parent's address range; their usage is
+  // rolled up into the totals.
+  std::vector<SubArenaStats> subs;
+  {
+    std::lock_guard lock(sub_arenas_mutex);
+    for (const auto *sub : sub_arenas) {
+      subs.push_back(sub->stats()); // Takes each range lock itself.
+
+      // One walk over all ranges: a block across an edge is listed once,
+      // and the next range is walked from its end. Each range stays
+      // locked until the next one is, so such a block cannot be freed
+      // between the two.
+      std::unique_lock<ShardLock> held;
+      std::size_t overhang = 0;
+      const auto n = sub->ranges_.size();
+      for (std::size_t i = 0; i < n; ++i) {
+        const auto *range = sub->ranges_.find(i);
+        if (range == nullptr) {
+          held = {};
+          overhang = 0;
+          total_free += sub->range_capacity(i);
+          ++free_blocks;
+          continue;
         }
-
-        meta.set_tag(safe_tag);
-
-        blocks.push_back(meta);
+        std::unique_lock range_lock(range->mutex);
+        held = std::move(range_lock);
+        total_allocated += range->allocator.bytes_allocated();
+        total_free += range->allocator.bytes_free();
+        free_blocks += range->allocator.free_block_count();
+        overhang = collect_live_blocks(
+            range->allocator, arena->base(), blocks, overhang,
+            i + 1 < n ? sub->range_capacity(i + 1) : 0);
       }
-      offset += block_size;
     }
   }
 
   auto j = snapshot_to_json(blocks, total_allocated, total_free,
                             arena->capacity(), 0, free_blocks);
+  j["sub_arenas"] = sub_arenas_to_json(subs)["sub_arenas"];
+  if constexpr (FreeListAllocator::kStatsEnabled) {
+    // Totals plus the shards that have seen traffic, keyed by index.
+    FreeListStats total;
+    nlohmann::json per_shard = nlohmann::json::object();
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+      auto *shard = shards.find(i);
+      if (!shard)
+        continue;
+      FreeListStats s;
+      {
+        std::lock_guard lock(shard->mutex);
+        if (shard->delegated.load(std::memory_order_relaxed))
+          continue;
+        s = shard->allocator.stats();
+      }
+      if (s.allocations + s.deallocations == 0)
+        continue;
+      total += s;
+      per_shard[std::to_string(i)] = s;
+    }
+    j["allocator_stats"] = {{"total", total}, {"shards", per_shard}};
+  }
+  j["overflow"] = {
+      {"allocations", overflow_allocations.load(std::memory_order_relaxed)},
+      {"deallocations",
+       overflow_deallocations.load(std::memory_order_relaxed)},
+      {"bytes_in_use", overflow_bytes.load(std::memory_order_relaxed)},
+      {"peak_bytes", overflow_peak.load(std::memory_order_relaxed)},
+  };
   return j.dump();
 }
 
+auto VisualizationArena::Impl::shard_lock_profiles() const
+    -> std::vector<ShardLockProfile> {
+  std::vector<ShardLockProfile> profiles(shards.size());
+  for (std::size_t i = 0; i < shards.size(); ++i) {
+    if (const auto *s = shards.find(i))
+      profiles[i] = s->mutex.profile();
+  }
+  return profiles;
+}
+
+auto VisualizationArena::Impl::shard(std::size_t i) -> Shard & {
+  return shards.get(i, [&] {
+    return Shard(config.shard_lock, arena->base() + (i * shard_size()),
+                 shard_size(), config.small_block_cache, *pressure, i);
+  });
+}
+
+auto VisualizationArena::Impl::usage() const
+    -> std::pair<std::size_t, std::size_t> {
+  std::size_t allocated = 0;
+  std::size_t free = 0;
+  for (std::size_t i = 0; i < shards.size(); ++i) {
+    const auto *s = shards.find(i);
+    if (!s) {
+      free += shard_size();
+    } else if (!s->delegated.load(std::memory_order_relaxed)) {
+      allocated += s->bytes_allocated();
+      free += s->bytes_free();
+    }
+  }
+  std::lock_guard lock(sub_arenas_mutex);
+  for (const auto *sub : sub_arenas) {
+    allocated += sub->bytes_allocated();
+    free += sub->bytes_free();
+  }
+  return {allocated, free};
+}
+
+auto VisualizationArena::Impl::metrics_text() const -> std::string {
+  auto [allocated, free] = usage();
+
+  MetricsWriter w;
+  w.family("mmap_viz_arena_capacity_bytes", "gauge", "Arena capacity.");
+  w.sample("mmap_viz_arena_capacity_bytes", "",
+           static_cast<double>(arena->capacity()));
+  w.family("mmap_viz_arena_allocated_bytes", "gauge",
+           "Bytes handed out by the shard allocators.");
+  w.sample("mmap_viz_arena_allocated_bytes", "",
+           static_cast<double>(allocated));
+  w.family("mmap_viz_arena_free_bytes", "gauge",
+           "Bytes free in the shard allocators.");
+  w.sample("mmap_viz_arena_free_bytes", "", static_cast<double>(free));
+  w.family("mmap_viz_overflow_bytes", "gauge",
+           "Live bytes served by the overflow upstream.");
+  w.sample("mmap_viz_overflow_bytes", "",
+           static_cast<double>(overflow_bytes.load(std::memory_order_relaxed)));
+  write_shard_lock_metrics(w, shard_lock_profiles());
+  write_observer_metrics(w, observer.latest());
+  write_quota_metrics(w, quotas.stats());
+  std::vector<SubArenaStats> subs;
+  {
+    std::lock_guard lock(sub_arenas_mutex);
+    for (const auto *sub : sub_arenas)
+      subs.push_back(sub->stats());
+  }
+  write_sub_arena_metrics(w, subs);
+  return w.str();
+}
+
+auto VisualizationArena::Impl::try_reclaim(std::size_t bytes) -> bool {
+  // A handler that allocates may run out too; it gets no second chance.
+  thread_local bool in_handler = false;
+  if (in_handler)
+    return false;
+
+  std::shared_ptr<ReclaimHandler> handler;
+  {
+    std::lock_guard lock(reclaim_mutex);
+    handler = reclaim_handler;
+  }
+  if (!handler)
+    return false;
+
+  reclaim_calls.fetch_add(1, std::memory_order_relaxed);
+  in_handler = true;
+  bool freed = (*handler)(bytes);
+  in_handler = false;
+  return freed;
+}
+
 auto VisualizationArena::Impl::event_log_json() const -> std::string {
   // Lock contexts to prevent batcher thread from draining concurrently
   std::lock_guard lock(const_cast<std::mutex &>(contexts_mutex));
@@ -185,6 +543,9 @@ auto VisualizationArena::Impl::event_log_json() const -> std::string {
 
 auto VisualizationArena::create(ArenaConfig cfg)
     -> std::expected<VisualizationArena, std::error_code> {
+  if (!TagQuotas::valid(cfg.tag_quotas)) {
+    return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
 
   // Ensure total capacity is a multiple of 16 * kMaxShards for shard alignment
   std::size_t alignment_quantum = 16 * kMaxShards;
@@ -200,7 +561,6 @@ auto VisualizationArena::create(ArenaConfig cfg)
   // 2. Initialize Impl
   auto impl = std::make_unique<Impl>(cfg);
   impl->arena = std::make_unique<Arena>(std::move(*arena_result));
-  impl->shards.resize(kMaxShards);
 
   // 3. Resolve cache-line size.
   auto line_sz = (cfg.cache_line_size == 0) ? CacheAnalyzer::detect_line_size()
@@ -210,18 +570,11 @@ auto VisualizationArena::create(ArenaConfig cfg)
   // 4. Build server and batcher
   impl->batcher = std::make_shared<Impl::Batcher>();
 
-  // Initialize all shards upfront to avoid races and O(1) allocation path
-  std::byte *base = impl->arena->base();
-  std::size_t total_cap = impl->arena->capacity();
-  std::size_t shard_size = total_cap / kMaxShards;
-
-  for (std::size_t i = 0; i < kMaxShards; ++i) {
-    auto shard = std::make_unique<Impl::Shard>();
-    std::byte *shard_base = base + (i * shard_size);
-    shard->allocator =
-        std::make_unique<FreeListAllocator>(shard_base, shard_size);
-    impl->shards[i] = std::move(shard);
-  }
+  // Shards are built by the first thread homed on (or carving) each, so
+  // creation touches none of the arena's pages.
+  impl->pressure = std::make_unique<PressureMonitor>(
+      impl->arena->capacity(), kMaxShards, impl->shard_size(),
+      cfg.on_thread_start);
 
   if (cfg.enable_server) {
     impl->server = std::make_unique<WsServer>(cfg.port, cfg.web_root, nullptr);
@@ -231,6 +584,10 @@ auto VisualizationArena::create(ArenaConfig cfg)
         [raw_impl = impl.get()]() -> std::string {
           return raw_impl->snapshot_json();
         });
+    impl->server->set_metrics_provider(
+        [raw_impl = impl.get()]() -> std::string {
+          return raw_impl->metrics_text();
+        });
   }
 
   // 5. Build PMR resource (needs facade for set_arena later, but construction
@@ -253,7 +610,8 @@ auto VisualizationArena::create(ArenaConfig cfg)
   va.impl_ = std::move(impl);
 
   // Now we can initialize Resource with 'va'
-  va.impl_->resource = std::make_unique<TrackedResource>(va);
+  va.impl_->resource =
+      std::make_unique<TrackedResource>(va, cfg.overflow_upstream);
 
   // 6. Start threads if enabled
   if (cfg.enable_server) {
@@ -261,15 +619,55 @@ auto VisualizationArena::create(ArenaConfig cfg)
 
     // Server thread
     va.server_thread_ = std::thread([raw_impl]() {
+      if (raw_impl->config.on_thread_start)
+        raw_impl->config.on_thread_start();
       if (raw_impl->server)
         raw_impl->server->run();
     });
 
+    // The batcher meters the server thread through its CPU clock.
+    clockid_t server_clock = static_cast<clockid_t>(-1);
+    if (pthread_getcpuclockid(va.server_thread_.native_handle(),
+                              &server_clock) != 0) {
+      server_clock = static_cast<clockid_t>(-1);
+    }
+
     // Batcher thread
-    va.batcher_thread_ = std::thread([raw_impl]() {
+    va.batcher_thread_ = std::thread([raw_impl, server_clock]() {
+      if (raw_impl->config.on_thread_start)
+        raw_impl->config.on_thread_start();
+      // Shard lock profiles and the observer overhead go out about once a
+      // second of wall time, however long draining takes under load; the
+      // overhead window is the time between reports.
+      constexpr auto kReportInterval = std::chrono::seconds(1);
+      auto last_report = std::chrono::steady_clock::now();
+      bool had_sub_arenas = false;
+      raw_impl->observer.update(ObserverClocks::read(server_clock));
       while (raw_impl->running) {
         std::this_thread::sleep_for(std::chrono::milliseconds(16));
 
+        auto now = std::chrono::steady_clock::now();
+        if (raw_impl->server && now - last_report >= kReportInterval) {
+          last_report = now;
+          raw_impl->server->broadcast(
+              shard_locks_to_json(raw_impl->shard_lock_profiles()).dump());
+          auto overhead =
+              raw_impl->observer.update(ObserverClocks::read(server_clock));
+          raw_impl->server->broadcast(observer_to_json(overhead).dump());
+
+          // Sub-arena totals, plus one empty list after the last release
+          // so the UI drops it.
+          std::vector<SubArenaStats> subs;
+          {
+            std::lock_guard lock(raw_impl->sub_arenas_mutex);
+            for (const auto *sub : raw_impl->sub_arenas)
+              subs.push_back(sub->stats());
+          }
+          if (!subs.empty() || had_sub_arenas)
+            raw_impl->server->broadcast(sub_arenas_to_json(subs).dump());
+          had_sub_arenas = !subs.empty();
+        }
+
         // 1. Drain all TLS buffers into batcher
         {
           std::lock_guard lock(raw_impl->contexts_mutex);
@@ -313,12 +711,15 @@ auto VisualizationArena::create(ArenaConfig cfg)
   return va;
 }
 
-VisualizationArena::~VisualizationArena() {
+VisualizationArena::~VisualizationArena() { stop(); }
+
+void VisualizationArena::stop() {
   if (impl_) {
     impl_->running = false;
     if (impl_->server) {
       impl_->server->stop();
     }
+    impl_->pressure->stop();
   }
   if (batcher_thread_.joinable()) {
     batcher_thread_.join();
@@ -335,16 +736,7 @@ VisualizationArena::VisualizationArena(VisualizationArena &&other) noexcept {
 VisualizationArena &
 VisualizationArena::operator=(VisualizationArena &&other) noexcept {
   if (this != &other) {
-    // Stop current threads
-    if (impl_) {
-      impl_->running = false;
-      if (impl_->server)
-        impl_->server->stop();
-    }
-    if (batcher_thread_.joinable())
-      batcher_thread_.join();
-    if (server_thread_.joinable())
-      server_thread_.join();
+    stop();
 
     // Move state
     impl_ = std::move(other.impl_);
@@ -368,17 +760,26 @@ void VisualizationArena::init_tls_context() {
     idx = idx % kMaxShards;
   }
 
-  if (!impl_->shards[idx]) {
-    return; // Should not happen with upfront init
+  // Skip shards delegated to a sub-arena. Shard 0 never is, so this ends.
+  // Pairs with the re-check in create_sub_arena(): either that sees this
+  // thread's home or this sees the flag.
+  auto &homes = impl_->homes;
+  homes[idx].fetch_add(1);
+  while (impl_->shard(idx).delegated.load()) {
+    homes[idx].fetch_sub(1);
+    idx = impl_->next_shard_idx.fetch_add(1) % kMaxShards;
+    homes[idx].fetch_add(1);
   }
 
-  // Create new context
+  // Create new context; dropping the old one unhomes it.
   tls_context_ = std::make_shared<ThreadContext>();
   tls_context_->generation = impl_->generation;
-  tls_context_->shard = impl_->shards[idx].get();
+  tls_context_->shard = &impl_->shard(idx);
+  tls_context_->shard_idx = idx;
+  tls_context_->homes = homes;
 
   tls_context_->tracker = std::make_unique<LocalTracker>(
-      *tls_context_->shard->allocator, impl_->config.sampling);
+      tls_context_->shard->allocator, impl_->observer.sampling());
 
   {
     std::lock_guard lock(impl_->contexts_mutex);
@@ -402,49 +803,68 @@ auto VisualizationArena::get_shard_idx(void *ptr) const -> std::size_t {
 
 auto VisualizationArena::alloc_raw(std::size_t size, std::size_t alignment,
                                    std::string_view tag) -> void * {
+  return try_alloc_raw(size, alignment, tag).value_or(nullptr);
+}
+
+auto VisualizationArena::try_alloc_raw(std::size_t size,
+                                       std::size_t alignment,
+                                       std::string_view tag)
+    -> std::expected<void *, AllocFailure> {
   if (!tls_context_ || tls_context_->generation != impl_->generation) {
     init_tls_context();
   }
   if (!tls_context_)
-    return nullptr;
-
-  auto *allocator = tls_context_->shard->allocator.get();
+    return std::unexpected(AllocFailure::kOutOfMemory);
 
-  std::size_t header_size = sizeof(AllocationHeader);
-  std::size_t footer_size = sizeof(std::uint32_t);
-  std::size_t base_overhead = header_size + footer_size;
-  std::size_t padding = 0;
+  auto *shard = tls_context_->shard;
 
-  if (alignment > 0) {
-    std::size_t remainder = base_overhead % alignment;
-    if (remainder != 0) {
-      padding = alignment - remainder;
+  std::size_t offset_to_user = user_offset(alignment);
+  std::size_t total_request = size + offset_to_user;
+  std::size_t block_size = FreeListAllocator::block_size(total_request);
+
+  // Charge the tag's quota up front, keyed like the free path: the header
+  // keeps the first TagQuotas::kMaxPrefix characters of the tag.
+  auto quota = TagQuotas::kNone;
+  if (!impl_->quotas.empty()) {
+    quota = impl_->quotas.find(tag);
+    if (quota != TagQuotas::kNone &&
+        !impl_->quotas.try_charge(quota, tls_context_->shard_idx,
+                                  block_size)) {
+      BlockMetadata meta{
+          .size = size,
+          .alignment = alignment,
+          .actual_size = block_size,
+          .timestamp = std::chrono::system_clock::now(),
+      };
+      meta.set_tag(tag);
+      tls_context_->tracker->record_quota_exceeded(std::move(meta));
+      return std::unexpected(
+          impl_->quotas.action(quota) == QuotaAction::kFail
+              ? AllocFailure::kQuotaExceeded
+              : AllocFailure::kQuotaOverflow);
     }
   }
 
-  std::size_t offset_to_user = base_overhead + padding;
-  std::size_t total_request = size + offset_to_user;
-
-  std::lock_guard lock(tls_context_->shard->mutex);
-  auto result = allocator->allocate(total_request, alignment);
+  auto result = shard->allocate(total_request, alignment, block_size);
+  // Out of memory: let the owner shed memory, then retry.
+  for (int attempt = 0; !result.has_value() && attempt < kMaxReclaimRetries &&
+                        impl_->try_reclaim(size);
+       ++attempt) {
+    result = shard->allocate(total_request, alignment, block_size);
+  }
 
   if (!result.has_value()) {
-    return nullptr;
+    if (quota != TagQuotas::kNone) {
+      impl_->quotas.credit(quota, tls_context_->shard_idx, block_size);
+    }
+    return std::unexpected(AllocFailure::kOutOfMemory);
   }
 
   std::byte *raw_ptr = result->ptr;
   if (raw_ptr) {
     auto actual_shard_idx = get_shard_idx(raw_ptr);
-    // Find matching shard
-    std::size_t expected_shard_idx = kMaxShards;
-    for (std::size_t i = 0; i < kMaxShards; ++i) {
-      if (impl_->shards[i].get() == tls_context_->shard) {
-        expected_shard_idx = i;
-        break;
-      }
-    }
-    if (expected_shard_idx != kMaxShards &&
-        actual_shard_idx != expected_shard_idx) {
+    std::size_t expected_shard_idx = tls_context_->shard_idx;
+    if (actual_shard_idx != expected_shard_idx) {
       std::fprintf(
           stderr,
           "FATAL: Shard Mismatch! requested=%zu, received=%zu, ptr=%p\n",
@@ -472,30 +892,30 @@ auto VisualizationArena::alloc_raw(std::size_t size, std::size_t alignment,
   // Initialize user memory
   std::memset(user_ptr, 0, size);
 
+  ObserverMeter::Probe probe(impl_->observer, tls_context_->probe_tick);
+  auto &tracker = *tls_context_->tracker;
+  if (!tracker.next_sampled()) {
+    tracker.skip();
+    return user_ptr;
+  }
   BlockMetadata meta{
-      .offset = result->offset,
+      .offset = static_cast<std::size_t>(raw_ptr - impl_->arena->base()),
       .size = size,
       .alignment = alignment,
       .actual_size = result->actual_size,
       .timestamp = std::chrono::system_clock::now(),
   };
   meta.set_tag(tag);
-  tls_context_->tracker->record_alloc(std::move(meta));
+  tracker.record_alloc(std::move(meta));
 
   return user_ptr;
 }
 
-void VisualizationArena::dealloc_raw(void *ptr, std::size_t size) {
+void VisualizationArena::dealloc_raw(void *ptr, std::size_t /*size*/) {
   if (ptr == nullptr)
     return;
 
-  // AllocationHeader is at the start of the block.
-  // We need to find it. How? VisualizationArena assumes alignment and overhead.
-  // Actually, VisualizationArena KNOWS how it allocated.
-  // Base overhead is header + footer (offset).
-  std::size_t base_overhead = sizeof(AllocationHeader) + sizeof(std::uint32_t);
-
-  // Actually, we can just use the footer to find the start of the block!
+  // The footer holds the distance back to the header at the block start.
   std::byte *user_ptr = static_cast<std::byte *>(ptr);
   std::uint32_t offset_val =
       *reinterpret_cast<std::uint32_t *>(user_ptr - sizeof(std::uint32_t));
@@ -508,28 +928,80 @@ void VisualizationArena::dealloc_raw(void *ptr, std::size_t size) {
 
   header->magic = 0; // Invalidate to prevent double free
 
-  std::size_t actual_size = header->actual_size;
+  free_block(raw_ptr, header->actual_size);
+}
 
+void VisualizationArena::dealloc_raw(void *ptr, std::size_t size,
+                                     std::size_t alignment) {
+  if (ptr == nullptr)
+    return;
+
+  // alloc_raw() placed the user pointer user_offset() bytes into a block of
+  // FreeListAllocator::block_size() bytes; both follow from the arguments.
+  std::size_t offset_to_user = user_offset(alignment);
+  std::byte *raw_ptr = static_cast<std::byte *>(ptr) - offset_to_user;
+  std::size_t actual_size =
+      FreeListAllocator::block_size(size + offset_to_user);
+  auto *header = reinterpret_cast<AllocationHeader *>(raw_ptr);
+
+#ifndef NDEBUG
+  if (header->magic != AllocationHeader::kMagicValue ||
+      header->actual_size != actual_size) {
+    std::fprintf(stderr,
+                 "FATAL: sized dealloc_raw(%p, %zu, %zu) does not match a "
+                 "live alloc_raw() block\n",
+                 ptr, size, alignment);
+    std::abort();
+  }
+#endif
+
+  // Still cleared: snapshots walk headers to find live blocks, and a block
+  // parked on a small free list keeps its old header bytes.
+  header->magic = 0;
+
+  free_block(raw_ptr, actual_size);
+}
+
+void VisualizationArena::free_block(std::byte *raw_ptr,
+                                    std::size_t actual_size) {
   if (tls_context_) {
-    auto offset = static_cast<std::size_t>(raw_ptr - impl_->arena->base());
-    tls_context_->tracker->record_dealloc(offset, actual_size);
+    ObserverMeter::Probe probe(impl_->observer, tls_context_->probe_tick);
+    auto &tracker = *tls_context_->tracker;
+    if (tracker.next_sampled()) {
+      auto offset = static_cast<std::size_t>(raw_ptr - impl_->arena->base());
+      tracker.record_dealloc(offset, actual_size);
+    } else {
+      tracker.skip();
+    }
+  }
+
+  // Refund the tag's quota; the tag is still in the header.
+  if (!impl_->quotas.empty()) {
+    const auto *header = reinterpret_cast<const AllocationHeader *>(raw_ptr);
+    auto quota = impl_->quotas.find(
+        {header->tag, strnlen(header->tag, sizeof(header->tag))});
+    if (quota != TagQuotas::kNone) {
+      impl_->quotas.credit(quota, tls_context_ ? tls_context_->shard_idx : 0,
+                           actual_size);
+    }
   }
 
   std::size_t idx = get_shard_idx(raw_ptr);
-  if (idx >= kMaxShards || !impl_->shards[idx]) {
+  auto *shard = idx < kMaxShards ? impl_->shards.find(idx) : nullptr;
+  if (!shard) {
     return;
   }
 
-  auto *shard = impl_->shards[idx].get();
   // Double check shard ownership to prevent tree contamination
-  if (!shard->allocator->contains(raw_ptr)) {
+  if (!shard->allocator.contains(raw_ptr)) {
     std::fprintf(stderr,
                  "WARNING: Shard hint %zu wrong for ptr %p. Searching...\n",
                  idx, (void *)raw_ptr);
     shard = nullptr;
     for (std::size_t i = 0; i < kMaxShards; ++i) {
-      if (impl_->shards[i] && impl_->shards[i]->allocator->contains(raw_ptr)) {
-        shard = impl_->shards[i].get();
+      auto *s = impl_->shards.find(i);
+      if (s && s->allocator.contains(raw_ptr)) {
+        shard = s;
         idx = i;
         break;
       }
@@ -540,9 +1012,20 @@ void VisualizationArena::dealloc_raw(void *ptr, std::size_t size) {
     std::fprintf(stderr, "FATAL: No shard owns pointer %p\n", (void *)raw_ptr);
     std::abort();
   }
+  if (shard->delegated.load(std::memory_order_relaxed)) {
+    std::fprintf(stderr,
+                 "FATAL: %p belongs to a sub-arena; free it through that "
+                 "SubArena\n",
+                 (void *)raw_ptr);
+    std::abort();
+  }
 
-  std::lock_guard lock(shard->mutex);
-  (void)shard->allocator->deallocate(raw_ptr, actual_size);
+  // A free on another thread's shard is the cross-thread case that can
+  // convoy behind that thread's allocations.
+  bool remote = !tls_context_ ||
+                tls_context_->generation != impl_->generation ||
+                tls_context_->shard_idx != idx;
+  shard->deallocate(raw_ptr, actual_size, remote);
 }
 
 // ─── PMR interop ─────────────────────────────────────────────────────────
@@ -551,6 +1034,121 @@ auto VisualizationArena::resource() noexcept -> std::pmr::memory_resource * {
   return impl_ ? impl_->resource.get() : nullptr;
 }
 
+// ─── Sub-allocator reporting ─────────────────────────────────────────────
+
+void VisualizationArena::record_suballoc(void *ptr, std::size_t size,
+                                         std::size_t alignment,
+                                         std::string_view tag) {
+  if (!tls_context_ || tls_context_->generation != impl_->generation) {
+    init_tls_context();
+  }
+  if (!tls_context_)
+    return;
+
+  BlockMetadata meta{
+      .offset = static_cast<std::size_t>(static_cast<std::byte *>(ptr) -
+                                         impl_->arena->base()),
+      .size = size,
+      .alignment = alignment,
+      .actual_size = size,
+      .timestamp = std::chrono::system_clock::now(),
+  };
+  meta.set_tag(tag);
+  tls_context_->tracker->record_alloc(std::move(meta));
+}
+
+void VisualizationArena::record_subfree(void *ptr, std::size_t size) {
+  if (!tls_context_ || tls_context_->generation != impl_->generation) {
+    init_tls_context();
+  }
+  if (!tls_context_)
+    return;
+
+  auto offset = static_cast<std::size_t>(static_cast<std::byte *>(ptr) -
+                                         impl_->arena->base());
+  tls_context_->tracker->record_dealloc(offset, size);
+}
+
+void VisualizationArena::record_occupancy(void *ptr, std::size_t used_bytes) {
+  if (!tls_context_ || tls_context_->generation != impl_->generation) {
+    init_tls_context();
+  }
+  if (!tls_context_ || ptr == nullptr)
+    return;
+
+  // Same footer walk as dealloc_raw().
+  auto *user_ptr = static_cast<std::byte *>(ptr);
+  std::uint32_t offset_val =
+      *reinterpret_cast<std::uint32_t *>(user_ptr - sizeof(std::uint32_t));
+  std::byte *raw_ptr = user_ptr - offset_val;
+  auto *header = reinterpret_cast<AllocationHeader *>(raw_ptr);
+  if (header->magic != AllocationHeader::kMagicValue) {
+    return;
+  }
+
+  BlockMetadata meta{
+      .offset = static_cast<std::size_t>(raw_ptr - impl_->arena->base()),
+      .size = used_bytes,
+      .alignment = 0,
+      .actual_size = header->actual_size,
+      .timestamp = std::chrono::system_clock::now(),
+  };
+  meta.set_tag(std::string_view{header->tag,
+                                strnlen(header->tag, sizeof(header->tag))});
+  tls_context_->tracker->record_occupancy(std::move(meta));
+}
+
+// ─── Overflow reporting ──────────────────────────────────────────────────
+
+void VisualizationArena::record_overflow_alloc(void *ptr, std::size_t size,
+                                               std::size_t alignment,
+                                               std::string_view tag) {
+  impl_->overflow_allocations.fetch_add(1, std::memory_order_relaxed);
+  const auto bytes =
+      impl_->overflow_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+  auto peak = impl_->overflow_peak.load(std::memory_order_relaxed);
+  while (bytes > peak && !impl_->overflow_peak.compare_exchange_weak(
+                             peak, bytes, std::memory_order_relaxed)) {
+  }
+
+  if (!tls_context_ || tls_context_->generation != impl_->generation) {
+    init_tls_context();
+  }
+  if (!tls_context_)
+    return;
+
+  BlockMetadata meta{
+      .offset = reinterpret_cast<std::uintptr_t>(ptr),
+      .size = size,
+      .alignment = alignment,
+      .actual_size = size,
+      .timestamp = std::chrono::system_clock::now(),
+  };
+  meta.set_tag(tag);
+  tls_context_->tracker->record_overflow(EventType::OverflowAllocate,
+                                         std::move(meta));
+}
+
+void VisualizationArena::record_overflow_free(void *ptr, std::size_t size) {
+  impl_->overflow_deallocations.fetch_add(1, std::memory_order_relaxed);
+  impl_->overflow_bytes.fetch_sub(size, std::memory_order_relaxed);
+
+  if (!tls_context_ || tls_context_->generation != impl_->generation) {
+    init_tls_context();
+  }
+  if (!tls_context_)
+    return;
+
+  BlockMetadata meta{
+      .offset = reinterpret_cast<std::uintptr_t>(ptr),
+      .size = size,
+      .actual_size = size,
+      .timestamp = std::chrono::system_clock::now(),
+  };
+  tls_context_->tracker->record_overflow(EventType::OverflowDeallocate,
+                                         std::move(meta));
+}
+
 // ─── Diagnostics ─────────────────────────────────────────────────────────
 
 auto VisualizationArena::padding_report() const -> PaddingReport { return {}; }
@@ -579,23 +1177,11 @@ auto VisualizationArena::capacity() const noexcept -> std::size_t {
 }
 
 auto VisualizationArena::bytes_allocated() const noexcept -> std::size_t {
-  if (!impl_)
-    return 0;
-  std::size_t sum = 0;
-  for (const auto &s : impl_->shards)
-    if (s)
-      sum += s->allocator->bytes_allocated();
-  return sum;
+  return impl_ ? impl_->usage().first : 0;
 }
 
 auto VisualizationArena::bytes_free() const noexcept -> std::size_t {
-  if (!impl_)
-    return 0;
-  std::size_t sum = 0;
-  for (const auto &s : impl_->shards)
-    if (s)
-      sum += s->allocator->bytes_free();
-  return sum;
+  return impl_ ? impl_->usage().second : 0;
 }
 
 auto VisualizationArena::active_block_count() const noexcept -> std::size_t {
@@ -610,4 +1196,289 @@ auto VisualizationArena::base() const noexcept -> std::byte * {
   return impl_ && impl_->arena ? impl_->arena->base() : nullptr;
 }
 
+/// @brief Header of a live alloc_raw() block of @p va, or nullptr.
+static auto live_header(const VisualizationArena &va, const void *ptr) noexcept
+    -> const AllocationHeader * {
+  if (!va.owns(ptr))
+    return nullptr;
+  // Same footer walk as dealloc_raw().
+  const auto *user_ptr = static_cast<const std::byte *>(ptr);
+  std::uint32_t offset_val = *reinterpret_cast<const std::uint32_t *>(
+      user_ptr - sizeof(std::uint32_t));
+  const auto *header =
+      reinterpret_cast<const AllocationHeader *>(user_ptr - offset_val);
+  return header->magic == AllocationHeader::kMagicValue ? header : nullptr;
+}
+
+auto VisualizationArena::allocation_size(const void *ptr) const noexcept
+    -> std::size_t {
+  const auto *header = live_header(*this, ptr);
+  return header != nullptr ? header->size : 0;
+}
+
+auto VisualizationArena::allocation_tag(const void *ptr) const noexcept
+    -> std::string_view {
+  const auto *header = live_header(*this, ptr);
+  if (header == nullptr)
+    return {};
+  return {header->tag, strnlen(header->tag, sizeof(header->tag))};
+}
+
+auto VisualizationArena::owns(const void *ptr) const noexcept -> bool {
+  if (!impl_ || !impl_->arena)
+    return false;
+  const auto *p = static_cast<const std::byte *>(ptr);
+  const auto *b = impl_->arena->base();
+  return p >= b && p < b + impl_->arena->capacity();
+}
+
+auto VisualizationArena::overflow_stats() const noexcept -> OverflowStats {
+  if (!impl_)
+    return {};
+  return {
+      .allocations =
+          impl_->overflow_allocations.load(std::memory_order_relaxed),
+      .deallocations =
+          impl_->overflow_deallocations.load(std::memory_order_relaxed),
+      .bytes_in_use = impl_->overflow_bytes.load(std::memory_order_relaxed),
+      .peak_bytes = impl_->overflow_peak.load(std::memory_order_relaxed),
+  };
+}
+
+auto VisualizationArena::quota_stats() const -> std::vector<TagQuotaStats> {
+  return impl_ ? impl_->quotas.stats() : std::vector<TagQuotaStats>{};
+}
+
+auto VisualizationArena::shard_lock_stats() const noexcept -> ShardLockStats {
+  ShardLockStats stats;
+  if (!impl_)
+    return stats;
+  for (std::size_t i = 0; i < impl_->shards.size(); ++i) {
+    if (const auto *s = impl_->shards.find(i)) {
+      auto profile = s->mutex.profile();
+      stats.acquisitions += profile.acquisitions;
+      stats.contended += profile.contended;
+    }
+  }
+  return stats;
+}
+
+auto VisualizationArena::shard_lock_profiles() const
+    -> std::vector<ShardLockProfile> {
+  return impl_ ? impl_->shard_lock_profiles()
+               : std::vector<ShardLockProfile>{};
+}
+
+auto VisualizationArena::metrics_text() const -> std::string {
+  return impl_ ? impl_->metrics_text() : std::string{};
+}
+
+auto VisualizationArena::observer_overhead() const -> ObserverOverhead {
+  return impl_ ? impl_->observer.latest() : ObserverOverhead{};
+}
+
+// ─── Memory pressure ─────────────────────────────────────────────────────
+
+auto VisualizationArena::on_pressure(Watermarks marks,
+                                     PressureCallback callback)
+    -> std::size_t {
+  return impl_->pressure->watch_arena(marks, std::move(callback));
+}
+
+auto VisualizationArena::on_shard_pressure(Watermarks marks,
+                                           PressureCallback callback)
+    -> std::size_t {
+  return impl_->pressure->watch_shards(marks, std::move(callback));
+}
+
+void VisualizationArena::remove_pressure_callback(std::size_t id) {
+  if (impl_)
+    impl_->pressure->unwatch(id);
+}
+
+void VisualizationArena::set_reclaim_handler(ReclaimHandler handler) {
+  auto shared = handler ? std::make_shared<ReclaimHandler>(std::move(handler))
+                        : nullptr;
+  std::lock_guard lock(impl_->reclaim_mutex);
+  impl_->reclaim_handler = std::move(shared);
+}
+
+auto VisualizationArena::pressure_stats() const noexcept -> PressureStats {
+  if (!impl_)
+    return {};
+  return PressureStats{
+      .bytes_in_use = impl_->pressure->arena_bytes_in_use(),
+      .level_changes = impl_->pressure->events_raised(),
+      .reclaim_calls = impl_->reclaim_calls.load(std::memory_order_relaxed),
+  };
+}
+
+// ─── Sub-arenas ──────────────────────────────────────────────────────────
+
+/// Smallest SubArena range: room for a header, footer and some payload.
+static constexpr std::size_t kMinSubArenaRange = 256;
+
+auto VisualizationArena::create_sub_arena(SubArenaConfig cfg)
+    -> std::expected<std::unique_ptr<SubArena>, std::error_code> {
+  const std::size_t shard_size = impl_->shard_size();
+  if (cfg.capacity == 0 || cfg.shard_count == 0 ||
+      cfg.ranges_per_shard == 0) {
+    return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
+  const std::size_t count = (cfg.capacity + shard_size - 1) / shard_size;
+  if (count >= kMaxShards) {
+    // Shard 0 always stays with the parent.
+    return std::unexpected(
+        std::make_error_code(std::errc::not_enough_memory));
+  }
+  if (count * shard_size / (cfg.shard_count * cfg.ranges_per_shard) <
+      kMinSubArenaRange) {
+    return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
+
+  std::lock_guard lock(impl_->sub_arenas_mutex);
+
+  // Highest run of `count` shards that no live thread is homed on and
+  // that hold no live block. Cached small blocks count as free.
+  auto available = [&](std::size_t i) {
+    const auto *s = impl_->shards.find(i);
+    return impl_->homes[i].load() == 0 &&
+           (s == nullptr || (!s->delegated.load(std::memory_order_relaxed) &&
+                             s->bytes_allocated() == 0));
+  };
+  std::size_t run = 0;
+  std::size_t first = kMaxShards;
+  for (std::size_t i = kMaxShards - 1; i >= 1 && run < count; --i) {
+    run = available(i) ? run + 1 : 0;
+    first = i;
+  }
+  if (run < count) {
+    return std::unexpected(
+        std::make_error_code(std::errc::not_enough_memory));
+  }
+
+  // Claim, then re-check: a thread may have been homed on the run, or a
+  // remote free may have landed, since the scan. With no thread homed, no
+  // one pops the small cache, so it can be drained back first.
+  auto unclaim = [&](std::size_t end) {
+    for (std::size_t i = first; i < end; ++i) {
+      auto &s = impl_->shard(i);
+      std::lock_guard shard_lock(s.mutex);
+      s.delegated.store(false);
+    }
+  };
+  for (std::size_t i = first; i < first + count; ++i) {
+    auto &s = impl_->shard(i);
+    std::lock_guard shard_lock(s.mutex);
+    s.delegated.store(true);
+    bool in_use = impl_->homes[i].load() != 0;
+    if (!in_use) {
+      s.reclaim();
+      s.report_usage();
+      in_use = s.allocator.bytes_allocated() != 0;
+    }
+    if (in_use) {
+      s.delegated.store(false);
+      unclaim(i);
+      return std::unexpected(
+          std::make_error_code(std::errc::not_enough_memory));
+    }
+  }
+
+  auto *base = impl_->arena->base() + (first * shard_size);
+  std::unique_ptr<SubArena> sub(
+      new SubArena(*this, *impl_->pressure, std::move(cfg), base,
+                   count * shard_size));
+  auto pos = std::find_if(
+      impl_->sub_arenas.begin(), impl_->sub_arenas.end(),
+      [base](const SubArena *other) { return other->base() > base; });
+  impl_->sub_arenas.insert(pos, sub.get());
+  return sub;
+}
+
+void VisualizationArena::release_sub_arena(SubArena &sub) {
+  std::lock_guard lock(impl_->sub_arenas_mutex);
+  std::erase(impl_->sub_arenas, &sub);
+
+  // The sub-arena's allocators overwrote the range; start each shard over.
+  const std::size_t shard_size = impl_->shard_size();
+  const auto first = get_shard_idx(sub.base());
+  const auto count = sub.capacity() / shard_size;
+  for (std::size_t i = first; i < first + count; ++i) {
+    auto &s = impl_->shard(i);
+    std::lock_guard shard_lock(s.mutex);
+    std::destroy_at(&s.allocator);
+    std::construct_at(&s.allocator, impl_->arena->base() + (i * shard_size),
+                      shard_size);
+    s.delegated.store(false);
+  }
+}
+
+void VisualizationArena::record_sub_arena_alloc(BlockMetadata meta) {
+  if (!tls_context_ || tls_context_->generation != impl_->generation) {
+    init_tls_context();
+  }
+  if (!tls_context_)
+    return;
+
+  ObserverMeter::Probe probe(impl_->observer, tls_context_->probe_tick);
+  auto &tracker = *tls_context_->tracker;
+  if (tracker.next_sampled()) {
+    tracker.record_alloc(std::move(meta));
+  } else {
+    tracker.skip();
+  }
+}
+
+void VisualizationArena::record_sub_arena_free(std::size_t offset,
+                                               std::size_t actual_size) {
+  if (!tls_context_ || tls_context_->generation != impl_->generation) {
+    init_tls_context();
+  }
+  if (!tls_context_)
+    return;
+
+  ObserverMeter::Probe probe(impl_->observer, tls_context_->probe_tick);
+  auto &tracker = *tls_context_->tracker;
+  if (tracker.next_sampled()) {
+    tracker.record_dealloc(offset, actual_size);
+  } else {
+    tracker.skip();
+  }
+}
+
+auto VisualizationArena::sub_arena_stats() const
+    -> std::vector<SubArenaStats> {
+  std::vector<SubArenaStats> out;
+  if (!impl_)
+    return out;
+  std::lock_guard lock(impl_->sub_arenas_mutex);
+  out.reserve(impl_->sub_arenas.size());
+  for (const auto *sub : impl_->sub_arenas)
+    out.push_back(sub->stats());
+  return out;
+}
+
+auto VisualizationArena::allocator_stats() const
+    -> std::vector<FreeListStats> {
+  std::vector<FreeListStats> stats;
+  if (!impl_)
+    return stats;
+  stats.reserve(impl_->shards.size());
+  for (std::size_t i = 0; i < impl_->shards.size(); ++i) {
+    auto *s = impl_->shards.find(i);
+    if (!s) {
+      stats.emplace_back();
+      continue;
+    }
+    std::lock_guard lock(s->mutex);
+    if (s->delegated.load(std::memory_order_relaxed)) {
+      stats.emplace_back();
+      continue;
+    }
+    stats.push_back(s->allocator.stats());
+  }
+  return stats;
+}
+
 } // namespace mmap_viz
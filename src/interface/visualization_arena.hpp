@@ -16,13 +16,20 @@
 
 #include "allocator/arena.hpp"
 #include "allocator/free_list.hpp"
+#include "allocator/small_block_cache.hpp"
 #include "allocator/tracked_resource.hpp"
 #include "interface/cache_analyzer.hpp"
+#include "interface/memory_pressure.hpp"
+#include "interface/observer_meter.hpp"
 #include "interface/padding_inspector.hpp"
+#include "interface/shard_lock.hpp"
+#include "interface/sub_arena.hpp"
+#include "interface/tag_quota.hpp"
 #include "tracker/tracker.hpp"
 
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <functional>
 #include <memory>
@@ -48,6 +55,58 @@ struct ArenaConfig {
   unsigned short port = 8080;           ///< Server port (if enabled).
   std::string web_root = "web";         ///< Static file root (if enabled).
   std::size_t sampling = 1; ///< Event sampling rate (1 = all events).
+  /// Where resource() allocations go once the arena is full
+  /// (nullptr = throw std::bad_alloc).
+  std::pmr::memory_resource *overflow_upstream =
+      std::pmr::new_delete_resource();
+  /// Run first on each internal thread (batcher, server), e.g. to mark it
+  /// for a malloc interposer.
+  std::function<void()> on_thread_start;
+  /// How shard locks wait under contention.
+  ShardLockKind shard_lock = ShardLockKind::kSpinFutex;
+  /// Serve alloc_raw() blocks of up to SmallBlockCache::kMaxBlockSize bytes
+  /// (header included) from lock-free per-shard stacks.
+  bool small_block_cache = true;
+  /// Observer overhead (% of process CPU) to stay under by raising the
+  /// sampling rate at runtime; 0 keeps `sampling` fixed. Needs
+  /// enable_server, whose batcher runs the controller.
+  double overhead_target_pct = 0;
+  /// Byte quotas per tag prefix, enforced by alloc_raw(). create() fails
+  /// with std::errc::invalid_argument if a prefix is repeated or longer
+  /// than TagQuotas::kMaxPrefix.
+  std::vector<TagQuota> tag_quotas;
+};
+
+/// @brief Why try_alloc_raw() returned no memory.
+enum class AllocFailure : std::uint8_t {
+  kOutOfMemory,   ///< The home shard is full (after any reclaim).
+  kQuotaExceeded, ///< A QuotaAction::kFail tag quota refused it.
+  kQuotaOverflow, ///< A QuotaAction::kOverflow tag quota refused it.
+};
+
+/// @brief Shard mutex acquisition counts, summed over all shards.
+///
+/// Only the allocation paths (alloc_raw / dealloc_raw) are counted;
+/// diagnostic snapshots are not.
+struct ShardLockStats {
+  std::uint64_t acquisitions = 0; ///< Total shard lock acquisitions.
+  std::uint64_t contended = 0;    ///< Acquisitions that found the lock held.
+};
+
+/// @brief Memory pressure bookkeeping (see on_pressure()).
+struct PressureStats {
+  std::size_t bytes_in_use = 0;    ///< Running arena usage counter.
+  std::uint64_t level_changes = 0; ///< Watermark events raised so far.
+  std::uint64_t reclaim_calls = 0; ///< Reclaim handler runs on OOM.
+};
+
+/// @brief Allocations served by the overflow upstream because the arena was
+///        full. Counters are monotonic; byte figures are requested sizes.
+struct OverflowStats {
+  std::uint64_t allocations = 0;   ///< Overflow allocations so far.
+  std::uint64_t deallocations = 0; ///< Overflow frees so far.
+  std::size_t bytes_in_use = 0;    ///< Live overflow bytes.
+  std::size_t peak_bytes = 0;      ///< High-water mark of bytes_in_use.
 };
 
 /// @brief Single-object façade wrapping the entire instrumented allocation
@@ -114,17 +173,117 @@ public:
   auto alloc_raw(std::size_t size, std::size_t alignment, std::string_view tag)
       -> void *;
 
+  /// @brief Like alloc_raw(), but says why an allocation failed.
+  ///
+  /// A tag covered by ArenaConfig::tag_quotas is charged the block size
+  /// before the shard is touched; a refusal emits a "quota_exceeded"
+  /// event and counts a hit in quota_stats().
+  auto try_alloc_raw(std::size_t size, std::size_t alignment,
+                     std::string_view tag)
+      -> std::expected<void *, AllocFailure>;
+
   /// @brief Deallocate raw bytes previously allocated via alloc_raw().
   /// @param ptr  Pointer returned by alloc_raw().
   /// @param size Original requested size.
   void dealloc_raw(void *ptr, std::size_t size);
 
+  /// @brief Sized deallocation for callers that still know the request,
+  ///        such as C++ sized operator delete.
+  ///
+  /// The block's start and size are computed from @p size and @p alignment,
+  /// so the footer and header are not read first. Both must match the
+  /// alloc_raw() call exactly; debug builds check this against the header.
+  /// @param ptr       Pointer returned by alloc_raw().
+  /// @param size      Size passed to alloc_raw().
+  /// @param alignment Alignment passed to alloc_raw().
+  void dealloc_raw(void *ptr, std::size_t size, std::size_t alignment);
+
   // ─── PMR interop ─────────────────────────────────────────────────────
 
   /// @brief Get a std::pmr::memory_resource* backed by this arena.
   /// @return Non-owning pointer; valid for the lifetime of this arena.
   [[nodiscard]] auto resource() noexcept -> std::pmr::memory_resource *;
 
+  // ─── Sub-allocator reporting ─────────────────────────────────────────
+
+  /// @brief Record an allocate event for memory carved out of a block that
+  ///        a sub-allocator (e.g. TrackedPoolResource) obtained from
+  ///        alloc_raw(). No arena memory changes hands.
+  void record_suballoc(void *ptr, std::size_t size, std::size_t alignment,
+                       std::string_view tag);
+
+  /// @brief Record the matching deallocate event for record_suballoc().
+  void record_subfree(void *ptr, std::size_t size);
+
+  /// @brief Report how many bytes of an alloc_raw() block its owner is
+  ///        using, shown as the block's fill level in the visualization.
+  /// @param ptr        Pointer returned by alloc_raw().
+  /// @param used_bytes Bytes currently handed out from the block.
+  void record_occupancy(void *ptr, std::size_t used_bytes);
+
+  /// @brief Record an allocation that an upstream resource served because
+  ///        the arena was full. Emitted as an "overflow_allocate" event whose
+  ///        offset is the absolute address, since the memory is not in the
+  ///        arena.
+  void record_overflow_alloc(void *ptr, std::size_t size,
+                             std::size_t alignment, std::string_view tag);
+
+  /// @brief Record the matching free for record_overflow_alloc().
+  void record_overflow_free(void *ptr, std::size_t size);
+
+  // ─── Memory pressure ─────────────────────────────────────────────────
+
+  /// @brief Call @p callback when arena usage crosses a watermark.
+  ///
+  /// Usage is checked against running counters on the locked allocation
+  /// paths (blocks in the lock-free small cache count as in use) and
+  /// callbacks run later, in order, on a reclaim thread, so they may free
+  /// and allocate. The arena figure is folded in from the shards in steps
+  /// of 1/64 of a shard, so it lags by up to one step per shard.
+  /// @return Id for remove_pressure_callback().
+  auto on_pressure(Watermarks marks, PressureCallback callback)
+      -> std::size_t;
+
+  /// @brief Like on_pressure(), for each shard separately. Threads
+  ///        allocate from their home shard only, so a full shard fails
+  ///        allocations while the arena still has room.
+  auto on_shard_pressure(Watermarks marks, PressureCallback callback)
+      -> std::size_t;
+
+  /// @brief Unregister a pressure callback. Once this returns it is not
+  ///        running and will not be called again.
+  void remove_pressure_callback(std::size_t id);
+
+  /// @brief Run @p handler when alloc_raw() finds the shard full, then
+  ///        retry while it returns true (up to three times). It runs on
+  ///        the allocating thread, whose home shard is the one that
+  ///        needs room. Pass nullptr to remove it.
+  void set_reclaim_handler(ReclaimHandler handler);
+
+  /// @brief Running pressure counters.
+  [[nodiscard]] auto pressure_stats() const noexcept -> PressureStats;
+
+  // ─── Sub-arenas ──────────────────────────────────────────────────────
+
+  /// @brief Delegate part of the arena to a SubArena.
+  ///
+  /// The range is carved from the top of the arena as whole shards (1/256
+  /// of the capacity each; @p cfg.capacity is rounded up) that are empty
+  /// and that no thread has been homed on yet, so create sub-arenas
+  /// before the threads that allocate from the parent start. Delegated
+  /// shards drop out of the parent's allocation paths until the
+  /// sub-arena is released or destroyed; its usage is added to the
+  /// parent's totals, snapshot and metrics.
+  /// @return The sub-arena, std::errc::invalid_argument for a zero
+  ///         capacity or shard count or shards too small to hold a block,
+  ///         or std::errc::not_enough_memory if no such run of shards is
+  ///         left.
+  [[nodiscard]] auto create_sub_arena(SubArenaConfig cfg)
+      -> std::expected<std::unique_ptr<SubArena>, std::error_code>;
+
+  /// @brief Usage of each live sub-arena, lowest offset first.
+  [[nodiscard]] auto sub_arena_stats() const -> std::vector<SubArenaStats>;
+
   // ─── Diagnostics ─────────────────────────────────────────────────────
 
   /// @brief Generate a padding waste report for all active allocations.
@@ -139,6 +298,11 @@ public:
   /// @brief Get the full event history as a JSON string.
   [[nodiscard]] auto event_log_json() const -> std::string;
 
+  /// @brief Stop the server, batcher and reclaim threads. Allocation keeps
+  ///        working; no more events are streamed and no more pressure
+  ///        callbacks run. Called by the destructor.
+  void stop();
+
   /// @brief Set a callback for WebSocket commands.
   void set_command_handler(std::function<void(const std::string &)> handler);
 
@@ -162,7 +326,54 @@ public:
   /// @brief Base address of the underlying arena.
   [[nodiscard]] auto base() const noexcept -> std::byte *;
 
+  /// @brief Requested size of a live alloc_raw() block.
+  /// @param ptr Pointer returned by alloc_raw().
+  /// @return The size passed to alloc_raw(), or 0 if @p ptr is not a live
+  ///         block of this arena.
+  [[nodiscard]] auto allocation_size(const void *ptr) const noexcept
+      -> std::size_t;
+
+  /// @brief Tag of a live alloc_raw() block.
+  /// @param ptr Pointer returned by alloc_raw().
+  /// @return The (possibly truncated) tag, or empty if @p ptr is not a live
+  ///         block of this arena. Valid until the block is freed.
+  [[nodiscard]] auto allocation_tag(const void *ptr) const noexcept
+      -> std::string_view;
+
+  /// @brief Whether @p ptr lies inside the arena's address range.
+  [[nodiscard]] auto owns(const void *ptr) const noexcept -> bool;
+
+  /// @brief Overflow upstream usage (see ArenaConfig::overflow_upstream).
+  [[nodiscard]] auto overflow_stats() const noexcept -> OverflowStats;
+
+  /// @brief Usage and hits of each ArenaConfig::tag_quotas entry, in
+  ///        configuration order.
+  [[nodiscard]] auto quota_stats() const -> std::vector<TagQuotaStats>;
+
+  /// @brief Shard lock contention counters (monotonic since creation).
+  [[nodiscard]] auto shard_lock_stats() const noexcept -> ShardLockStats;
+
+  /// @brief Per-shard lock profiles (index = shard): wait and hold time
+  ///        histograms plus contended and cross-thread acquisition counts.
+  [[nodiscard]] auto shard_lock_profiles() const
+      -> std::vector<ShardLockProfile>;
+
+  /// @brief Arena metrics in the Prometheus text exposition format, as
+  ///        served on the visualization server's /metrics endpoint.
+  [[nodiscard]] auto metrics_text() const -> std::string;
+
+  /// @brief What the instrumentation cost over its last window (about a
+  ///        second), and the sampling rate the controller chose. All zero
+  ///        until the batcher has closed a window (enable_server).
+  [[nodiscard]] auto observer_overhead() const -> ObserverOverhead;
+
+  /// @brief Free-list hot-path counters, one entry per shard (index =
+  ///        shard). All zero unless built with MMAP_VIZ_ALLOC_STATS.
+  [[nodiscard]] auto allocator_stats() const -> std::vector<FreeListStats>;
+
 private:
+  friend class SubArena;
+
   VisualizationArena() = default;
   struct Impl;
   std::unique_ptr<Impl> impl_;
@@ -181,6 +392,13 @@ private:
   // Helpers
   void init_tls_context();
   auto get_shard_idx(void *ptr) const -> std::size_t;
+  /// @brief Record the free and return a block to its shard.
+  void free_block(std::byte *raw_ptr, std::size_t actual_size);
+  /// @brief SubArena events, sampled like the parent's own.
+  void record_sub_arena_alloc(BlockMetadata meta);
+  void record_sub_arena_free(std::size_t offset, std::size_t actual_size);
+  /// @brief Unregister @p sub and hand its shards back.
+  void release_sub_arena(SubArena &sub);
 };
 
 } // namespace mmap_viz
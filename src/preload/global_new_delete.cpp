@@ -0,0 +1,208 @@
+/// @file global_new_delete.cpp
+/// @brief Replacement global operator new/delete backed by the process
+///        arena (see global_new_delete.hpp).
+///
+/// All forms funnel into allocate() and release() below. Plain forms use
+/// __STDCPP_DEFAULT_NEW_ALIGNMENT__ as the arena alignment, so a sized
+/// delete can hand the same (size, alignment) pair back to dealloc_raw().
+
+#include "preload/global_new_delete.hpp"
+#include "interface/visualization_arena.hpp"
+#include "preload/process_arena.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace mmap_viz {
+namespace {
+
+namespace process_arena = mmap_viz::process_arena;
+
+constexpr std::size_t kDefaultAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+constexpr std::string_view kDefaultTag = "new";
+
+__attribute__((tls_model("initial-exec"))) thread_local std::string_view
+    t_tag = kDefaultTag;
+
+auto malloc_fallback(std::size_t size, std::size_t alignment) noexcept
+    -> void * {
+  if (alignment <= kDefaultAlignment) {
+    return std::malloc(size);
+  }
+  // aligned_alloc wants a multiple of the alignment.
+  std::size_t rounded = (std::max<std::size_t>(size, 1) + alignment - 1) &
+                        ~(alignment - 1);
+  return std::aligned_alloc(alignment, rounded);
+}
+
+/// @return The block, or nullptr if neither the arena nor malloc had room.
+auto try_allocate(std::size_t size, std::size_t alignment) noexcept -> void * {
+  auto *va = process_arena::get();
+  if (va == nullptr) {
+    process_arena::counters().passthrough.fetch_add(1,
+                                                    std::memory_order_relaxed);
+    return malloc_fallback(size, alignment);
+  }
+  void *ptr = process_arena::allocate(*va, size, alignment, t_tag);
+  return ptr != nullptr ? ptr : malloc_fallback(size, alignment);
+}
+
+/// @brief Throwing allocation: retries through the new_handler, as the
+///        standard requires of a replacement operator new.
+auto allocate(std::size_t size, std::size_t alignment) -> void * {
+  for (;;) {
+    if (void *ptr = try_allocate(size, alignment)) {
+      return ptr;
+    }
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+auto allocate_nothrow(std::size_t size, std::size_t alignment) noexcept
+    -> void * {
+  try {
+    return allocate(size, alignment);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void release(void *ptr) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  if (process_arena::owns(ptr)) {
+    process_arena::release(ptr);
+  } else {
+    std::free(ptr);
+  }
+}
+
+void release_sized(void *ptr, std::size_t size,
+                   std::size_t alignment) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  if (process_arena::owns(ptr)) {
+    process_arena::release(ptr, size, alignment);
+  } else {
+    std::free(ptr);
+  }
+}
+
+auto to_size(std::align_val_t alignment) noexcept -> std::size_t {
+  return std::max(static_cast<std::size_t>(alignment), kDefaultAlignment);
+}
+
+} // namespace
+
+// ─── AllocationTagScope ─────────────────────────────────────────────────
+
+AllocationTagScope::AllocationTagScope(std::string_view tag) noexcept
+    : prev_{t_tag} {
+  t_tag = tag;
+}
+
+AllocationTagScope::~AllocationTagScope() { t_tag = prev_; }
+
+auto AllocationTagScope::current() noexcept -> std::string_view {
+  return t_tag;
+}
+
+} // namespace mmap_viz
+
+// ─── Replaceable allocation functions ───────────────────────────────────
+
+using mmap_viz::allocate;
+using mmap_viz::allocate_nothrow;
+using mmap_viz::kDefaultAlignment;
+using mmap_viz::release;
+using mmap_viz::release_sized;
+using mmap_viz::to_size;
+
+void *operator new(std::size_t size) {
+  return allocate(size, kDefaultAlignment);
+}
+
+void *operator new[](std::size_t size) {
+  return allocate(size, kDefaultAlignment);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate_nothrow(size, kDefaultAlignment);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate_nothrow(size, kDefaultAlignment);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return allocate(size, to_size(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return allocate(size, to_size(alignment));
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+  return allocate_nothrow(size, to_size(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  return allocate_nothrow(size, to_size(alignment));
+}
+
+// ─── Replaceable deallocation functions ─────────────────────────────────
+
+void operator delete(void *ptr) noexcept { release(ptr); }
+
+void operator delete[](void *ptr) noexcept { release(ptr); }
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  release(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  release(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept { release(ptr); }
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+  release(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  release(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  release(ptr);
+}
+
+void operator delete(void *ptr, std::size_t size) noexcept {
+  release_sized(ptr, size, kDefaultAlignment);
+}
+
+void operator delete[](void *ptr, std::size_t size) noexcept {
+  release_sized(ptr, size, kDefaultAlignment);
+}
+
+void operator delete(void *ptr, std::size_t size,
+                     std::align_val_t alignment) noexcept {
+  release_sized(ptr, size, to_size(alignment));
+}
+
+void operator delete[](void *ptr, std::size_t size,
+                       std::align_val_t alignment) noexcept {
+  release_sized(ptr, size, to_size(alignment));
+}
@@ -0,0 +1,69 @@
+#pragma once
+/// @file global_new_delete.hpp
+/// @brief Tagging for the global operator new/delete replacement.
+///
+/// Linking the `mmap_viz_new_delete` object library into an executable
+/// replaces every form of global operator new and delete (plain, array,
+/// nothrow, aligned, sized) with allocation from the process-global arena
+/// described in process_arena.hpp; no code changes are needed:
+/// @code
+///   target_link_libraries(my_service PRIVATE mmap_viz_new_delete)
+/// @endcode
+///
+/// Blocks are tagged "new" unless an AllocationTagScope is active on the
+/// calling thread:
+/// @code
+///   {
+///     auto scope = mmap_viz::AllocationTagScope::of<Order>();
+///     orders.push_back(std::make_unique<Order>());  // tagged "Order"
+///   }
+/// @endcode
+///
+/// Sized delete, which the compiler emits whenever the size is known,
+/// frees through the sized VisualizationArena::dealloc_raw() and so skips
+/// the header lookup. Requests the arena declines are served by malloc, and
+/// delete routes by address.
+
+#include <string_view>
+
+namespace mmap_viz {
+
+/// @brief Readable name of @p T, usable as an allocation tag.
+template <typename T>
+[[nodiscard]] constexpr auto type_name() -> std::string_view {
+  std::string_view name = __PRETTY_FUNCTION__;
+  // GCC: "... type_name() [with T = Foo; ...]", Clang: "... [T = Foo]".
+  auto start = name.find("T = ");
+  if (start == std::string_view::npos) {
+    return "new";
+  }
+  start += 4;
+  auto end = name.find_first_of(";]", start);
+  return name.substr(start, end - start);
+}
+
+/// @brief Tags the calling thread's operator new allocations for a scope.
+///
+/// Scopes nest; the innermost wins. The tag is not copied, so it must
+/// outlive the scope (string literals and type_name() results do).
+class AllocationTagScope {
+public:
+  explicit AllocationTagScope(std::string_view tag) noexcept;
+  ~AllocationTagScope();
+  AllocationTagScope(const AllocationTagScope &) = delete;
+  AllocationTagScope &operator=(const AllocationTagScope &) = delete;
+
+  /// @brief Scope tagged with type_name<T>().
+  template <typename T> [[nodiscard]] static auto of() noexcept
+      -> AllocationTagScope {
+    return AllocationTagScope(type_name<T>());
+  }
+
+  /// @brief The calling thread's current tag ("new" outside any scope).
+  [[nodiscard]] static auto current() noexcept -> std::string_view;
+
+private:
+  std::string_view prev_;
+};
+
+} // namespace mmap_viz
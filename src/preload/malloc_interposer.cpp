@@ -0,0 +1,213 @@
+/// @file malloc_interposer.cpp
+/// @brief LD_PRELOAD replacement of the C allocation functions.
+///
+/// Every call is routed to the process-global arena (process_arena.hpp).
+/// Whenever that arena declines a request (bootstrap, re-entry from arena
+/// code, thread exit, full shard) glibc serves it instead, and free() /
+/// realloc() tell the two apart by address, so memory from before init
+/// stays valid forever.
+///
+/// The fast path is one acquire load, the per-thread shard lock (held only
+/// by the owning thread unless there are more than 256 threads) and the
+/// free-list search.
+
+#include "preload/malloc_interposer.hpp"
+#include "interface/visualization_arena.hpp"
+#include "preload/process_arena.hpp"
+
+#include <dlfcn.h>
+#include <malloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+// glibc's own implementations, exported for exactly this purpose.
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void __libc_free(void *ptr);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *ptr, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+}
+
+namespace {
+
+namespace process_arena = mmap_viz::process_arena;
+
+constexpr std::size_t kMallocAlignment = alignof(std::max_align_t);
+
+// ─── Allocation paths ───────────────────────────────────────────────────
+
+auto libc_alloc(std::size_t size, std::size_t alignment) noexcept -> void * {
+  return alignment <= kMallocAlignment ? __libc_malloc(size)
+                                       : __libc_memalign(alignment, size);
+}
+
+auto allocate(std::size_t size, std::size_t alignment, const char *tag) noexcept
+    -> void * {
+  auto *va = process_arena::get();
+  if (va == nullptr) {
+    process_arena::counters().passthrough.fetch_add(1,
+                                                    std::memory_order_relaxed);
+    return libc_alloc(size, alignment);
+  }
+  void *ptr = process_arena::allocate(*va, size, alignment, tag);
+  if (ptr == nullptr) {
+    // This thread's shard is full: degrade to glibc rather than fail.
+    ptr = libc_alloc(size, alignment);
+  }
+  if (ptr == nullptr) {
+    errno = ENOMEM;
+  }
+  return ptr;
+}
+
+void release(void *ptr) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  if (!process_arena::owns(ptr)) {
+    __libc_free(ptr);
+    return;
+  }
+  process_arena::release(ptr);
+}
+
+auto is_valid_alignment(std::size_t alignment) noexcept -> bool {
+  return alignment != 0 && std::has_single_bit(alignment);
+}
+
+} // namespace
+
+// ─── Interposed C API ───────────────────────────────────────────────────
+
+extern "C" {
+
+void *malloc(std::size_t size) noexcept {
+  return allocate(size, kMallocAlignment, "malloc");
+}
+
+void free(void *ptr) noexcept { release(ptr); }
+
+void *calloc(std::size_t count, std::size_t size) noexcept {
+  std::size_t total = 0;
+  if (__builtin_mul_overflow(count, size, &total)) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  if (process_arena::get() == nullptr) {
+    process_arena::counters().passthrough.fetch_add(1,
+                                                    std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+  }
+  // alloc_raw() zero-fills; only the overflow path needs clearing.
+  void *ptr = allocate(total, kMallocAlignment, "calloc");
+  if (ptr != nullptr && !process_arena::owns(ptr)) {
+    std::memset(ptr, 0, total);
+  }
+  return ptr;
+}
+
+void *realloc(void *ptr, std::size_t size) noexcept {
+  if (ptr == nullptr) {
+    return allocate(size, kMallocAlignment, "realloc");
+  }
+  if (size == 0) {
+    release(ptr);
+    return nullptr;
+  }
+  if (!process_arena::owns(ptr)) {
+    return __libc_realloc(ptr, size);
+  }
+
+  const std::size_t old_size = process_arena::instance()->allocation_size(ptr);
+  if (size <= old_size && size >= old_size / 2) {
+    return ptr; // Shrinking a little: keep the block.
+  }
+  void *moved = allocate(size, kMallocAlignment, "realloc");
+  if (moved == nullptr) {
+    return nullptr; // The old block stays valid, as C requires.
+  }
+  std::memcpy(moved, ptr, std::min(old_size, size));
+  release(ptr);
+  return moved;
+}
+
+void *memalign(std::size_t alignment, std::size_t size) noexcept {
+  // glibc rounds a bad alignment up to the next power of two.
+  if (!is_valid_alignment(alignment)) {
+    alignment = std::bit_ceil(std::max<std::size_t>(alignment, 1));
+  }
+  return allocate(size, std::max(alignment, kMallocAlignment), "memalign");
+}
+
+int posix_memalign(void **memptr, std::size_t alignment,
+                   std::size_t size) noexcept {
+  if (!is_valid_alignment(alignment) || alignment % sizeof(void *) != 0) {
+    return EINVAL;
+  }
+  void *ptr = allocate(size, std::max(alignment, kMallocAlignment),
+                       "posix_memalign");
+  if (ptr == nullptr) {
+    return ENOMEM;
+  }
+  *memptr = ptr;
+  return 0;
+}
+
+void *aligned_alloc(std::size_t alignment, std::size_t size) noexcept {
+  if (!is_valid_alignment(alignment)) {
+    errno = EINVAL;
+    return nullptr;
+  }
+  return allocate(size, std::max(alignment, kMallocAlignment),
+                  "aligned_alloc");
+}
+
+std::size_t malloc_usable_size(void *ptr) noexcept {
+  if (ptr == nullptr) {
+    return 0;
+  }
+  if (process_arena::owns(ptr)) {
+    return process_arena::instance()->allocation_size(ptr);
+  }
+  using UsableSizeFn = std::size_t (*)(void *);
+  static std::atomic<UsableSizeFn> libc_usable_size{nullptr};
+  auto fn = libc_usable_size.load(std::memory_order_acquire);
+  if (fn == nullptr) {
+    process_arena::ReentryGuard guard; // dlsym may allocate.
+    fn = reinterpret_cast<UsableSizeFn>(
+        ::dlsym(RTLD_NEXT, "malloc_usable_size"));
+    libc_usable_size.store(fn, std::memory_order_release);
+  }
+  return fn != nullptr ? fn(ptr) : 0;
+}
+
+// ─── Introspection ──────────────────────────────────────────────────────
+
+void mmap_viz_preload_stats(MmapVizPreloadStats *out) {
+  if (out == nullptr) {
+    return;
+  }
+  auto *va = process_arena::instance();
+  auto &counters = process_arena::counters();
+  *out = MmapVizPreloadStats{
+      .ready = va != nullptr ? 1 : 0,
+      .arena_capacity = va != nullptr ? va->capacity() : 0,
+      .arena_bytes = va != nullptr ? va->bytes_allocated() : 0,
+      .passthrough_allocs =
+          counters.passthrough.load(std::memory_order_relaxed),
+      .overflow_allocs = counters.overflow.load(std::memory_order_relaxed),
+      .exit_leaked_frees = counters.exit_leaks.load(std::memory_order_relaxed),
+  };
+}
+
+int mmap_viz_preload_owns(const void *ptr) {
+  return process_arena::owns(ptr) ? 1 : 0;
+}
+
+} // extern "C"
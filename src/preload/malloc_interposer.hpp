@@ -0,0 +1,47 @@
+#pragma once
+/// @file malloc_interposer.hpp
+/// @brief Introspection API of the LD_PRELOAD malloc interposer.
+///
+/// libmmap_viz_preload.so replaces the C allocation functions of any
+/// dynamically linked program with a process-global VisualizationArena:
+/// @code
+///   LD_PRELOAD=./build/libmmap_viz_preload.so MMAP_VIZ_PORT=8080 ./some_app
+/// @endcode
+///
+/// Environment variables (read once, on the first allocation):
+///   - `MMAP_VIZ_ARENA_MB`  arena size in MiB (default 4096; virtual only),
+///   - `MMAP_VIZ_SAMPLING`  event sampling rate (default 1),
+///   - `MMAP_VIZ_PORT`      start the dashboard server on this port,
+///   - `MMAP_VIZ_WEB_ROOT`  static file root for the server (default "web").
+///
+/// Memory handed out before the arena exists, by calls made from inside the
+/// arena itself, or after a thread's shard is full comes from glibc. free()
+/// tells the two apart by address, so both kinds can be mixed freely. Once
+/// a thread's thread_local destructors have started, it uses glibc only,
+/// and arena blocks it frees are left allocated.
+///
+/// The functions below are exported by the library so a preloaded program
+/// (or a test) can look them up with dlsym(RTLD_DEFAULT, ...).
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+
+/// @brief Counters of the interposer.
+struct MmapVizPreloadStats {
+  int ready;                        ///< 1 once the arena is initialized.
+  std::size_t arena_capacity;       ///< Arena size in bytes.
+  std::size_t arena_bytes;          ///< Bytes allocated in the arena.
+  std::uint64_t passthrough_allocs; ///< Served by glibc: bootstrap/re-entry.
+  std::uint64_t overflow_allocs;    ///< Served by glibc: shard full.
+  std::uint64_t exit_leaked_frees;  ///< Arena frees skipped at thread exit.
+};
+
+/// @brief Fill @p out with the current counters.
+void mmap_viz_preload_stats(MmapVizPreloadStats *out);
+
+/// @brief Whether @p ptr was allocated from the arena.
+int mmap_viz_preload_owns(const void *ptr);
+
+} // extern "C"
@@ -0,0 +1,256 @@
+/// @file process_arena.cpp
+/// @brief Bootstrap and lifetime of the process-global VisualizationArena.
+///
+/// Three things keep the arena usable from inside an arbitrary program's
+/// allocation functions:
+///   - a thread-local re-entry flag: VisualizationArena itself allocates
+///     (thread contexts, event rings, server buffers), and those calls must
+///     be served elsewhere instead of recursing,
+///   - a bootstrap state machine: until the arena is ready (before this
+///     object's ELF constructor has run, or while another thread builds it)
+///     get() returns nullptr,
+///   - an exit sentinel per thread: once a thread's thread_local destructors
+///     run, VisualizationArena's per-thread context may be gone, so the
+///     thread stays out of the arena from then on.
+
+#include "preload/process_arena.hpp"
+#include "interface/visualization_arena.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <new>
+
+namespace mmap_viz::process_arena {
+namespace {
+
+// ─── Bootstrap state ────────────────────────────────────────────────────
+
+enum class State : int {
+  Uninit,       ///< No allocation seen yet.
+  Initializing, ///< One thread is building the arena.
+  Ready,        ///< g_arena is usable.
+  Failed,       ///< Arena creation failed; callers serve everything.
+};
+
+std::atomic<State> g_state{State::Uninit};
+
+/// Set by this object's ELF constructor. Allocations made by constructors
+/// that run earlier (libc, ld.so, other preloads) happen before libstdc++ is
+/// guaranteed to be initialized, so they must not build the arena.
+std::atomic<bool> g_loaded{false};
+
+__attribute__((constructor)) void mark_loaded() {
+  g_loaded.store(true, std::memory_order_release);
+}
+
+/// Never destroyed: pointers into the arena outlive every static object.
+alignas(VisualizationArena) unsigned char
+    g_storage[sizeof(VisualizationArena)];
+VisualizationArena *g_arena = nullptr;
+const std::byte *g_base = nullptr;
+std::size_t g_capacity = 0;
+
+Counters g_counters;
+
+/// Set while this thread runs arena code, and for good on the arena's own
+/// threads. initial-exec keeps the access free of __tls_get_addr, which may
+/// allocate on first use.
+__attribute__((tls_model("initial-exec"))) thread_local bool t_busy = false;
+
+/// Set once this thread's thread_local destructors have begun.
+__attribute__((tls_model("initial-exec"))) thread_local bool t_exiting = false;
+__attribute__((tls_model("initial-exec"))) thread_local bool t_armed = false;
+
+/// @brief Flips t_exiting when the thread's thread_locals are torn down.
+///
+/// Armed right after the thread's first arena allocation, i.e. after
+/// VisualizationArena registered its own thread_local context, so this
+/// destructor runs before that context's.
+struct ExitSentinel {
+  ExitSentinel() = default;
+  ExitSentinel(const ExitSentinel &) = delete;
+  ExitSentinel &operator=(const ExitSentinel &) = delete;
+  ~ExitSentinel() { t_exiting = true; }
+};
+
+void arm_exit_sentinel() {
+  t_armed = true;
+  // Registering the destructor allocates; callers hold a ReentryGuard.
+  static thread_local ExitSentinel sentinel;
+  (void)sentinel;
+}
+
+auto env_size(const char *name, std::size_t fallback) -> std::size_t {
+  const char *value = std::getenv(name);
+  if (value == nullptr || *value == '\0') {
+    return fallback;
+  }
+  return static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+}
+
+auto config_from_env() -> ArenaConfig {
+  ArenaConfig cfg{
+      .arena_size = env_size("MMAP_VIZ_ARENA_MB", 4096) * 1024 * 1024,
+      .sampling = std::max<std::size_t>(1, env_size("MMAP_VIZ_SAMPLING", 1)),
+      .on_thread_start = [] { t_busy = true; },
+  };
+  if (const char *port = std::getenv("MMAP_VIZ_PORT")) {
+    cfg.enable_server = true;
+    cfg.port = static_cast<unsigned short>(std::strtoul(port, nullptr, 10));
+    if (const char *root = std::getenv("MMAP_VIZ_WEB_ROOT")) {
+      cfg.web_root = root;
+    }
+  }
+  return cfg;
+}
+
+/// @brief VisualizationArena::create() that reports instead of throwing.
+///        WsServer throws if the port is taken, e.g. by a parent process
+///        that was preloaded too; the arena is then built without a server.
+auto create_arena(ArenaConfig cfg) -> bool {
+  for (;;) {
+    try {
+      auto result = VisualizationArena::create(cfg);
+      if (!result.has_value()) {
+        std::fprintf(stderr, "[mmap_viz] arena creation failed: %s\n",
+                     result.error().message().c_str());
+        return false;
+      }
+      g_arena = ::new (g_storage) VisualizationArena(std::move(*result));
+      return true;
+    } catch (const std::exception &e) {
+      if (!cfg.enable_server) {
+        std::fprintf(stderr, "[mmap_viz] arena setup failed: %s\n", e.what());
+        return false;
+      }
+      std::fprintf(stderr, "[mmap_viz] server disabled for pid %d: %s\n",
+                   static_cast<int>(::getpid()), e.what());
+      cfg.enable_server = false;
+    }
+  }
+}
+
+void init() noexcept {
+  State expected = State::Uninit;
+  if (!g_state.compare_exchange_strong(expected, State::Initializing,
+                                       std::memory_order_acq_rel)) {
+    return;
+  }
+  ReentryGuard guard;
+
+  bool ok = false;
+  try {
+    ok = create_arena(config_from_env());
+  } catch (...) {
+    ok = false;
+  }
+  if (!ok) {
+    g_state.store(State::Failed, std::memory_order_release);
+    return;
+  }
+  g_base = g_arena->base();
+  g_capacity = g_arena->capacity();
+  // The arena outlives exit(), but its server threads must not run while
+  // static destructors tear down what they use. Registered after create()
+  // so it runs before the destructors of statics the server set up.
+  std::atexit([] {
+    ReentryGuard guard;
+    g_arena->stop();
+  });
+  g_state.store(State::Ready, std::memory_order_release);
+}
+
+/// @return Whether a free of an arena block may touch the arena now.
+auto may_release() noexcept -> bool {
+  if (t_exiting) {
+    // Freed by a thread_local destructor after the arena's per-thread
+    // context is gone. The block is left allocated rather than risk it.
+    g_counters.exit_leaks.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+// ─── Public API ─────────────────────────────────────────────────────────
+
+ReentryGuard::ReentryGuard() noexcept : prev_{t_busy} { t_busy = true; }
+
+ReentryGuard::~ReentryGuard() { t_busy = prev_; }
+
+auto counters() noexcept -> Counters & { return g_counters; }
+
+auto get() noexcept -> VisualizationArena * {
+  if (t_busy || t_exiting) {
+    return nullptr;
+  }
+  auto state = g_state.load(std::memory_order_acquire);
+  if (state == State::Uninit) {
+    if (!g_loaded.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    init();
+    state = g_state.load(std::memory_order_acquire);
+  }
+  return state == State::Ready ? g_arena : nullptr;
+}
+
+auto ready() noexcept -> bool {
+  return g_state.load(std::memory_order_acquire) == State::Ready;
+}
+
+auto instance() noexcept -> VisualizationArena * {
+  return ready() ? g_arena : nullptr;
+}
+
+auto owns(const void *ptr) noexcept -> bool {
+  // Arena pointers only exist once Ready has been published.
+  if (!ready()) {
+    return false;
+  }
+  const auto *p = static_cast<const std::byte *>(ptr);
+  return p >= g_base && p < g_base + g_capacity;
+}
+
+auto allocate(VisualizationArena &arena, std::size_t size,
+              std::size_t alignment, std::string_view tag) noexcept -> void * {
+  void *ptr = nullptr;
+  {
+    ReentryGuard guard;
+    try {
+      ptr = arena.alloc_raw(size, alignment, tag);
+      if (!t_armed) {
+        arm_exit_sentinel();
+      }
+    } catch (...) {
+      ptr = nullptr;
+    }
+  }
+  if (ptr == nullptr) {
+    g_counters.overflow.fetch_add(1, std::memory_order_relaxed);
+  }
+  return ptr;
+}
+
+void release(void *ptr) noexcept {
+  if (!may_release()) {
+    return;
+  }
+  ReentryGuard guard;
+  g_arena->dealloc_raw(ptr, 0);
+}
+
+void release(void *ptr, std::size_t size, std::size_t alignment) noexcept {
+  if (!may_release()) {
+    return;
+  }
+  ReentryGuard guard;
+  g_arena->dealloc_raw(ptr, size, alignment);
+}
+
+} // namespace mmap_viz::process_arena
@@ -0,0 +1,82 @@
+#pragma once
+/// @file process_arena.hpp
+/// @brief The process-global VisualizationArena behind the allocator
+///        replacements (the LD_PRELOAD malloc interposer and the global
+///        operator new/delete object).
+///
+/// The arena is created lazily on the first allocation that may use it and
+/// is never destroyed, so blocks freed by static destructors after main()
+/// returns stay valid. Configuration comes from the environment, read once:
+///   - `MMAP_VIZ_ARENA_MB`  arena size in MiB (default 4096; virtual only),
+///   - `MMAP_VIZ_SAMPLING`  event sampling rate (default 1),
+///   - `MMAP_VIZ_PORT`      start the dashboard server on this port,
+///   - `MMAP_VIZ_WEB_ROOT`  static file root for the server (default "web").
+///
+/// Nothing here falls back to another allocator; callers decide what serves
+/// a request when get() or allocate() returns nullptr.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace mmap_viz {
+class VisualizationArena;
+} // namespace mmap_viz
+
+namespace mmap_viz::process_arena {
+
+/// @brief Fallback counters shared by every replacement in the process.
+struct Counters {
+  std::atomic<std::uint64_t> passthrough{0}; ///< No arena: bootstrap/re-entry.
+  std::atomic<std::uint64_t> overflow{0};    ///< Arena present, shard full.
+  std::atomic<std::uint64_t> exit_leaks{0};  ///< Frees skipped at thread exit.
+};
+
+/// @brief The process's counters.
+[[nodiscard]] auto counters() noexcept -> Counters &;
+
+/// @brief The arena, creating it on first use.
+/// @return nullptr if this call must be served elsewhere: the arena is not
+///         (or not yet) available, the calling thread is inside arena code,
+///         or its thread_local destructors have started.
+[[nodiscard]] auto get() noexcept -> VisualizationArena *;
+
+/// @brief Whether the arena has been created successfully.
+[[nodiscard]] auto ready() noexcept -> bool;
+
+/// @brief The arena once ready(), whatever the calling thread's state; for
+///        queries on blocks owns() accepted. nullptr before that.
+[[nodiscard]] auto instance() noexcept -> VisualizationArena *;
+
+/// @brief Whether @p ptr lies inside the arena's mapping.
+[[nodiscard]] auto owns(const void *ptr) noexcept -> bool;
+
+/// @brief alloc_raw() on @p arena (as returned by get()) with the re-entry
+///        guard held.
+/// @return nullptr if the thread's shard is full; counted as overflow.
+[[nodiscard]] auto allocate(VisualizationArena &arena, std::size_t size,
+                            std::size_t alignment,
+                            std::string_view tag) noexcept -> void *;
+
+/// @brief Free an arena block, i.e. one for which owns() is true.
+void release(void *ptr) noexcept;
+
+/// @brief Sized release(); see VisualizationArena::dealloc_raw(ptr, size,
+///        alignment). @p size and @p alignment must be those of allocate().
+void release(void *ptr, std::size_t size, std::size_t alignment) noexcept;
+
+/// @brief Marks the current thread as inside the arena for a scope, so
+///        allocations it makes are served elsewhere.
+class ReentryGuard {
+public:
+  ReentryGuard() noexcept;
+  ~ReentryGuard();
+  ReentryGuard(const ReentryGuard &) = delete;
+  ReentryGuard &operator=(const ReentryGuard &) = delete;
+
+private:
+  bool prev_;
+};
+
+} // namespace mmap_viz::process_arena
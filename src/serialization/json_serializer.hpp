@@ -2,10 +2,16 @@
 /// @file json_serializer.hpp
 /// @brief nlohmann/json serialization for BlockMetadata and AllocationEvent.
 
+#include "allocator/free_list.hpp"
+#include "interface/observer_meter.hpp"
+#include "interface/shard_lock.hpp"
+#include "interface/sub_arena.hpp"
 #include "tracker/block_metadata.hpp"
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+
 namespace mmap_viz {
 
 inline void to_json(nlohmann::json &j, const BlockMetadata &b) {
@@ -21,9 +27,50 @@ inline void to_json(nlohmann::json &j, const BlockMetadata &b) {
   };
 }
 
+inline void to_json(nlohmann::json &j, const FreeListStats &s) {
+  j = nlohmann::json{
+      {"allocations", s.allocations},
+      {"deallocations", s.deallocations},
+      {"small_list_hits", s.small_list_hits},
+      {"small_list_misses", s.small_list_misses},
+      {"small_list_hit_rate", s.small_list_hit_rate()},
+      {"fit_searches", s.fit_searches},
+      {"fit_nodes_visited", s.fit_nodes_visited},
+      {"mean_fit_visits", s.mean_fit_visits()},
+      {"successor_steps", s.successor_steps},
+      {"inserts", s.inserts},
+      {"mean_insert_depth", s.mean_insert_depth()},
+      {"max_insert_depth", s.insert_depth_max},
+      {"rotations", s.rotations},
+      {"rotations_per_op", s.rotations_per_op()},
+      {"splits", s.splits},
+      {"coalesces", s.coalesces},
+      {"absorbed_remainders", s.absorbed_remainders},
+  };
+}
+
+/// @brief Wire name of an event type.
+inline auto event_type_name(EventType type) -> const char * {
+  switch (type) {
+  case EventType::Allocate:
+    return "allocate";
+  case EventType::Deallocate:
+    return "deallocate";
+  case EventType::Occupancy:
+    return "occupancy";
+  case EventType::OverflowAllocate:
+    return "overflow_allocate";
+  case EventType::OverflowDeallocate:
+    return "overflow_deallocate";
+  case EventType::QuotaExceeded:
+    return "quota_exceeded";
+  }
+  return "unknown";
+}
+
 inline void to_json(nlohmann::json &j, const AllocationEvent &e) {
   j = nlohmann::json{
-      {"type", e.type == EventType::Allocate ? "allocate" : "deallocate"},
+      {"type", event_type_name(e.type)},
       {"event_id", e.event_id},
       {"offset", e.block.offset},
       {"size", e.block.size},
@@ -63,4 +110,97 @@ inline auto snapshot_to_json(const std::vector<BlockMetadata> &blocks,
   return j;
 }
 
+/// @brief Periodic "shard_locks" message for the UI: arena-wide totals
+///        plus the @p top_n busiest shards, most contended first.
+/// @param profiles One entry per shard, indexed by shard.
+inline auto shard_locks_to_json(const std::vector<ShardLockProfile> &profiles,
+                                std::size_t top_n = 16) -> nlohmann::json {
+  std::uint64_t acquisitions = 0, contended = 0, remote = 0;
+  std::vector<std::size_t> active;
+  for (std::size_t i = 0; i < profiles.size(); ++i) {
+    const auto &p = profiles[i];
+    acquisitions += p.acquisitions;
+    contended += p.contended;
+    remote += p.remote;
+    if (p.acquisitions != 0) {
+      active.push_back(i);
+    }
+  }
+  auto hotter = [&](std::size_t a, std::size_t b) {
+    const auto &pa = profiles[a];
+    const auto &pb = profiles[b];
+    if (pa.contended != pb.contended)
+      return pa.contended > pb.contended;
+    return pa.acquisitions > pb.acquisitions;
+  };
+  auto shown = std::min(top_n, active.size());
+  std::partial_sort(active.begin(), active.begin() + shown, active.end(),
+                    hotter);
+
+  nlohmann::json j;
+  j["type"] = "shard_locks";
+  j["acquisitions"] = acquisitions;
+  j["contended"] = contended;
+  j["remote"] = remote;
+  j["active_shards"] = active.size();
+  j["shards"] = nlohmann::json::array();
+  for (std::size_t k = 0; k < shown; ++k) {
+    const auto &p = profiles[active[k]];
+    j["shards"].push_back({
+        {"shard", active[k]},
+        {"acquisitions", p.acquisitions},
+        {"contended", p.contended},
+        {"remote", p.remote},
+        {"wait_p50_ns", p.wait_ns.percentile(0.50)},
+        {"wait_p99_ns", p.wait_ns.percentile(0.99)},
+        {"wait_max_ns", p.wait_ns.max_ns},
+        {"hold_p50_ns", p.hold_ns.percentile(0.50)},
+        {"hold_p99_ns", p.hold_ns.percentile(0.99)},
+    });
+  }
+  return j;
+}
+
+/// @brief Periodic "observer" message: what the instrumentation cost over
+///        the last window and the sampling rate now in force.
+inline auto observer_to_json(const ObserverOverhead &o) -> nlohmann::json {
+  return nlohmann::json{
+      {"type", "observer"},
+      {"overhead_pct", o.overhead_pct},
+      {"batcher_pct", o.batcher_pct},
+      {"server_pct", o.server_pct},
+      {"tracking_pct", o.tracking_pct},
+      {"tracking_ns_per_op", o.tracking_ns_per_op},
+      {"sampling", o.sampling},
+      {"target_pct", o.target_pct},
+      {"window_ms", o.window_ns / 1'000'000},
+  };
+}
+
+/// @brief Periodic "sub_arenas" message: one entry per live sub-arena,
+///        lowest offset first.
+inline auto sub_arenas_to_json(const std::vector<SubArenaStats> &subs)
+    -> nlohmann::json {
+  nlohmann::json j;
+  j["type"] = "sub_arenas";
+  j["sub_arenas"] = nlohmann::json::array();
+  for (const auto &s : subs) {
+    j["sub_arenas"].push_back({
+        {"name", s.name},
+        {"offset", s.offset},
+        {"capacity", s.capacity},
+        {"shard_count", s.shard_count},
+        {"ranges_per_shard", s.ranges_per_shard},
+        {"bytes_allocated", s.bytes_allocated},
+        {"bytes_free", s.bytes_free},
+        {"free_blocks", s.free_blocks},
+        {"active_blocks", s.active_blocks},
+        {"allocations", s.allocations},
+        {"deallocations", s.deallocations},
+        {"edge_allocations", s.edge_allocations},
+    });
+  }
+  return j;
+}
+
 } // namespace mmap_viz
@@ -0,0 +1,217 @@
+#pragma once
+/// @file metrics_serializer.hpp
+/// @brief Prometheus text exposition (format 0.0.4) for the /metrics
+///        endpoint.
+
+#include "interface/observer_meter.hpp"
+#include "interface/shard_lock.hpp"
+#include "interface/sub_arena.hpp"
+#include "interface/tag_quota.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mmap_viz {
+
+/// @brief Appends metric families to a Prometheus text exposition.
+class MetricsWriter {
+public:
+  /// @brief Start a metric family (`# HELP` and `# TYPE` lines).
+  void family(std::string_view name, std::string_view type,
+              std::string_view help) {
+    out_ += "# HELP ";
+    out_ += name;
+    out_ += ' ';
+    out_ += help;
+    out_ += "\n# TYPE ";
+    out_ += name;
+    out_ += ' ';
+    out_ += type;
+    out_ += '\n';
+  }
+
+  /// @brief One sample; @p labels is the inside of the braces, or empty.
+  void sample(std::string_view name, std::string_view labels, double value) {
+    out_ += name;
+    if (!labels.empty()) {
+      out_ += '{';
+      out_ += labels;
+      out_ += '}';
+    }
+    out_ += ' ';
+    out_ += number(value);
+    out_ += '\n';
+  }
+
+  /// @brief A LockHistogram as a histogram in seconds. Buckets above the
+  ///        highest non-empty one are folded into +Inf.
+  void histogram(std::string_view name, std::string_view labels,
+                 const LockHistogram &h) {
+    std::size_t last = 0;
+    for (std::size_t i = 0; i < LockHistogram::kBuckets; ++i) {
+      if (h.buckets[i] != 0) {
+        last = i;
+      }
+    }
+    std::string bucket = std::string(name) + "_bucket";
+    std::string prefix(labels);
+    if (!prefix.empty()) {
+      prefix += ',';
+    }
+    std::uint64_t cumulative = 0;
+    for (std::size_t i = 0; i <= last; ++i) {
+      cumulative += h.buckets[i];
+      double le = i == 0 ? 0.0 : LockHistogram::bucket_limit_ns(i) * 1e-9;
+      sample(bucket, prefix + "le=\"" + number(le) + "\"",
+             static_cast<double>(cumulative));
+    }
+    sample(bucket, prefix + "le=\"+Inf\"", static_cast<double>(h.count));
+    sample(std::string(name) + "_sum", labels, h.sum_ns * 1e-9);
+    sample(std::string(name) + "_count", labels,
+           static_cast<double>(h.count));
+  }
+
+  [[nodiscard]] auto str() const -> const std::string & { return out_; }
+
+private:
+  static auto number(double value) -> std::string {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.10g", value);
+    return buf;
+  }
+
+  std::string out_;
+};
+
+/// @brief Shard lock families; shards with no acquisitions are skipped.
+/// @param profiles One entry per shard, indexed by shard.
+inline void write_shard_lock_metrics(
+    MetricsWriter &w, const std::vector<ShardLockProfile> &profiles) {
+  auto label = [](std::size_t shard) {
+    return "shard=\"" + std::to_string(shard) + "\"";
+  };
+  auto counter = [&](const char *name, const char *help,
+                     std::uint64_t ShardLockProfile::*field) {
+    w.family(name, "counter", help);
+    for (std::size_t i = 0; i < profiles.size(); ++i) {
+      if (profiles[i].acquisitions != 0) {
+        w.sample(name, label(i), static_cast<double>(profiles[i].*field));
+      }
+    }
+  };
+  auto histogram = [&](const char *name, const char *help,
+                       LockHistogram ShardLockProfile::*field) {
+    w.family(name, "histogram", help);
+    for (std::size_t i = 0; i < profiles.size(); ++i) {
+      if (profiles[i].acquisitions != 0) {
+        w.histogram(name, label(i), profiles[i].*field);
+      }
+    }
+  };
+
+  counter("mmap_viz_shard_lock_acquisitions_total",
+          "Shard lock acquisitions on the allocation paths.",
+          &ShardLockProfile::acquisitions);
+  counter("mmap_viz_shard_lock_contended_total",
+          "Shard lock acquisitions that found the lock held.",
+          &ShardLockProfile::contended);
+  counter("mmap_viz_shard_lock_remote_total",
+          "Shard lock acquisitions by threads homed on another shard "
+          "(cross-thread frees).",
+          &ShardLockProfile::remote);
+  histogram("mmap_viz_shard_lock_wait_seconds",
+            "Time spent acquiring the shard lock.",
+            &ShardLockProfile::wait_ns);
+  histogram("mmap_viz_shard_lock_hold_seconds",
+            "Time the shard lock was held (sampled).",
+            &ShardLockProfile::hold_ns);
+}
+
+/// @brief Observer overhead gauges for the last closed window.
+inline void write_observer_metrics(MetricsWriter &w,
+                                   const ObserverOverhead &o) {
+  w.family("mmap_viz_observer_overhead_percent", "gauge",
+           "Instrumentation CPU time as a share of process CPU time.");
+  w.sample("mmap_viz_observer_overhead_percent", "component=\"batcher\"",
+           o.batcher_pct);
+  w.sample("mmap_viz_observer_overhead_percent", "component=\"server\"",
+           o.server_pct);
+  w.sample("mmap_viz_observer_overhead_percent", "component=\"tracking\"",
+           o.tracking_pct);
+  w.family("mmap_viz_observer_sampling", "gauge",
+           "Event sampling rate in force (1 = every event).");
+  w.sample("mmap_viz_observer_sampling", "", static_cast<double>(o.sampling));
+}
+
+/// @brief `name="value"`, with the value escaped for the exposition.
+inline auto metric_label(std::string_view name, std::string_view value)
+    -> std::string {
+  std::string out(name);
+  out += "=\"";
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      out += '\\';
+      out += c;
+    } else if (c == '\n') {
+      out += "\\n";
+    } else {
+      out += c;
+    }
+  }
+  return out + '"';
+}
+
+/// @brief Tag quota families, labelled by prefix; nothing if none are set.
+inline void write_quota_metrics(MetricsWriter &w,
+                                const std::vector<TagQuotaStats> &quotas) {
+  if (quotas.empty()) {
+    return;
+  }
+  auto label = [](std::string_view prefix) {
+    return metric_label("prefix", prefix);
+  };
+  w.family("mmap_viz_tag_quota_limit_bytes", "gauge",
+           "Byte limit of a tag prefix quota.");
+  for (const auto &q : quotas) {
+    w.sample("mmap_viz_tag_quota_limit_bytes", label(q.prefix),
+             static_cast<double>(q.limit_bytes));
+  }
+  w.family("mmap_viz_tag_quota_bytes", "gauge",
+           "Live block bytes charged to a tag prefix quota.");
+  for (const auto &q : quotas) {
+    w.sample("mmap_viz_tag_quota_bytes", label(q.prefix),
+             static_cast<double>(q.bytes_in_use));
+  }
+  w.family("mmap_viz_tag_quota_hits_total", "counter",
+           "Allocations a tag prefix quota refused.");
+  for (const auto &q : quotas) {
+    w.sample("mmap_viz_tag_quota_hits_total", label(q.prefix),
+             static_cast<double>(q.hits));
+  }
+}
+
+/// @brief Sub-arena families, labelled by name; nothing without any.
+inline void write_sub_arena_metrics(MetricsWriter &w,
+                                    const std::vector<SubArenaStats> &subs) {
+  if (subs.empty()) {
+    return;
+  }
+  w.family("mmap_viz_sub_arena_capacity_bytes", "gauge",
+           "Bytes delegated to a sub-arena.");
+  for (const auto &s : subs) {
+    w.sample("mmap_viz_sub_arena_capacity_bytes",
+             metric_label("name", s.name), static_cast<double>(s.capacity));
+  }
+  w.family("mmap_viz_sub_arena_allocated_bytes", "gauge",
+           "Bytes handed out by a sub-arena (included in the arena's).");
+  for (const auto &s : subs) {
+    w.sample("mmap_viz_sub_arena_allocated_bytes",
+             metric_label("name", s.name),
+             static_cast<double>(s.bytes_allocated));
+  }
+}
+
+} // namespace mmap_viz
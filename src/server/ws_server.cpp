@@ -15,18 +15,22 @@ namespace mmap_viz {
 
 WsSession::WsSession(tcp::socket socket, std::string web_root,
                      CommandHandler on_command,
-                     SnapshotProvider snapshot_provider)
+                     SnapshotProvider snapshot_provider,
+                     MetricsProvider metrics_provider)
     : ws_{std::move(socket)}, web_root_{std::move(web_root)},
       on_command_{std::move(on_command)},
-      snapshot_provider_{std::move(snapshot_provider)} {}
+      snapshot_provider_{std::move(snapshot_provider)},
+      metrics_provider_{std::move(metrics_provider)} {}
 
 void WsSession::run() {
   // Read the initial HTTP request to decide: WebSocket upgrade or static file.
   http::async_read(
       ws_.next_layer(), buffer_, req_,
       [self = shared_from_this()](beast::error_code ec, std::size_t) {
-        if (ec)
+        if (ec) {
+          self->finished_ = true;
           return;
+        }
 
         // Check if this is a WebSocket upgrade request.
         if (ws::is_upgrade(self->req_)) {
@@ -40,8 +44,10 @@ void WsSession::run() {
 }
 
 void WsSession::on_accept(beast::error_code ec) {
-  if (ec)
+  if (ec) {
+    finished_ = true;
     return;
+  }
   is_websocket_ = true;
 
   // Send snapshot immediately after handshake
@@ -61,10 +67,11 @@ void WsSession::do_read() {
 
 void WsSession::on_read(beast::error_code ec,
                         std::size_t /*bytes_transferred*/) {
-  if (ec == ws::error::closed)
-    return;
-  if (ec)
+  if (ec) {
+    // Includes ws::error::closed (clean close by the peer).
+    finished_ = true;
     return;
+  }
 
   // Forward client messages to the command handler.
   if (on_command_) {
@@ -87,6 +94,9 @@ void WsSession::send(std::string message) {
     beast::error_code ec;
     self->ws_.text(true);
     self->ws_.write(net::buffer(*msg), ec);
+    if (ec) {
+      self->finished_ = true;
+    }
   });
 }
 
@@ -94,12 +104,15 @@ auto WsSession::is_open() const -> bool {
   return is_websocket_ && ws_.is_open();
 }
 
+auto WsSession::is_finished() const -> bool { return finished_; }
+
 void WsSession::handle_http_request(http::request<http::string_body> req) {
   auto target = std::string(req.target());
   if (target == "/")
     target = "/index.html";
 
-  auto response = serve_file(target);
+  auto response =
+      target == "/metrics" ? serve_metrics() : serve_file(target);
   response.set(http::field::server, "MemoryMapper/0.1");
   // Force close — we don't loop to handle additional HTTP requests on this
   // connection.  Without this, the browser thinks the socket is still
@@ -109,6 +122,7 @@ void WsSession::handle_http_request(http::request<http::string_body> req) {
 
   beast::error_code ec;
   http::write(ws_.next_layer(), response, ec);
+  finished_ = true;
 }
 
 auto WsSession::serve_file(const std::string &path)
@@ -134,6 +148,18 @@ auto WsSession::serve_file(const std::string &path)
   return res;
 }
 
+auto WsSession::serve_metrics() -> http::response<http::string_body> {
+  if (!metrics_provider_) {
+    return serve_file("/metrics");
+  }
+  http::response<http::string_body> res{http::status::ok, 11};
+  // Prometheus text exposition format.
+  res.set(http::field::content_type, "text/plain; version=0.0.4");
+  res.set(http::field::access_control_allow_origin, "*");
+  res.body() = metrics_provider_();
+  return res;
+}
+
 auto WsSession::mime_type(const std::string &path) -> std::string {
   auto ext = std::filesystem::path(path).extension().string();
   if (ext == ".html")
@@ -181,7 +207,8 @@ void WsServer::do_accept() {
       return;
 
     auto session = std::make_shared<WsSession>(
-        std::move(socket), web_root_, command_handler_, snapshot_provider_);
+        std::move(socket), web_root_, command_handler_, snapshot_provider_,
+        metrics_provider_);
 
     {
       std::lock_guard lock(sessions_mutex_);
@@ -199,8 +226,10 @@ void WsServer::do_accept() {
 void WsServer::broadcast(const std::string &message) {
   std::lock_guard lock(sessions_mutex_);
 
-  // Remove dead sessions.
-  std::erase_if(sessions_, [](const auto &s) { return !s->is_open(); });
+  // Remove dead sessions. Sessions still in their HTTP upgrade handshake
+  // are not open yet but must be kept, or clients that connect while
+  // events are flowing would never receive anything.
+  std::erase_if(sessions_, [](const auto &s) { return s->is_finished(); });
 
   for (auto &session : sessions_) {
     session->send(message);
@@ -215,6 +244,10 @@ void WsServer::set_command_handler(CommandHandler handler) {
   command_handler_ = std::move(handler);
 }
 
+void WsServer::set_metrics_provider(MetricsProvider provider) {
+  metrics_provider_ = std::move(provider);
+}
+
 auto WsServer::get_io_context() -> net::io_context & { return ioc_; }
 
 } // namespace mmap_viz
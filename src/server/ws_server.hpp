@@ -7,6 +7,7 @@
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -27,12 +28,16 @@ using SnapshotProvider = std::function<std::string()>;
 /// @brief Callback invoked when a WebSocket client sends a text message.
 using CommandHandler = std::function<void(const std::string &)>;
 
+/// @brief Callback producing the Prometheus text served on GET /metrics.
+using MetricsProvider = std::function<std::string()>;
+
 /// @brief A single WebSocket session (one connected browser client).
 class WsSession : public std::enable_shared_from_this<WsSession> {
 public:
   explicit WsSession(tcp::socket socket, std::string web_root,
                      CommandHandler on_command,
-                     SnapshotProvider snapshot_provider);
+                     SnapshotProvider snapshot_provider,
+                     MetricsProvider metrics_provider = nullptr);
 
   /// @brief Start the session: read HTTP upgrade request,
   ///        serve static files, or upgrade to WebSocket.
@@ -44,21 +49,29 @@ public:
   /// @brief Check if the session is still alive.
   [[nodiscard]] auto is_open() const -> bool;
 
+  /// @brief True once the session has ended (handshake failed, the socket
+  ///        closed, or a plain HTTP request was served). A session that is
+  ///        still handshaking is neither open nor finished.
+  [[nodiscard]] auto is_finished() const -> bool;
+
 private:
   void on_accept(beast::error_code ec);
   void do_read();
   void on_read(beast::error_code ec, std::size_t bytes_transferred);
   void handle_http_request(http::request<http::string_body> req);
   auto serve_file(const std::string &path) -> http::response<http::string_body>;
+  auto serve_metrics() -> http::response<http::string_body>;
   auto mime_type(const std::string &path) -> std::string;
 
   beast::flat_buffer buffer_;
   ws::stream<beast::tcp_stream> ws_;
   http::request<http::string_body> req_;
-  bool is_websocket_ = false;
+  std::atomic<bool> is_websocket_{false};
+  std::atomic<bool> finished_{false};
   std::string web_root_;
   CommandHandler on_command_;
   SnapshotProvider snapshot_provider_;
+  MetricsProvider metrics_provider_;
 };
 
 /// @brief WebSocket + HTTP server that broadcasts AllocationEvents to all
@@ -88,6 +101,9 @@ public:
   /// @brief Set the command handler for incoming WebSocket messages.
   void set_command_handler(CommandHandler handler);
 
+  /// @brief Set the provider behind GET /metrics (404 while unset).
+  void set_metrics_provider(MetricsProvider provider);
+
   /// @brief Get the io_context (for posting work from other threads).
   auto get_io_context() -> net::io_context &;
 
@@ -102,6 +118,7 @@ private:
   std::mutex sessions_mutex_;
   std::vector<std::shared_ptr<WsSession>> sessions_;
   CommandHandler command_handler_;
+  MetricsProvider metrics_provider_;
 };
 
 } // namespace mmap_viz
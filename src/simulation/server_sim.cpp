@@ -31,8 +31,66 @@ auto rand_between(std::size_t lo, std::size_t hi) -> std::size_t {
 
 // ─── ServerSim ──────────────────────────────────────────────────────────
 
-ServerSim::ServerSim(VisualizationArena &arena, ServerConfig cfg) noexcept
-    : arena_{arena}, cfg_{cfg} {}
+ServerSim::ServerSim(VisualizationArena &arena, ServerConfig cfg)
+    : arena_{arena}, cfg_{cfg} {
+  if (!cfg_.shed_streams)
+    return;
+
+  // Requests are served from one thread, so its shard is the one that
+  // fills up.
+  pressure_watch_ = arena_.on_shard_pressure(
+      Watermarks{.low = 0.75, .critical = 0.90},
+      [this](const PressureEvent &e) {
+        if (e.level == PressureLevel::kCritical) {
+          std::lock_guard lock(streams_mutex_);
+          ++shedding_.critical_events;
+        } else if (e.level == PressureLevel::kLow &&
+                   e.previous == PressureLevel::kNormal) {
+          std::lock_guard lock(streams_mutex_);
+          ++shedding_.low_events;
+        } else {
+          return; // Pressure easing.
+        }
+        std::size_t count = 0;
+        {
+          std::lock_guard lock(streams_mutex_);
+          count = e.level == PressureLevel::kCritical
+                      ? stream_buffers_.size()
+                      : stream_buffers_.size() / 2;
+        }
+        shed_streams(count, SIZE_MAX);
+      });
+  arena_.set_reclaim_handler([this](std::size_t bytes) {
+    {
+      std::lock_guard lock(streams_mutex_);
+      ++shedding_.oom_reclaims;
+    }
+    return shed_streams(SIZE_MAX, bytes) > 0;
+  });
+}
+
+ServerSim::~ServerSim() {
+  if (pressure_watch_ != 0) {
+    arena_.remove_pressure_callback(pressure_watch_);
+    arena_.set_reclaim_handler(nullptr);
+  }
+}
+
+auto ServerSim::shed_streams(std::size_t count, std::size_t bytes)
+    -> std::size_t {
+  std::lock_guard lock(streams_mutex_);
+  std::size_t freed = 0;
+  for (std::size_t i = 0;
+       i < count && freed < bytes && !stream_buffers_.empty(); ++i) {
+    auto [ptr, size] = stream_buffers_.front();
+    stream_buffers_.pop_front();
+    arena_.dealloc_raw(ptr, size);
+    freed += size;
+    ++shedding_.streams_shed;
+  }
+  shedding_.bytes_shed += freed;
+  return freed;
+}
 
 auto ServerSim::response_size_for(const Request &req) const -> std::size_t {
   switch (req.type) {
@@ -62,17 +120,18 @@ auto ServerSim::handle_request(const Request &req) -> Response {
     std::snprintf(tag_buf, sizeof(tag_buf), "%s %s #%llu [req]",
                   to_string(req.type), req.endpoint.c_str(),
                   static_cast<unsigned long long>(req.id));
-    req_buf = arena_.alloc_raw(req.payload_size, 16, tag_buf);
-    if (req_buf == nullptr) {
-      // Arena OOM — record failure.
+    auto buf = arena_.try_alloc_raw(req.payload_size, 16, tag_buf);
+    if (!buf.has_value()) {
+      // Arena OOM or over quota — record failure.
       const auto latency = Clock::now() - t0;
       metrics_.record(latency, req.payload_size, 0, false);
       return Response{
           .request_id = req.id,
-          .status = StatusCode::OutOfMemory,
+          .status = failure_status(req, buf.error()),
           .body_size = 0,
       };
     }
+    req_buf = *buf;
     // Simulate writing payload into the buffer.
     std::memset(req_buf, 0xAA, req.payload_size);
   }
@@ -82,8 +141,8 @@ auto ServerSim::handle_request(const Request &req) -> Response {
   std::snprintf(tag_buf, sizeof(tag_buf), "%s %s #%llu [resp]",
                 to_string(req.type), req.endpoint.c_str(),
                 static_cast<unsigned long long>(req.id));
-  void *resp_buf = arena_.alloc_raw(resp_size, 16, tag_buf);
-  if (resp_buf == nullptr) {
+  auto resp = arena_.try_alloc_raw(resp_size, 16, tag_buf);
+  if (!resp.has_value()) {
     // Free request buffer if allocated, then fail.
     if (req_buf != nullptr) {
       arena_.dealloc_raw(req_buf, req.payload_size);
@@ -92,10 +151,11 @@ auto ServerSim::handle_request(const Request &req) -> Response {
     metrics_.record(latency, req.payload_size, 0, false);
     return Response{
         .request_id = req.id,
-        .status = StatusCode::OutOfMemory,
+        .status = failure_status(req, resp.error()),
         .body_size = 0,
     };
   }
+  void *resp_buf = *resp;
 
   // 3. Simulate processing — write response data.
   std::memset(resp_buf, 0xBB, resp_size);
@@ -114,6 +174,7 @@ auto ServerSim::handle_request(const Request &req) -> Response {
   // 6. For STREAM requests, keep the response buffer alive.
   //    For all others, free it immediately (short-lived).
   if (req.type == RequestType::STREAM) {
+    std::lock_guard lock(streams_mutex_);
     stream_buffers_.emplace_back(resp_buf, resp_size);
   } else {
     arena_.dealloc_raw(resp_buf, resp_size);
@@ -130,13 +191,36 @@ auto ServerSim::handle_request(const Request &req) -> Response {
   };
 }
 
+auto ServerSim::failure_status(const Request &req, AllocFailure failure)
+    -> StatusCode {
+  if (failure == AllocFailure::kOutOfMemory) {
+    return StatusCode::OutOfMemory;
+  }
+  std::string endpoint = to_string(req.type);
+  endpoint += ' ';
+  endpoint += req.endpoint;
+  ++quota_hits_[endpoint];
+  return StatusCode::TooManyRequests;
+}
+
 void ServerSim::cleanup_streams() {
+  std::lock_guard lock(streams_mutex_);
   for (auto &[ptr, size] : stream_buffers_) {
     arena_.dealloc_raw(ptr, size);
   }
   stream_buffers_.clear();
 }
 
+auto ServerSim::shedding_stats() const -> SheddingStats {
+  std::lock_guard lock(streams_mutex_);
+  return shedding_;
+}
+
+auto ServerSim::quota_hits() const
+    -> const std::map<std::string, std::uint64_t> & {
+  return quota_hits_;
+}
+
 auto ServerSim::metrics() const -> const MetricsCollector & { return metrics_; }
 
 auto ServerSim::metrics() -> MetricsCollector & { return metrics_; }
@@ -10,8 +10,11 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <string>
-#include <vector>
+#include <utility>
 
 namespace mmap_viz::sim {
 
@@ -47,6 +50,7 @@ enum class RequestType : std::uint8_t {
 enum class StatusCode : std::uint16_t {
   Ok = 200,
   NotFound = 404,
+  TooManyRequests = 429, ///< Refused by a tag quota.
   ServerError = 500,
   OutOfMemory = 503,
 };
@@ -73,6 +77,19 @@ struct ServerConfig {
   /// Simulate processing latency (microseconds) per request type.
   /// If 0, no artificial delay is added.
   std::size_t base_latency_us = 0;
+  /// Treat STREAM buffers as a droppable cache: shed the oldest half at
+  /// the low watermark of the serving shard, all of them at critical,
+  /// and as many as needed when an allocation runs out of memory.
+  bool shed_streams = false;
+};
+
+/// @brief What STREAM shedding did over a run.
+struct SheddingStats {
+  std::uint64_t low_events = 0;      ///< Low watermark crossings.
+  std::uint64_t critical_events = 0; ///< Critical watermark crossings.
+  std::uint64_t oom_reclaims = 0;    ///< Reclaim-and-retry runs on OOM.
+  std::uint64_t streams_shed = 0;    ///< STREAM buffers dropped.
+  std::size_t bytes_shed = 0;        ///< Bytes of those buffers.
 };
 
 /// @brief Simulated request/response server backed by VisualizationArena.
@@ -86,7 +103,11 @@ public:
   /// @brief Construct a server simulation.
   /// @param arena  Reference to the backing VisualizationArena.
   /// @param cfg    Server configuration.
-  explicit ServerSim(VisualizationArena &arena, ServerConfig cfg = {}) noexcept;
+  explicit ServerSim(VisualizationArena &arena, ServerConfig cfg = {});
+  ~ServerSim();
+
+  ServerSim(const ServerSim &) = delete;
+  ServerSim &operator=(const ServerSim &) = delete;
 
   /// @brief Process a single request.
   /// @param req The inbound request.
@@ -96,6 +117,13 @@ public:
   /// @brief Free all outstanding STREAM buffers.
   void cleanup_streams();
 
+  /// @brief Requests refused by a tag quota, keyed by "METHOD /endpoint".
+  [[nodiscard]] auto quota_hits() const
+      -> const std::map<std::string, std::uint64_t> &;
+
+  /// @brief STREAM shedding counters (all zero unless cfg.shed_streams).
+  [[nodiscard]] auto shedding_stats() const -> SheddingStats;
+
   /// @brief Access the metrics collector.
   [[nodiscard]] auto metrics() const -> const MetricsCollector &;
   [[nodiscard]] auto metrics() -> MetricsCollector &;
@@ -104,12 +132,26 @@ private:
   /// @brief Determine response size based on request type.
   [[nodiscard]] auto response_size_for(const Request &req) const -> std::size_t;
 
+  /// @brief Status for a failed allocation; counts quota refusals.
+  auto failure_status(const Request &req, AllocFailure failure)
+      -> StatusCode;
+
+  /// @brief Free the oldest STREAM buffers until @p count are gone or
+  ///        @p bytes have been freed, whichever comes first.
+  /// @return Bytes freed.
+  auto shed_streams(std::size_t count, std::size_t bytes) -> std::size_t;
+
   VisualizationArena &arena_;
   ServerConfig cfg_;
   MetricsCollector metrics_;
 
-  /// Outstanding STREAM allocations (ptr → size).
-  std::vector<std::pair<void *, std::size_t>> stream_buffers_;
+  /// Outstanding STREAM allocations (ptr → size), oldest first. Shedding
+  /// runs on the arena's reclaim thread, hence the mutex.
+  mutable std::mutex streams_mutex_;
+  std::deque<std::pair<void *, std::size_t>> stream_buffers_;
+  SheddingStats shedding_;
+  std::size_t pressure_watch_ = 0; ///< 0 = none registered.
+  std::map<std::string, std::uint64_t> quota_hits_;
 };
 
 } // namespace mmap_viz::sim
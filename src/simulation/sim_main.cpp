@@ -33,6 +33,9 @@ struct SimArgs {
   bool show_progress = true;
   std::size_t interval_us = 100; // Default 100us
   std::size_t sampling = 1;      // Default 1 (no sampling)
+  double overhead_target = 0;    // Observer overhead target %, 0 = off
+  bool shed_streams = false;     // Drop STREAM buffers under pressure
+  std::vector<TagQuota> quotas;  // --quota PREFIX=KB, repeatable
 };
 
 void print_usage(const char *prog) {
@@ -47,6 +50,12 @@ void print_usage(const char *prog) {
       << "  --interval-us <N>    Request interval in microseconds (default: "
          "100)\n"
       << "  --sampling <N>       Event sampling rate (default: 1)\n"
+      << "  --overhead-target <P> Raise sampling at runtime to keep the "
+         "observer\n"
+      << "                       under P % of CPU (default: 0 = off)\n"
+      << "  --shed-streams       Drop STREAM buffers under memory pressure\n"
+      << "  --quota <PREFIX=KB>  Cap live bytes of tags starting with PREFIX,\n"
+      << "                       e.g. \"STREAM=512\" (repeatable)\n"
       << "  --server             Enable WebSocket visualization server\n"
       << "  --port <N>           Server port (default: 8080)\n"
       << "  --no-progress        Disable progress output\n"
@@ -96,6 +105,21 @@ auto parse_args(int argc, char *argv[]) -> SimArgs {
       args.interval_us = std::stoull(argv[++i]);
     } else if (arg == "--sampling" && i + 1 < argc) {
       args.sampling = std::stoull(argv[++i]);
+    } else if (arg == "--overhead-target" && i + 1 < argc) {
+      args.overhead_target = std::stod(argv[++i]);
+    } else if (arg == "--shed-streams") {
+      args.shed_streams = true;
+    } else if (arg == "--quota" && i + 1 < argc) {
+      std::string spec = argv[++i];
+      auto eq = spec.rfind('=');
+      if (eq == std::string::npos) {
+        std::cerr << "ERROR: --quota expects PREFIX=KB, got " << spec << '\n';
+        std::exit(1);
+      }
+      args.quotas.push_back(TagQuota{
+          .prefix = spec.substr(0, eq),
+          .limit_bytes = std::stoull(spec.substr(eq + 1)) * 1024,
+      });
     } else if (arg == "--server") {
       args.enable_server = true;
     } else if (arg == "--port" && i + 1 < argc) {
@@ -111,7 +135,8 @@ auto parse_args(int argc, char *argv[]) -> SimArgs {
 
 void print_separator() { std::cout << std::string(60, '=') << '\n'; }
 
-void print_report(const RequestMetrics &m, const VisualizationArena &arena) {
+void print_report(const RequestMetrics &m, const VisualizationArena &arena,
+                  const ServerSim &server, bool shed_streams) {
   std::cout << '\n';
   print_separator();
   std::cout << "  SERVER SIMULATION RESULTS\n";
@@ -166,6 +191,45 @@ void print_report(const RequestMetrics &m, const VisualizationArena &arena) {
             << "    Cache Lines: " << cache.active_lines << " active / "
             << cache.total_lines << " total\n";
 
+  // Instrumentation cost (measured by the batcher, so server runs only).
+  auto observer = arena.observer_overhead();
+  if (observer.window_ns != 0) {
+    std::cout << std::setprecision(2);
+    std::cout << "\n  Observer (last window)\n"
+              << "    Overhead:    " << observer.overhead_pct << " %\n"
+              << "    Batcher:     " << observer.batcher_pct << " %\n"
+              << "    Server:      " << observer.server_pct << " %\n"
+              << "    Tracking:    " << observer.tracking_pct << " % ("
+              << std::setprecision(0) << observer.tracking_ns_per_op
+              << " ns/op)\n"
+              << "    Sampling:    1/" << observer.sampling << '\n';
+  }
+
+  auto quotas = arena.quota_stats();
+  if (!quotas.empty()) {
+    std::cout << "\n  Quotas\n";
+    for (const auto &q : quotas) {
+      std::cout << "    \"" << q.prefix << "\": " << q.limit_bytes / 1024
+                << " KB limit, " << q.hits << " hits\n";
+    }
+    for (const auto &[endpoint, hits] : server.quota_hits()) {
+      std::cout << "    " << std::left << std::setw(24) << endpoint
+                << std::right << hits << " refused\n";
+    }
+  }
+
+  if (shed_streams) {
+    auto pressure = arena.pressure_stats();
+    auto shed = server.shedding_stats();
+    std::cout << "\n  Pressure\n"
+              << "    Level Chg:   " << pressure.level_changes << " ("
+              << shed.low_events << " low, " << shed.critical_events
+              << " critical)\n"
+              << "    OOM Reclaim: " << shed.oom_reclaims << '\n'
+              << "    Shed:        " << shed.streams_shed << " streams, "
+              << shed.bytes_shed / 1024 << " KB\n";
+  }
+
   print_separator();
   std::cout << std::endl;
 }
@@ -187,6 +251,10 @@ int main(int argc, char *argv[]) {
     if (args.sampling > 1) {
       std::cout << "  Sampling:   1/" << args.sampling << " events\n";
     }
+    if (args.overhead_target > 0) {
+      std::cout << "  Target:     " << args.overhead_target
+                << " % observer overhead\n";
+    }
   }
   std::cout << '\n';
 
@@ -196,6 +264,8 @@ int main(int argc, char *argv[]) {
       .enable_server = args.enable_server,
       .port = args.port,
       .sampling = args.sampling,
+      .overhead_target_pct = args.overhead_target,
+      .tag_quotas = args.quotas,
   });
 
   if (!arena_result.has_value()) {
@@ -207,7 +277,7 @@ int main(int argc, char *argv[]) {
   auto arena = std::move(*arena_result);
 
   // 2. Create the server.
-  ServerSim server{arena};
+  ServerSim server{arena, {.shed_streams = args.shed_streams}};
 
   // 3. Create the request generator.
   RequestGenerator generator{{
@@ -237,7 +307,7 @@ int main(int argc, char *argv[]) {
 
   // 6. Print results.
   auto metrics = server.metrics().snapshot();
-  print_report(metrics, arena);
+  print_report(metrics, arena, server, args.shed_streams);
 
   // 7. If server is running, keep alive for inspection.
   if (args.enable_server) {
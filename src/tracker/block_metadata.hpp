@@ -36,10 +36,30 @@ struct AllocationHeader {
   static constexpr std::size_t kMagicValue = 0xAC1DCAFEDEADBEEF;
 };
 
+/// @brief Distance from a tracked block's start to the user pointer:
+///        AllocationHeader and the uint32 footer that points back to it,
+///        padded so the user pointer meets @p alignment.
+[[nodiscard]] constexpr auto user_offset(std::size_t alignment)
+    -> std::size_t {
+  std::size_t base_overhead = sizeof(AllocationHeader) + sizeof(std::uint32_t);
+  std::size_t padding = 0;
+  if (alignment > 0) {
+    std::size_t remainder = base_overhead % alignment;
+    if (remainder != 0) {
+      padding = alignment - remainder;
+    }
+  }
+  return base_overhead + padding;
+}
+
 /// @brief Type of allocation event.
 enum class EventType : std::uint8_t {
   Allocate,
   Deallocate,
+  Occupancy, ///< Bytes in use inside a block owned by a sub-allocator.
+  OverflowAllocate,   ///< Served by the upstream resource (arena full).
+  OverflowDeallocate, ///< Free of an OverflowAllocate block.
+  QuotaExceeded,      ///< Refused by a tag quota; nothing was allocated.
 };
 
 /// @brief A recorded allocation or deallocation event with aggregate stats.
@@ -56,10 +56,29 @@ class LocalTracker {
 public:
   explicit LocalTracker(FreeListAllocator &allocator,
                         std::size_t sampling = 1) noexcept
-      : allocator_{allocator}, sampling_{sampling} {}
+      : allocator_{allocator}, fixed_sampling_{sampling},
+        sampling_{&fixed_sampling_} {}
+
+  /// @brief Follow a sampling rate that another thread may change at
+  ///        runtime (the arena's ObserverMeter).
+  LocalTracker(FreeListAllocator &allocator,
+               const std::atomic<std::size_t> &sampling) noexcept
+      : allocator_{allocator}, sampling_{&sampling} {}
+
+  /// @brief Whether sampling keeps the next event. Lets a hot path skip
+  ///        building the metadata of a dropped event; it calls skip()
+  ///        instead of record_*() then.
+  [[nodiscard]] auto next_sampled() const noexcept -> bool {
+    return (next_event_id_ + 1) %
+               sampling_->load(std::memory_order_relaxed) ==
+           0;
+  }
+
+  /// @brief Count an event that sampling drops without recording it.
+  void skip() noexcept { ++next_event_id_; }
 
   void record_alloc(BlockMetadata block) {
-    if (++next_event_id_ % sampling_ != 0)
+    if (sampled_out())
       return;
 
     AllocationEvent event{
@@ -75,7 +94,7 @@ public:
   }
 
   void record_dealloc(std::size_t offset, std::size_t size) {
-    if (++next_event_id_ % sampling_ != 0)
+    if (sampled_out())
       return;
 
     BlockMetadata block{
@@ -95,6 +114,57 @@ public:
     event_buffer_.push(std::move(event));
   }
 
+  /// @brief Report the bytes in use inside a sub-allocator's block.
+  ///
+  /// Producers rate-limit these themselves, so they bypass sampling.
+  void record_occupancy(BlockMetadata block) {
+    AllocationEvent event{
+        .type = EventType::Occupancy,
+        .block = std::move(block),
+        .event_id = ++next_event_id_,
+        .total_allocated = allocator_.bytes_allocated(),
+        .total_free = allocator_.bytes_free(),
+        .fragmentation_pct = 0,
+        .free_block_count = allocator_.free_block_count(),
+    };
+    event_buffer_.push(std::move(event));
+  }
+
+  /// @brief Record an allocation or free served by the overflow upstream.
+  /// @param type  EventType::OverflowAllocate or OverflowDeallocate.
+  void record_overflow(EventType type, BlockMetadata block) {
+    if (sampled_out())
+      return;
+
+    AllocationEvent event{
+        .type = type,
+        .block = std::move(block),
+        .event_id = next_event_id_,
+        .total_allocated = allocator_.bytes_allocated(),
+        .total_free = allocator_.bytes_free(),
+        .fragmentation_pct = 0,
+        .free_block_count = allocator_.free_block_count(),
+    };
+    event_buffer_.push(std::move(event));
+  }
+
+  /// @brief Record an allocation a tag quota refused. Offset is 0.
+  void record_quota_exceeded(BlockMetadata block) {
+    if (sampled_out())
+      return;
+
+    AllocationEvent event{
+        .type = EventType::QuotaExceeded,
+        .block = std::move(block),
+        .event_id = next_event_id_,
+        .total_allocated = allocator_.bytes_allocated(),
+        .total_free = allocator_.bytes_free(),
+        .fragmentation_pct = 0,
+        .free_block_count = allocator_.free_block_count(),
+    };
+    event_buffer_.push(std::move(event));
+  }
+
   // Drain events into a vector (called by server thread)
   void drain_to(std::vector<AllocationEvent> &out) {
     AllocationEvent evt;
@@ -104,9 +174,15 @@ public:
   }
 
 private:
+  /// @brief Number the next event; true if sampling drops it.
+  auto sampled_out() noexcept -> bool {
+    return ++next_event_id_ % sampling_->load(std::memory_order_relaxed) != 0;
+  }
+
   FreeListAllocator &allocator_;
   RingBuffer<AllocationEvent, 4096> event_buffer_; // 4K events per thread
-  std::size_t sampling_;
+  std::atomic<std::size_t> fixed_sampling_{1};
+  const std::atomic<std::size_t> *sampling_;
   std::size_t next_event_id_ = 0;
 };
 
@@ -0,0 +1,136 @@
+/// @file preload_probe.cpp
+/// @brief Small program run under LD_PRELOAD=libmmap_viz_preload.so by
+///        test_preload.cpp.
+///
+/// Uses every interposed entry point the way ordinary code does (C calls,
+/// C++ containers, several threads), checks the results, and prints the
+/// interposer's counters as `key=value` lines. Exits non-zero if any check
+/// fails.
+
+#include "preload/malloc_interposer.hpp"
+
+#include <dlfcn.h>
+#include <malloc.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+  if (!ok) {
+    std::fprintf(stderr, "FAILED: %s\n", what);
+    ++failures;
+  }
+}
+
+auto aligned_to(const void *ptr, std::size_t alignment) -> bool {
+  return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+void exercise_c_api() {
+  auto *bytes = static_cast<unsigned char *>(std::malloc(100));
+  check(bytes != nullptr, "malloc");
+  check(aligned_to(bytes, alignof(std::max_align_t)), "malloc alignment");
+  std::memset(bytes, 0xAB, 100);
+  check(malloc_usable_size(bytes) >= 100, "malloc_usable_size");
+
+  bytes = static_cast<unsigned char *>(std::realloc(bytes, 4000));
+  check(bytes != nullptr && bytes[0] == 0xAB && bytes[99] == 0xAB,
+        "realloc keeps contents");
+  std::free(bytes);
+
+  auto *zeros = static_cast<unsigned char *>(std::calloc(64, 16));
+  bool all_zero = zeros != nullptr;
+  for (int i = 0; all_zero && i < 64 * 16; ++i) {
+    all_zero = zeros[i] == 0;
+  }
+  check(all_zero, "calloc zero-fills");
+  std::free(zeros);
+
+  void *p = nullptr;
+  check(posix_memalign(&p, 256, 1000) == 0 && aligned_to(p, 256),
+        "posix_memalign");
+  std::free(p);
+  check(posix_memalign(&p, 3, 16) == EINVAL, "posix_memalign rejects 3");
+
+  p = std::aligned_alloc(64, 640);
+  check(p != nullptr && aligned_to(p, 64), "aligned_alloc");
+  std::free(p);
+
+  p = memalign(4096, 100);
+  check(p != nullptr && aligned_to(p, 4096), "memalign");
+  std::free(p);
+
+  std::free(nullptr);
+  check(std::realloc(std::malloc(8), 0) == nullptr, "realloc to 0 frees");
+}
+
+void exercise_cpp() {
+  std::map<int, std::string> m;
+  for (int i = 0; i < 2000; ++i) {
+    m.emplace(i, std::string(static_cast<std::size_t>(i % 97), 'x'));
+  }
+  check(m.size() == 2000 && m[1000].size() == 1000 % 97, "std::map");
+
+  std::vector<std::thread> threads;
+  std::vector<int> ok(4, 0);
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&ok, t] {
+      std::vector<std::vector<int>> live;
+      for (int i = 0; i < 5000; ++i) {
+        live.emplace_back(static_cast<std::size_t>(i % 64 + 1), i);
+        if (live.size() > 128) {
+          live.erase(live.begin());
+        }
+      }
+      ok[static_cast<std::size_t>(t)] = live.back().front() == 4999;
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  for (int v : ok) {
+    check(v == 1, "threaded churn");
+  }
+}
+
+} // namespace
+
+int main() {
+  exercise_c_api();
+  exercise_cpp();
+
+  using StatsFn = void (*)(MmapVizPreloadStats *);
+  auto stats_fn = reinterpret_cast<StatsFn>(
+      ::dlsym(RTLD_DEFAULT, "mmap_viz_preload_stats"));
+  std::printf("preloaded=%d\n", stats_fn != nullptr ? 1 : 0);
+  if (stats_fn != nullptr) {
+    MmapVizPreloadStats stats{};
+    stats_fn(&stats);
+
+    using OwnsFn = int (*)(const void *);
+    auto owns_fn = reinterpret_cast<OwnsFn>(
+        ::dlsym(RTLD_DEFAULT, "mmap_viz_preload_owns"));
+    void *probe = std::malloc(32);
+    std::printf("ready=%d\n", stats.ready);
+    std::printf("arena_bytes=%zu\n", stats.arena_bytes);
+    std::printf("owns_malloc=%d\n", owns_fn != nullptr && owns_fn(probe));
+    std::printf("passthrough_allocs=%llu\n",
+                static_cast<unsigned long long>(stats.passthrough_allocs));
+    std::printf("overflow_allocs=%llu\n",
+                static_cast<unsigned long long>(stats.overflow_allocs));
+    std::free(probe);
+  }
+  std::printf("failures=%d\n", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+/// @file test_btree_free_index.cpp
+/// @brief Unit tests for BTreeFreeIndex and BTreeAllocator.
+
+#include "allocator/arena.hpp"
+#include "allocator/btree_allocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+using namespace mmap_viz;
+using Extent = BTreeFreeIndex::Extent;
+
+// ─── Index ──────────────────────────────────────────────────────────────
+
+TEST(BTreeFreeIndexTest, EmptyIndex) {
+  BTreeFreeIndex index;
+  EXPECT_EQ(index.size(), 0u);
+  EXPECT_EQ(index.max_size(), 0u);
+  EXPECT_FALSE(index.first_fit(1).has_value());
+  EXPECT_FALSE(index.floor(100).has_value());
+  EXPECT_FALSE(index.erase(0));
+  EXPECT_TRUE(index.verify());
+}
+
+TEST(BTreeFreeIndexTest, MatchesReferenceMap) {
+  // Random inserts, erases and resizes, checked against std::map.
+  BTreeFreeIndex index;
+  std::map<std::uint32_t, std::uint32_t> ref;
+  std::mt19937 rng(11);
+
+  auto ref_first_fit = [&](std::uint32_t size) -> std::optional<Extent> {
+    for (auto [off, len] : ref) {
+      if (len >= size) {
+        return Extent{off, len};
+      }
+    }
+    return std::nullopt;
+  };
+
+  // Slots 8 granules apart; an extent sits at a slot or one past it.
+  for (int step = 0; step < 20000; ++step) {
+    auto slot = static_cast<std::uint32_t>(rng() % 2000) * 8;
+    auto size = static_cast<std::uint32_t>(rng() % 3) + 1;
+    bool moved = ref.contains(slot + 1);
+    auto key = moved ? slot + 1 : slot;
+    bool present = ref.contains(key);
+    switch (rng() % 3) {
+    case 0:
+      if (!present) {
+        index.insert({slot, size});
+        ref[slot] = size;
+      }
+      break;
+    case 1:
+      EXPECT_EQ(index.erase(key), present);
+      ref.erase(key);
+      break;
+    default:
+      if (present && !moved) {
+        index.rekey(slot, {slot + 1, size});
+        ref.erase(slot);
+        ref[slot + 1] = size;
+      }
+      break;
+    }
+    if (step % 500 == 0) {
+      ASSERT_TRUE(index.verify()) << "step " << step;
+    }
+  }
+  ASSERT_TRUE(index.verify());
+  ASSERT_EQ(index.size(), ref.size());
+
+  for (std::uint32_t size = 1; size <= 4; ++size) {
+    auto got = index.first_fit(size);
+    auto want = ref_first_fit(size);
+    ASSERT_EQ(got.has_value(), want.has_value());
+    if (got) {
+      EXPECT_EQ(got->offset, want->offset);
+    }
+  }
+  for (std::uint32_t probe = 0; probe < 16010; probe += 7) {
+    auto got = index.floor(probe);
+    auto it = ref.upper_bound(probe);
+    if (it == ref.begin()) {
+      EXPECT_FALSE(got.has_value());
+    } else {
+      --it;
+      ASSERT_TRUE(got.has_value());
+      EXPECT_EQ(got->offset, it->first);
+      EXPECT_EQ(got->size, it->second);
+    }
+  }
+}
+
+TEST(BTreeFreeIndexTest, ShallowAndCompactAtScale) {
+  BTreeFreeIndex index;
+  constexpr std::uint32_t kExtents = 100000;
+  for (std::uint32_t i = 0; i < kExtents; ++i) {
+    index.insert({i * 8, 1});
+  }
+  index.rekey(8 * (kExtents / 2), {8 * (kExtents / 2), 7});
+  ASSERT_TRUE(index.verify());
+  EXPECT_EQ(index.size(), kExtents);
+  EXPECT_EQ(index.max_size(), 7u);
+  EXPECT_LE(index.depth(), 12u);
+  // Every node is one cache line.
+  EXPECT_EQ(index.metadata_bytes(), index.node_count() * 64);
+  EXPECT_EQ(index.first_fit(5)->offset, 8 * (kExtents / 2));
+
+  for (std::uint32_t i = 0; i < kExtents; ++i) {
+    ASSERT_TRUE(index.erase(i * 8));
+  }
+  EXPECT_TRUE(index.verify());
+  EXPECT_EQ(index.node_count(), 0u);
+}
+
+// ─── Allocator ──────────────────────────────────────────────────────────
+
+class BTreeAllocatorTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    auto result = Arena::create(kArenaSize);
+    ASSERT_TRUE(result.has_value());
+    arena_ = std::make_unique<Arena>(std::move(*result));
+    alloc_ =
+        std::make_unique<BTreeAllocator>(arena_->base(), arena_->capacity());
+  }
+
+  static constexpr std::size_t kArenaSize = 64 * 1024;
+  std::unique_ptr<Arena> arena_;
+  std::unique_ptr<BTreeAllocator> alloc_;
+};
+
+TEST_F(BTreeAllocatorTest, AllocateSplitsAndFreeCoalesces) {
+  auto a = alloc_->allocate(100);
+  auto b = alloc_->allocate(20);
+  auto c = alloc_->allocate(300);
+  ASSERT_TRUE(a && b && c);
+  EXPECT_EQ(a->ptr, arena_->base());
+  EXPECT_EQ(a->actual_size, 112u);
+  EXPECT_EQ(b->ptr, a->ptr + 112);
+  EXPECT_EQ(alloc_->bytes_allocated(), 112u + 32u + 304u);
+
+  ASSERT_TRUE(alloc_->deallocate(a->ptr, 100).has_value());
+  ASSERT_TRUE(alloc_->deallocate(c->ptr, 300).has_value());
+  EXPECT_EQ(alloc_->free_block_count(), 2u);
+  ASSERT_TRUE(alloc_->deallocate(b->ptr, 20).has_value());
+  EXPECT_EQ(alloc_->free_block_count(), 1u);
+  EXPECT_EQ(alloc_->largest_free_block(), kArenaSize);
+  EXPECT_EQ(alloc_->bytes_allocated(), 0u);
+}
+
+TEST_F(BTreeAllocatorTest, AlignmentAndErrors) {
+  ASSERT_TRUE(alloc_->allocate(16).has_value());
+  auto r = alloc_->allocate(64, 256);
+  ASSERT_TRUE(r.has_value());
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(r->ptr) % 256, 0u);
+  // The alignment gap stays free.
+  EXPECT_EQ(alloc_->free_block_count(), 2u);
+
+  EXPECT_EQ(alloc_->allocate(64, 3).error(), AllocError::InvalidAlignment);
+  EXPECT_EQ(alloc_->allocate(kArenaSize + 1).error(),
+            AllocError::OutOfMemory);
+
+  ASSERT_TRUE(alloc_->deallocate(r->ptr, 64).has_value());
+  EXPECT_EQ(alloc_->deallocate(r->ptr, 64).error(), AllocError::DoubleFree);
+  std::byte outside[16];
+  EXPECT_EQ(alloc_->deallocate(outside, 16).error(), AllocError::BadPointer);
+}
+
+TEST_F(BTreeAllocatorTest, NeverWritesFreeMemory) {
+  std::memset(arena_->base(), 0xAB, kArenaSize);
+  std::vector<AllocationResult> blocks;
+  for (int i = 0; i < 100; ++i) {
+    auto r = alloc_->allocate(48 + (i % 7) * 16);
+    ASSERT_TRUE(r.has_value());
+    blocks.push_back(*r);
+  }
+  std::mt19937 rng(3);
+  std::shuffle(blocks.begin(), blocks.end(), rng);
+  for (const auto &b : blocks) {
+    ASSERT_TRUE(alloc_->deallocate(b.ptr, b.actual_size).has_value());
+  }
+  EXPECT_EQ(alloc_->free_block_count(), 1u);
+  EXPECT_TRUE(alloc_->index().verify());
+  for (std::size_t i = 0; i < kArenaSize; ++i) {
+    ASSERT_EQ(arena_->base()[i], std::byte{0xAB}) << "byte " << i;
+  }
+}
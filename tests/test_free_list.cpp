@@ -5,6 +5,8 @@
 #include "allocator/free_list.hpp"
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
 #include <vector>
 
 using namespace mmap_viz;
@@ -78,6 +80,46 @@ TEST_F(FreeListTest, Coalescing) {
   EXPECT_LE(alloc_->free_block_count(), blocks_before + 1);
 }
 
+TEST_F(FreeListTest, CoalescesBothNeighbours) {
+  auto a = alloc_->allocate(256);
+  auto b = alloc_->allocate(256);
+  auto c = alloc_->allocate(256);
+  ASSERT_TRUE(a.has_value() && b.has_value() && c.has_value());
+
+  ASSERT_TRUE(alloc_->deallocate(a->ptr, a->actual_size).has_value());
+  // c merges into the free tail of the arena.
+  ASSERT_TRUE(alloc_->deallocate(c->ptr, c->actual_size).has_value());
+  EXPECT_EQ(alloc_->free_block_count(), 2u);
+
+  // b joins its free predecessor and successor into a single block.
+  ASSERT_TRUE(alloc_->deallocate(b->ptr, b->actual_size).has_value());
+  EXPECT_EQ(alloc_->free_block_count(), 1u);
+  EXPECT_EQ(alloc_->largest_free_block(), kArenaSize);
+}
+
+TEST_F(FreeListTest, RandomFreesCoalesceToOneBlock) {
+  // Tree-sized blocks of mixed sizes, filling about half the arena.
+  std::vector<AllocationResult> results;
+  for (std::size_t i = 0; i < 200; ++i) {
+    auto r = alloc_->allocate(144 + (i % 5) * 16);
+    ASSERT_TRUE(r.has_value());
+    results.push_back(*r);
+  }
+
+  std::mt19937 rng(7);
+  std::shuffle(results.begin(), results.end(), rng);
+  for (const auto &r : results) {
+    ASSERT_TRUE(alloc_->deallocate(r.ptr, r.actual_size).has_value());
+  }
+  EXPECT_EQ(alloc_->bytes_allocated(), 0u);
+  EXPECT_EQ(alloc_->free_block_count(), 1u);
+
+  // The whole arena is one block again.
+  auto all = alloc_->allocate(kArenaSize);
+  ASSERT_TRUE(all.has_value());
+  EXPECT_EQ(all->ptr, arena_->base());
+}
+
 TEST_F(FreeListTest, OutOfMemory) {
   // Try to allocate more than the arena.
   auto r = alloc_->allocate(kArenaSize + 1);
@@ -137,3 +179,74 @@ TEST_F(FreeListTest, BadPointer) {
   EXPECT_FALSE(result.has_value());
   EXPECT_EQ(result.error(), AllocError::BadPointer);
 }
+
+TEST_F(FreeListTest, TakesRegionEdges) {
+  EXPECT_EQ(alloc_->free_head(), kArenaSize);
+  EXPECT_EQ(alloc_->free_tail(), kArenaSize);
+
+  alloc_->take_head(4096);
+  alloc_->take_tail(1024);
+  EXPECT_EQ(alloc_->free_head(), 0u);
+  EXPECT_EQ(alloc_->free_tail(), 0u);
+  EXPECT_EQ(alloc_->bytes_allocated(), 4096u + 1024u);
+  EXPECT_EQ(alloc_->largest_free_block(), kArenaSize - 4096 - 1024);
+
+  // Edge blocks free like any other and merge back.
+  std::byte *base = arena_->base();
+  ASSERT_TRUE(alloc_->deallocate(base + kArenaSize - 1024, 1024).has_value());
+  EXPECT_EQ(alloc_->free_tail(), kArenaSize - 4096);
+  ASSERT_TRUE(alloc_->deallocate(base, 4096).has_value());
+  EXPECT_EQ(alloc_->free_head(), kArenaSize);
+
+  // Taking all but a list-sized sliver leaves it on a list, not the tree.
+  alloc_->take_head(kArenaSize - 32);
+  EXPECT_EQ(alloc_->free_tail(), 0u);
+  EXPECT_EQ(alloc_->bytes_free(), 32u);
+  ASSERT_TRUE(alloc_->deallocate(base, kArenaSize - 32).has_value());
+  EXPECT_EQ(alloc_->bytes_free(), kArenaSize);
+}
+
+TEST_F(FreeListTest, StatsZeroWhenDisabled) {
+  if (FreeListAllocator::kStatsEnabled) {
+    GTEST_SKIP() << "built with MMAP_VIZ_ALLOC_STATS";
+  }
+  auto r = alloc_->allocate(256);
+  ASSERT_TRUE(r.has_value());
+  ASSERT_TRUE(alloc_->deallocate(r->ptr, r->actual_size).has_value());
+  auto stats = alloc_->stats();
+  EXPECT_EQ(stats.allocations, 0u);
+  EXPECT_EQ(stats.inserts, 0u);
+}
+
+TEST_F(FreeListTest, StatsCountHotPath) {
+  if (!FreeListAllocator::kStatsEnabled) {
+    GTEST_SKIP() << "needs MMAP_VIZ_ALLOC_STATS";
+  }
+  // Tree allocation that splits the initial block, then two frees that
+  // coalesce back into it.
+  auto a = alloc_->allocate(256);
+  auto b = alloc_->allocate(256);
+  ASSERT_TRUE(a.has_value() && b.has_value());
+  ASSERT_TRUE(alloc_->deallocate(a->ptr, a->actual_size).has_value());
+  ASSERT_TRUE(alloc_->deallocate(b->ptr, b->actual_size).has_value());
+
+  // Small request: first a miss (list empty), then a hit on the freed block.
+  auto s1 = alloc_->allocate(32);
+  ASSERT_TRUE(s1.has_value());
+  ASSERT_TRUE(alloc_->deallocate(s1->ptr, s1->actual_size).has_value());
+  auto s2 = alloc_->allocate(32);
+  ASSERT_TRUE(s2.has_value());
+  EXPECT_EQ(s2->ptr, s1->ptr);
+
+  auto stats = alloc_->stats();
+  EXPECT_EQ(stats.allocations, 4u);
+  EXPECT_EQ(stats.deallocations, 3u);
+  EXPECT_EQ(stats.small_list_misses, 1u);
+  EXPECT_EQ(stats.small_list_hits, 1u);
+  EXPECT_DOUBLE_EQ(stats.small_list_hit_rate(), 0.5);
+  EXPECT_EQ(stats.fit_searches, 3u);
+  EXPECT_GE(stats.fit_nodes_visited, stats.fit_searches);
+  EXPECT_EQ(stats.splits, 3u);
+  EXPECT_GE(stats.coalesces, 2u);
+  EXPECT_GE(stats.inserts, 1u + 3u); // Initial block, remainders, frees.
+}
@@ -0,0 +1,159 @@
+/// @file test_global_new_delete.cpp
+/// @brief Tests for the global operator new/delete replacement. Built into
+///        its own executable, linked with mmap_viz_new_delete, so that every
+///        allocation in the process (GoogleTest's included) goes through it.
+
+#include "interface/visualization_arena.hpp"
+#include "preload/global_new_delete.hpp"
+#include "preload/process_arena.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace process_arena = mmap_viz::process_arena;
+
+struct Widget {
+  int id = 0;
+  std::uint64_t payload[6]{};
+};
+
+struct alignas(256) OverAligned {
+  char data[300];
+};
+
+namespace {
+
+auto arena() -> mmap_viz::VisualizationArena & {
+  // The first allocation of the process created it.
+  auto *va = process_arena::instance();
+  EXPECT_NE(va, nullptr);
+  return *va;
+}
+
+auto aligned_to(const void *ptr, std::size_t alignment) -> bool {
+  return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+} // namespace
+
+// ─── Routing ────────────────────────────────────────────────────────────
+
+TEST(GlobalNewDeleteTest, NewIsServedByArena) {
+  auto widget = std::make_unique<Widget>();
+  EXPECT_TRUE(process_arena::owns(widget.get()));
+  EXPECT_TRUE(aligned_to(widget.get(), __STDCPP_DEFAULT_NEW_ALIGNMENT__));
+  EXPECT_EQ(arena().allocation_size(widget.get()), sizeof(Widget));
+}
+
+TEST(GlobalNewDeleteTest, ArrayNewIsServedByArena) {
+  auto values = std::make_unique<int[]>(1000);
+  EXPECT_TRUE(process_arena::owns(values.get()));
+  EXPECT_EQ(values[999], 0);
+}
+
+TEST(GlobalNewDeleteTest, OverAlignedNew) {
+  auto block = std::make_unique<OverAligned>();
+  EXPECT_TRUE(process_arena::owns(block.get()));
+  EXPECT_TRUE(aligned_to(block.get(), alignof(OverAligned)));
+
+  auto *array = new OverAligned[3];
+  EXPECT_TRUE(aligned_to(array, alignof(OverAligned)));
+  delete[] array;
+}
+
+TEST(GlobalNewDeleteTest, NothrowNewReportsFailure) {
+  volatile std::size_t huge = std::numeric_limits<std::size_t>::max() / 2;
+  EXPECT_EQ(new (std::nothrow) char[huge], nullptr);
+  // A volatile sink keeps the new-expression from being elided.
+  char *volatile sink = nullptr;
+  EXPECT_THROW(sink = new char[huge], std::bad_alloc);
+  EXPECT_EQ(sink, nullptr);
+}
+
+// ─── Deallocation ───────────────────────────────────────────────────────
+
+TEST(GlobalNewDeleteTest, SizedDeleteReturnsBlock) {
+  auto &va = arena();
+  const auto before = va.bytes_allocated();
+
+  auto *widget = new Widget{};
+  EXPECT_GT(va.bytes_allocated(), before);
+  ::operator delete(widget, sizeof(Widget));
+  EXPECT_EQ(va.bytes_allocated(), before);
+
+  auto *block = new OverAligned{};
+  ::operator delete(block, sizeof(OverAligned),
+                    std::align_val_t{alignof(OverAligned)});
+  EXPECT_EQ(va.bytes_allocated(), before);
+}
+
+TEST(GlobalNewDeleteTest, UnsizedDeleteReturnsBlock) {
+  auto &va = arena();
+  const auto before = va.bytes_allocated();
+  void *raw = ::operator new(100);
+  ::operator delete(raw);
+  EXPECT_EQ(va.bytes_allocated(), before);
+}
+
+TEST(GlobalNewDeleteTest, ContainersChurnAcrossThreads) {
+  std::vector<std::thread> threads;
+  std::vector<int> ok(4, 0);
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&ok, t] {
+      std::map<int, std::string> m;
+      for (int i = 0; i < 3000; ++i) {
+        m.emplace(i, std::string(static_cast<std::size_t>(i % 50), 'x'));
+        if (i % 3 == 0) {
+          m.erase(i / 2);
+        }
+      }
+      ok[static_cast<std::size_t>(t)] = m.count(2999) == 1;
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  for (int v : ok) {
+    EXPECT_EQ(v, 1);
+  }
+}
+
+// ─── Tags ───────────────────────────────────────────────────────────────
+
+TEST(GlobalNewDeleteTest, TypeName) {
+  EXPECT_EQ(mmap_viz::type_name<Widget>(), "Widget");
+  EXPECT_EQ(mmap_viz::type_name<int>(), "int");
+}
+
+TEST(GlobalNewDeleteTest, TagScopesNest) {
+  EXPECT_EQ(mmap_viz::AllocationTagScope::current(), "new");
+  {
+    auto outer = mmap_viz::AllocationTagScope::of<Widget>();
+    EXPECT_EQ(mmap_viz::AllocationTagScope::current(), "Widget");
+    {
+      mmap_viz::AllocationTagScope inner("cache");
+      EXPECT_EQ(mmap_viz::AllocationTagScope::current(), "cache");
+    }
+    EXPECT_EQ(mmap_viz::AllocationTagScope::current(), "Widget");
+  }
+  EXPECT_EQ(mmap_viz::AllocationTagScope::current(), "new");
+}
+
+TEST(GlobalNewDeleteTest, TagReachesBlockHeader) {
+  std::unique_ptr<Widget> tagged;
+  {
+    auto scope = mmap_viz::AllocationTagScope::of<Widget>();
+    tagged = std::make_unique<Widget>();
+  }
+  auto untagged = std::make_unique<Widget>();
+  EXPECT_EQ(arena().allocation_tag(tagged.get()), "Widget");
+  EXPECT_EQ(arena().allocation_tag(untagged.get()), "new");
+}
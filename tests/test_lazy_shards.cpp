@@ -0,0 +1,153 @@
+/// @file test_lazy_shards.cpp
+/// @brief Unit tests for LazyShards.
+
+#include "interface/lazy_shards.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace mmap_viz;
+
+namespace {
+
+std::atomic<int> g_built{0};
+std::atomic<int> g_destroyed{0};
+
+/// @brief Counts constructions and destructions; not movable, like a
+///        shard holding a lock.
+struct Counted {
+  explicit Counted(std::size_t v) : value(v) { ++g_built; }
+  ~Counted() { ++g_destroyed; }
+  Counted(const Counted &) = delete;
+  Counted &operator=(const Counted &) = delete;
+
+  std::size_t value;
+};
+
+class LazyShardsTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    g_built = 0;
+    g_destroyed = 0;
+  }
+};
+
+} // namespace
+
+TEST_F(LazyShardsTest, BuildsOnFirstGetOnly) {
+  LazyShards<Counted> shards(256);
+  EXPECT_EQ(shards.size(), 256u);
+  EXPECT_EQ(g_built, 0);
+  EXPECT_EQ(shards.find(7), nullptr);
+
+  auto &a = shards.get(7, [] { return Counted(70); });
+  EXPECT_EQ(a.value, 70u);
+  EXPECT_EQ(shards.find(7), &a);
+  // Later gets return the same object without calling make().
+  auto &b = shards.get(7, []() -> Counted {
+    ADD_FAILURE() << "rebuilt";
+    return Counted(0);
+  });
+  EXPECT_EQ(&b, &a);
+  EXPECT_EQ(g_built, 1);
+  EXPECT_EQ(shards.find(8), nullptr);
+}
+
+TEST_F(LazyShardsTest, SlotsAreContiguousAndCacheAligned) {
+  LazyShards<Counted> shards(4);
+  auto *first = &shards.get(0, [] { return Counted(0); });
+  auto *second = &shards.get(1, [] { return Counted(1); });
+  const auto a = reinterpret_cast<std::uintptr_t>(first);
+  const auto b = reinterpret_cast<std::uintptr_t>(second);
+  EXPECT_EQ(a % 64, 0u);
+  EXPECT_EQ(b - a, 64u);
+}
+
+TEST_F(LazyShardsTest, RacingGetsBuildOnce) {
+  LazyShards<Counted> shards(8);
+  std::vector<std::thread> threads;
+  std::vector<Counted *> seen(16);
+  std::atomic<bool> go{false};
+  for (std::size_t t = 0; t < seen.size(); ++t) {
+    threads.emplace_back([&, t] {
+      while (!go.load()) {
+        std::this_thread::yield();
+      }
+      seen[t] = &shards.get(3, [] {
+        std::this_thread::yield(); // Widen the window.
+        return Counted(3);
+      });
+    });
+  }
+  go = true;
+  for (auto &t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(g_built, 1);
+  for (auto *p : seen) {
+    EXPECT_EQ(p, shards.find(3));
+  }
+}
+
+TEST_F(LazyShardsTest, ThrowingBuildLeavesSlotEmpty) {
+  LazyShards<Counted> shards(4);
+  auto fail = []() -> Counted { throw std::bad_alloc(); };
+  EXPECT_THROW(shards.get(1, fail), std::bad_alloc);
+  EXPECT_EQ(shards.find(1), nullptr);
+  EXPECT_EQ(g_built, 0);
+
+  // The next get() builds it instead of waiting on the failed one.
+  EXPECT_EQ(shards.get(1, [] { return Counted(1); }).value, 1u);
+  EXPECT_EQ(g_built, 1);
+}
+
+TEST_F(LazyShardsTest, WaitersRetryAfterThrowingBuild) {
+  LazyShards<Counted> shards(2);
+  std::atomic<bool> building{false};
+  std::atomic<bool> fail_now{false};
+  std::thread builder([&] {
+    EXPECT_THROW(shards.get(0,
+                            [&]() -> Counted {
+                              building = true;
+                              while (!fail_now) {
+                                std::this_thread::yield();
+                              }
+                              throw std::runtime_error("no memory");
+                            }),
+                 std::runtime_error);
+  });
+  while (!building) {
+    std::this_thread::yield();
+  }
+  // Whether this get() waits on the failing build or starts after it, it
+  // ends up building the slot itself.
+  std::thread waiter([&] {
+    EXPECT_EQ(shards.get(0, [] { return Counted(7); }).value, 7u);
+  });
+  fail_now = true;
+  builder.join();
+  waiter.join();
+  EXPECT_EQ(g_built, 1);
+}
+
+TEST_F(LazyShardsTest, ClearDestroysBuiltOnly) {
+  {
+    LazyShards<Counted> shards(16);
+    shards.get(2, [] { return Counted(2); });
+    shards.get(9, [] { return Counted(9); });
+    shards.clear();
+    EXPECT_TRUE(shards.empty());
+    EXPECT_EQ(g_destroyed, 2);
+
+    LazyShards<Counted> other(4);
+    other.get(0, [] { return Counted(0); });
+  }
+  // The second array destroyed its one object; the cleared one nothing.
+  EXPECT_EQ(g_built, 3);
+  EXPECT_EQ(g_destroyed, 3);
+}
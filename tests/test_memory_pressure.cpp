@@ -0,0 +1,156 @@
+/// @file test_memory_pressure.cpp
+/// @brief Unit tests for Watermarks and PressureMonitor.
+
+#include "interface/memory_pressure.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+using namespace mmap_viz;
+
+namespace {
+
+/// @brief Collects delivered events; wait_for() blocks until @p n arrived.
+class Recorder {
+public:
+  auto callback() -> PressureCallback {
+    return [this](const PressureEvent &e) {
+      std::lock_guard lock(mutex_);
+      events_.push_back(e);
+      cv_.notify_all();
+    };
+  }
+
+  auto wait_for(std::size_t n) -> std::vector<PressureEvent> {
+    std::unique_lock lock(mutex_);
+    cv_.wait_for(lock, std::chrono::seconds(5),
+                 [&] { return events_.size() >= n; });
+    return events_;
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<PressureEvent> events_;
+};
+
+} // namespace
+
+// ─── Watermarks ─────────────────────────────────────────────────────────
+
+TEST(WatermarksTest, LevelsWithHysteresis) {
+  Watermarks w{.low = 0.5, .critical = 0.9, .hysteresis = 0.1};
+  using L = PressureLevel;
+  EXPECT_EQ(w.next_level(L::kNormal, 49, 100), L::kNormal);
+  EXPECT_EQ(w.next_level(L::kNormal, 50, 100), L::kLow);
+  EXPECT_EQ(w.next_level(L::kNormal, 95, 100), L::kCritical);
+
+  // Leaving a level takes a drop of `hysteresis` below its watermark.
+  EXPECT_EQ(w.next_level(L::kLow, 45, 100), L::kLow);
+  EXPECT_EQ(w.next_level(L::kLow, 39, 100), L::kNormal);
+  EXPECT_EQ(w.next_level(L::kCritical, 85, 100), L::kCritical);
+  EXPECT_EQ(w.next_level(L::kCritical, 79, 100), L::kLow);
+  EXPECT_EQ(w.next_level(L::kCritical, 10, 100), L::kNormal);
+}
+
+TEST(WatermarksTest, BoundsMatchNextLevel) {
+  Watermarks w{.low = 0.5, .critical = 0.9, .hysteresis = 0.1};
+  for (auto level : {PressureLevel::kNormal, PressureLevel::kLow,
+                     PressureLevel::kCritical}) {
+    auto b = w.bounds(level, 100);
+    for (std::size_t used = 0; used <= 100; ++used) {
+      bool inside = used >= b.down && used < b.up;
+      EXPECT_EQ(inside, w.next_level(level, used, 100) == level)
+          << to_string(level) << " at " << used;
+    }
+  }
+}
+
+// ─── PressureMonitor ────────────────────────────────────────────────────
+
+TEST(PressureMonitorTest, ArenaWatchFollowsFoldedUsage) {
+  // 10 shards of 100 bytes: a quantum of 1 byte, so folding is exact.
+  PressureMonitor monitor(1000, 10, 100);
+  Recorder rec;
+  monitor.watch_arena({.low = 0.8, .critical = 0.95, .hysteresis = 0.05},
+                      rec.callback());
+
+  auto fill = [&](std::size_t per_shard) {
+    for (std::size_t i = 0; i < 10; ++i) {
+      monitor.on_shard_usage(i, per_shard);
+    }
+  };
+  fill(85); // 850: low.
+  fill(96); // 960: critical.
+  fill(92); // 920: still critical (exit at 900).
+  fill(89); // 890: low.
+  fill(70); // 700: normal (exit at 750).
+  EXPECT_EQ(monitor.arena_bytes_in_use(), 700u);
+
+  auto events = rec.wait_for(4);
+  ASSERT_EQ(events.size(), 4u);
+  using L = PressureLevel;
+  EXPECT_EQ(events[0].level, L::kLow);
+  EXPECT_EQ(events[1].level, L::kCritical);
+  EXPECT_EQ(events[2].level, L::kLow);
+  EXPECT_EQ(events[2].previous, L::kCritical);
+  EXPECT_EQ(events[3].level, L::kNormal);
+  EXPECT_EQ(events[0].shard, PressureEvent::kArena);
+  EXPECT_EQ(events[0].capacity, 1000u);
+  EXPECT_EQ(monitor.events_raised(), 4u);
+}
+
+TEST(PressureMonitorTest, ShardWatchReportsEachShard) {
+  PressureMonitor monitor(1000, 10, 100);
+  Recorder rec;
+  monitor.watch_shards({.low = 0.5, .critical = 0.9}, rec.callback());
+
+  monitor.on_shard_usage(3, 60);
+  monitor.on_shard_usage(7, 95);
+  monitor.on_shard_usage(3, 65); // No change.
+
+  auto events = rec.wait_for(2);
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0].shard, 3u);
+  EXPECT_EQ(events[0].level, PressureLevel::kLow);
+  EXPECT_EQ(events[0].bytes_in_use, 60u);
+  EXPECT_EQ(events[1].shard, 7u);
+  EXPECT_EQ(events[1].level, PressureLevel::kCritical);
+  EXPECT_EQ(events[1].capacity, 100u);
+}
+
+TEST(PressureMonitorTest, WatchReportsUsageAlreadyPastWatermark) {
+  PressureMonitor monitor(1000, 10, 100);
+  for (std::size_t i = 0; i < 10; ++i) {
+    monitor.on_shard_usage(i, 90);
+  }
+  Recorder rec;
+  monitor.watch_arena({}, rec.callback());
+  auto events = rec.wait_for(1);
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].level, PressureLevel::kLow);
+}
+
+TEST(PressureMonitorTest, UnwatchStopsDelivery) {
+  PressureMonitor monitor(1000, 10, 100);
+  Recorder kept;
+  Recorder dropped;
+  monitor.watch_shards({.low = 0.5}, kept.callback());
+  auto id = monitor.watch_shards({.low = 0.5}, dropped.callback());
+  monitor.unwatch(id);
+
+  monitor.on_shard_usage(0, 80);
+  EXPECT_EQ(kept.wait_for(1).size(), 1u);
+  EXPECT_TRUE(dropped.wait_for(0).empty());
+}
+
+TEST(PressureMonitorTest, NoWatchesNoEvaluation) {
+  PressureMonitor monitor(1000, 10, 100);
+  monitor.on_shard_usage(0, 100);
+  EXPECT_EQ(monitor.events_raised(), 0u);
+  EXPECT_EQ(monitor.arena_bytes_in_use(), 100u);
+}
@@ -0,0 +1,120 @@
+/// @file test_observer_meter.cpp
+/// @brief Unit tests for ObserverMeter and its sampling controller.
+
+#include "interface/observer_meter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+using namespace mmap_viz;
+
+// ─── Controller ─────────────────────────────────────────────────────────
+
+TEST(ObserverMeterTest, NextSamplingDoublesAboveTarget) {
+  EXPECT_EQ(ObserverMeter::next_sampling(1, 1, 5.0, 2.0), 2u);
+  EXPECT_EQ(ObserverMeter::next_sampling(8, 1, 2.5, 2.0), 16u);
+  EXPECT_EQ(ObserverMeter::next_sampling(ObserverMeter::kMaxSampling, 1,
+                                         50.0, 2.0),
+            ObserverMeter::kMaxSampling);
+}
+
+TEST(ObserverMeterTest, NextSamplingHalvesWellBelowTarget) {
+  EXPECT_EQ(ObserverMeter::next_sampling(16, 1, 0.5, 2.0), 8u);
+  EXPECT_EQ(ObserverMeter::next_sampling(4, 4, 0.1, 2.0), 4u); // Floor.
+  // Between target / 2 and target the rate holds.
+  EXPECT_EQ(ObserverMeter::next_sampling(16, 1, 1.5, 2.0), 16u);
+}
+
+TEST(ObserverMeterTest, NoTargetKeepsConfiguredRate) {
+  EXPECT_EQ(ObserverMeter::next_sampling(1, 1, 90.0, 0.0), 1u);
+  EXPECT_EQ(ObserverMeter::next_sampling(3, 3, 90.0, 0.0), 3u);
+}
+
+// ─── Windows ────────────────────────────────────────────────────────────
+
+TEST(ObserverMeterTest, WindowSplitsOverheadByComponent) {
+  ObserverMeter meter(1, 5.0);
+  EXPECT_EQ(meter.sampling().load(), 1u);
+
+  ObserverClocks start{.wall_ns = 1'000'000'000,
+                       .cycles = 2'000'000'000,
+                       .process_cpu_ns = 0,
+                       .batcher_cpu_ns = 0,
+                       .server_cpu_ns = 0};
+  auto first = meter.update(start);
+  EXPECT_EQ(first.window_ns, 0u); // Only starts the window.
+
+  // 1 s wall at 2 cycles/ns; one timed call of 100 ns stands for
+  // kCostSampleEvery calls.
+  meter.add_tracking_cost(200);
+  ObserverClocks end = start;
+  end.wall_ns += 1'000'000'000;
+  end.cycles += 2'000'000'000;
+  end.process_cpu_ns = 2'000'000'000; // Two busy cores.
+  end.batcher_cpu_ns = 80'000'000;
+  end.server_cpu_ns = 40'000'000;
+
+  auto o = meter.update(end);
+  EXPECT_EQ(o.window_ns, 1'000'000'000u);
+  EXPECT_DOUBLE_EQ(o.batcher_pct, 4.0);
+  EXPECT_DOUBLE_EQ(o.server_pct, 2.0);
+  EXPECT_DOUBLE_EQ(o.tracking_ns_per_op, 100.0);
+  EXPECT_DOUBLE_EQ(o.tracking_pct,
+                   100.0 * 100 * ObserverMeter::kCostSampleEvery / 2e9);
+  EXPECT_DOUBLE_EQ(o.overhead_pct,
+                   o.batcher_pct + o.server_pct + o.tracking_pct);
+
+  // Over the 5 % target: the controller doubled the rate.
+  EXPECT_EQ(o.sampling, 2u);
+  EXPECT_EQ(meter.sampling().load(), 2u);
+  EXPECT_EQ(meter.latest().sampling, 2u);
+}
+
+TEST(ObserverMeterTest, IdleProcessIsBilledAgainstOneCore) {
+  ObserverMeter meter(1, 5.0);
+  ObserverClocks start{.wall_ns = 1'000'000'000};
+  meter.update(start);
+
+  // The process spent 2 ms of CPU in 1 s, nearly all of it the batcher's
+  // wakeups: 0.15 % of a core, not 75 % of the process.
+  ObserverClocks end = start;
+  end.wall_ns += 1'000'000'000;
+  end.process_cpu_ns = 2'000'000;
+  end.batcher_cpu_ns = 1'500'000;
+  auto o = meter.update(end);
+  EXPECT_DOUBLE_EQ(o.batcher_pct, 0.15);
+  EXPECT_EQ(o.sampling, 1u);
+}
+
+TEST(ObserverMeterTest, ProbeTimesOneCallInN) {
+  ObserverMeter meter(1, 0.0);
+  std::uint32_t tick = 0;
+  for (std::uint32_t i = 0; i < 3 * ObserverMeter::kCostSampleEvery; ++i) {
+    ObserverMeter::Probe probe(meter, tick);
+  }
+  ObserverClocks a = ObserverClocks::read(static_cast<clockid_t>(-1));
+  meter.update(a);
+  for (std::uint32_t i = 0; i < 2 * ObserverMeter::kCostSampleEvery; ++i) {
+    ObserverMeter::Probe probe(meter, tick);
+  }
+  ObserverClocks b = a;
+  b.wall_ns += 1'000'000;
+  b.cycles += 1'000'000;
+  b.process_cpu_ns += 1'000'000;
+  auto o = meter.update(b);
+  EXPECT_GT(o.tracking_pct, 0.0);
+  EXPECT_EQ(o.sampling, 1u);
+}
+
+TEST(ObserverMeterTest, ReadsThreadCpuClocks) {
+  auto a = ObserverClocks::read(static_cast<clockid_t>(-1));
+  volatile std::uint64_t sink = 0;
+  for (std::uint64_t i = 0; i < 5'000'000; ++i) {
+    sink = sink + i;
+  }
+  auto b = ObserverClocks::read(static_cast<clockid_t>(-1));
+  EXPECT_GT(b.batcher_cpu_ns, a.batcher_cpu_ns);
+  EXPECT_GT(b.process_cpu_ns, a.process_cpu_ns);
+  EXPECT_EQ(b.server_cpu_ns, 0u);
+}
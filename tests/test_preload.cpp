@@ -0,0 +1,88 @@
+/// @file test_preload.cpp
+/// @brief Runs programs under LD_PRELOAD=libmmap_viz_preload.so.
+
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <sstream>
+#include <string>
+
+#ifndef MMAP_VIZ_PRELOAD_LIB
+#error "MMAP_VIZ_PRELOAD_LIB must name the built interposer library"
+#endif
+#ifndef MMAP_VIZ_PRELOAD_PROBE
+#error "MMAP_VIZ_PRELOAD_PROBE must name the built preload_probe binary"
+#endif
+
+namespace {
+
+struct RunResult {
+  int exit_code = -1;
+  std::map<std::string, std::string> values; ///< Parsed `key=value` lines.
+  std::string output;
+};
+
+/// @brief Run @p command through the shell and collect its stdout.
+auto run(const std::string &command) -> RunResult {
+  RunResult result;
+  FILE *pipe = ::popen(command.c_str(), "r");
+  if (pipe == nullptr) {
+    return result;
+  }
+  char buf[512];
+  while (std::fgets(buf, sizeof(buf), pipe) != nullptr) {
+    result.output += buf;
+  }
+  const int status = ::pclose(pipe);
+  result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+  std::istringstream lines(result.output);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (auto eq = line.find('='); eq != std::string::npos) {
+      result.values[line.substr(0, eq)] = line.substr(eq + 1);
+    }
+  }
+  return result;
+}
+
+auto preloaded(const std::string &program) -> std::string {
+  // 256MB keeps the reservation small; each thread gets a 1MB shard.
+  return "LD_PRELOAD=" MMAP_VIZ_PRELOAD_LIB " MMAP_VIZ_ARENA_MB=256 " +
+         program;
+}
+
+} // namespace
+
+// ─── Probe program ──────────────────────────────────────────────────────
+
+TEST(PreloadTest, ProbeRunsWithoutInterposer) {
+  auto result = run(MMAP_VIZ_PRELOAD_PROBE);
+  EXPECT_EQ(result.exit_code, 0) << result.output;
+  EXPECT_EQ(result.values["preloaded"], "0");
+}
+
+TEST(PreloadTest, ProbeAllocatesFromArena) {
+  auto result = run(preloaded(MMAP_VIZ_PRELOAD_PROBE));
+  ASSERT_EQ(result.exit_code, 0) << result.output;
+  EXPECT_EQ(result.values["preloaded"], "1");
+  EXPECT_EQ(result.values["ready"], "1");
+  EXPECT_EQ(result.values["owns_malloc"], "1");
+  EXPECT_GT(std::stoull(result.values["arena_bytes"]), 0u);
+  EXPECT_EQ(result.values["failures"], "0");
+}
+
+// ─── Unmodified binaries ────────────────────────────────────────────────
+
+TEST(PreloadTest, SystemBinaryRunsUnderInterposer) {
+  if (!std::filesystem::exists("/bin/ls")) {
+    GTEST_SKIP() << "/bin/ls not available";
+  }
+  auto result = run(preloaded("/bin/ls -la /"));
+  EXPECT_EQ(result.exit_code, 0);
+  EXPECT_NE(result.output.find(".."), std::string::npos);
+}
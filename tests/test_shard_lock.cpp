@@ -0,0 +1,221 @@
+/// @file test_shard_lock.cpp
+/// @brief Unit tests for ShardLock and LockHistogram.
+
+#include "interface/shard_lock.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace mmap_viz;
+
+namespace {
+
+/// @brief Start a thread that calls @p acquire on @p lock, which the
+///        caller holds, and return once it is blocked there: the thread
+///        has signalled that it started and the lock shows it waiting.
+template <typename Acquire>
+auto start_blocked_waiter(ShardLock &lock, Acquire acquire) -> std::thread {
+  std::atomic<bool> started{false};
+  std::thread waiter([&lock, &started, acquire] {
+    started.store(true);
+    acquire(lock);
+    lock.unlock();
+  });
+  while (!started.load() || !lock.has_waiters()) {
+    std::this_thread::yield();
+  }
+  return waiter;
+}
+
+} // namespace
+
+// ─── LockHistogram ──────────────────────────────────────────────────────
+
+TEST(LockHistogramTest, BucketsArePowersOfTwo) {
+  EXPECT_EQ(LockHistogram::bucket_of(0), 0u);
+  EXPECT_EQ(LockHistogram::bucket_of(1), 1u);
+  EXPECT_EQ(LockHistogram::bucket_of(2), 2u);
+  EXPECT_EQ(LockHistogram::bucket_of(3), 2u);
+  EXPECT_EQ(LockHistogram::bucket_of(1024), 11u);
+  EXPECT_EQ(LockHistogram::bucket_of(~0ull), LockHistogram::kBuckets - 1);
+}
+
+TEST(LockHistogramTest, Percentiles) {
+  LockHistogram h;
+  h.buckets[0] = 90;                              // 90 x 0 ns
+  h.buckets[LockHistogram::bucket_of(1000)] = 10; // 10 x ~1 us
+  h.count = 100;
+  h.sum_ns = 10 * 1000;
+  h.max_ns = 1000;
+
+  EXPECT_EQ(h.percentile(0.5), 0u);
+  EXPECT_EQ(h.percentile(0.99), 1000u); // Bucket bound capped at max.
+  EXPECT_DOUBLE_EQ(h.mean_ns(), 100.0);
+
+  LockHistogram sum = h;
+  sum += h;
+  EXPECT_EQ(sum.count, 200u);
+  EXPECT_EQ(sum.buckets[0], 180u);
+  EXPECT_EQ(sum.max_ns, 1000u);
+}
+
+// ─── ShardLock ──────────────────────────────────────────────────────────
+
+TEST(ShardLockTest, UncontendedProfile) {
+  ShardLock lock;
+  for (int i = 0; i < 16; ++i) {
+    lock.lock_profiled(i % 4 == 0);
+    lock.unlock();
+  }
+  // Plain lock() is not profiled.
+  { std::lock_guard guard(lock); }
+
+  auto p = lock.profile();
+  EXPECT_EQ(p.acquisitions, 16u);
+  EXPECT_EQ(p.contended, 0u);
+  EXPECT_EQ(p.remote, 4u);
+  EXPECT_EQ(p.wait_ns.count, 16u);
+  EXPECT_EQ(p.wait_ns.buckets[0], 16u);
+  EXPECT_EQ(p.hold_ns.count, 16 / ShardLock::kHoldSampleEvery);
+}
+
+TEST(ShardLockTest, TryLock) {
+  ShardLock lock;
+  ASSERT_TRUE(lock.try_lock());
+  EXPECT_FALSE(lock.try_lock());
+  lock.unlock();
+  EXPECT_TRUE(lock.try_lock());
+  lock.unlock();
+}
+
+TEST(ShardLockTest, ContendedWaitIsTimed) {
+  ShardLock lock;
+  lock.lock();
+  auto waiter = start_blocked_waiter(
+      lock, [](ShardLock &l) { l.lock_profiled(false); });
+  // The waiter is asleep on the futex; its wait is already timing.
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  lock.unlock();
+  waiter.join();
+
+  auto p = lock.profile();
+  EXPECT_EQ(p.acquisitions, 1u);
+  EXPECT_EQ(p.contended, 1u);
+  EXPECT_GE(p.wait_ns.max_ns, 1'000'000u);
+  EXPECT_EQ(p.wait_ns.buckets[0], 0u);
+}
+
+TEST(ShardLockTest, MutualExclusion) {
+  ShardLock lock;
+  constexpr int kThreads = 4;
+  constexpr int kIters = 20000;
+  long counter = 0;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < kIters; ++i) {
+        lock.lock_profiled(false);
+        ++counter;
+        lock.unlock();
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(counter, long{kThreads} * kIters);
+  auto p = lock.profile();
+  EXPECT_EQ(p.acquisitions, std::uint64_t{kThreads} * kIters);
+  EXPECT_EQ(p.wait_ns.count, p.acquisitions);
+  EXPECT_LE(p.contended, p.acquisitions);
+}
+
+// ─── Lock kinds ─────────────────────────────────────────────────────────
+
+class ShardLockKindTest : public ::testing::TestWithParam<ShardLockKind> {};
+
+TEST_P(ShardLockKindTest, ExcludesAndProfiles) {
+  ShardLock lock(GetParam());
+  EXPECT_EQ(lock.kind(), GetParam());
+  constexpr int kThreads = 8; // Often more threads than cores.
+  constexpr int kIters = 5000;
+  long counter = 0;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < kIters; ++i) {
+        lock.lock_profiled(false);
+        ++counter;
+        lock.unlock();
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(counter, long{kThreads} * kIters);
+  EXPECT_EQ(lock.profile().acquisitions, std::uint64_t{kThreads} * kIters);
+}
+
+TEST_P(ShardLockKindTest, SleepingWaiterIsWoken) {
+  ShardLock lock(GetParam());
+  lock.lock();
+  auto waiter = start_blocked_waiter(
+      lock, [](ShardLock &l) { l.lock_profiled(true); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  lock.unlock();
+  waiter.join();
+
+  auto p = lock.profile();
+  EXPECT_EQ(p.contended, 1u);
+  EXPECT_EQ(p.remote, 1u);
+  EXPECT_GE(p.wait_ns.max_ns, 1'000'000u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Kinds, ShardLockKindTest,
+                         ::testing::Values(ShardLockKind::kSpinFutex,
+                                           ShardLockKind::kAdaptive,
+                                           ShardLockKind::kMutex));
+
+TEST(ShardLockTest, AdaptiveBudgetFollowsHoldTime) {
+  ShardLock lock(ShardLockKind::kAdaptive);
+  EXPECT_EQ(lock.spin_budget_ns(), ShardLock::kInitialSpinNs);
+
+  // Long holds (1 ms, far past the cap) pull the budget up to the cap.
+  for (std::uint64_t i = 0; i < 32 * ShardLock::kHoldSampleEvery; ++i) {
+    lock.lock_profiled(false);
+    if ((i + 1) % ShardLock::kHoldSampleEvery == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    lock.unlock();
+  }
+  EXPECT_GT(lock.spin_budget_ns(), ShardLock::kMaxSpinNs * 9 / 10);
+  EXPECT_LE(lock.spin_budget_ns(), ShardLock::kMaxSpinNs);
+
+  // Empty critical sections bring it back down to the floor region.
+  for (std::uint64_t i = 0; i < 64 * ShardLock::kHoldSampleEvery; ++i) {
+    lock.lock_profiled(false);
+    lock.unlock();
+  }
+  EXPECT_LT(lock.spin_budget_ns(), ShardLock::kInitialSpinNs);
+  EXPECT_GE(lock.spin_budget_ns(), ShardLock::kMinSpinNs);
+}
+
+TEST(ShardLockTest, AdaptiveBudgetShrinksWhenSpinningFails) {
+  ShardLock lock(ShardLockKind::kAdaptive);
+  lock.lock();
+  // Held until the waiter has spun out its budget and gone to sleep.
+  auto waiter = start_blocked_waiter(lock, [](ShardLock &l) { l.lock(); });
+  lock.unlock();
+  waiter.join();
+  EXPECT_LT(lock.spin_budget_ns(), ShardLock::kInitialSpinNs);
+}
@@ -0,0 +1,132 @@
+/// @file test_size_classes.cpp
+/// @brief Unit tests for the size-class schemes and the allocators using them.
+
+#include "allocator/arena.hpp"
+#include "allocator/free_list.hpp"
+#include "allocator/profiled_size_classes.hpp"
+#include "allocator/size_classes.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace mmap_viz;
+
+namespace {
+
+/// @brief class_of() and class_floor() agree with a scan of the table for
+///        every size the scheme covers.
+template <typename Scheme> void expect_exact_lookup() {
+  for (std::size_t size = 1; size <= Scheme::kMaxSize; ++size) {
+    std::size_t ceil = 0;
+    while (Scheme::size_of(ceil) < size) {
+      ++ceil;
+    }
+    ASSERT_EQ(Scheme::class_of(size), ceil) << "size " << size;
+    if (size >= 16) {
+      std::size_t floor = Scheme::kCount - 1;
+      while (Scheme::size_of(floor) > size) {
+        --floor;
+      }
+      ASSERT_EQ(Scheme::class_floor(size), floor) << "size " << size;
+    }
+  }
+}
+
+} // namespace
+
+// ─── Schemes ────────────────────────────────────────────────────────────
+
+TEST(SizeClassesTest, LinearKeepsOriginalLists) {
+  using Linear = LinearSizeClasses<>;
+  EXPECT_EQ(Linear::kCount, 8u);
+  EXPECT_EQ(Linear::kMaxSize, 128u);
+  expect_exact_lookup<Linear>();
+  // FreeListAllocator rounds exactly as before: whole granules.
+  EXPECT_EQ(FreeListAllocator::block_size(100), 112u);
+  EXPECT_EQ(FreeListAllocator::block_size(200), 208u);
+}
+
+TEST(SizeClassesTest, GeometricFollowsJemallocSpacing) {
+  using Geometric = GeometricSizeClasses<1024, 4>;
+  constexpr std::array<std::size_t, 20> kExpected = {
+      16,  32,  48,  64,  80,  96,  112, 128, 160, 192,
+      224, 256, 320, 384, 448, 512, 640, 768, 896, 1024};
+  ASSERT_EQ(Geometric::kCount, kExpected.size());
+  for (std::size_t i = 0; i < kExpected.size(); ++i) {
+    EXPECT_EQ(Geometric::size_of(i), kExpected[i]);
+  }
+  expect_exact_lookup<Geometric>();
+  EXPECT_EQ(GeometricFreeListAllocator::block_size(200), 224u);
+  EXPECT_EQ(GeometricFreeListAllocator::block_size(1025), 1040u);
+}
+
+TEST(SizeClassesTest, TablesAreValidated) {
+  expect_exact_lookup<ProfiledSizeClasses>();
+  expect_exact_lookup<TableSizeClasses<16, 32, 48, 176, 4096>>();
+  static_assert(size_classes::valid(std::array<std::size_t, 3>{16, 32, 48}));
+  // 64 without 48, unaligned, or out of order.
+  static_assert(!size_classes::valid(std::array<std::size_t, 3>{16, 32, 64}));
+  static_assert(
+      !size_classes::valid(std::array<std::size_t, 4>{16, 32, 48, 100}));
+  static_assert(
+      !size_classes::valid(std::array<std::size_t, 4>{16, 32, 48, 48}));
+}
+
+// ─── Allocators ─────────────────────────────────────────────────────────
+
+TEST(SizeClassesTest, GeometricListsServeLargerBlocks) {
+  auto arena = Arena::create(64 * 1024);
+  ASSERT_TRUE(arena.has_value());
+  GeometricFreeListAllocator alloc{arena->base(), arena->capacity()};
+
+  auto a = alloc.allocate(200);
+  ASSERT_TRUE(a.has_value());
+  EXPECT_EQ(a->actual_size, 224u);
+  ASSERT_TRUE(alloc.deallocate(a->ptr, a->actual_size).has_value());
+
+  // Anything in the same class comes back off its list.
+  auto b = alloc.allocate(193);
+  ASSERT_TRUE(b.has_value());
+  EXPECT_EQ(b->ptr, a->ptr);
+  EXPECT_EQ(b->actual_size, 224u);
+  EXPECT_EQ(alloc.bytes_allocated(), 224u);
+}
+
+TEST(SizeClassesTest, ProfiledChurnBalances) {
+  auto arena = Arena::create(1024 * 1024);
+  ASSERT_TRUE(arena.has_value());
+  ProfiledFreeListAllocator alloc{arena->base(), arena->capacity()};
+
+  std::mt19937 rng(7);
+  std::vector<AllocationResult> live;
+  for (int i = 0; i < 20000; ++i) {
+    if (live.empty() || rng() % 3 != 0) {
+      auto r = alloc.allocate(1 + rng() % 2048, 16u << (rng() % 3));
+      ASSERT_TRUE(r.has_value());
+      EXPECT_EQ(r->actual_size,
+                ProfiledFreeListAllocator::block_size(r->actual_size));
+      live.push_back(*r);
+    } else {
+      auto j = rng() % live.size();
+      ASSERT_TRUE(
+          alloc.deallocate(live[j].ptr, live[j].actual_size).has_value());
+      live[j] = live.back();
+      live.pop_back();
+    }
+    if (live.size() > 400) {
+      for (const auto &r : live) {
+        ASSERT_TRUE(alloc.deallocate(r.ptr, r.actual_size).has_value());
+      }
+      live.clear();
+    }
+  }
+  for (const auto &r : live) {
+    ASSERT_TRUE(alloc.deallocate(r.ptr, r.actual_size).has_value());
+  }
+  EXPECT_EQ(alloc.bytes_allocated(), 0u);
+  EXPECT_EQ(alloc.bytes_free(), arena->capacity());
+}
@@ -0,0 +1,129 @@
+/// @file test_small_block_cache.cpp
+/// @brief Unit tests for the lock-free SmallBlockCache.
+
+#include "allocator/small_block_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace mmap_viz;
+
+// ─── Test fixture ────────────────────────────────────────────────────────
+
+class SmallBlockCacheTest : public ::testing::Test {
+protected:
+  static constexpr std::size_t kRegion = 64 * 1024;
+
+  alignas(16) std::byte region_[kRegion];
+  SmallBlockCache cache_{region_, kRegion};
+};
+
+// ─── Single-threaded ────────────────────────────────────────────────────
+
+TEST_F(SmallBlockCacheTest, Accepts) {
+  EXPECT_TRUE(cache_.accepts(16));
+  EXPECT_TRUE(cache_.accepts(SmallBlockCache::kMaxBlockSize));
+  EXPECT_FALSE(cache_.accepts(0));
+  EXPECT_FALSE(cache_.accepts(24));
+  EXPECT_FALSE(cache_.accepts(SmallBlockCache::kMaxBlockSize + 16));
+
+  SmallBlockCache off(region_, kRegion, false);
+  EXPECT_FALSE(off.accepts(16));
+}
+
+TEST_F(SmallBlockCacheTest, PushPopIsLifoPerClass) {
+  EXPECT_EQ(cache_.pop(64), nullptr);
+  cache_.push(region_ + 0, 64);
+  cache_.push(region_ + 64, 64);
+  cache_.push(region_ + 128, 32);
+  EXPECT_EQ(cache_.cached_bytes(), 160u);
+
+  EXPECT_EQ(cache_.pop(64), region_ + 64);
+  EXPECT_EQ(cache_.pop(64), region_ + 0);
+  EXPECT_EQ(cache_.pop(64), nullptr);
+  EXPECT_EQ(cache_.pop(32), region_ + 128);
+  EXPECT_EQ(cache_.cached_bytes(), 0u);
+}
+
+TEST_F(SmallBlockCacheTest, CachedBlockRecordsItsSize) {
+  cache_.push(region_ + 256, 96);
+  EXPECT_EQ(*reinterpret_cast<std::size_t *>(region_ + 256), 96u);
+}
+
+TEST_F(SmallBlockCacheTest, LinksStayOutsideBlocks) {
+  cache_.push(region_ + 0, 48);
+  cache_.push(region_ + 48, 48);
+  // A block is rewritten past its size word as soon as its popper owns
+  // it; the stack must not depend on those bytes.
+  std::fill(region_ + 48 + sizeof(std::size_t), region_ + 96, std::byte{0xff});
+  EXPECT_EQ(cache_.pop(48), region_ + 48);
+  EXPECT_EQ(cache_.pop(48), region_ + 0);
+  EXPECT_EQ(cache_.pop(48), nullptr);
+}
+
+TEST_F(SmallBlockCacheTest, Drain) {
+  cache_.push(region_ + 0, 16);
+  cache_.push(region_ + 16, 48);
+  cache_.push(region_ + 64, 128);
+  std::size_t bytes = 0;
+  int blocks = 0;
+  cache_.drain([&](std::byte *, std::size_t size) {
+    bytes += size;
+    ++blocks;
+  });
+  EXPECT_EQ(blocks, 3);
+  EXPECT_EQ(bytes, 192u);
+  EXPECT_EQ(cache_.cached_bytes(), 0u);
+}
+
+// ─── Concurrency ────────────────────────────────────────────────────────
+
+TEST_F(SmallBlockCacheTest, ConcurrentChurnKeepsEveryBlockOnce) {
+  constexpr std::size_t kBlock = 64;
+  constexpr std::size_t kBlocks = kRegion / kBlock;
+  for (std::size_t i = 0; i < kBlocks; ++i) {
+    cache_.push(region_ + i * kBlock, kBlock);
+  }
+
+  // Threads pop a few blocks and push them back, so the same blocks keep
+  // cycling through the head: the ABA pattern the tag guards against.
+  constexpr int kThreads = 8;
+  std::vector<std::thread> threads;
+  std::atomic<bool> start{false};
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      while (!start) {
+      }
+      std::vector<std::byte *> held;
+      for (int i = 0; i < 20000; ++i) {
+        if (auto *b = cache_.pop(kBlock)) {
+          held.push_back(b);
+        }
+        if (held.size() > 3 || (i % 2 == 0 && !held.empty())) {
+          cache_.push(held.back(), kBlock);
+          held.pop_back();
+        }
+      }
+      for (auto *b : held) {
+        cache_.push(b, kBlock);
+      }
+    });
+  }
+  start = true;
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  std::set<std::byte *> seen;
+  while (auto *b = cache_.pop(kBlock)) {
+    EXPECT_TRUE(seen.insert(b).second) << "block popped twice";
+  }
+  EXPECT_EQ(seen.size(), kBlocks);
+  EXPECT_EQ(cache_.cached_bytes(), 0u);
+}
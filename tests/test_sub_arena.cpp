@@ -0,0 +1,500 @@
+/// @file test_sub_arena.cpp
+/// @brief Unit tests for SubArena and its roll-up into the parent.
+
+#include "interface/visualization_arena.hpp"
+#include "tracker/block_metadata.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+using namespace mmap_viz;
+
+// ─── Test fixture ────────────────────────────────────────────────────────
+
+class SubArenaTest : public ::testing::Test {
+protected:
+  static constexpr std::size_t kArenaSize = 1024 * 1024;
+  static constexpr std::size_t kShardSize = kArenaSize / 256;
+
+  void SetUp() override {
+    auto result = VisualizationArena::create({.arena_size = kArenaSize});
+    ASSERT_TRUE(result.has_value());
+    arena_ = std::make_unique<VisualizationArena>(std::move(*result));
+  }
+
+  auto carve(std::string name, std::size_t capacity,
+             std::size_t shard_count = 4) -> std::unique_ptr<SubArena> {
+    auto sub = arena_->create_sub_arena({.name = std::move(name),
+                                         .capacity = capacity,
+                                         .shard_count = shard_count});
+    EXPECT_TRUE(sub.has_value()) << sub.error().message();
+    return sub ? std::move(*sub) : nullptr;
+  }
+
+  std::unique_ptr<VisualizationArena> arena_;
+};
+
+// ─── Carving ────────────────────────────────────────────────────────────
+
+TEST_F(SubArenaTest, CarvedFromTopOfParent) {
+  auto sub = carve("tenant", 64 * 1024);
+  ASSERT_NE(sub, nullptr);
+  EXPECT_EQ(sub->capacity(), 64u * 1024);
+  EXPECT_EQ(sub->base(), arena_->base() + kArenaSize - (64 * 1024));
+  EXPECT_EQ(sub->name(), "tenant");
+
+  // Rounded up to whole parent shards, below the first one.
+  auto next = carve("next", 100);
+  ASSERT_NE(next, nullptr);
+  EXPECT_EQ(next->capacity(), kShardSize);
+  EXPECT_EQ(next->base() + kShardSize, sub->base());
+
+  auto stats = arena_->sub_arena_stats();
+  ASSERT_EQ(stats.size(), 2u);
+  EXPECT_EQ(stats[0].name, "next");
+  EXPECT_EQ(stats[1].offset, kArenaSize - (64 * 1024));
+}
+
+TEST_F(SubArenaTest, InvalidConfigRejected) {
+  auto zero = arena_->create_sub_arena({.capacity = 0});
+  ASSERT_FALSE(zero.has_value());
+  EXPECT_EQ(zero.error(), std::errc::invalid_argument);
+
+  auto no_shards =
+      arena_->create_sub_arena({.capacity = 4096, .shard_count = 0});
+  ASSERT_FALSE(no_shards.has_value());
+  EXPECT_EQ(no_shards.error(), std::errc::invalid_argument);
+
+  auto tiny_shards =
+      arena_->create_sub_arena({.capacity = 4096, .shard_count = 64});
+  ASSERT_FALSE(tiny_shards.has_value());
+  EXPECT_EQ(tiny_shards.error(), std::errc::invalid_argument);
+
+  auto no_ranges = arena_->create_sub_arena(
+      {.capacity = 4096, .shard_count = 1, .ranges_per_shard = 0});
+  ASSERT_FALSE(no_ranges.has_value());
+  EXPECT_EQ(no_ranges.error(), std::errc::invalid_argument);
+
+  auto tiny_ranges = arena_->create_sub_arena(
+      {.capacity = 4096, .shard_count = 2, .ranges_per_shard = 16});
+  ASSERT_FALSE(tiny_ranges.has_value());
+  EXPECT_EQ(tiny_ranges.error(), std::errc::invalid_argument);
+
+  auto whole = arena_->create_sub_arena({.capacity = kArenaSize});
+  ASSERT_FALSE(whole.has_value());
+  EXPECT_EQ(whole.error(), std::errc::not_enough_memory);
+}
+
+TEST_F(SubArenaTest, CannotCarveShardsInUse) {
+  // Leave a live block on each of shards 0-9.
+  std::vector<void *> live;
+  for (int i = 0; i < 10; ++i) {
+    std::thread([&] { live.push_back(arena_->alloc_raw(16, 8, "t")); })
+        .join();
+  }
+  // 246 shards are still empty.
+  auto rest = arena_->create_sub_arena({.capacity = 246 * kShardSize});
+  ASSERT_TRUE(rest.has_value());
+  auto more = arena_->create_sub_arena({.capacity = kShardSize});
+  ASSERT_FALSE(more.has_value());
+  EXPECT_EQ(more.error(), std::errc::not_enough_memory);
+  for (auto *p : live) {
+    arena_->dealloc_raw(p, 16);
+  }
+}
+
+TEST_F(SubArenaTest, CannotCarveLiveThreadsHome) {
+  // This thread is homed on shard 0, the holder on shard 1.
+  arena_->dealloc_raw(arena_->alloc_raw(16, 8, "main"), 16);
+  std::atomic<bool> homed{false};
+  std::atomic<bool> done{false};
+  std::thread holder([&] {
+    arena_->dealloc_raw(arena_->alloc_raw(16, 8, "holder"), 16);
+    homed = true;
+    while (!done) {
+      std::this_thread::yield();
+    }
+  });
+  while (!homed) {
+    std::this_thread::yield();
+  }
+  // Shard 1 is empty but still a live thread's home.
+  auto all = arena_->create_sub_arena({.capacity = 255 * kShardSize});
+  ASSERT_FALSE(all.has_value());
+  EXPECT_EQ(all.error(), std::errc::not_enough_memory);
+
+  done = true;
+  holder.join();
+  all = arena_->create_sub_arena({.capacity = 255 * kShardSize});
+  EXPECT_TRUE(all.has_value());
+}
+
+TEST_F(SubArenaTest, ExitedThreadsGiveUpTheirHomes) {
+  // More threads than shards: every home has been handed out at least once.
+  for (int i = 0; i < 300; ++i) {
+    std::thread([&] {
+      arena_->dealloc_raw(arena_->alloc_raw(64, 8, "churn"), 64);
+    }).join();
+  }
+  auto sub = arena_->create_sub_arena({.capacity = 128 * kShardSize});
+  ASSERT_TRUE(sub.has_value()) << sub.error().message();
+  auto *p = (*sub)->alloc_raw(64, 8, "tenant");
+  EXPECT_NE(p, nullptr);
+  (*sub)->dealloc_raw(p, 64);
+}
+
+// ─── Allocation and roll-up ─────────────────────────────────────────────
+
+TEST_F(SubArenaTest, AllocationsRollUpIntoParent) {
+  auto before_allocated = arena_->bytes_allocated();
+  auto before_free = arena_->bytes_free();
+
+  auto sub = carve("tenant", 64 * 1024);
+  ASSERT_NE(sub, nullptr);
+  auto *p = sub->alloc<std::uint64_t>("tenant/counter", 42u);
+  ASSERT_NE(p, nullptr);
+  EXPECT_EQ(*p, 42u);
+  EXPECT_TRUE(sub->owns(p));
+  EXPECT_EQ(arena_->allocation_tag(p), "tenant/counter");
+
+  EXPECT_GT(sub->bytes_allocated(), 0u);
+  EXPECT_EQ(arena_->bytes_allocated(),
+            before_allocated + sub->bytes_allocated());
+  EXPECT_EQ(arena_->bytes_allocated() + arena_->bytes_free(),
+            before_allocated + before_free);
+
+  auto stats = sub->stats();
+  EXPECT_EQ(stats.active_blocks, 1u);
+  EXPECT_EQ(stats.allocations, 1u);
+
+  auto snapshot = arena_->snapshot_json();
+  EXPECT_NE(snapshot.find("tenant/counter"), std::string::npos);
+  EXPECT_NE(snapshot.find("\"sub_arenas\""), std::string::npos);
+  EXPECT_NE(arena_->metrics_text().find(
+                "mmap_viz_sub_arena_allocated_bytes{name=\"tenant\"}"),
+            std::string::npos);
+
+  sub->dealloc(p);
+  stats = sub->stats();
+  EXPECT_EQ(stats.active_blocks, 0u);
+  EXPECT_EQ(stats.deallocations, 1u);
+  EXPECT_EQ(arena_->bytes_allocated(), before_allocated);
+}
+
+TEST_F(SubArenaTest, UsageFeedsArenaPressure) {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<PressureEvent> events;
+  arena_->on_pressure({.low = 0.5, .critical = 0.8},
+                      [&](const PressureEvent &e) {
+                        std::lock_guard lock(mutex);
+                        events.push_back(e);
+                        cv.notify_all();
+                      });
+  auto wait_for = [&](std::size_t n) {
+    std::unique_lock lock(mutex);
+    cv.wait_for(lock, std::chrono::seconds(5),
+                [&] { return events.size() >= n; });
+    return events.size();
+  };
+
+  // Fill a tenant holding 15/16 of the parent.
+  auto sub = carve("tenant", 240 * kShardSize);
+  ASSERT_NE(sub, nullptr);
+  while (sub->alloc_raw(1024 - user_offset(8), 8, "fill") != nullptr) {
+  }
+  ASSERT_EQ(wait_for(2), 2u);
+  EXPECT_GE(arena_->pressure_stats().bytes_in_use, kArenaSize * 8 / 10);
+
+  // Releasing drops every block, and the tenant's usage with them; the
+  // level steps down as each range empties.
+  sub->release();
+  EXPECT_EQ(arena_->pressure_stats().bytes_in_use, 0u);
+  const auto raised = arena_->pressure_stats().level_changes;
+  ASSERT_EQ(wait_for(raised), raised);
+
+  std::lock_guard lock(mutex);
+  EXPECT_EQ(events[0].level, PressureLevel::kLow);
+  EXPECT_EQ(events[1].level, PressureLevel::kCritical);
+  EXPECT_EQ(events.back().level, PressureLevel::kNormal);
+  EXPECT_EQ(events[0].shard, PressureEvent::kArena);
+}
+
+TEST_F(SubArenaTest, FullShardSpillsToSiblings) {
+  auto sub = carve("tenant", 4 * kShardSize, 2);
+  ASSERT_NE(sub, nullptr);
+  std::vector<void *> ptrs;
+  while (auto *p = sub->alloc_raw(256, 8, "fill")) {
+    ptrs.push_back(p);
+  }
+  // Both shards filled, not just this thread's.
+  EXPECT_GT(ptrs.size() * 256, 2 * kShardSize);
+  for (auto *p : ptrs) {
+    sub->dealloc_raw(p, 256);
+  }
+  EXPECT_EQ(sub->bytes_allocated(), 0u);
+}
+
+TEST_F(SubArenaTest, ParentThreadsSkipDelegatedShards) {
+  auto sub = carve("tenant", 128 * kShardSize);
+  ASSERT_NE(sub, nullptr);
+  // Enough threads to wrap around every home shard.
+  for (int i = 0; i < 300; ++i) {
+    std::thread([&] {
+      auto *p = arena_->alloc_raw(64, 8, "parent");
+      ASSERT_NE(p, nullptr);
+      EXPECT_FALSE(sub->owns(p));
+      arena_->dealloc_raw(p, 64);
+    }).join();
+  }
+}
+
+TEST_F(SubArenaTest, ConcurrentTenantTraffic) {
+  auto sub = carve("tenant", 64 * kShardSize, 8);
+  ASSERT_NE(sub, nullptr);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&] {
+      std::vector<void *> held;
+      for (int i = 0; i < 2000; ++i) {
+        if (auto *p = sub->alloc_raw(32 + (i % 7) * 48, 16, "work")) {
+          held.push_back(p);
+        }
+        if (held.size() > 32) {
+          sub->dealloc_raw(held.front(), 0);
+          held.erase(held.begin());
+        }
+      }
+      for (auto *p : held) {
+        sub->dealloc_raw(p, 0);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  auto stats = sub->stats();
+  EXPECT_EQ(stats.allocations, stats.deallocations);
+  EXPECT_EQ(stats.active_blocks, 0u);
+  EXPECT_EQ(stats.bytes_allocated, 0u);
+  EXPECT_EQ(stats.bytes_free, sub->capacity());
+}
+
+// ─── Ranges ─────────────────────────────────────────────────────────────
+
+TEST_F(SubArenaTest, RangesSplitEachShard) {
+  auto sub = arena_->create_sub_arena({.name = "ranged",
+                                       .capacity = 64 * kShardSize,
+                                       .shard_count = 2,
+                                       .ranges_per_shard = 4});
+  ASSERT_TRUE(sub.has_value());
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&] {
+      std::vector<void *> held;
+      for (int i = 0; i < 2000; ++i) {
+        if (auto *p = (*sub)->alloc_raw(32 + (i % 7) * 48, 16, "work")) {
+          held.push_back(p);
+        }
+        if (held.size() > 32) {
+          (*sub)->dealloc_raw(held.front(), 0);
+          held.erase(held.begin());
+        }
+      }
+      for (auto *p : held) {
+        (*sub)->dealloc_raw(p, 0);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  auto stats = (*sub)->stats();
+  EXPECT_EQ(stats.shard_count, 2u);
+  EXPECT_EQ(stats.ranges_per_shard, 4u);
+  EXPECT_EQ(stats.allocations, stats.deallocations);
+  EXPECT_EQ(stats.active_blocks, 0u);
+  EXPECT_EQ(stats.bytes_free, (*sub)->capacity());
+  EXPECT_NE(arena_->snapshot_json().find("\"ranges_per_shard\":4"),
+            std::string::npos);
+}
+
+TEST_F(SubArenaTest, ManyRangesBuiltOnDemand) {
+  // 512 ranges of 1 KB; only the ones traffic reaches get built.
+  auto sub = arena_->create_sub_arena({.capacity = 128 * kShardSize,
+                                       .shard_count = 64,
+                                       .ranges_per_shard = 8});
+  ASSERT_TRUE(sub.has_value());
+  auto &tenant = **sub;
+  EXPECT_EQ(tenant.bytes_free(), tenant.capacity());
+  EXPECT_EQ(tenant.stats().bytes_free, tenant.capacity());
+
+  auto *p = tenant.alloc_raw(100, 8, "first");
+  ASSERT_NE(p, nullptr);
+  auto stats = tenant.stats();
+  EXPECT_EQ(stats.active_blocks, 1u);
+  EXPECT_EQ(stats.bytes_allocated + stats.bytes_free, tenant.capacity());
+  EXPECT_NE(arena_->snapshot_json().find("\"first\""), std::string::npos);
+
+  // Filling it builds every range.
+  std::vector<void *> ptrs{p};
+  while (auto *q = tenant.alloc_raw(512, 8, "fill")) {
+    ptrs.push_back(q);
+  }
+  EXPECT_GE(ptrs.size(), 512u);
+  for (auto *q : ptrs) {
+    tenant.dealloc_raw(q, 0);
+  }
+  EXPECT_EQ(tenant.bytes_free(), tenant.capacity());
+}
+
+TEST_F(SubArenaTest, LargeBlockStraddlesRangeEdge) {
+  // Four 4-shard ranges: a 6-shard block fits none of them alone.
+  auto sub = arena_->create_sub_arena(
+      {.capacity = 16 * kShardSize, .shard_count = 1, .ranges_per_shard = 4});
+  ASSERT_TRUE(sub.has_value());
+  auto &tenant = **sub;
+  auto *p = tenant.alloc_raw(6 * kShardSize, 64, "large");
+  ASSERT_NE(p, nullptr);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % 64, 0u);
+  EXPECT_EQ(arena_->allocation_tag(p), "large");
+  auto stats = tenant.stats();
+  EXPECT_EQ(stats.edge_allocations, 1u);
+  EXPECT_EQ(stats.active_blocks, 1u);
+  EXPECT_GT(stats.bytes_allocated, 6 * kShardSize);
+
+  // Small blocks still come from the ranges on either side: four threads
+  // start on the four ranges in turn, so one lands right after the block.
+  std::vector<void *> after(40);
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (std::size_t i = t * 10; i < (t + 1) * 10; ++i) {
+        after[i] = tenant.alloc_raw(200, 8, "after");
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  auto *upper_end = tenant.base() + (8 * kShardSize);
+  EXPECT_TRUE(std::ranges::any_of(after, [&](void *q) {
+    return q > p && q < upper_end;
+  }));
+
+  // The snapshot walks the ranges as one: the edge block is listed, and
+  // the walk of the upper range resumes at its end.
+  auto count = [](const std::string &text, const std::string &what) {
+    std::size_t n = 0;
+    for (auto pos = text.find(what); pos != std::string::npos;
+         pos = text.find(what, pos + 1)) {
+      ++n;
+    }
+    return n;
+  };
+  auto snapshot = arena_->snapshot_json();
+  EXPECT_EQ(count(snapshot, "\"large\""), 1u);
+  EXPECT_EQ(count(snapshot, "\"after\""), 40u);
+  for (auto *q : after) {
+    ASSERT_NE(q, nullptr);
+    tenant.dealloc_raw(q, 200);
+  }
+
+  // Each part returns to its own range, which merges back to one block.
+  tenant.dealloc_raw(p, 6 * kShardSize);
+  stats = tenant.stats();
+  EXPECT_EQ(stats.active_blocks, 0u);
+  EXPECT_EQ(stats.bytes_allocated, 0u);
+  EXPECT_EQ(stats.bytes_free, tenant.capacity());
+  auto *again = tenant.alloc_raw(6 * kShardSize, 64, "large");
+  ASSERT_NE(again, nullptr);
+  EXPECT_EQ(again, p);
+  tenant.dealloc_raw(again, 6 * kShardSize);
+
+  // Too large for any edge.
+  EXPECT_EQ(tenant.alloc_raw(9 * kShardSize, 8, "huge"), nullptr);
+}
+
+TEST_F(SubArenaTest, EdgeFragmentsStayBounded) {
+  // Four 16 KB ranges filled with 1 KB blocks, 16 per range.
+  auto sub = arena_->create_sub_arena(
+      {.capacity = 16 * kShardSize, .shard_count = 1, .ranges_per_shard = 4});
+  ASSERT_TRUE(sub.has_value());
+  auto &tenant = **sub;
+  constexpr std::size_t kBlock = 1024;
+  std::vector<std::byte *> ptrs;
+  while (auto *p = tenant.alloc_raw(kBlock - user_offset(8), 8, "fill")) {
+    ptrs.push_back(static_cast<std::byte *>(p));
+  }
+  ASSERT_EQ(ptrs.size(), 4 * 16u);
+  EXPECT_EQ(tenant.stats().free_blocks, 0u);
+  std::ranges::sort(ptrs);
+
+  // Free the block on each side of each edge: adjacent free space that
+  // stays split in two, and no more than that.
+  for (std::size_t edge = 16; edge < ptrs.size(); edge += 16) {
+    tenant.dealloc_raw(ptrs[edge - 1], 0);
+    tenant.dealloc_raw(ptrs[edge], 0);
+    ptrs[edge - 1] = ptrs[edge] = nullptr;
+  }
+  EXPECT_EQ(tenant.stats().free_blocks, 2 * 3u);
+
+  // No range has 1.5 KB in one piece, but each split run still serves it.
+  std::vector<void *> across;
+  for (int i = 0; i < 3; ++i) {
+    auto *p = tenant.alloc_raw(kBlock + 512 - user_offset(8), 8, "across");
+    ASSERT_NE(p, nullptr);
+    across.push_back(p);
+  }
+  EXPECT_EQ(tenant.stats().edge_allocations, 3u);
+
+  // Once everything is freed, each range is one free block again.
+  for (auto *p : across) {
+    tenant.dealloc_raw(p, 0);
+  }
+  for (auto *p : ptrs) {
+    tenant.dealloc_raw(p, 0);
+  }
+  auto stats = tenant.stats();
+  EXPECT_EQ(stats.free_blocks, 4u);
+  EXPECT_EQ(stats.bytes_free, tenant.capacity());
+}
+
+// ─── Release ────────────────────────────────────────────────────────────
+
+TEST_F(SubArenaTest, ReleaseReturnsRangeToParent) {
+  auto free_before = arena_->bytes_free();
+  auto sub = carve("tenant", 64 * 1024);
+  ASSERT_NE(sub, nullptr);
+  auto *base = sub->base();
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_NE(sub->alloc_raw(100, 8, "leaked"), nullptr);
+  }
+  EXPECT_LT(arena_->bytes_free(), free_before);
+
+  // Every block goes at once, without freeing them one by one.
+  sub->release();
+  EXPECT_EQ(sub->capacity(), 0u);
+  EXPECT_EQ(sub->alloc_raw(16, 8, "late"), nullptr);
+  EXPECT_TRUE(arena_->sub_arena_stats().empty());
+  EXPECT_EQ(arena_->bytes_free(), free_before);
+  EXPECT_EQ(arena_->snapshot_json().find("leaked"), std::string::npos);
+
+  // The same range can be delegated again, and destruction releases too.
+  auto again = carve("again", 64 * 1024);
+  ASSERT_NE(again, nullptr);
+  EXPECT_EQ(again->base(), base);
+  again.reset();
+  EXPECT_TRUE(arena_->sub_arena_stats().empty());
+}
@@ -0,0 +1,119 @@
+/// @file test_tag_quota.cpp
+/// @brief Unit tests for TagQuotas.
+
+#include "interface/tag_quota.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mmap_viz;
+
+// ─── Matching ───────────────────────────────────────────────────────────
+
+TEST(TagQuotasTest, LongestPrefixWins) {
+  TagQuotas q({{.prefix = "GET", .limit_bytes = 100},
+               {.prefix = "GET /api/users", .limit_bytes = 200},
+               {.prefix = "", .limit_bytes = 300}});
+  EXPECT_EQ(q.find("GET /api/users #1 [resp]"), 1u);
+  EXPECT_EQ(q.find("GET /api/data #1 [resp]"), 0u);
+  EXPECT_EQ(q.find("POST /api/upload"), 2u);
+  EXPECT_EQ(q.find(""), 2u);
+
+  TagQuotas none({{.prefix = "STREAM", .limit_bytes = 1}});
+  EXPECT_EQ(none.find("GET"), TagQuotas::kNone);
+  EXPECT_EQ(none.find("STREA"), TagQuotas::kNone);
+}
+
+TEST(TagQuotasTest, Validation) {
+  EXPECT_TRUE(TagQuotas::valid({}));
+  EXPECT_TRUE(TagQuotas::valid({{.prefix = "a"}, {.prefix = "ab"}}));
+  EXPECT_FALSE(TagQuotas::valid({{.prefix = "a"}, {.prefix = "a"}}));
+  EXPECT_FALSE(TagQuotas::valid(
+      {{.prefix = std::string(TagQuotas::kMaxPrefix + 1, 'x')}}));
+}
+
+// ─── Accounting ─────────────────────────────────────────────────────────
+
+TEST(TagQuotasTest, ChargeUpToLimitThenRefuse) {
+  TagQuotas q({{.prefix = "t", .limit_bytes = 6400}});
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(q.try_charge(0, 0, 64)) << "charge " << i;
+  }
+  EXPECT_FALSE(q.try_charge(0, 0, 64));
+  EXPECT_FALSE(q.try_charge(0, 0, 1));
+
+  auto s = q.stats();
+  ASSERT_EQ(s.size(), 1u);
+  EXPECT_EQ(s[0].bytes_in_use, 6400u);
+  EXPECT_EQ(s[0].hits, 2u);
+
+  q.credit(0, 0, 64);
+  EXPECT_TRUE(q.try_charge(0, 0, 64));
+}
+
+TEST(TagQuotasTest, IdleTokensOnOtherStripesAreReclaimed) {
+  // Stripe 0 takes a chunk it never uses; stripe 1 must still reach the
+  // full limit.
+  TagQuotas q({{.prefix = "t", .limit_bytes = 64 * 1024}});
+  ASSERT_TRUE(q.try_charge(0, 0, 16));
+  q.credit(0, 0, 16);
+
+  std::size_t charged = 0;
+  while (q.try_charge(0, 1, 16)) {
+    charged += 16;
+  }
+  EXPECT_EQ(charged, 64u * 1024);
+  EXPECT_EQ(q.stats()[0].bytes_in_use, 64u * 1024);
+}
+
+TEST(TagQuotasTest, CreditOnAnotherStripe) {
+  TagQuotas q({{.prefix = "t", .limit_bytes = 4096}});
+  ASSERT_TRUE(q.try_charge(0, 3, 4096));
+  EXPECT_FALSE(q.try_charge(0, 5, 16));
+  q.credit(0, 5, 4096);
+  EXPECT_EQ(q.stats()[0].bytes_in_use, 0u);
+  EXPECT_TRUE(q.try_charge(0, 7, 4096));
+}
+
+TEST(TagQuotasTest, ConcurrentChargesNeverExceedLimit) {
+  constexpr std::size_t kLimit = 256 * 1024;
+  constexpr std::size_t kBlock = 128;
+  TagQuotas q({{.prefix = "t", .limit_bytes = kLimit}});
+
+  constexpr int kThreads = 8;
+  std::atomic<std::size_t> live{0};
+  std::atomic<std::size_t> peak{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      std::size_t held = 0;
+      for (int i = 0; i < 20000; ++i) {
+        if (i % 3 != 2 && q.try_charge(0, t, kBlock)) {
+          ++held;
+          auto now = live.fetch_add(kBlock) + kBlock;
+          auto p = peak.load();
+          while (now > p && !peak.compare_exchange_weak(p, now)) {
+          }
+        } else if (held > 0) {
+          --held;
+          live.fetch_sub(kBlock);
+          q.credit(0, t, kBlock);
+        }
+      }
+      while (held-- > 0) {
+        live.fetch_sub(kBlock);
+        q.credit(0, t, kBlock);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  EXPECT_LE(peak.load(), kLimit);
+  EXPECT_EQ(q.stats()[0].bytes_in_use, 0u);
+}
@@ -0,0 +1,173 @@
+/// @file test_tracked_pool_resource.cpp
+/// @brief Unit tests for the TrackedPoolResource pmr front end.
+
+#include "allocator/tracked_pool_resource.hpp"
+#include "interface/visualization_arena.hpp"
+
+#include <gtest/gtest.h>
+#include <list>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mmap_viz;
+
+// ─── Test fixture ────────────────────────────────────────────────────────
+
+class TrackedPoolResourceTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    // Each thread uses one of 256 shards, so 64MB gives 256KB per thread.
+    auto result = VisualizationArena::create({.arena_size = 64 * 1024 * 1024});
+    ASSERT_TRUE(result.has_value()) << "Failed to create VisualizationArena";
+    arena_ = std::make_unique<VisualizationArena>(std::move(*result));
+  }
+
+  static auto options() -> TrackedPoolOptions {
+    return {.chunk_size = 4096, .max_node_size = 256};
+  }
+
+  std::unique_ptr<VisualizationArena> arena_;
+};
+
+// ─── Pooling ────────────────────────────────────────────────────────────
+
+TEST_F(TrackedPoolResourceTest, NodesShareChunks) {
+  UnsynchronizedTrackedPoolResource pool{*arena_, options()};
+  const auto before = arena_->bytes_allocated();
+
+  std::vector<void *> nodes;
+  for (int i = 0; i < 100; ++i) {
+    nodes.push_back(pool.allocate(24, 8));
+  }
+
+  // 100 x 32B nodes fit in one 4KB chunk: one arena block, not 100.
+  auto chunks = pool.chunks();
+  ASSERT_EQ(chunks.size(), 1u);
+  EXPECT_EQ(chunks[0].node_size, 32u);
+  EXPECT_EQ(chunks[0].used, 100u);
+  EXPECT_LT(arena_->bytes_allocated() - before, 2u * 4096);
+
+  for (void *p : nodes) {
+    pool.deallocate(p, 24, 8);
+  }
+  EXPECT_EQ(pool.chunks()[0].used, 0u);
+}
+
+TEST_F(TrackedPoolResourceTest, NodesAreAlignedAndDistinct) {
+  UnsynchronizedTrackedPoolResource pool{*arena_, options()};
+  auto *a = static_cast<std::byte *>(pool.allocate(64, 64));
+  auto *b = static_cast<std::byte *>(pool.allocate(64, 64));
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(a) % 64, 0u);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(b) % 64, 0u);
+  EXPECT_GE(static_cast<std::size_t>(b > a ? b - a : a - b), 64u);
+  pool.deallocate(a, 64, 64);
+  pool.deallocate(b, 64, 64);
+}
+
+TEST_F(TrackedPoolResourceTest, LargeRequestsBypassPool) {
+  UnsynchronizedTrackedPoolResource pool{*arena_, options()};
+  void *p = pool.allocate(1024, 16);
+  EXPECT_TRUE(pool.chunks().empty());
+  EXPECT_GE(arena_->bytes_allocated(), 1024u);
+  pool.deallocate(p, 1024, 16);
+}
+
+TEST_F(TrackedPoolResourceTest, EmptyChunksReturnToArena) {
+  UnsynchronizedTrackedPoolResource pool{*arena_, options()};
+  std::vector<void *> nodes;
+  // 128 x 32B nodes per chunk, so this spans three chunks.
+  for (int i = 0; i < 300; ++i) {
+    nodes.push_back(pool.allocate(32, 8));
+  }
+  EXPECT_EQ(pool.chunks().size(), 3u);
+
+  for (void *p : nodes) {
+    pool.deallocate(p, 32, 8);
+  }
+  // One empty chunk is kept so the next allocation is cheap.
+  EXPECT_EQ(pool.chunks().size(), 1u);
+
+  pool.release();
+  EXPECT_TRUE(pool.chunks().empty());
+}
+
+TEST_F(TrackedPoolResourceTest, WorksAsPmrResource) {
+  UnsynchronizedTrackedPoolResource pool{*arena_, options()};
+  {
+    std::pmr::list<int> list{&pool};
+    for (int i = 0; i < 500; ++i) {
+      list.push_back(i);
+    }
+    EXPECT_EQ(list.size(), 500u);
+    EXPECT_FALSE(pool.chunks().empty());
+  }
+  for (const auto &chunk : pool.chunks()) {
+    EXPECT_EQ(chunk.used, 0u);
+  }
+}
+
+// ─── Reporting ──────────────────────────────────────────────────────────
+
+TEST_F(TrackedPoolResourceTest, ReportsOccupancyNotNodes) {
+  (void)arena_->event_log_json(); // Drain setup events.
+  UnsynchronizedTrackedPoolResource pool{*arena_, options()};
+  std::vector<void *> nodes;
+  for (int i = 0; i < 64; ++i) {
+    nodes.push_back(pool.allocate(32, 8));
+  }
+
+  auto log = arena_->event_log_json();
+  EXPECT_NE(log.find("\"occupancy\""), std::string::npos);
+  EXPECT_NE(log.find("\"pool:32\""), std::string::npos);
+  EXPECT_EQ(log.find("\"tag\":\"pool\""), std::string::npos)
+      << "Per-node events are off by default";
+
+  for (void *p : nodes) {
+    pool.deallocate(p, 32, 8);
+  }
+}
+
+TEST_F(TrackedPoolResourceTest, SampledNodeEvents) {
+  auto opts = options();
+  opts.node_sampling = 1;
+  UnsynchronizedTrackedPoolResource pool{*arena_, opts};
+  void *p = pool.allocate(32, 8);
+
+  auto log = arena_->event_log_json();
+  EXPECT_NE(log.find("\"tag\":\"pool\""), std::string::npos);
+  pool.deallocate(p, 32, 8);
+}
+
+// ─── Thread safety ──────────────────────────────────────────────────────
+
+TEST_F(TrackedPoolResourceTest, SynchronizedPoolAcrossThreads) {
+  SynchronizedTrackedPoolResource pool{*arena_, options()};
+  constexpr int kThreads = 4;
+  constexpr int kOps = 2000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&pool] {
+      std::vector<void *> mine;
+      for (int i = 0; i < kOps; ++i) {
+        mine.push_back(pool.allocate(48, 16));
+        if (mine.size() > 64) {
+          pool.deallocate(mine.front(), 48, 16);
+          mine.erase(mine.begin());
+        }
+      }
+      for (void *p : mine) {
+        pool.deallocate(p, 48, 16);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  for (const auto &chunk : pool.chunks()) {
+    EXPECT_EQ(chunk.used, 0u);
+  }
+}
@@ -7,6 +7,8 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+
 using namespace mmap_viz;
 
 class TrackerTest : public ::testing::Test {
@@ -84,6 +86,28 @@ TEST_F(TrackerTest, Sampling) {
   EXPECT_EQ(events[0].type, EventType::Deallocate);
 }
 
+TEST_F(TrackerTest, SharedSamplingRateChangesAtRuntime) {
+  std::atomic<std::size_t> rate{1};
+  LocalTracker shared(*alloc_, rate);
+
+  EXPECT_TRUE(shared.next_sampled());
+  shared.record_dealloc(0, 0); // ID 1, kept.
+  rate = 4;
+  for (int i = 0; i < 7; ++i) { // IDs 2..8: only 4 and 8 kept.
+    if (shared.next_sampled()) {
+      shared.record_dealloc(0, 0);
+    } else {
+      shared.skip();
+    }
+  }
+
+  std::vector<AllocationEvent> events;
+  shared.drain_to(events);
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[1].event_id, 4u);
+  EXPECT_EQ(events[2].event_id, 8u);
+}
+
 TEST_F(TrackerTest, EventMonotonicity) {
   for (int i = 0; i < 5; ++i) {
     tracker_->record_dealloc(0, 0);
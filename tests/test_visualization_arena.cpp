@@ -5,6 +5,8 @@
 #include "interface/visualization_arena.hpp"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <gtest/gtest.h>
 #include <memory_resource>
 #include <string>
@@ -46,6 +48,32 @@ TEST_F(VisualizationArenaTest, CreateWithCustomConfig) {
   EXPECT_EQ(result->cache_line_size(), 128u);
 }
 
+TEST_F(VisualizationArenaTest, UntouchedShardsCountAsFree) {
+  // No shard is built until a thread is homed on it.
+  EXPECT_EQ(arena_->bytes_free(), arena_->capacity());
+
+  void *p = nullptr;
+  std::thread([&] { p = arena_->alloc_raw(100, 8, "one"); }).join();
+  ASSERT_NE(p, nullptr);
+  EXPECT_GT(arena_->bytes_allocated(), 0u);
+  EXPECT_EQ(arena_->bytes_allocated() + arena_->bytes_free(),
+            arena_->capacity());
+  EXPECT_NE(arena_->snapshot_json().find("\"one\""), std::string::npos);
+  arena_->dealloc_raw(p, 100);
+  EXPECT_EQ(arena_->bytes_free(), arena_->capacity());
+}
+
+TEST_F(VisualizationArenaTest, CreateLargeArenaIsCheap) {
+  // 16 GB reserved; only the pages the first block touches are backed.
+  auto result = VisualizationArena::create(
+      {.arena_size = std::size_t{16} << 30, .enable_server = false});
+  ASSERT_TRUE(result.has_value()) << result.error().message();
+  EXPECT_EQ(result->bytes_free(), result->capacity());
+  auto *p = result->alloc_raw(64, 8, "first");
+  ASSERT_NE(p, nullptr);
+  result->dealloc_raw(p, 64);
+}
+
 TEST_F(VisualizationArenaTest, CreateWithZeroFails) {
   auto result = VisualizationArena::create({.arena_size = 0});
   EXPECT_FALSE(result.has_value());
@@ -125,6 +153,56 @@ TEST_F(VisualizationArenaTest, PmrInterop) {
   EXPECT_GT(arena_->bytes_allocated(), 0u);
 }
 
+TEST_F(VisualizationArenaTest, PmrOverflowFallsThroughToUpstream) {
+  auto *res = arena_->resource();
+  const std::size_t big = arena_->capacity() + 1;
+
+  void *p = res->allocate(big, 16);
+  ASSERT_NE(p, nullptr);
+  EXPECT_FALSE(arena_->owns(p));
+  static_cast<char *>(p)[big - 1] = 'x'; // Usable memory.
+
+  auto stats = arena_->overflow_stats();
+  EXPECT_EQ(stats.allocations, 1u);
+  EXPECT_EQ(stats.bytes_in_use, big);
+  EXPECT_NE(arena_->snapshot_json().find("\"overflow\""), std::string::npos);
+
+  res->deallocate(p, big, 16);
+  stats = arena_->overflow_stats();
+  EXPECT_EQ(stats.deallocations, 1u);
+  EXPECT_EQ(stats.bytes_in_use, 0u);
+  EXPECT_EQ(stats.peak_bytes, big);
+
+  auto log = arena_->event_log_json();
+  EXPECT_NE(log.find("\"overflow_allocate\""), std::string::npos);
+  EXPECT_NE(log.find("\"overflow_deallocate\""), std::string::npos);
+}
+
+TEST_F(VisualizationArenaTest, PmrFreesRoutedByAddress) {
+  auto *res = arena_->resource();
+  void *in_arena = res->allocate(64, 16);
+  void *overflow = res->allocate(arena_->capacity() + 1, 16);
+  EXPECT_TRUE(arena_->owns(in_arena));
+  EXPECT_FALSE(arena_->owns(overflow));
+
+  const auto allocated = arena_->bytes_allocated();
+  res->deallocate(overflow, arena_->capacity() + 1, 16);
+  EXPECT_EQ(arena_->bytes_allocated(), allocated); // Arena untouched.
+  res->deallocate(in_arena, 64, 16);
+  EXPECT_LT(arena_->bytes_allocated(), allocated);
+  EXPECT_EQ(arena_->overflow_stats().allocations, 1u);
+}
+
+TEST_F(VisualizationArenaTest, PmrOverflowDisabledThrows) {
+  auto result = VisualizationArena::create(
+      {.arena_size = 1024 * 1024, .overflow_upstream = nullptr});
+  ASSERT_TRUE(result.has_value());
+  auto *res = result->resource();
+  EXPECT_THROW((void)res->allocate(result->capacity() + 1, 16),
+               std::bad_alloc);
+  EXPECT_EQ(result->overflow_stats().allocations, 0u);
+}
+
 // ─── Padding report ─────────────────────────────────────────────────────
 
 TEST_F(VisualizationArenaTest, DISABLED_PaddingReport) {
@@ -162,6 +240,21 @@ TEST_F(VisualizationArenaTest, SnapshotJson) {
   EXPECT_NE(json.find("\"capacity\""), std::string::npos);
 }
 
+TEST_F(VisualizationArenaTest, SnapshotJsonListsEveryLiveBlock) {
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_NE(arena_->alloc_raw(100, 16, "walk"), nullptr);
+  }
+
+  auto json = arena_->snapshot_json();
+  std::size_t count = 0;
+  for (auto pos = json.find("\"walk\""); pos != std::string::npos;
+       pos = json.find("\"walk\"", pos + 1)) {
+    ++count;
+  }
+  EXPECT_EQ(count, 10u);
+  EXPECT_NE(json.find("\"size\":100"), std::string::npos);
+}
+
 TEST_F(VisualizationArenaTest, EventLogJson) {
   arena_->alloc_raw(64, 16, "log_test");
 
@@ -267,6 +360,364 @@ TEST_F(VisualizationArenaTest, MultiThreadedAlloc) {
   EXPECT_EQ(arena_->bytes_allocated(), 0u);
 }
 
+TEST_F(VisualizationArenaTest, ShardLockStatsCountAllocPaths) {
+  auto before = arena_->shard_lock_stats();
+
+  // Large enough to bypass the lock-free small-block cache.
+  void *p = arena_->alloc_raw(256, 16, "lock_stats");
+  ASSERT_NE(p, nullptr);
+  arena_->dealloc_raw(p, 256);
+  (void)arena_->snapshot_json(); // Diagnostics are not counted.
+
+  auto after = arena_->shard_lock_stats();
+  EXPECT_EQ(after.acquisitions - before.acquisitions, 2u);
+  EXPECT_EQ(after.contended, before.contended);
+}
+
+TEST_F(VisualizationArenaTest, ShardLockProfilesCountRemoteFrees) {
+  void *local = arena_->alloc_raw(256, 16, "local");
+  void *shared = arena_->alloc_raw(256, 16, "shared");
+  ASSERT_NE(local, nullptr);
+  ASSERT_NE(shared, nullptr);
+  arena_->dealloc_raw(local, 256);
+  // Freed by a thread homed on a different shard.
+  std::thread([&] { arena_->dealloc_raw(shared, 256); }).join();
+
+  auto profiles = arena_->shard_lock_profiles();
+  ASSERT_EQ(profiles.size(), 256u);
+  ShardLockProfile total;
+  for (const auto &p : profiles) {
+    total.acquisitions += p.acquisitions;
+    total.remote += p.remote;
+    total.wait_ns += p.wait_ns;
+  }
+  EXPECT_EQ(total.acquisitions, 4u);
+  EXPECT_EQ(total.remote, 1u);
+  EXPECT_EQ(total.wait_ns.count, 4u);
+}
+
+TEST_F(VisualizationArenaTest, ShardLockKindFromConfig) {
+  for (auto kind : {ShardLockKind::kAdaptive, ShardLockKind::kMutex}) {
+    auto result = VisualizationArena::create(
+        {.arena_size = 1024 * 1024, .shard_lock = kind});
+    ASSERT_TRUE(result.has_value());
+    auto &va = *result;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&va] {
+        for (int i = 0; i < 200; ++i) {
+          void *p = va.alloc_raw(256, 16, "kind");
+          ASSERT_NE(p, nullptr);
+          va.dealloc_raw(p, 256);
+        }
+      });
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+    EXPECT_EQ(va.bytes_allocated(), 0u);
+    EXPECT_EQ(va.shard_lock_stats().acquisitions, 4u * 200 * 2);
+  }
+}
+
+TEST_F(VisualizationArenaTest, SmallBlocksSkipShardLock) {
+  // Block size (request + 64 B header/footer) within the small classes.
+  void *first = arena_->alloc_raw(48, 16, "small");
+  ASSERT_NE(first, nullptr);
+  arena_->dealloc_raw(first, 48);
+  auto before = arena_->shard_lock_stats();
+
+  // Same-thread churn and a foreign-thread free, all lock-free.
+  for (int i = 0; i < 100; ++i) {
+    void *p = arena_->alloc_raw(48, 16, "small");
+    ASSERT_NE(p, nullptr);
+    arena_->dealloc_raw(p, 48);
+  }
+  void *shared = arena_->alloc_raw(48, 16, "small");
+  std::thread([&] { arena_->dealloc_raw(shared, 48); }).join();
+
+  EXPECT_EQ(arena_->shard_lock_stats().acquisitions, before.acquisitions);
+  EXPECT_EQ(arena_->bytes_allocated(), 0u);
+  EXPECT_EQ(arena_->bytes_allocated() + arena_->bytes_free(),
+            arena_->capacity());
+}
+
+TEST_F(VisualizationArenaTest, SmallBlockCacheReusesBlocks) {
+  // Fill the thread's shard with small blocks, free them all into the
+  // cache, then fill it again from the cache.
+  auto fill = [&] {
+    std::vector<void *> blocks;
+    while (void *p = arena_->alloc_raw(48, 16, "fill")) {
+      blocks.push_back(p);
+    }
+    return blocks;
+  };
+  auto first = fill();
+  ASSERT_FALSE(first.empty());
+  for (void *p : first) {
+    arena_->dealloc_raw(p, 48);
+  }
+  EXPECT_EQ(arena_->bytes_allocated(), 0u);
+
+  auto second = fill();
+  EXPECT_EQ(second.size(), first.size());
+  for (void *p : second) {
+    arena_->dealloc_raw(p, 48);
+  }
+}
+
+TEST_F(VisualizationArenaTest, SmallBlockCacheCanBeDisabled) {
+  auto result = VisualizationArena::create(
+      {.arena_size = 1024 * 1024, .small_block_cache = false});
+  ASSERT_TRUE(result.has_value());
+  auto before = result->shard_lock_stats();
+  void *p = result->alloc_raw(48, 16, "small");
+  ASSERT_NE(p, nullptr);
+  result->dealloc_raw(p, 48);
+  EXPECT_EQ(result->shard_lock_stats().acquisitions - before.acquisitions,
+            2u);
+}
+
+TEST_F(VisualizationArenaTest, MetricsTextIsPrometheus) {
+  void *p = arena_->alloc_raw(256, 16, "metrics");
+  ASSERT_NE(p, nullptr);
+  arena_->dealloc_raw(p, 256);
+
+  auto text = arena_->metrics_text();
+  EXPECT_NE(text.find("# TYPE mmap_viz_shard_lock_wait_seconds histogram"),
+            std::string::npos);
+  EXPECT_NE(text.find("mmap_viz_shard_lock_acquisitions_total{shard=\""),
+            std::string::npos);
+  EXPECT_NE(text.find("mmap_viz_shard_lock_wait_seconds_bucket{shard=\""),
+            std::string::npos);
+  EXPECT_NE(text.find("le=\"+Inf\"} 2"), std::string::npos);
+  EXPECT_NE(text.find("mmap_viz_arena_capacity_bytes "), std::string::npos);
+}
+
+// ─── Memory pressure ────────────────────────────────────────────────────
+
+TEST_F(VisualizationArenaTest, ShardPressureCallbacksRunAsync) {
+  auto result = VisualizationArena::create({.arena_size = 16 * 1024 * 1024});
+  ASSERT_TRUE(result.has_value());
+  auto &va = *result;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<PressureEvent> events;
+  const auto caller = std::this_thread::get_id();
+  std::atomic<bool> on_caller{false};
+  va.on_shard_pressure({.low = 0.5, .critical = 0.9},
+                       [&](const PressureEvent &e) {
+                         if (std::this_thread::get_id() == caller)
+                           on_caller = true;
+                         std::lock_guard lock(mutex);
+                         events.push_back(e);
+                         cv.notify_all();
+                       });
+  auto wait_for = [&](std::size_t n) {
+    std::unique_lock lock(mutex);
+    cv.wait_for(lock, std::chrono::seconds(5),
+                [&] { return events.size() >= n; });
+    return events.size();
+  };
+
+  // Fill this thread's shard to the brim.
+  std::vector<void *> held;
+  while (void *p = va.alloc_raw(1024, 16, "pressure")) {
+    held.push_back(p);
+  }
+  ASSERT_EQ(wait_for(2), 2u);
+  EXPECT_GT(va.pressure_stats().bytes_in_use, 0u);
+
+  // Emptying it steps back down through low.
+  for (void *p : held) {
+    va.dealloc_raw(p, 1024);
+  }
+  ASSERT_EQ(wait_for(4), 4u);
+
+  std::lock_guard lock(mutex);
+  EXPECT_EQ(events[0].level, PressureLevel::kLow);
+  EXPECT_EQ(events[1].level, PressureLevel::kCritical);
+  EXPECT_EQ(events[2].level, PressureLevel::kLow);
+  EXPECT_EQ(events[3].level, PressureLevel::kNormal);
+  EXPECT_EQ(events[0].shard, events[3].shard);
+  EXPECT_EQ(events[0].capacity, va.capacity() / 256);
+  EXPECT_FALSE(on_caller);
+  EXPECT_EQ(va.pressure_stats().level_changes, 4u);
+}
+
+TEST_F(VisualizationArenaTest, ReclaimHandlerRetriesAllocation) {
+  auto result = VisualizationArena::create({.arena_size = 16 * 1024 * 1024});
+  ASSERT_TRUE(result.has_value());
+  auto &va = *result;
+
+  std::vector<void *> held;
+  while (void *p = va.alloc_raw(1024, 16, "cache")) {
+    held.push_back(p);
+  }
+  ASSERT_FALSE(held.empty());
+  EXPECT_EQ(va.pressure_stats().reclaim_calls, 0u);
+
+  // Shed half the "cache" when the shard runs out.
+  std::size_t requested = 0;
+  va.set_reclaim_handler([&](std::size_t bytes) {
+    requested = bytes;
+    auto keep = held.size() / 2;
+    for (auto i = keep; i < held.size(); ++i) {
+      va.dealloc_raw(held[i], 1024);
+    }
+    held.resize(keep);
+    return true;
+  });
+  void *p = va.alloc_raw(4096, 16, "needs room");
+  ASSERT_NE(p, nullptr);
+  EXPECT_EQ(requested, 4096u);
+  EXPECT_EQ(va.pressure_stats().reclaim_calls, 1u);
+  va.dealloc_raw(p, 4096);
+
+  // A handler with nothing left to free is asked once per failure.
+  va.set_reclaim_handler([](std::size_t) { return false; });
+  while (void *q = va.alloc_raw(1024, 16, "fill")) {
+    held.push_back(q);
+  }
+  auto calls = va.pressure_stats().reclaim_calls;
+  EXPECT_EQ(va.alloc_raw(1024, 16, "fill"), nullptr);
+  EXPECT_EQ(va.pressure_stats().reclaim_calls, calls + 1);
+
+  va.set_reclaim_handler(nullptr);
+  for (void *q : held) {
+    va.dealloc_raw(q, 1024);
+  }
+}
+
+// ─── Tag quotas ─────────────────────────────────────────────────────────
+
+TEST_F(VisualizationArenaTest, TagQuotaRefusesAndRefunds) {
+  auto result = VisualizationArena::create({
+      .arena_size = 16 * 1024 * 1024,
+      .tag_quotas = {{.prefix = "session", .limit_bytes = 8 * 1024}},
+  });
+  ASSERT_TRUE(result.has_value());
+  auto &va = *result;
+
+  // 1000 bytes plus the 64-byte header make 1072-byte blocks: 7 fit.
+  std::vector<void *> held;
+  for (int i = 0; i < 7; ++i) {
+    auto p = va.try_alloc_raw(1000, 16, "session #" + std::to_string(i));
+    ASSERT_TRUE(p.has_value()) << i;
+    held.push_back(*p);
+  }
+  auto refused = va.try_alloc_raw(1000, 16, "session #7");
+  ASSERT_FALSE(refused.has_value());
+  EXPECT_EQ(refused.error(), AllocFailure::kQuotaExceeded);
+  EXPECT_EQ(va.alloc_raw(1000, 16, "session #8"), nullptr);
+
+  // Other tags are not charged.
+  void *other = va.alloc_raw(1000, 16, "index");
+  ASSERT_NE(other, nullptr);
+  va.dealloc_raw(other, 1000);
+
+  auto stats = va.quota_stats();
+  ASSERT_EQ(stats.size(), 1u);
+  EXPECT_EQ(stats[0].bytes_in_use, 7u * 1072);
+  EXPECT_EQ(stats[0].hits, 2u);
+
+  // Both dealloc_raw() forms refund the block.
+  va.dealloc_raw(held.back(), 1000);
+  held.pop_back();
+  va.dealloc_raw(held.back(), 1000, 16);
+  held.pop_back();
+  EXPECT_EQ(va.quota_stats()[0].bytes_in_use, 5u * 1072);
+  EXPECT_NE(va.alloc_raw(1000, 16, "session #9"), nullptr);
+  EXPECT_NE(va.alloc_raw(1000, 16, "session #10"), nullptr);
+}
+
+TEST_F(VisualizationArenaTest, TagQuotaActionSteersResource) {
+  auto result = VisualizationArena::create({
+      .arena_size = 16 * 1024 * 1024,
+      .tag_quotas = {{.prefix = "hard", .limit_bytes = 1024},
+                     {.prefix = "soft",
+                      .limit_bytes = 1024,
+                      .action = QuotaAction::kOverflow}},
+  });
+  ASSERT_TRUE(result.has_value());
+  auto &va = *result;
+  auto *res = static_cast<TrackedResource *>(va.resource());
+
+  res->set_next_tag("soft");
+  void *p = res->allocate(4096, 16);
+  ASSERT_NE(p, nullptr);
+  EXPECT_FALSE(va.owns(p));
+  EXPECT_EQ(va.overflow_stats().allocations, 1u);
+  res->deallocate(p, 4096, 16);
+
+  res->set_next_tag("hard");
+  EXPECT_THROW((void)res->allocate(4096, 16), std::bad_alloc);
+  EXPECT_EQ(va.overflow_stats().allocations, 1u);
+  EXPECT_EQ(va.quota_stats()[0].hits, 1u);
+  EXPECT_EQ(va.quota_stats()[1].hits, 1u);
+}
+
+TEST_F(VisualizationArenaTest, InvalidTagQuotasRejected) {
+  auto result = VisualizationArena::create({
+      .tag_quotas = {{.prefix = "dup"}, {.prefix = "dup"}},
+  });
+  ASSERT_FALSE(result.has_value());
+  EXPECT_EQ(result.error(), std::make_error_code(std::errc::invalid_argument));
+}
+
+TEST_F(VisualizationArenaTest, ObserverStartsAtConfiguredSampling) {
+  auto result = VisualizationArena::create(
+      {.arena_size = 1024 * 1024, .sampling = 4, .overhead_target_pct = 2.0});
+  ASSERT_TRUE(result.has_value());
+  auto &va = *result;
+
+  // No batcher without the server, so no window has closed yet.
+  auto o = va.observer_overhead();
+  EXPECT_EQ(o.sampling, 4u);
+  EXPECT_DOUBLE_EQ(o.target_pct, 2.0);
+  EXPECT_EQ(o.window_ns, 0u);
+
+  for (int i = 0; i < 8; ++i) {
+    void *p = va.alloc_raw(256, 16, "sampled");
+    ASSERT_NE(p, nullptr);
+    va.dealloc_raw(p, 256);
+  }
+  // 16 events at 1 in 4.
+  auto log = va.event_log_json();
+  std::size_t events = 0;
+  for (auto pos = log.find("\"event_id\""); pos != std::string::npos;
+       pos = log.find("\"event_id\"", pos + 1)) {
+    ++events;
+  }
+  EXPECT_EQ(events, 4u);
+
+  EXPECT_NE(va.metrics_text().find("mmap_viz_observer_sampling 4"),
+            std::string::npos);
+}
+
+TEST_F(VisualizationArenaTest, AllocatorStatsPerShard) {
+  void *p = arena_->alloc_raw(256, 16, "alloc_stats");
+  ASSERT_NE(p, nullptr);
+  arena_->dealloc_raw(p, 256);
+
+  auto stats = arena_->allocator_stats();
+  ASSERT_EQ(stats.size(), 256u);
+  FreeListStats total;
+  for (const auto &s : stats) {
+    total += s;
+  }
+  if (FreeListAllocator::kStatsEnabled) {
+    EXPECT_GE(total.allocations, 1u);
+    EXPECT_GE(total.deallocations, 1u);
+    EXPECT_NE(arena_->snapshot_json().find("allocator_stats"),
+              std::string::npos);
+  } else {
+    EXPECT_EQ(total.allocations, 0u);
+  }
+}
+
 TEST_F(VisualizationArenaTest, TwoArenasOneThread) {
   auto result_b = VisualizationArena::create({.arena_size = 1024 * 1024});
   ASSERT_TRUE(result_b.has_value());
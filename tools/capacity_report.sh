@@ -27,7 +27,7 @@ $BUILD_DIR/server_sim --server --port $PORT --requests 1000000 --sampling 100 --
 SERVER_PID=$!
 sleep 2
 
-python3 tools/load_tester.py --url ws://localhost:$PORT --clients 10 --duration 5
+$BUILD_DIR/load_tester --url ws://localhost:$PORT/ws --clients 10 --duration 5
 
 kill $SERVER_PID || true
 
@@ -37,7 +37,7 @@ $BUILD_DIR/server_sim --server --port $PORT --requests 2000000 --sampling 500 --
 SERVER_PID=$!
 sleep 2
 
-python3 tools/load_tester.py --url ws://localhost:$PORT --clients 50 --duration 5
+$BUILD_DIR/load_tester --url ws://localhost:$PORT/ws --clients 50 --duration 5
 
 kill $SERVER_PID || true
 
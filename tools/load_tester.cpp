@@ -0,0 +1,337 @@
+/// @file load_tester.cpp
+/// @brief Native WebSocket load tester for the visualization stream.
+///
+/// Opens hundreds of client connections spread over a handful of
+/// io_context threads and consumes the event stream exactly as the
+/// dashboard would, minus rendering. Frames are never parsed into a DOM:
+/// the tester only scans for `"timestamp_us":` to count events and compute
+/// lag, so the numbers reflect the server rather than the client.
+///
+/// Reports aggregate and per-client events/sec, end-to-end lag
+/// percentiles (system_clock, same epoch as the server's timestamp_us) and
+/// how many clients failed to connect or were disconnected mid-run.
+
+#include "latency_histogram.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace ws = beast::websocket;
+using tcp = net::ip::tcp;
+using mmap_viz::bench::LatencyHistogram;
+
+// ─── CLI ────────────────────────────────────────────────────────────────
+
+struct LoadArgs {
+  std::string host = "localhost";
+  std::string port = "9999";
+  std::string path = "/ws";
+  std::size_t clients = 100;
+  std::size_t threads = 4;
+  std::size_t duration_s = 10;
+};
+
+void print_usage(const char *prog) {
+  std::cout
+      << "Usage: " << prog << " [options]\n\n"
+      << "Options:\n"
+      << "  --url <ws://host:port/path>  Server URL "
+         "(default: ws://localhost:9999/ws)\n"
+      << "  --clients <N>                Concurrent clients (default: 100)\n"
+      << "  --threads <N>                Client io threads (default: 4)\n"
+      << "  --duration <N>               Test duration in seconds "
+         "(default: 10)\n"
+      << "  --help                       Show this help\n";
+}
+
+/// @brief Split ws://host[:port][/path] into its parts.
+void parse_url(std::string_view url, LoadArgs &args) {
+  constexpr std::string_view kScheme = "ws://";
+  if (url.starts_with(kScheme)) {
+    url.remove_prefix(kScheme.size());
+  }
+  const auto slash = url.find('/');
+  const auto authority = url.substr(0, slash);
+  args.path = slash == std::string_view::npos ? "/"
+                                              : std::string(url.substr(slash));
+  const auto colon = authority.rfind(':');
+  if (colon == std::string_view::npos) {
+    args.host = std::string(authority);
+    args.port = "80";
+  } else {
+    args.host = std::string(authority.substr(0, colon));
+    args.port = std::string(authority.substr(colon + 1));
+  }
+}
+
+auto parse_args(int argc, char *argv[]) -> LoadArgs {
+  LoadArgs args;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      print_usage(argv[0]);
+      std::exit(0);
+    } else if (arg == "--url" && i + 1 < argc) {
+      parse_url(argv[++i], args);
+    } else if (arg == "--clients" && i + 1 < argc) {
+      args.clients = std::stoull(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      args.threads = std::max<std::size_t>(1, std::stoull(argv[++i]));
+    } else if (arg == "--duration" && i + 1 < argc) {
+      args.duration_s = std::stoull(argv[++i]);
+    }
+  }
+  return args;
+}
+
+auto now_us() -> std::uint64_t {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+}
+
+// ─── Client ─────────────────────────────────────────────────────────────
+
+/// @brief One WebSocket connection. Only ever touched by the thread running
+///        its io_context, so its counters need no synchronization.
+class LoadClient {
+public:
+  LoadClient(net::io_context &ioc, const LoadArgs &args,
+             const std::atomic<bool> &stopping)
+      : resolver_{ioc}, ws_{ioc}, args_{args}, stopping_{stopping} {}
+
+  void start() {
+    resolver_.async_resolve(
+        args_.host, args_.port,
+        [this](beast::error_code ec, tcp::resolver::results_type results) {
+          if (ec) {
+            return fail(ec);
+          }
+          beast::get_lowest_layer(ws_).async_connect(
+              results, [this](beast::error_code ec,
+                              const tcp::endpoint &) { on_connect(ec); });
+        });
+  }
+
+  [[nodiscard]] auto connected() const -> bool { return connected_; }
+  [[nodiscard]] auto disconnected() const -> bool { return disconnected_; }
+  [[nodiscard]] auto events() const -> std::uint64_t { return events_; }
+  [[nodiscard]] auto frames() const -> std::uint64_t { return frames_; }
+  [[nodiscard]] auto lag_us() const -> const LatencyHistogram & {
+    return lag_us_;
+  }
+
+  /// @brief Events per second over the time this client was connected.
+  [[nodiscard]] auto events_per_sec(
+      std::chrono::steady_clock::time_point end) const -> double {
+    if (!connected_) {
+      return 0.0;
+    }
+    const auto until = disconnected_ ? disconnected_at_ : end;
+    const double secs =
+        std::chrono::duration<double>(until - connected_at_).count();
+    return secs > 0 ? static_cast<double>(events_) / secs : 0.0;
+  }
+
+private:
+  void on_connect(beast::error_code ec) {
+    if (ec) {
+      return fail(ec);
+    }
+    ws_.async_handshake(args_.host + ":" + args_.port, args_.path,
+                        [this](beast::error_code ec) {
+                          if (ec) {
+                            return fail(ec);
+                          }
+                          connected_ = true;
+                          connected_at_ = std::chrono::steady_clock::now();
+                          do_read();
+                        });
+  }
+
+  void do_read() {
+    ws_.async_read(buffer_, [this](beast::error_code ec, std::size_t) {
+      if (ec) {
+        return fail(ec);
+      }
+      on_frame();
+      buffer_.consume(buffer_.size());
+      do_read();
+    });
+  }
+
+  void on_frame() {
+    const auto t = now_us();
+    auto data = buffer_.cdata();
+    std::string_view frame{static_cast<const char *>(data.data()),
+                           data.size()};
+    ++frames_;
+    // Event batches are JSON arrays; the snapshot (an object) is skipped.
+    if (frame.empty() || frame.front() != '[') {
+      return;
+    }
+
+    constexpr std::string_view kKey = R"("timestamp_us":)";
+    for (auto pos = frame.find(kKey); pos != std::string_view::npos;
+         pos = frame.find(kKey, pos)) {
+      pos += kKey.size();
+      std::uint64_t stamp = 0;
+      auto [end, err] = std::from_chars(
+          frame.data() + pos, frame.data() + frame.size(), stamp);
+      ++events_;
+      if (err == std::errc{}) {
+        lag_us_.record(t > stamp ? t - stamp : 0);
+      }
+    }
+  }
+
+  void fail(beast::error_code ec) {
+    if (stopping_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    if (connected_) {
+      disconnected_ = true;
+      disconnected_at_ = std::chrono::steady_clock::now();
+      std::cerr << "[LoadTester] disconnected: " << ec.message() << "\n";
+    } else {
+      std::cerr << "[LoadTester] connect failed: " << ec.message() << "\n";
+    }
+  }
+
+  tcp::resolver resolver_;
+  ws::stream<beast::tcp_stream> ws_;
+  beast::flat_buffer buffer_;
+  const LoadArgs &args_;
+  const std::atomic<bool> &stopping_;
+
+  bool connected_ = false;
+  bool disconnected_ = false;
+  std::chrono::steady_clock::time_point connected_at_;
+  std::chrono::steady_clock::time_point disconnected_at_;
+  std::uint64_t events_ = 0;
+  std::uint64_t frames_ = 0;
+  LatencyHistogram lag_us_;
+};
+
+// ─── Report ─────────────────────────────────────────────────────────────
+
+void report(const std::vector<std::unique_ptr<LoadClient>> &clients,
+            double elapsed_s, std::chrono::steady_clock::time_point end) {
+  std::size_t connected = 0;
+  std::size_t disconnected = 0;
+  std::uint64_t events = 0;
+  std::uint64_t frames = 0;
+  LatencyHistogram lag;
+  std::vector<double> per_client;
+
+  for (const auto &c : clients) {
+    if (!c->connected()) {
+      continue;
+    }
+    ++connected;
+    disconnected += c->disconnected() ? 1 : 0;
+    events += c->events();
+    frames += c->frames();
+    lag.merge(c->lag_us());
+    per_client.push_back(c->events_per_sec(end));
+  }
+  std::sort(per_client.begin(), per_client.end());
+  auto at = [&](double q) {
+    if (per_client.empty()) {
+      return 0.0;
+    }
+    const auto i = static_cast<std::size_t>(
+        q * static_cast<double>(per_client.size() - 1));
+    return per_client[i];
+  };
+
+  std::printf("\n--- Load Test Report ---\n");
+  std::printf("Clients:          %zu requested, %zu connected, "
+              "%zu failed, %zu disconnected\n",
+              clients.size(), connected, clients.size() - connected,
+              disconnected);
+  std::printf("Duration:         %.2fs\n", elapsed_s);
+  std::printf("Total frames:     %llu\n",
+              static_cast<unsigned long long>(frames));
+  std::printf("Total events:     %llu\n",
+              static_cast<unsigned long long>(events));
+  std::printf("Events/sec:       %.2f (all clients)\n",
+              static_cast<double>(events) / elapsed_s);
+  std::printf("Events/sec/client: min %.2f  p50 %.2f  max %.2f\n", at(0.0),
+              at(0.5), at(1.0));
+  if (lag.count() == 0) {
+    std::printf("No latency data received.\n");
+    return;
+  }
+  std::printf("Lag (us):\n");
+  std::printf("  P50:   %llu\n",
+              static_cast<unsigned long long>(lag.percentile(0.50)));
+  std::printf("  P90:   %llu\n",
+              static_cast<unsigned long long>(lag.percentile(0.90)));
+  std::printf("  P99:   %llu\n",
+              static_cast<unsigned long long>(lag.percentile(0.99)));
+  std::printf("  P99.9: %llu\n",
+              static_cast<unsigned long long>(lag.percentile(0.999)));
+  std::printf("  Max:   %llu\n", static_cast<unsigned long long>(lag.max()));
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  auto args = parse_args(argc, argv);
+  std::cout << "[LoadTester] ws://" << args.host << ":" << args.port
+            << args.path << " with " << args.clients << " clients on "
+            << args.threads << " threads for " << args.duration_s << "s\n";
+
+  std::atomic<bool> stopping{false};
+  const auto num_threads = std::min(args.threads, args.clients);
+
+  std::vector<std::unique_ptr<net::io_context>> iocs;
+  for (std::size_t i = 0; i < num_threads; ++i) {
+    iocs.push_back(std::make_unique<net::io_context>(1));
+  }
+  std::vector<std::unique_ptr<LoadClient>> clients;
+  for (std::size_t i = 0; i < args.clients; ++i) {
+    clients.push_back(
+        std::make_unique<LoadClient>(*iocs[i % iocs.size()], args, stopping));
+    clients.back()->start();
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (auto &ioc : iocs) {
+    threads.emplace_back([&ioc] { ioc->run(); });
+  }
+
+  std::this_thread::sleep_for(std::chrono::seconds(args.duration_s));
+  stopping = true;
+  const auto end = std::chrono::steady_clock::now();
+
+  for (auto &ioc : iocs) {
+    ioc->stop();
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  report(clients, std::chrono::duration<double>(end - start).count(), end);
+  return 0;
+}
@@ -0,0 +1,279 @@
+/// @file size_class_gen.cpp
+/// @brief Fit a size-class table to a recorded request-size histogram.
+///
+/// Reads either a histogram (one `<size> <count>` pair per line, `#`
+/// comments) or an event log exported from the dashboard (requested sizes
+/// of its `allocate` events), picks the @c --classes class sizes up to
+/// @c --max bytes that minimise the bytes lost to rounding, and writes a
+/// header defining ProfiledSizeClasses for FreeListAllocator to stdout.
+/// From the build directory, the checked-in table is regenerated with:
+/// @code
+///   ./size_class_gen ../tools/server_mix_sizes.txt --classes 20 --max 1024
+///   > ../src/allocator/profiled_size_classes.hpp
+/// @endcode
+/// (one command; the redirect is wrapped only to fit the line width).
+///
+/// 16, 32 and 48 are always classes (see size_classes::valid()); the rest
+/// are placed by dynamic programming over 16-byte granules, so the table is
+/// optimal for the histogram. Requests above --max are left to the tree.
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kGranule = 16;
+constexpr std::size_t kFixedClasses = 3; ///< 16, 32 and 48.
+
+// ─── CLI ────────────────────────────────────────────────────────────────
+
+struct GenArgs {
+  std::string input;
+  std::size_t classes = 20;
+  std::size_t max_size = 1024;
+};
+
+void print_usage(const char *prog) {
+  std::cerr
+      << "Usage: " << prog << " <histogram|event log> [options]\n\n"
+      << "Options:\n"
+      << "  --classes <N>   Number of size classes, 4-255 (default: 20)\n"
+      << "  --max <BYTES>   Largest class; larger requests use the tree "
+         "(default: 1024)\n"
+      << "  --help          Show this help\n\n"
+      << "Writes the header to stdout and a summary to stderr.\n";
+}
+
+auto parse_args(int argc, char *argv[]) -> GenArgs {
+  GenArgs args;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      print_usage(argv[0]);
+      std::exit(0);
+    } else if (arg == "--classes" && i + 1 < argc) {
+      args.classes = std::stoull(argv[++i]);
+    } else if (arg == "--max" && i + 1 < argc) {
+      args.max_size = std::stoull(argv[++i]);
+    } else {
+      args.input = arg;
+    }
+  }
+  if (args.input.empty() || args.classes < kFixedClasses + 1 ||
+      args.classes > 255 || args.max_size < 64) {
+    print_usage(argv[0]);
+    std::exit(1);
+  }
+  args.max_size = args.max_size / kGranule * kGranule;
+  return args;
+}
+
+// ─── Input ──────────────────────────────────────────────────────────────
+
+/// @brief Request counts by size in granules; index 0 is unused.
+struct Histogram {
+  std::vector<std::uint64_t> counts;
+  std::uint64_t total = 0; ///< Every request read.
+  std::uint64_t above = 0; ///< Requests larger than the largest class.
+  std::uint64_t bytes = 0; ///< Requested bytes at or below it.
+
+  void add(std::size_t size, std::uint64_t n) {
+    total += n;
+    auto g = (std::max<std::size_t>(size, 1) + kGranule - 1) / kGranule;
+    if (g >= counts.size()) {
+      above += n;
+      return;
+    }
+    counts[g] += n;
+    bytes += size * n;
+  }
+};
+
+auto read_histogram(const GenArgs &args) -> Histogram {
+  std::ifstream in(args.input);
+  if (!in) {
+    std::cerr << "Cannot open " << args.input << "\n";
+    std::exit(1);
+  }
+  std::stringstream text;
+  text << in.rdbuf();
+  const std::string body = text.str();
+
+  Histogram h;
+  h.counts.assign(args.max_size / kGranule + 1, 0);
+
+  const auto first = body.find_first_not_of(" \t\r\n");
+  if (first != std::string::npos &&
+      (body[first] == '{' || body[first] == '[')) {
+    // An exported event log: {"events": [...]} or a bare array.
+    auto j = nlohmann::json::parse(body, nullptr, false);
+    if (j.is_discarded()) {
+      std::cerr << args.input << " is not valid JSON\n";
+      std::exit(1);
+    }
+    const auto &events = j.is_object() ? j.value("events", nlohmann::json{})
+                                       : j;
+    for (const auto &e : events) {
+      if (e.value("type", "") == "allocate") {
+        h.add(e.value("size", std::size_t{0}), 1);
+      }
+    }
+    return h;
+  }
+
+  std::istringstream lines(body);
+  std::string line;
+  while (std::getline(lines, line)) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    std::size_t size = 0;
+    std::uint64_t n = 0;
+    if (fields >> size >> n) {
+      h.add(size, n);
+    }
+  }
+  return h;
+}
+
+// ─── Fit ────────────────────────────────────────────────────────────────
+
+/// @brief Classes (in granules) minimising rounding waste, and that waste
+///        in bytes.
+auto fit(const Histogram &h, std::size_t classes)
+    -> std::pair<std::vector<std::size_t>, std::uint64_t> {
+  const std::size_t m = h.counts.size() - 1;
+  std::size_t top = m;
+  while (top > kFixedClasses && h.counts[top] == 0) {
+    --top;
+  }
+
+  // waste(a, b): requests of a+1..b granules all rounded up to b.
+  std::vector<std::uint64_t> n(m + 1, 0), g(m + 1, 0);
+  for (std::size_t i = 1; i <= m; ++i) {
+    n[i] = n[i - 1] + h.counts[i];
+    g[i] = g[i - 1] + h.counts[i] * i;
+  }
+  auto waste = [&](std::size_t a, std::size_t b) {
+    return kGranule * (b * (n[b] - n[a]) - (g[b] - g[a]));
+  };
+
+  // best[k][b]: least waste covering 1..b with k classes, the last at b.
+  constexpr auto kInf = std::numeric_limits<std::uint64_t>::max();
+  const std::size_t k_max = std::min(classes, top);
+  std::vector<std::vector<std::uint64_t>> best(
+      k_max + 1, std::vector<std::uint64_t>(top + 1, kInf));
+  std::vector<std::vector<std::size_t>> from(
+      k_max + 1, std::vector<std::size_t>(top + 1, 0));
+  best[kFixedClasses][kFixedClasses] = 0;
+  for (std::size_t k = kFixedClasses + 1; k <= k_max; ++k) {
+    for (std::size_t b = k; b <= top; ++b) {
+      for (std::size_t a = k - 1; a < b; ++a) {
+        if (best[k - 1][a] == kInf) {
+          continue;
+        }
+        auto w = best[k - 1][a] + waste(a, b);
+        if (w < best[k][b]) {
+          best[k][b] = w;
+          from[k][b] = a;
+        }
+      }
+    }
+  }
+
+  std::size_t k = kFixedClasses;
+  for (std::size_t i = kFixedClasses; i <= k_max; ++i) {
+    if (best[i][top] < best[k][top]) {
+      k = i;
+    }
+  }
+  const auto least = best[k][top];
+  std::vector<std::size_t> out;
+  for (std::size_t b = top; k > kFixedClasses; b = from[k--][b]) {
+    out.push_back(b);
+  }
+  for (std::size_t i = kFixedClasses; i > 0; --i) {
+    out.push_back(i);
+  }
+  std::reverse(out.begin(), out.end());
+  return {out, least};
+}
+
+} // namespace
+
+auto main(int argc, char *argv[]) -> int {
+  const auto args = parse_args(argc, argv);
+  const auto h = read_histogram(args);
+  if (h.total == h.above) {
+    std::cerr << "No requests of at most " << args.max_size << " B in "
+              << args.input << "\n";
+    return 1;
+  }
+  const auto [classes, waste] = fit(h, args.classes);
+  // Bytes the classes hand out, against the bytes requested.
+  std::uint64_t class_bytes = waste;
+  for (std::size_t i = 1; i < h.counts.size(); ++i) {
+    class_bytes += h.counts[i] * i * kGranule;
+  }
+  const double pct = 100.0 * static_cast<double>(class_bytes - h.bytes) /
+                     static_cast<double>(class_bytes);
+  std::fprintf(stderr,
+               "%llu requests, %llu above %zu B; %zu classes, %.2f%% of "
+               "class bytes lost to rounding\n",
+               static_cast<unsigned long long>(h.total),
+               static_cast<unsigned long long>(h.above), args.max_size,
+               classes.size(), pct);
+
+  // Wrap the table at 80 columns, continuation lines under the first size.
+  const std::string open = "    TableSizeClasses<";
+  std::string table;
+  std::string line = open;
+  for (std::size_t i = 0; i < classes.size(); ++i) {
+    auto item = std::to_string(classes[i] * kGranule) +
+                (i + 1 < classes.size() ? "," : ">;");
+    if (line.size() + 1 + item.size() > 80) {
+      table += line + "\n";
+      line = std::string(open.size(), ' ');
+    } else if (line.size() > open.size()) {
+      line += " ";
+    }
+    line += item;
+  }
+  table += line;
+
+  std::printf(
+      "#pragma once\n"
+      "/// @file profiled_size_classes.hpp\n"
+      "/// @brief Size classes fitted by tools/size_class_gen.\n"
+      "///\n"
+      "/// Fitted to %s: %zu classes up to %zu B, with\n"
+      "/// %.2f%% of the bytes those requests take lost to rounding.\n"
+      "/// Generated, do not edit; see tools/size_class_gen.cpp.\n"
+      "\n"
+      "#include \"allocator/free_list.hpp\"\n"
+      "\n"
+      "namespace mmap_viz {\n"
+      "\n"
+      "using ProfiledSizeClasses =\n"
+      "%s\n"
+      "\n"
+      "/// @brief FreeListAllocator with the fitted lists.\n"
+      "using ProfiledFreeListAllocator = "
+      "BasicFreeListAllocator<ProfiledSizeClasses>;\n"
+      "\n"
+      "extern template class BasicFreeListAllocator<ProfiledSizeClasses>;\n"
+      "\n"
+      "} // namespace mmap_viz\n",
+      args.input.c_str(), classes.size(), classes.back() * kGranule, pct,
+      table.c_str());
+  return 0;
+}
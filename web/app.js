@@ -21,7 +21,10 @@ const state = {
         totalFree: 0,
         fragPct: 0,
         freeBlockCount: 0,
+        overflowBytes: 0,      // Live bytes served by the overflow upstream
+        overflowCount: 0,      // Overflow allocations so far
     },
+    subArenas: [],             // Live sub-arenas: { name, offset, capacity, ... }
     hover: null,               // Currently hovered block or null
     eventCount: 0,
     // Heatmap state
@@ -48,7 +51,9 @@ const dom = {
     statFree: document.getElementById('statFree'),
     statFrag: document.getElementById('statFrag'),
     statFreeBlocks: document.getElementById('statFreeBlocks'),
+    statOverflow: document.getElementById('statOverflow'),
     statEvents: document.getElementById('statEvents'),
+    statObserver: document.getElementById('statObserver'),
     btnClear: document.getElementById('btnClear'),
     btnHeatmap: document.getElementById('btnHeatmap'),
     btnExport: document.getElementById('btnExport'),
@@ -62,6 +67,10 @@ const dom = {
     btnCleanup: document.getElementById('btnCleanup'),
     btnStop: document.getElementById('btnStop'),
     stressStatus: document.getElementById('stressStatus'),
+    locksSummary: document.getElementById('locksSummary'),
+    locksBody: document.getElementById('locksBody'),
+    subArenasSummary: document.getElementById('subArenasSummary'),
+    subArenasBody: document.getElementById('subArenasBody'),
 };
 
 const ctx = dom.canvas.getContext('2d');
@@ -79,6 +88,7 @@ const COLORS = {
     deallocFade: '#7f1d1d',
     hover: '#fbbf24',
     hoverBorder: '#f59e0b',
+    subArena: '#a78bfa',
     gridLine: '#1a2235',
     text: '#94a3b8',
     textBright: '#e2e8f0',
@@ -159,6 +169,20 @@ function processEvent(data) {
         handleAllocate(data);
     } else if (data.type === 'deallocate') {
         handleDeallocate(data);
+    } else if (data.type === 'occupancy') {
+        handleOccupancy(data);
+    } else if (data.type === 'overflow_allocate' || data.type === 'overflow_deallocate') {
+        handleOverflow(data);
+    } else if (data.type === 'quota_exceeded') {
+        // Refused before touching the arena: a timeline entry only.
+        state.eventCount++;
+        addTimelineEvent(data);
+    } else if (data.type === 'shard_locks') {
+        handleShardLocks(data);
+    } else if (data.type === 'observer') {
+        handleObserver(data);
+    } else if (data.type === 'sub_arenas') {
+        handleSubArenas(data.sub_arenas);
     }
 }
 
@@ -181,6 +205,13 @@ function handleSnapshot(data) {
     state.stats.totalFree = data.total_free;
     state.stats.fragPct = data.fragmentation_pct;
     state.stats.freeBlockCount = data.free_block_count;
+    if (data.overflow) {
+        state.stats.overflowBytes = data.overflow.bytes_in_use;
+        state.stats.overflowCount = data.overflow.allocations;
+    }
+    if (data.sub_arenas) {
+        handleSubArenas(data.sub_arenas);
+    }
 
     updateStatsUI();
 }
@@ -236,6 +267,113 @@ function handleDeallocate(data) {
     updateStatsUI();
 }
 
+// Pool chunks report how much of the block is handed out as nodes.
+// No timeline entry: these are fill-level updates, not allocations.
+function handleOccupancy(data) {
+    const block = state.blocks.get(data.offset);
+    if (block) {
+        block.used = data.size;
+    }
+}
+
+// Allocations the arena could not hold and the upstream resource served.
+// They live outside the arena (offset is an absolute address), so they
+// only feed the overflow counter and the timeline, not the memory map.
+function handleOverflow(data) {
+    if (data.type === 'overflow_allocate') {
+        state.stats.overflowBytes += data.size;
+        state.stats.overflowCount++;
+    } else {
+        state.stats.overflowBytes = Math.max(0, state.stats.overflowBytes - data.size);
+    }
+
+    state.eventCount++;
+    addTimelineEvent(data);
+    updateStatsUI();
+}
+
+// Periodic shard lock profile: totals plus the most contended shards.
+// A shard with a high remote share and long waits is convoying frees
+// from other threads behind its owner's allocations.
+function handleShardLocks(data) {
+    const pct = (n, d) => d === 0 ? '0%' : (100 * n / d).toFixed(1) + '%';
+
+    dom.locksSummary.textContent =
+        `${data.active_shards} active shards · ` +
+        `${pct(data.contended, data.acquisitions)} contended · ` +
+        `${pct(data.remote, data.acquisitions)} remote`;
+
+    dom.locksBody.innerHTML = '';
+    for (const s of data.shards) {
+        const row = document.createElement('tr');
+        if (s.contended > 0 && s.contended * 20 >= s.acquisitions) {
+            row.className = 'lock-hot'; // At least 5% contended.
+        }
+        row.innerHTML = `
+            <td>#${s.shard}</td>
+            <td>${s.acquisitions}</td>
+            <td>${s.contended} (${pct(s.contended, s.acquisitions)})</td>
+            <td>${s.remote} (${pct(s.remote, s.acquisitions)})</td>
+            <td>${formatNs(s.wait_p50_ns)} / ${formatNs(s.wait_p99_ns)} / ${formatNs(s.wait_max_ns)}</td>
+            <td>${formatNs(s.hold_p50_ns)} / ${formatNs(s.hold_p99_ns)}</td>
+        `;
+        dom.locksBody.appendChild(row);
+    }
+}
+
+// Periodic sub-arena list. A sub-arena that is gone was released as a
+// whole, without a free event per block, so drop its blocks here.
+function handleSubArenas(subs) {
+    const live = new Set(subs.map((s) => `${s.name}@${s.offset}`));
+    for (const old of state.subArenas) {
+        if (live.has(`${old.name}@${old.offset}`)) continue;
+        const end = old.offset + old.capacity;
+        for (const offset of state.blocks.keys()) {
+            if (offset >= old.offset && offset < end) state.blocks.delete(offset);
+        }
+    }
+    state.subArenas = subs;
+
+    const pct = (n, d) => d === 0 ? '0%' : (100 * n / d).toFixed(1) + '%';
+    const delegated = subs.reduce((sum, s) => sum + s.capacity, 0);
+    dom.subArenasSummary.textContent = subs.length === 0
+        ? 'No sub-arenas'
+        : `${subs.length} sub-arenas · ${formatBytes(delegated)} delegated`;
+
+    dom.subArenasBody.innerHTML = '';
+    for (const s of subs) {
+        const row = document.createElement('tr');
+        if (s.bytes_allocated * 10 >= s.capacity * 9) {
+            row.className = 'subarena-full'; // At least 90% allocated.
+        }
+        const hex = (n) => '0x' + n.toString(16).padStart(6, '0');
+        row.innerHTML = `
+            <td>${s.name}</td>
+            <td>${hex(s.offset)}–${hex(s.offset + s.capacity)}</td>
+            <td>${formatBytes(s.bytes_allocated)}</td>
+            <td>${formatBytes(s.bytes_free)}</td>
+            <td>${s.active_blocks}</td>
+            <td>${pct(s.bytes_allocated, s.capacity)}</td>
+        `;
+        dom.subArenasBody.appendChild(row);
+    }
+}
+
+// Periodic observer overhead: what the instrumentation cost over the
+// last window and the sampling rate the controller settled on.
+function handleObserver(data) {
+    const rate = data.sampling === 1 ? 'all' : `1/${data.sampling}`;
+    dom.statObserver.textContent = `${data.overhead_pct.toFixed(2)}% · ${rate}`;
+    dom.statObserver.classList.toggle('observer-over',
+        data.target_pct > 0 && data.overhead_pct > data.target_pct);
+    dom.statObserver.parentElement.title =
+        `batcher ${data.batcher_pct.toFixed(2)}% · ` +
+        `server ${data.server_pct.toFixed(2)}% · ` +
+        `tracking ${data.tracking_pct.toFixed(2)}% ` +
+        `(${data.tracking_ns_per_op.toFixed(0)} ns/op)` +
+        (data.target_pct > 0 ? ` · target ${data.target_pct}%` : '');
+}
+
 // ─── Stats UI ───────────────────────────────────────────────────
 
 function formatBytes(bytes) {
@@ -244,12 +382,21 @@ function formatBytes(bytes) {
     return bytes + ' B';
 }
 
+function formatNs(ns) {
+    if (ns >= 1e6) return (ns / 1e6).toFixed(1) + ' ms';
+    if (ns >= 1e3) return (ns / 1e3).toFixed(1) + ' µs';
+    return ns + ' ns';
+}
+
 function updateStatsUI() {
     dom.statCapacity.textContent = formatBytes(state.capacity);
     dom.statAllocated.textContent = formatBytes(state.stats.totalAllocated);
     dom.statFree.textContent = formatBytes(state.stats.totalFree);
     dom.statFrag.textContent = state.stats.fragPct + '%';
     dom.statFreeBlocks.textContent = state.stats.freeBlockCount;
+    dom.statOverflow.textContent = state.stats.overflowCount === 0
+        ? '0'
+        : `${formatBytes(state.stats.overflowBytes)} (${state.stats.overflowCount})`;
     dom.statEvents.textContent = state.eventCount;
     dom.fragBar.style.width = state.stats.fragPct + '%';
 }
@@ -268,19 +415,32 @@ function addTimelineEvent(data) {
     }
 
     const isAlloc = data.type === 'allocate';
+    const isOverflow = data.type.startsWith('overflow_');
+    const isQuota = data.type === 'quota_exceeded';
+    let typeClass = isAlloc ? 'alloc' : 'dealloc';
+    let typeLabel = isAlloc ? 'ALLOC' : 'FREE';
+    if (isOverflow) {
+        typeClass = 'overflow';
+        typeLabel = data.type === 'overflow_allocate' ? 'OVERFLOW' : 'OVF FREE';
+    } else if (isQuota) {
+        typeClass = 'quota';
+        typeLabel = 'QUOTA';
+    }
     const row = document.createElement('div');
     row.className = 'event-row';
     row.innerHTML = `
         <span class="event-id">#${data.event_id}</span>
-        <span class="event-type ${isAlloc ? 'alloc' : 'dealloc'}">${isAlloc ? 'ALLOC' : 'FREE'}</span>
+        <span class="event-type ${typeClass}">${typeLabel}</span>
         <span class="event-tag">${data.tag || '—'}</span>
         <span class="event-size">${formatBytes(data.size)}</span>
         <span class="event-offset">0x${data.offset.toString(16).padStart(6, '0')}</span>
         <span class="event-frag">${data.fragmentation_pct}%</span>
     `;
 
-    // Highlight block on hover.
+    // Highlight block on hover (overflow and quota events are not on the
+    // map).
     row.addEventListener('mouseenter', () => {
+        if (isOverflow || isQuota) return;
         state.hover = { offset: data.offset, size: data.actual_size || data.size };
     });
     row.addEventListener('mouseleave', () => {
@@ -564,6 +724,12 @@ function render() {
         state.recentDeallocs.delete(key);
     }
 
+    // ─── Draw sub-arena outlines ────────────────────────────────
+
+    for (const sub of state.subArenas) {
+        drawSubArena(sub, pad, drawW, rows, bytesPerRow);
+    }
+
     // ─── Draw heatmap overlay ───────────────────────────────────
 
     if (state.heatmapEnabled && state.heatmapMax > 0) {
@@ -604,6 +770,14 @@ function drawBlock(offset, size, block, now, pad, drawW, rows, bytesPerRow, isHi
     roundRect(ctx, start.x + BLOCK_PADDING, start.y + 1, pixelWidth - BLOCK_PADDING * 2, ROW_HEIGHT - 4, 2);
     ctx.fill();
 
+    // Pool chunk: dim the part not handed out as nodes.
+    if (block.used !== undefined && size > 0) {
+        const fill = Math.min(1, block.used / size);
+        const usedW = (pixelWidth - BLOCK_PADDING * 2) * fill;
+        ctx.fillStyle = COLORS.allocDim;
+        ctx.fillRect(start.x + BLOCK_PADDING + usedW, start.y + 1, pixelWidth - BLOCK_PADDING * 2 - usedW, ROW_HEIGHT - 4);
+    }
+
     // Tag label if block is wide enough.
     if (pixelWidth > 40 && block.tag) {
         ctx.fillStyle = '#0a0e17';
@@ -638,6 +812,30 @@ function drawDeallocBlock(offset, size, alpha, pad, drawW, rows, bytesPerRow) {
     ctx.shadowBlur = 0;
 }
 
+// Dashed outline around a sub-arena's range, one segment per row it
+// spans, with its name at the start.
+function drawSubArena(sub, pad, drawW, rows, bytesPerRow) {
+    const end = sub.offset + sub.capacity;
+    ctx.strokeStyle = COLORS.subArena;
+    ctx.lineWidth = 1;
+    ctx.setLineDash([4, 3]);
+    for (let offset = sub.offset; offset < end;) {
+        const start = offsetToPixel(offset, pad, drawW, rows, bytesPerRow);
+        const rowEnd = Math.min(end, (start.row + 1) * bytesPerRow);
+        const width = Math.max(2, ((rowEnd - offset) / bytesPerRow) * drawW);
+        ctx.strokeRect(start.x + 0.5, start.y + 0.5, width - 1, ROW_HEIGHT - 3);
+        if (start.row === rows - 1) break;
+        offset = rowEnd;
+    }
+    ctx.setLineDash([]);
+
+    const first = offsetToPixel(sub.offset, pad, drawW, rows, bytesPerRow);
+    ctx.fillStyle = COLORS.subArena;
+    ctx.font = '9px JetBrains Mono, monospace';
+    ctx.textAlign = 'left';
+    ctx.fillText(sub.name, first.x + 3, first.y + 9);
+}
+
 function drawHighlight(offset, size, pad, drawW, rows, bytesPerRow) {
     const start = offsetToPixel(offset, pad, drawW, rows, bytesPerRow);
     const pixelWidth = Math.max(2, (size / bytesPerRow) * drawW);
@@ -732,6 +930,7 @@ function showTooltip(x, y, block) {
         <div><span class="tt-label">Size: </span><span class="tt-value">${formatBytes(block.size)}</span></div>
         <div><span class="tt-label">Actual: </span><span class="tt-value">${formatBytes(block.actual_size)}</span></div>
         <div><span class="tt-label">Align: </span><span class="tt-value">${block.alignment}B</span></div>
+        ${block.used !== undefined ? `<div><span class="tt-label">Used: </span><span class="tt-value">${formatBytes(block.used)} (${Math.round(100 * block.used / block.actual_size)}%)</span></div>` : ''}
     `;
 
     // Position tooltip, keeping it within the canvas container.